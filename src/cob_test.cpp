@@ -1,7 +1,10 @@
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <rwe/cob/CobExecutionContext.h>
 #include <rwe/cob/CobOpCode.h>
+#include <rwe/cob/CobProgram.h>
 #include <rwe/io/_3do/_3do.h>
 #include <rwe/io/cob/Cob.h>
 #include <rwe/optional_io.h>
@@ -229,11 +232,99 @@ void printCob(const rwe::CobScript& cob)
     CobInstructionPrinter<std::vector<unsigned int>::const_iterator>(cob.instructions.begin(), cob.instructions.end(), functionsMap).printInstructions();
 }
 
+/**
+ * Runs every function in the script once, standing in for the engine:
+ * queries are answered with zero, and a thread is abandoned
+ * once it sleeps, blocks, finishes, fails or has been interrupted too many times.
+ * Returns the number of interruptions seen, so that runs can be compared.
+ */
+template <typename Execute>
+unsigned int runAllFunctions(const rwe::CobProgram& program, Execute execute)
+{
+    static const unsigned int MaxInterruptionsPerFunction = 64;
+
+    unsigned int interruptions = 0;
+    for (unsigned int functionId = 0; functionId < program.script.functions.size(); ++functionId)
+    {
+        rwe::CobEnvironment env(&program);
+        auto thread = env.createNonScheduledThread(functionId, std::vector<int>());
+        rwe::CobExecutionContext context(&env, &thread);
+
+        try
+        {
+            for (unsigned int i = 0; i < MaxInterruptionsPerFunction; ++i)
+            {
+                auto status = execute(context);
+                ++interruptions;
+
+                if (std::holds_alternative<rwe::CobEnvironment::QueryStatus>(status))
+                {
+                    thread.stack.push(0);
+                }
+                else if (std::holds_alternative<rwe::CobEnvironment::SleepStatus>(status)
+                    || std::holds_alternative<rwe::CobEnvironment::BlockedStatus>(status)
+                    || std::holds_alternative<rwe::CobEnvironment::FinishedStatus>(status))
+                {
+                    break;
+                }
+            }
+        }
+        catch (const std::exception&)
+        {
+            // malformed script, move on to the next function
+        }
+    }
+
+    return interruptions;
+}
+
+template <typename Execute>
+std::pair<double, unsigned int> timeRuns(const rwe::CobProgram& program, unsigned int iterations, Execute execute)
+{
+    unsigned int interruptions = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned int i = 0; i < iterations; ++i)
+    {
+        interruptions += runAllFunctions(program, execute);
+    }
+    auto end = std::chrono::steady_clock::now();
+    return {std::chrono::duration<double, std::milli>(end - start).count(), interruptions};
+}
+
+int benchmarkCob(const rwe::CobScript& script, unsigned int iterations)
+{
+    auto program = rwe::compileCobScript(rwe::CobScript(script));
+
+    auto [referenceMs, referenceInterruptions] = timeRuns(program, iterations, [](auto& c) { return c.executeReference(); });
+    auto [decodedMs, decodedInterruptions] = timeRuns(program, iterations, [](auto& c) { return c.execute(); });
+
+    std::cout << "Functions: " << script.functions.size() << ", iterations: " << iterations << std::endl;
+    std::cout << "  reference: " << std::fixed << std::setprecision(2) << referenceMs << " ms" << std::endl;
+    std::cout << "  decoded:   " << std::fixed << std::setprecision(2) << decodedMs << " ms" << std::endl;
+    std::cout << "  speedup:   " << std::fixed << std::setprecision(2) << (referenceMs / decodedMs) << "x" << std::endl;
+
+    if (referenceInterruptions != decodedInterruptions)
+    {
+        std::cerr << "Interpreters disagree: " << referenceInterruptions << " vs " << decodedInterruptions << " interruptions" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
 int main(int argc, char* argv[])
 {
+    if (argc >= 3 && std::string(argv[1]) == "--bench")
+    {
+        std::ifstream fh(argv[2], std::ios::binary);
+        auto script = rwe::parseCob(fh);
+        auto iterations = argc >= 4 ? static_cast<unsigned int>(std::stoul(argv[3])) : 1000u;
+        return benchmarkCob(script, iterations);
+    }
+
     if (argc < 2)
     {
-        std::cerr << "Specify a cob file to dump." << std::endl;
+        std::cerr << "Specify a cob file to dump, or --bench <file> [iterations] to time the interpreter." << std::endl;
         return 1;
     }
 
@@ -1,10 +1,19 @@
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <iomanip>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <rwe/io/hpi/HpiArchive.h>
+#include <rwe/io/hpi/hpi_util.h>
+#include <rwe/io/hpi/hpi_write.h>
+#include <rwe/util/MappedFile.h>
+#include <rwe/util/ThreadPool.h>
 #include <rwe/util/match.h>
 #include <string>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -59,16 +68,19 @@ void printFile(unsigned int indent, const std::string& name, const rwe::HpiArchi
 int listCommand(const std::string& filename)
 {
     std::cout << "HPI archive: " << filename << std::endl;
-    std::ifstream file(filename, std::ios::binary);
-
-    if (!file.is_open())
+    std::optional<rwe::MappedFile> file;
+    try
+    {
+        file.emplace(filename);
+    }
+    catch (const std::runtime_error& e)
     {
-        std::cerr << "Failed to open file." << std::endl;
+        std::cerr << "Failed to open file: " << e.what() << std::endl;
         return 1;
     }
 
     std::cout << "Opening..." << std::endl;
-    rwe::HpiArchive archive(&file);
+    rwe::HpiArchive archive(file->data(), file->size());
 
     std::cout << "Enumerating contents..." << std::endl;
     printDir(0, "<ROOT>", archive.root());
@@ -79,16 +91,19 @@ int listCommand(const std::string& filename)
 int extractCommand(const std::string& hpiPath, const std::string& filePath, const std::string& destinationPath)
 {
     std::cout << "HPI archive: " << hpiPath << std::endl;
-    std::ifstream file(hpiPath, std::ios::binary);
-
-    if (!file.is_open())
+    std::optional<rwe::MappedFile> file;
+    try
     {
-        std::cerr << "Failed to open file." << std::endl;
+        file.emplace(hpiPath);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Failed to open file: " << e.what() << std::endl;
         return 1;
     }
 
     std::cout << "Opening..." << std::endl;
-    rwe::HpiArchive archive(&file);
+    rwe::HpiArchive archive(file->data(), file->size());
 
     std::cout << "Finding file..." << std::endl;
     auto entry = archive.findFile(filePath);
@@ -138,16 +153,19 @@ void extractRecursive(rwe::HpiArchive& archive, const rwe::HpiArchive::Directory
 int extractAllCommand(const std::string& hpiPath, const std::string& destinationPath)
 {
     std::cout << "HPI archive: " << hpiPath << std::endl;
-    std::ifstream file(hpiPath, std::ios::binary);
-
-    if (!file.is_open())
+    std::optional<rwe::MappedFile> file;
+    try
     {
-        std::cerr << "Failed to open file." << std::endl;
+        file.emplace(hpiPath);
+    }
+    catch (const std::runtime_error& e)
+    {
+        std::cerr << "Failed to open file: " << e.what() << std::endl;
         return 1;
     }
 
     std::cout << "Extracting..." << std::endl;
-    rwe::HpiArchive archive(&file);
+    rwe::HpiArchive archive(file->data(), file->size());
 
     for (const auto& e : archive.root().entries)
     {
@@ -159,6 +177,118 @@ int extractAllCommand(const std::string& hpiPath, const std::string& destination
     return 0;
 }
 
+using BenchClock = std::chrono::steady_clock;
+
+/** Runs f repeatedly for at least half a second and returns the throughput in MiB/s. */
+template <typename F>
+double measureThroughput(std::size_t bytesPerRun, F f)
+{
+    // warm up
+    f();
+
+    unsigned int runs = 0;
+    auto start = BenchClock::now();
+    std::chrono::duration<double> elapsed;
+    do
+    {
+        f();
+        ++runs;
+        elapsed = BenchClock::now() - start;
+    } while (elapsed < std::chrono::milliseconds(500));
+
+    return (static_cast<double>(bytesPerRun) * runs) / (1024.0 * 1024.0) / elapsed.count();
+}
+
+void printThroughput(const std::string& name, double mibPerSecond)
+{
+    std::cout << "  " << std::left << std::setw(28) << name << std::right << std::setw(10) << mibPerSecond << " MiB/s" << std::endl;
+}
+
+/**
+ * Data that compresses about as well as typical game assets:
+ * short runs of a few byte values.
+ */
+std::string createBenchmarkData(std::size_t size, uint32_t seed)
+{
+    std::string data(size, '\0');
+    uint32_t state = seed;
+    std::size_t i = 0;
+    while (i < size)
+    {
+        state = (state * 1103515245) + 12345;
+        auto value = static_cast<char>((state >> 16) & 0x1f);
+        auto runLength = 1 + ((state >> 24) & 0x7);
+        for (uint32_t r = 0; r < runLength && i < size; ++r)
+        {
+            data[i++] = value;
+        }
+    }
+    return data;
+}
+
+int benchCommand(unsigned int sizeMiB)
+{
+    const unsigned int fileCount = 8;
+    auto fileSize = (static_cast<std::size_t>(sizeMiB) * 1024 * 1024) / fileCount;
+
+    std::cout << "Generating a synthetic archive of " << fileCount << " files, " << sizeMiB << " MiB in total..." << std::endl;
+    std::vector<rwe::HpiWriteFile> files;
+    for (unsigned int i = 0; i < fileCount; ++i)
+    {
+        files.push_back(rwe::HpiWriteFile{"bench/file" + std::to_string(i) + ".bin", createBenchmarkData(fileSize, i + 1), true});
+    }
+    auto bytes = rwe::writeHpiArchive(files, 0x7d);
+    rwe::HpiArchive archive(bytes.data(), bytes.size());
+
+    std::vector<std::reference_wrapper<const rwe::HpiArchive::File>> archiveFiles;
+    for (const auto& f : files)
+    {
+        archiveFiles.push_back(archive.findFile(f.path).value());
+    }
+
+    rwe::ThreadPool threadPool(rwe::ThreadPool::getDefaultThreadCount());
+
+    std::cout << "Archive is " << (bytes.size() / 1024) << " KiB, SIMD level " << rwe::getHpiSimdLevel() << ", " << threadPool.getThreadCount() << " threads" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+
+    auto scratch = bytes;
+    volatile uint32_t checksumSink = 0;
+    printThroughput("decrypt (scalar)", measureThroughput(scratch.size(), [&]() { rwe::decryptScalar(0x7d, 0, scratch.data(), scratch.size()); }));
+    printThroughput("decrypt", measureThroughput(scratch.size(), [&]() { rwe::decrypt(0x7d, 0, scratch.data(), scratch.size()); }));
+    printThroughput("decryptInner (scalar)", measureThroughput(scratch.size(), [&]() { rwe::decryptInnerScalar(scratch.data(), scratch.size()); }));
+    printThroughput("decryptInner", measureThroughput(scratch.size(), [&]() { rwe::decryptInner(scratch.data(), scratch.size()); }));
+    printThroughput("computeChecksum (scalar)", measureThroughput(scratch.size(), [&]() { checksumSink = rwe::computeChecksumScalar(scratch.data(), scratch.size()); }));
+    printThroughput("computeChecksum", measureThroughput(scratch.size(), [&]() { checksumSink = rwe::computeChecksum(scratch.data(), scratch.size()); }));
+
+    // throughput of extraction is measured in extracted bytes
+    std::vector<char> out(fileSize);
+    auto totalSize = fileSize * fileCount;
+    printThroughput("extract (serial)", measureThroughput(totalSize, [&]() {
+        for (const auto& f : archiveFiles)
+        {
+            archive.extract(f, out.data());
+        }
+    }));
+    printThroughput("extract (parallel chunks)", measureThroughput(totalSize, [&]() {
+        for (const auto& f : archiveFiles)
+        {
+            archive.extract(f, out.data(), threadPool);
+        }
+    }));
+
+    for (std::size_t i = 0; i < fileCount; ++i)
+    {
+        archive.extract(archiveFiles[i], out.data(), threadPool);
+        if (std::string(out.data(), out.size()) != files[i].data)
+        {
+            std::cerr << "Extracted data does not match for " << files[i].path << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 int main(int argc, char* argv[])
 {
     if (argc < 2)
@@ -202,6 +332,12 @@ int main(int argc, char* argv[])
         return extractAllCommand(argv[2], argv[3]);
     }
 
+    if (command == "bench")
+    {
+        auto sizeMiB = argc < 3 ? 64u : static_cast<unsigned int>(std::stoul(argv[2]));
+        return benchCommand(sizeMiB);
+    }
+
     std::cerr << "Unrecognised command: " << command << std::endl;
     return 1;
 }
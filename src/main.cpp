@@ -220,6 +220,7 @@ namespace rwe
         {
             addToVfs(vfs, path.string());
         }
+        vfs.buildIndex();
 
         LOG_INFO << "Loading palette";
         auto paletteBytes = vfs.readFile("palettes/PALETTE.PAL");
@@ -517,7 +518,8 @@ int main(int argc, char* argv[])
             std::cout << "Usage: rwe [options]\n"
                       << "  --help                Show this message\n"
                       << "  --log <path>          Log output file path\n"
-                      << "  --state-log <path>    Sim-state log file (desync debugging)\n"
+                      << "  --state-log <path>    Sim-state log file, read with rwe_statelog (desync debugging)\n"
+                      << "  --record-replay <path> Record the game to a replay file\n"
                       << "  --width <pixels>      Window width (default: 800)\n"
                       << "  --height <pixels>     Window height (default: 600)\n"
                       << "  --fullscreen          Start in fullscreen mode\n"
@@ -549,6 +551,10 @@ int main(int argc, char* argv[])
                 {
                     gameParameters->stateLogFile = args.getString("state-log");
                 }
+                if (args.contains("record-replay"))
+                {
+                    gameParameters->replayFile = args.getString("record-replay");
+                }
                 gameParameters->localNetworkPort = args.getString("port", "1337");
                 unsigned int playerIndex = 0;
                 if (players.size() > 10)
@@ -0,0 +1,112 @@
+#include "GafCache.h"
+#include <rwe/io/gaf/gaf_util.h>
+#include <rwe/util/rwe_string.h>
+
+namespace rwe
+{
+    GafCache::CachedGaf::CachedGaf(std::vector<char>&& bytes)
+        : bytes(std::move(bytes)),
+          stream(this->bytes.data(), this->bytes.size()),
+          archive(&stream)
+    {
+        const auto& archiveEntries = archive.entries();
+        for (std::size_t i = 0; i < archiveEntries.size(); ++i)
+        {
+            // the first entry with a name wins, as in GafArchive::findEntry
+            entryIndices.try_emplace(toUpper(archiveEntries[i].name), i);
+        }
+    }
+
+    const std::vector<GafArchive::Entry>& GafCache::CachedGaf::entries() const
+    {
+        return archive.entries();
+    }
+
+    std::optional<std::reference_wrapper<const GafArchive::Entry>> GafCache::CachedGaf::findEntry(const std::string& name) const
+    {
+        auto it = entryIndices.find(toUpper(name));
+        if (it == entryIndices.end())
+        {
+            return std::nullopt;
+        }
+
+        return archive.entries()[it->second];
+    }
+
+    void GafCache::CachedGaf::extract(const GafArchive::Entry& entry, GafReaderAdapter& adapter) const
+    {
+        SpanStream entryStream(bytes.data(), bytes.size());
+        extractGafEntry(&entryStream, entry.frameOffsets, adapter);
+    }
+
+    std::size_t GafCache::CachedGaf::byteSize() const
+    {
+        return bytes.size();
+    }
+
+    GafCache::GafCache(AbstractVirtualFileSystem* fileSystem, std::size_t byteBudget)
+        : fileSystem(fileSystem), byteBudget(byteBudget)
+    {
+    }
+
+    std::optional<std::shared_ptr<GafCache::CachedGaf>> GafCache::getGaf(const std::string& path)
+    {
+        auto key = toUpper(path);
+
+        auto it = itemsByKey.find(key);
+        if (it != itemsByKey.end())
+        {
+            items.splice(items.begin(), items, it->second);
+            if (!it->second->gaf)
+            {
+                return std::nullopt;
+            }
+            return it->second->gaf;
+        }
+
+        std::shared_ptr<CachedGaf> gaf;
+        auto bytes = fileSystem->readFile(path);
+        if (bytes)
+        {
+            gaf = std::make_shared<CachedGaf>(std::move(*bytes));
+            cachedBytes += gaf->byteSize();
+        }
+
+        items.push_front(CacheItem{key, gaf});
+        itemsByKey.insert({std::move(key), items.begin()});
+        evict();
+
+        if (!gaf)
+        {
+            return std::nullopt;
+        }
+        return gaf;
+    }
+
+    std::size_t GafCache::getCachedBytes() const
+    {
+        return cachedBytes;
+    }
+
+    void GafCache::clear()
+    {
+        itemsByKey.clear();
+        items.clear();
+        cachedBytes = 0;
+    }
+
+    void GafCache::evict()
+    {
+        // never evict the most recent archive, even if it alone exceeds the budget
+        while (cachedBytes > byteBudget && items.size() > 1)
+        {
+            const auto& item = items.back();
+            if (item.gaf)
+            {
+                cachedBytes -= item.gaf->byteSize();
+            }
+            itemsByKey.erase(item.key);
+            items.pop_back();
+        }
+    }
+}
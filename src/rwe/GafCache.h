@@ -0,0 +1,81 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <rwe/io/gaf/GafArchive.h>
+#include <rwe/util/SpanStream.h>
+#include <rwe/vfs/AbstractVirtualFileSystem.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * Keeps parsed GAF archives in memory, keyed case-insensitively by path,
+     * so that extracting many entries from one GAF reads and parses it only once.
+     * The most recently used archives are kept up to a budget of file bytes.
+     */
+    class GafCache
+    {
+    public:
+        class CachedGaf
+        {
+        private:
+            std::vector<char> bytes;
+            SpanStream stream;
+            GafArchive archive;
+
+            /** Keyed by upper-case entry name. */
+            std::unordered_map<std::string, std::size_t> entryIndices;
+
+        public:
+            explicit CachedGaf(std::vector<char>&& bytes);
+
+            const std::vector<GafArchive::Entry>& entries() const;
+
+            std::optional<std::reference_wrapper<const GafArchive::Entry>> findEntry(const std::string& name) const;
+
+            /** Reads from its own stream, so it may be called from several threads at once. */
+            void extract(const GafArchive::Entry& entry, GafReaderAdapter& adapter) const;
+
+            std::size_t byteSize() const;
+        };
+
+    private:
+        struct CacheItem
+        {
+            std::string key;
+
+            /** Null if the file does not exist. */
+            std::shared_ptr<CachedGaf> gaf;
+        };
+
+        AbstractVirtualFileSystem* fileSystem;
+        std::size_t byteBudget;
+        std::size_t cachedBytes{0};
+
+        /** Most recently used first. */
+        std::list<CacheItem> items;
+        std::unordered_map<std::string, std::list<CacheItem>::iterator> itemsByKey;
+
+    public:
+        GafCache(AbstractVirtualFileSystem* fileSystem, std::size_t byteBudget);
+
+        /**
+         * Returns the parsed archive, reading it from the filesystem if it is not cached.
+         * Returns empty if there is no such file.
+         * The archive stays valid while it is held, even once it is evicted.
+         */
+        std::optional<std::shared_ptr<CachedGaf>> getGaf(const std::string& path);
+
+        std::size_t getCachedBytes() const;
+
+        void clear();
+
+    private:
+        void evict();
+    };
+}
@@ -0,0 +1,146 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <rwe/GafCache.h>
+#include <rwe/io/gaf/gaf_headers.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rwe
+{
+    /** Serves files from memory and counts how often each is read. */
+    class GafCacheTestFileSystem final : public AbstractVirtualFileSystem
+    {
+    public:
+        std::unordered_map<std::string, std::vector<char>> files;
+        mutable std::unordered_map<std::string, unsigned int> readCounts;
+
+        std::optional<std::vector<char>> readFile(const std::string& filename) const override
+        {
+            ++readCounts[filename];
+            auto it = files.find(filename);
+            if (it == files.end())
+            {
+                return std::nullopt;
+            }
+            return it->second;
+        }
+
+        std::vector<std::string> getFileNames(const std::string&, const std::string&) override
+        {
+            return std::vector<std::string>();
+        }
+
+        std::vector<std::string> getDirectoryNames(const std::string&) override
+        {
+            return std::vector<std::string>();
+        }
+
+        std::vector<std::string> getFileNamesRecursive(const std::string&, const std::string&) override
+        {
+            return std::vector<std::string>();
+        }
+    };
+
+    template <typename T>
+    void appendGafTestRaw(std::vector<char>& out, const T& value)
+    {
+        auto p = reinterpret_cast<const char*>(&value);
+        out.insert(out.end(), p, p + sizeof(T));
+    }
+
+    /** A GAF whose entries have no frames, padded to the given size. */
+    std::vector<char> createGafTestData(const std::vector<std::string>& entryNames, std::size_t size)
+    {
+        std::vector<char> out;
+        appendGafTestRaw(out, GafHeader{GafVersionNumber, static_cast<uint32_t>(entryNames.size()), 0});
+
+        auto entriesStart = sizeof(GafHeader) + (entryNames.size() * sizeof(uint32_t));
+        for (std::size_t i = 0; i < entryNames.size(); ++i)
+        {
+            appendGafTestRaw(out, static_cast<uint32_t>(entriesStart + (i * sizeof(GafEntry))));
+        }
+
+        for (const auto& name : entryNames)
+        {
+            GafEntry entry{0, 0, 0, {}};
+            std::memcpy(entry.name, name.data(), name.size());
+            appendGafTestRaw(out, entry);
+        }
+
+        out.resize(std::max(out.size(), size));
+        return out;
+    }
+
+    TEST_CASE("GafCache")
+    {
+        GafCacheTestFileSystem vfs;
+        vfs.files["anims/fx.gaf"] = createGafTestData({"smoke 1", "Smoke 2", "radlogo"}, 1000);
+        vfs.files["anims/other.gaf"] = createGafTestData({"boom"}, 1000);
+        vfs.files["anims/third.gaf"] = createGafTestData({"bang"}, 1000);
+
+        SECTION("reads each archive once")
+        {
+            GafCache cache(&vfs, 10000);
+
+            auto gaf = cache.getGaf("anims/fx.gaf");
+            REQUIRE(gaf);
+            REQUIRE((*gaf)->entries().size() == 3);
+            REQUIRE(cache.getGaf("anims/fx.gaf") == gaf);
+            REQUIRE(vfs.readCounts["anims/fx.gaf"] == 1);
+            REQUIRE(cache.getCachedBytes() == 1000);
+        }
+
+        SECTION("finds entries case-insensitively")
+        {
+            GafCache cache(&vfs, 10000);
+            auto gaf = *cache.getGaf("anims/fx.gaf");
+
+            REQUIRE(gaf->findEntry("SMOKE 1"));
+            REQUIRE(gaf->findEntry("smoke 2")->get().name == "Smoke 2");
+            REQUIRE(!gaf->findEntry("smoke 3"));
+        }
+
+        SECTION("remembers missing files")
+        {
+            GafCache cache(&vfs, 10000);
+            REQUIRE(!cache.getGaf("anims/missing.gaf"));
+            REQUIRE(!cache.getGaf("anims/missing.gaf"));
+            REQUIRE(vfs.readCounts["anims/missing.gaf"] == 1);
+        }
+
+        SECTION("evicts the least recently used archive when over budget")
+        {
+            GafCache cache(&vfs, 2000);
+
+            auto fx = cache.getGaf("anims/fx.gaf");
+            cache.getGaf("anims/other.gaf");
+            cache.getGaf("anims/fx.gaf");
+            cache.getGaf("anims/third.gaf");
+            REQUIRE(cache.getCachedBytes() == 2000);
+
+            // other.gaf was used least recently, so it is read again
+            cache.getGaf("anims/fx.gaf");
+            REQUIRE(vfs.readCounts["anims/fx.gaf"] == 1);
+            cache.getGaf("anims/other.gaf");
+            REQUIRE(vfs.readCounts["anims/other.gaf"] == 2);
+
+            // evicted archives stay usable by those holding them
+            cache.clear();
+            REQUIRE((*fx)->findEntry("radlogo"));
+        }
+
+        SECTION("keeps an archive bigger than the budget until the next is read")
+        {
+            GafCache cache(&vfs, 500);
+            cache.getGaf("anims/fx.gaf");
+            cache.getGaf("anims/fx.gaf");
+            REQUIRE(vfs.readCounts["anims/fx.gaf"] == 1);
+
+            cache.getGaf("anims/other.gaf");
+            REQUIRE(cache.getCachedBytes() == 1000);
+            cache.getGaf("anims/fx.gaf");
+            REQUIRE(vfs.readCounts["anims/fx.gaf"] == 2);
+        }
+    }
+}
@@ -1,5 +1,6 @@
 #include "LoadingScene.h"
 #include <algorithm>
+#include <cassert>
 #include <rwe/util/SpanStream.h>
 #include <rwe/LoadingScene_util.h>
 #include <rwe/atlas_util.h>
@@ -7,6 +8,8 @@
 #include <rwe/game/FeatureMediaInfo.h>
 #include <rwe/game/GameNetworkService.h>
 #include <rwe/game/MapTerrainGraphics.h>
+#include <rwe/game/Replay.h>
+#include <rwe/game/StateLog.h>
 #include <rwe/geometry/CollisionMesh.h>
 #include <rwe/io/fbi/io.h>
 #include <rwe/io/featuretdf/io.h>
@@ -19,6 +22,7 @@
 #include <rwe/sim/FeatureDefinitionId.h>
 #include <rwe/ui/UiLabel.h>
 #include <rwe/util/Index.h>
+#include <rwe/util/JobBatch.h>
 
 namespace rwe
 {
@@ -146,7 +150,7 @@ namespace rwe
 
     std::unique_ptr<GameScene> LoadingScene::createGameScene(const std::string& mapName, unsigned int schemaIndex)
     {
-        auto atlasInfo = createTextureAtlases(sceneContext.vfs, sceneContext.graphics, sceneContext.palette);
+        auto atlasInfo = createTextureAtlases(sceneContext.vfs, &sceneContext.textureService->getGafCache(), sceneContext.graphics, sceneContext.palette);
         MeshService meshService(sceneContext.vfs, sceneContext.graphics, std::move(atlasInfo.textureAtlasMap), std::move(atlasInfo.teamTextureAtlasMap), std::move(atlasInfo.colorAtlasMap));
 
         auto otaRaw = sceneContext.vfs->readFile(std::string("maps/").append(mapName).append(".ota"));
@@ -164,18 +168,22 @@ namespace rwe
             requiredFeatureNames.insert(f.second);
         }
 
-        auto dataMaps = loadDefinitions(meshService, requiredFeatureNames);
+        ThreadPool threadPool(ThreadPool::getDefaultThreadCount());
+        auto dataMaps = loadDefinitions(threadPool, meshService, requiredFeatureNames);
 
         auto movementClassCollisionService = createMovementClassCollisionService(mapInfo.terrain, dataMaps.movementClassDatabase);
 
         GameSimulation simulation(std::move(mapInfo.terrain), mapInfo.surfaceMetal, std::max(0, mapInfo.minWindSpeed), std::min(mapInfo.maxWindSpeed, MaxUtilizableWindSpeed));
 
         simulation.unitDefinitions = std::move(dataMaps.unitDefinitions);
+        simulation.unitNameIndex = std::move(dataMaps.unitNameIndex);
         simulation.weaponDefinitions = std::move(dataMaps.weaponDefinitions);
+        simulation.weaponNameIndex = std::move(dataMaps.weaponNameIndex);
+        simulation.resolveWeaponDamage();
         simulation.movementClassDatabase = std::move(dataMaps.movementClassDatabase);
         simulation.movementClassCollisionService = std::move(movementClassCollisionService);
         simulation.unitModelDefinitions = dataMaps.modelDefinitions;
-        simulation.unitScriptDefinitions = loadCobScripts(*sceneContext.vfs);
+        simulation.unitScriptDefinitions = loadCobScripts(*sceneContext.vfs, threadPool);
         simulation.featureDefinitions = std::move(dataMaps.featureDefinitions);
         simulation.featureNameIndex = std::move(dataMaps.featureNameIndex);
 
@@ -254,10 +262,21 @@ namespace rwe
 
         auto consoleFont = sceneContext.textureService->getFont("fonts/CONSOLE.FNT");
 
-        std::optional<std::ofstream> stateLogStream;
+        std::optional<StateLogWriter> stateLog;
         if (gameParameters.stateLogFile)
         {
-            stateLogStream = std::ofstream(*gameParameters.stateLogFile, std::ios::binary);
+            stateLog.emplace(std::make_unique<std::ofstream>(*gameParameters.stateLogFile, std::ios::binary));
+        }
+
+        std::optional<ReplayWriter> replayWriter;
+        if (gameParameters.replayFile)
+        {
+            auto replayStream = std::make_unique<std::ofstream>(*gameParameters.replayFile, std::ios::binary);
+            if (!*replayStream)
+            {
+                throw std::runtime_error("Failed to open replay file: " + *gameParameters.replayFile);
+            }
+            replayWriter.emplace(std::move(replayStream), createReplayHeader(mapName, schemaIndex, simulation));
         }
 
         auto gameScene = std::make_unique<GameScene>(
@@ -278,7 +297,8 @@ namespace rwe
             consoleFont,
             *localPlayerId,
             audioLookup,
-            std::move(stateLogStream));
+            std::move(stateLog),
+            std::move(replayWriter));
 
         const auto& schema = ota.schemas.at(schemaIndex);
 
@@ -436,7 +456,7 @@ namespace rwe
         return it->second;
     }
 
-    void LoadingScene::loadFeatureMedia(MeshService& meshService, std::unordered_map<std::string, UnitModelDefinition>& modelDefinitions, GameMediaDatabase& gameMediaDatabase, const FeatureTdf& tdf)
+    void LoadingScene::loadFeatureMedia(MeshService& meshService, std::unordered_map<std::string, MeshService::ParsedMesh>& parsedMeshes, std::unordered_map<std::string, UnitModelDefinition>& modelDefinitions, GameMediaDatabase& gameMediaDatabase, const FeatureTdf& tdf)
     {
         FeatureMediaInfo f;
 
@@ -450,7 +470,10 @@ namespace rwe
 
             if (modelDefinitions.find(normalizedObjectName) == modelDefinitions.end())
             {
-                auto meshInfo = meshService.loadProjectileMesh(normalizedObjectName);
+                auto parsedMesh = parsedMeshes.find(normalizedObjectName);
+                auto meshInfo = parsedMesh != parsedMeshes.end()
+                    ? meshService.createProjectileMesh(std::move(parsedMesh->second))
+                    : meshService.loadProjectileMesh(normalizedObjectName);
                 modelDefinitions.insert({normalizedObjectName, std::move(meshInfo.modelDefinition)});
                 for (const auto& m : meshInfo.pieceMeshes)
                 {
@@ -492,7 +515,7 @@ namespace rwe
         gameMediaDatabase.addFeature(std::move(f));
     }
 
-    void LoadingScene::loadFeature(MeshService& meshService, GameMediaDatabase& gameMediaDatabase, const std::unordered_map<std::string, FeatureTdf>& tdfs, DataMaps& dataMaps, const std::string& initialFeatureName)
+    void LoadingScene::loadFeature(const std::unordered_map<std::string, FeatureTdf>& tdfs, DataMaps& dataMaps, const std::string& initialFeatureName, std::vector<const FeatureTdf*>& loadedTdfs)
     {
         auto nextId = dataMaps.featureDefinitions.getNextId();
         std::unordered_map<std::string, FeatureDefinitionId> openSet{{toUpper(initialFeatureName), nextId}};
@@ -503,62 +526,16 @@ namespace rwe
 
             const auto& tdf = tdfs.at(toUpper(featureName));
 
-            FeatureDefinition f;
-
-            f.name = featureName;
-
-            f.footprintX = tdf.footprintX;
-            f.footprintZ = tdf.footprintZ;
-            f.height = SimScalar(tdf.height);
-
-            f.reclaimable = tdf.reclaimable;
-            f.autoreclaimable = tdf.autoreclaimable;
-            if (!tdf.featureReclamate.empty())
-            {
-                f.featureReclamate = getFeatureId(nextId, dataMaps.featureNameIndex, featuresToLoad, openSet, tdf.featureReclamate);
-            }
-            f.metal = tdf.metal;
-            f.energy = tdf.energy;
-
-            f.flamable = tdf.flamable;
-            if (!tdf.featureBurnt.empty())
-            {
-                f.featureBurnt = getFeatureId(nextId, dataMaps.featureNameIndex, featuresToLoad, openSet, tdf.featureBurnt);
-            }
-            f.burnMin = tdf.burnMin;
-            f.burnMax = tdf.burnMax;
-            f.sparkTime = tdf.sparkTime;
-            f.spreadChance = tdf.spreadChance;
-            f.burnWeapon = tdf.burnWeapon;
-
-            f.geothermal = tdf.geothermal;
-
-            f.hitDensity = tdf.hitDensity;
-
-            f.reproduce = tdf.reproduce;
-            f.reproduceArea = tdf.reproduceArea;
-
-            f.noDisplayInfo = tdf.noDisplayInfo;
-
-            f.permanent = tdf.permanent;
-
-            f.blocking = tdf.blocking;
-
-            f.indestructible = tdf.indestructible;
-            f.damage = tdf.damage;
-            if (!tdf.featureDead.empty())
-            {
-                f.featureDead = getFeatureId(nextId, dataMaps.featureNameIndex, featuresToLoad, openSet, tdf.featureDead);
-            }
+            auto f = parseFeatureDefinition(tdf, featureName, nextId, dataMaps.featureNameIndex, featuresToLoad, openSet);
 
             auto id = dataMaps.featureDefinitions.insert(f);
             dataMaps.featureNameIndex.insert({toUpper(featureName), id});
 
-            loadFeatureMedia(meshService, dataMaps.modelDefinitions, gameMediaDatabase, tdf);
+            loadedTdfs.push_back(&tdf);
         }
     }
 
-    LoadingScene::DataMaps LoadingScene::loadDefinitions(MeshService& meshService, const std::unordered_set<std::string>& requiredFeatures)
+    LoadingScene::DataMaps LoadingScene::loadDefinitions(ThreadPool& threadPool, MeshService& meshService, const std::unordered_set<std::string>& requiredFeatures)
     {
         DataMaps dataMaps;
 
@@ -619,56 +596,147 @@ namespace rwe
             }
         }
 
-        // read weapons
-        {
-            auto weaponFiles = sceneContext.vfs->getFileNames(sceneContext.pathMapping->weapons, ".tdf");
+        // The weapon, unit and feature files are read and parsed on the thread pool,
+        // in batches that each use only what the batches before them produced.
+        // Every job writes to its own slot and the slots are added to the databases
+        // on this thread in listing order, so the result does not depend on the number of threads.
+        // Anything that touches the graphics context or the audio service stays on this thread.
+        auto weaponFiles = sceneContext.vfs->getFileNames(sceneContext.pathMapping->weapons, ".tdf");
+        auto fbiFiles = sceneContext.vfs->getFileNames(sceneContext.pathMapping->units, ".fbi");
+        auto featureFiles = sceneContext.vfs->getFileNamesRecursive("features", ".tdf");
 
-            for (const auto& fileName : weaponFiles)
-            {
-                auto bytes = sceneContext.vfs->readFile(sceneContext.pathMapping->weapons + "/" + fileName);
-                if (!bytes)
+        std::vector<std::vector<std::pair<std::string, WeaponTdf>>> weaponTdfs(weaponFiles.size());
+        std::vector<std::optional<UnitFbi>> fbis(fbiFiles.size());
+        std::vector<std::vector<std::pair<std::string, FeatureTdf>>> featureFileTdfs(featureFiles.size());
+
+        JobBatch batch;
+        for (std::size_t i = 0; i < weaponFiles.size(); ++i)
+        {
+            batch.add([&, i]() {
+                weaponTdfs[i] = parseWeaponTdf(readTdf(*sceneContext.vfs, sceneContext.pathMapping->weapons + "/" + weaponFiles[i]));
+            });
+        }
+        for (std::size_t i = 0; i < fbiFiles.size(); ++i)
+        {
+            batch.add([&, i]() {
+                fbis[i] = parseUnitFbi(readTdf(*sceneContext.vfs, sceneContext.pathMapping->units + "/" + fbiFiles[i]));
+            });
+        }
+        for (std::size_t i = 0; i < featureFiles.size(); ++i)
+        {
+            batch.add([&, i]() {
+                auto tdfRoot = readTdf(*sceneContext.vfs, "features/" + featureFiles[i]);
+                for (const auto& e : tdfRoot.blocks)
                 {
-                    throw std::runtime_error("File in listing could not be read: " + fileName);
+                    featureFileTdfs[i].emplace_back(toUpper(e.first), parseFeatureTdf(*e.second));
                 }
+            });
+        }
+        batch.run(threadPool);
 
-                std::string tdfString(bytes->data(), bytes->size());
-                auto entries = parseWeaponTdf(parseTdfFromString(tdfString));
+        struct LoadedWeapon
+        {
+            WeaponDefinition definition;
+            WeaponMediaInfo mediaInfo;
+            std::optional<MeshService::ParsedMesh> mesh;
+        };
 
-                for (auto& pair : entries)
-                {
-                    auto weaponDefinition = parseWeaponDefinition(pair.second);
-                    auto weaponMediaInfo = parseWeaponMediaInfo(*sceneContext.palette, *sceneContext.guiPalette, pair.second);
+        std::vector<LoadedWeapon> weapons;
+        for (auto& fileTdfs : weaponTdfs)
+        {
+            for (auto& pair : fileTdfs)
+            {
+                auto weaponDefinition = parseWeaponDefinition(pair.first, pair.second);
+                auto weaponMediaInfo = parseWeaponMediaInfo(*sceneContext.palette, *sceneContext.guiPalette, pair.second);
+                weapons.push_back(LoadedWeapon{std::move(weaponDefinition), std::move(weaponMediaInfo), std::nullopt});
+            }
+        }
 
-                    preloadSound(dataMaps.gameMediaDatabase, weaponMediaInfo.soundStart);
-                    preloadSound(dataMaps.gameMediaDatabase, weaponMediaInfo.soundHit);
-                    preloadSound(dataMaps.gameMediaDatabase, weaponMediaInfo.soundWater);
+        // models depend on the weapon TDFs and FBIs that name them
+        std::vector<std::optional<MeshService::ParsedMesh>> unitMeshes(fbis.size());
+        std::vector<std::optional<std::vector<std::vector<GuiEntry>>>> builderGuis(fbis.size());
+        for (auto& weapon : weapons)
+        {
+            if (auto modelRenderType = std::get_if<ProjectileRenderTypeModel>(&weapon.mediaInfo.renderType); modelRenderType != nullptr)
+            {
+                batch.add([&meshService, &weapon, objectName = modelRenderType->objectName]() {
+                    weapon.mesh = meshService.parseMesh(objectName);
+                });
+            }
+        }
+        for (std::size_t i = 0; i < fbis.size(); ++i)
+        {
+            batch.add([&, i]() {
+                unitMeshes[i] = meshService.parseMesh(fbis[i]->objectName);
+            });
 
-                    if (auto modelRenderType = std::get_if<ProjectileRenderTypeModel>(&weaponMediaInfo.renderType); modelRenderType != nullptr)
-                    {
-                        auto meshInfo = meshService.loadProjectileMesh(modelRenderType->objectName);
-                        dataMaps.modelDefinitions.insert({modelRenderType->objectName, std::move(meshInfo.modelDefinition)});
-                        for (const auto& m : meshInfo.pieceMeshes)
-                        {
-                            dataMaps.gameMediaDatabase.addUnitPieceMesh(modelRenderType->objectName, m.first, m.second);
-                        }
-                    }
+            // if it's a builder, also attempt to read its gui pages
+            if (fbis[i]->builder)
+            {
+                batch.add([&, i]() {
+                    builderGuis[i] = loadBuilderGui(fbis[i]->unitName);
+                });
+            }
+        }
+        batch.run(threadPool);
 
-                    if (weaponMediaInfo.explosionAnim)
-                    {
-                        auto anim = sceneContext.textureService->getGafEntry("anims/" + weaponMediaInfo.explosionAnim->gafName + ".gaf", weaponMediaInfo.explosionAnim->animName);
-                        dataMaps.gameMediaDatabase.addSpriteSeries(weaponMediaInfo.explosionAnim->gafName, weaponMediaInfo.explosionAnim->animName, anim);
-                    }
-                    if (weaponMediaInfo.waterExplosionAnim)
-                    {
-                        auto anim = sceneContext.textureService->getGafEntry("anims/" + weaponMediaInfo.waterExplosionAnim->gafName + ".gaf", weaponMediaInfo.waterExplosionAnim->animName);
-                        dataMaps.gameMediaDatabase.addSpriteSeries(weaponMediaInfo.waterExplosionAnim->gafName, weaponMediaInfo.waterExplosionAnim->animName, anim);
-                    }
+        // decode the sprites weapons use before uploading them below
+        {
+            std::vector<std::pair<std::string, std::string>> gafEntries;
+            for (const auto& weapon : weapons)
+            {
+                if (weapon.mediaInfo.explosionAnim)
+                {
+                    gafEntries.emplace_back("anims/" + weapon.mediaInfo.explosionAnim->gafName + ".gaf", weapon.mediaInfo.explosionAnim->animName);
+                }
+                if (weapon.mediaInfo.waterExplosionAnim)
+                {
+                    gafEntries.emplace_back("anims/" + weapon.mediaInfo.waterExplosionAnim->gafName + ".gaf", weapon.mediaInfo.waterExplosionAnim->animName);
+                }
+            }
+            for (const auto& animName : {"smoke 1", "smoke 2", "cannonshell", "plasmasm", "plasmamd", "ultrashell", "flamestream"})
+            {
+                gafEntries.emplace_back("anims/FX.GAF", animName);
+            }
+            sceneContext.textureService->preloadGafEntries(threadPool, gafEntries);
+        }
+
+        // add weapons
+        for (auto& weapon : weapons)
+        {
+            auto& weaponMediaInfo = weapon.mediaInfo;
 
-                    dataMaps.gameMediaDatabase.addWeapon(toUpper(pair.first), std::move(weaponMediaInfo));
+            preloadSound(dataMaps.gameMediaDatabase, weaponMediaInfo.soundStart);
+            preloadSound(dataMaps.gameMediaDatabase, weaponMediaInfo.soundHit);
+            preloadSound(dataMaps.gameMediaDatabase, weaponMediaInfo.soundWater);
 
-                    dataMaps.weaponDefinitions.insert({toUpper(pair.first), std::move(weaponDefinition)});
+            if (auto modelRenderType = std::get_if<ProjectileRenderTypeModel>(&weaponMediaInfo.renderType); modelRenderType != nullptr)
+            {
+                auto meshInfo = meshService.createProjectileMesh(std::move(*weapon.mesh));
+                dataMaps.modelDefinitions.insert({modelRenderType->objectName, std::move(meshInfo.modelDefinition)});
+                for (const auto& m : meshInfo.pieceMeshes)
+                {
+                    dataMaps.gameMediaDatabase.addUnitPieceMesh(modelRenderType->objectName, m.first, m.second);
                 }
             }
+
+            if (weaponMediaInfo.explosionAnim)
+            {
+                auto anim = sceneContext.textureService->getGafEntry("anims/" + weaponMediaInfo.explosionAnim->gafName + ".gaf", weaponMediaInfo.explosionAnim->animName);
+                dataMaps.gameMediaDatabase.addSpriteSeries(weaponMediaInfo.explosionAnim->gafName, weaponMediaInfo.explosionAnim->animName, anim);
+            }
+            if (weaponMediaInfo.waterExplosionAnim)
+            {
+                auto anim = sceneContext.textureService->getGafEntry("anims/" + weaponMediaInfo.waterExplosionAnim->gafName + ".gaf", weaponMediaInfo.waterExplosionAnim->animName);
+                dataMaps.gameMediaDatabase.addSpriteSeries(weaponMediaInfo.waterExplosionAnim->gafName, weaponMediaInfo.waterExplosionAnim->animName, anim);
+            }
+
+            // weapon media shares its ids with the weapon definitions
+            if (auto weaponId = addWeaponDefinition(dataMaps.weaponDefinitions, dataMaps.weaponNameIndex, std::move(weapon.definition)))
+            {
+                auto mediaId = dataMaps.gameMediaDatabase.addWeapon(std::move(weaponMediaInfo));
+                assert(mediaId == *weaponId);
+            }
         }
 
         std::unordered_set<std::string> requiredFeaturesSet;
@@ -677,82 +745,101 @@ namespace rwe
             requiredFeaturesSet.insert(toUpper(f));
         }
 
-        // read unit FBIs
+        // add units
+        for (std::size_t i = 0; i < fbis.size(); ++i)
         {
-            auto fbis = sceneContext.vfs->getFileNames(sceneContext.pathMapping->units, ".fbi");
-
-            for (const auto& fbiName : fbis)
-            {
-                auto bytes = sceneContext.vfs->readFile(sceneContext.pathMapping->units + "/" + fbiName);
-                if (!bytes)
-                {
-                    throw std::runtime_error("File in listing could not be read: " + fbiName);
-                }
+            const auto& fbi = *fbis[i];
 
-                std::string fbiString(bytes->data(), bytes->size());
-                auto fbi = parseUnitFbi(parseTdfFromString(fbiString));
+            auto unitDefinition = parseUnitDefinition(fbi, dataMaps.movementClassDatabase);
+            addUnitDefinition(dataMaps.unitDefinitions, dataMaps.unitNameIndex, std::move(unitDefinition));
 
-                auto unitDefinition = parseUnitDefinition(fbi, dataMaps.movementClassDatabase);
-                dataMaps.unitDefinitions.insert({toUpper(fbi.unitName), std::move(unitDefinition)});
-
-                // if it's a builder, also attempt to read its gui pages
-                if (fbi.builder)
-                {
-                    auto guiPages = loadBuilderGui(fbi.unitName);
-                    if (guiPages)
-                    {
-                        dataMaps.builderGuisDatabase.addBuilderGui(fbi.unitName, std::move(*guiPages));
-                    }
+            if (builderGuis[i])
+            {
+                dataMaps.builderGuisDatabase.addBuilderGui(fbi.unitName, std::move(*builderGuis[i]));
+            }
 
-                    // TODO: if no gui defined, attempt to build it dynamically?
-                    // Need a database of download.tdf mappings first...
-                }
+            // TODO: if no gui defined, attempt to build it dynamically?
+            // Need a database of download.tdf mappings first...
 
-                auto meshInfo = meshService.loadUnitMesh(fbi.objectName);
-                dataMaps.modelDefinitions.insert({toUpper(fbi.objectName), std::move(meshInfo.modelDefinition)});
-                for (const auto& m : meshInfo.pieceMeshes)
-                {
-                    dataMaps.gameMediaDatabase.addUnitPieceMesh(fbi.objectName, m.first, m.second);
-                }
+            auto meshInfo = meshService.createUnitMesh(std::move(*unitMeshes[i]));
+            dataMaps.modelDefinitions.insert({toUpper(fbi.objectName), std::move(meshInfo.modelDefinition)});
+            for (const auto& m : meshInfo.pieceMeshes)
+            {
+                dataMaps.gameMediaDatabase.addUnitPieceMesh(fbi.objectName, m.first, m.second);
+            }
 
-                dataMaps.gameMediaDatabase.addSelectionCollisionMesh(fbi.objectName, std::make_shared<CollisionMesh>(std::move(meshInfo.selectionMesh.collisionMesh)));
-                dataMaps.gameMediaDatabase.addSelectionMesh(fbi.objectName, std::make_shared<GlMesh>(std::move(meshInfo.selectionMesh.visualMesh)));
+            dataMaps.gameMediaDatabase.addSelectionCollisionMesh(fbi.objectName, std::make_shared<CollisionMesh>(std::move(meshInfo.selectionMesh.collisionMesh)));
+            dataMaps.gameMediaDatabase.addSelectionMesh(fbi.objectName, std::make_shared<GlMesh>(std::move(meshInfo.selectionMesh.visualMesh)));
 
-                if (!fbi.corpse.empty())
-                {
-                    requiredFeaturesSet.insert(toUpper(fbi.corpse));
-                }
+            if (!fbi.corpse.empty())
+            {
+                requiredFeaturesSet.insert(toUpper(fbi.corpse));
             }
         }
 
-        // read feature TDFs
+        // add features
         {
-            auto files = sceneContext.vfs->getFileNamesRecursive("features", ".tdf");
-
             std::unordered_map<std::string, FeatureTdf> featureTdfs;
-
-            for (const auto& name : files)
+            for (auto& fileTdfs : featureFileTdfs)
             {
-                auto bytes = sceneContext.vfs->readFile("features/" + name);
-                if (!bytes)
+                for (auto& pair : fileTdfs)
                 {
-                    throw std::runtime_error("Failed to read feature " + name);
+                    featureTdfs.insert(std::move(pair));
                 }
+            }
 
-                std::string tdfString(bytes->data(), bytes->size());
+            // actually parse the features that we require
+            std::vector<const FeatureTdf*> loadedFeatureTdfs;
+            for (const auto& featureName : requiredFeaturesSet)
+            {
+                loadFeature(featureTdfs, dataMaps, featureName, loadedFeatureTdfs);
+            }
 
-                auto tdfRoot = parseTdfFromString(tdfString);
-                for (const auto& e : tdfRoot.blocks)
+            // then load their assets, parsing models and decoding sprites on the thread pool
+            std::unordered_map<std::string, MeshService::ParsedMesh> featureMeshes;
+            std::vector<std::string> featureMeshNames;
+            std::unordered_set<std::string> featureMeshNameSet;
+            std::vector<std::pair<std::string, std::string>> gafEntries;
+            for (const auto* tdf : loadedFeatureTdfs)
+            {
+                if (!tdf->object.empty())
+                {
+                    auto normalizedObjectName = toUpper(tdf->object);
+                    if (dataMaps.modelDefinitions.find(normalizedObjectName) == dataMaps.modelDefinitions.end() && featureMeshNameSet.insert(normalizedObjectName).second)
+                    {
+                        featureMeshNames.push_back(normalizedObjectName);
+                    }
+                    continue;
+                }
+
+                if (!tdf->fileName.empty() && !tdf->seqName.empty())
+                {
+                    gafEntries.emplace_back("anims/" + tdf->fileName + ".GAF", tdf->seqName);
+                }
+                if (!tdf->fileName.empty() && !tdf->seqNameShad.empty())
                 {
-                    auto featureTdf = parseFeatureTdf(*e.second);
-                    featureTdfs.insert({toUpper(e.first), featureTdf});
+                    gafEntries.emplace_back("anims/" + tdf->fileName + ".GAF", tdf->seqNameShad);
                 }
             }
 
-            // actually parse and load assets for features that we require
-            for (const auto& featureName : requiredFeaturesSet)
+            std::vector<std::optional<MeshService::ParsedMesh>> parsedFeatureMeshes(featureMeshNames.size());
+            for (std::size_t i = 0; i < featureMeshNames.size(); ++i)
+            {
+                batch.add([&, i]() {
+                    parsedFeatureMeshes[i] = meshService.parseMesh(featureMeshNames[i]);
+                });
+            }
+            batch.run(threadPool);
+            for (std::size_t i = 0; i < featureMeshNames.size(); ++i)
+            {
+                featureMeshes.insert({featureMeshNames[i], std::move(*parsedFeatureMeshes[i])});
+            }
+
+            sceneContext.textureService->preloadGafEntries(threadPool, gafEntries);
+
+            for (const auto* tdf : loadedFeatureTdfs)
             {
-                loadFeature(meshService, dataMaps.gameMediaDatabase, featureTdfs, dataMaps, featureName);
+                loadFeatureMedia(meshService, featureMeshes, dataMaps.modelDefinitions, dataMaps.gameMediaDatabase, *tdf);
             }
         }
 
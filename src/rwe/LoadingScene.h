@@ -22,6 +22,7 @@
 #include <rwe/ui/UiFactory.h>
 #include <rwe/ui/UiLightBar.h>
 #include <rwe/ui/UiPanel.h>
+#include <rwe/util/ThreadPool.h>
 #include <rwe/MeshService.h>
 
 namespace rwe
@@ -82,6 +83,7 @@ namespace rwe
         std::array<std::optional<PlayerInfo>, 10> players;
         std::string localNetworkPort{"1337"};
         std::optional<std::string> stateLogFile;
+        std::optional<std::string> replayFile;
 
         GameParameters(const std::string& mapName, unsigned int schemaIndex);
     };
@@ -144,14 +146,16 @@ namespace rwe
             BuilderGuisDatabase builderGuisDatabase;
             GameMediaDatabase gameMediaDatabase;
             MovementClassDatabase movementClassDatabase;
-            std::unordered_map<std::string, UnitDefinition> unitDefinitions;
+            SimpleVectorMap<UnitDefinition, UnitDefinitionIdTag> unitDefinitions;
+            std::unordered_map<std::string, UnitDefinitionId> unitNameIndex;
             std::unordered_map<std::string, UnitModelDefinition> modelDefinitions;
-            std::unordered_map<std::string, WeaponDefinition> weaponDefinitions;
+            SimpleVectorMap<WeaponDefinition, WeaponDefinitionIdTag> weaponDefinitions;
+            std::unordered_map<std::string, WeaponDefinitionId> weaponNameIndex;
             SimpleVectorMap<FeatureDefinition, FeatureDefinitionIdTag> featureDefinitions;
             std::unordered_map<std::string, FeatureDefinitionId> featureNameIndex;
         };
 
-        DataMaps loadDefinitions(MeshService& meshService, const std::unordered_set<std::string>& requiredFeatures);
+        DataMaps loadDefinitions(ThreadPool& threadPool, MeshService& meshService, const std::unordered_set<std::string>& requiredFeatures);
 
         void preloadSound(GameMediaDatabase& meshDb, const std::string& soundName);
 
@@ -161,7 +165,12 @@ namespace rwe
 
         std::optional<std::vector<std::vector<GuiEntry>>> loadBuilderGui(const std::string& unitName);
 
-        void loadFeature(MeshService& meshService, GameMediaDatabase& gameMediaDatabase, const std::unordered_map<std::string, FeatureTdf>& tdfs, DataMaps& dataMaps, const std::string& initialFeatureName);
-        void loadFeatureMedia(MeshService& meshService, std::unordered_map<std::string, UnitModelDefinition>& modelDefinitions, GameMediaDatabase& gameMediaDatabase, const FeatureTdf& tdf);
+        /**
+         * Adds the definition of the feature and the features it turns into.
+         * Appends the TDF of each feature added to loadedTdfs, in id order,
+         * so that their media can be loaded afterwards.
+         */
+        void loadFeature(const std::unordered_map<std::string, FeatureTdf>& tdfs, DataMaps& dataMaps, const std::string& initialFeatureName, std::vector<const FeatureTdf*>& loadedTdfs);
+        void loadFeatureMedia(MeshService& meshService, std::unordered_map<std::string, MeshService::ParsedMesh>& parsedMeshes, std::unordered_map<std::string, UnitModelDefinition>& modelDefinitions, GameMediaDatabase& gameMediaDatabase, const FeatureTdf& tdf);
     };
 }
@@ -1,8 +1,9 @@
 #include "LoadingScene_util.h"
 #include <algorithm>
 
-#include <rwe/util/SpanStream.h>
+#include <rwe/io/tdf/tdf.h>
 #include <rwe/sim/UnitState.h>
+#include <rwe/util/SpanStream.h>
 
 namespace rwe
 {
@@ -17,26 +18,36 @@ namespace rwe
     }
 
 
-    std::unordered_map<std::string, CobScript> loadCobScripts(AbstractVirtualFileSystem& vfs)
+    TdfBlock readTdf(const AbstractVirtualFileSystem& vfs, const std::string& path)
     {
-        std::unordered_map<std::string, CobScript> output;
+        auto bytes = vfs.readFileOrThrow(path);
+        std::string tdfString(bytes.data(), bytes.size());
+        return parseTdfFromString(tdfString);
+    }
 
+    std::unordered_map<std::string, CobProgram> loadCobScripts(AbstractVirtualFileSystem& vfs, ThreadPool& threadPool)
+    {
         auto scripts = vfs.getFileNames("scripts", ".cob");
 
-        for (const auto& scriptName : scripts)
-        {
-            auto bytes = vfs.readFile("scripts/" + scriptName);
+        std::vector<std::optional<CobProgram>> programs(scripts.size());
+        threadPool.parallelFor(scripts.size(), [&](std::size_t i, unsigned int) {
+            auto bytes = vfs.readFile("scripts/" + scripts[i]);
             if (!bytes)
             {
-                throw std::runtime_error("File in listing could not be read: " + scriptName);
+                throw std::runtime_error("File in listing could not be read: " + scripts[i]);
             }
 
             rwe::SpanStream s(bytes->data(), bytes->size());
-            auto cob = parseCob(s);
+            programs[i] = compileCobScript(parseCob(s));
+        });
 
+        std::unordered_map<std::string, CobProgram> output;
+        for (std::size_t i = 0; i < scripts.size(); ++i)
+        {
+            const auto& scriptName = scripts[i];
             auto scriptNameWithoutExtension = scriptName.substr(0, scriptName.size() - 4);
 
-            output.insert({toUpper(scriptNameWithoutExtension), std::move(cob)});
+            output.insert({toUpper(scriptNameWithoutExtension), std::move(*programs[i])});
         }
 
         return output;
@@ -145,10 +156,12 @@ namespace rwe
         return mc;
     }
 
-    WeaponDefinition parseWeaponDefinition(const WeaponTdf& tdf)
+    WeaponDefinition parseWeaponDefinition(const std::string& weaponType, const WeaponTdf& tdf)
     {
         WeaponDefinition weaponDefinition;
 
+        weaponDefinition.weaponType = toUpper(weaponType);
+
         weaponDefinition.maxRange = SimScalar(tdf.range);
         weaponDefinition.reloadTime = SimScalar(tdf.reloadTime);
         weaponDefinition.tolerance = SimAngle(tdf.tolerance);
@@ -193,6 +206,19 @@ namespace rwe
         return weaponDefinition;
     }
 
+    std::optional<WeaponDefinitionId> addWeaponDefinition(SimpleVectorMap<WeaponDefinition, WeaponDefinitionIdTag>& weaponDefinitions, std::unordered_map<std::string, WeaponDefinitionId>& weaponNameIndex, WeaponDefinition&& weaponDefinition)
+    {
+        if (weaponNameIndex.find(weaponDefinition.weaponType) != weaponNameIndex.end())
+        {
+            return std::nullopt;
+        }
+
+        auto weaponType = weaponDefinition.weaponType;
+        auto id = weaponDefinitions.insert(std::move(weaponDefinition));
+        weaponNameIndex.insert({std::move(weaponType), id});
+        return id;
+    }
+
     std::optional<YardMapCell> parseYardMapCell(char c)
     {
         switch (c)
@@ -259,6 +285,7 @@ namespace rwe
 
         u.unitName = fbi.name;
         u.unitDescription = fbi.description;
+        u.unitType = toUpper(fbi.unitName);
         u.objectName = fbi.objectName;
 
         u.turnRate = SimScalar(fbi.turnRate);
@@ -354,6 +381,19 @@ namespace rwe
         return u;
     }
 
+    std::optional<UnitDefinitionId> addUnitDefinition(SimpleVectorMap<UnitDefinition, UnitDefinitionIdTag>& unitDefinitions, std::unordered_map<std::string, UnitDefinitionId>& unitNameIndex, UnitDefinition&& unitDefinition)
+    {
+        if (unitNameIndex.find(unitDefinition.unitType) != unitNameIndex.end())
+        {
+            return std::nullopt;
+        }
+
+        auto unitType = unitDefinition.unitType;
+        auto id = unitDefinitions.insert(std::move(unitDefinition));
+        unitNameIndex.insert({std::move(unitType), id});
+        return id;
+    }
+
     WeaponMediaInfo parseWeaponMediaInfo(const std::vector<Color>& palette, const std::vector<Color>& guiPalette, const WeaponTdf& tdf)
     {
         WeaponMediaInfo mediaInfo;
@@ -499,4 +539,57 @@ namespace rwe
         nextId = FeatureDefinitionId(nextId.value + 1);
         return id;
     }
+
+    FeatureDefinition parseFeatureDefinition(const FeatureTdf& tdf, const std::string& featureName, FeatureDefinitionId& nextId, const std::unordered_map<std::string, FeatureDefinitionId>& featureNameIndex, std::deque<std::string>& openQueue, std::unordered_map<std::string, FeatureDefinitionId>& openSet)
+    {
+        FeatureDefinition f;
+
+        f.name = featureName;
+
+        f.footprintX = tdf.footprintX;
+        f.footprintZ = tdf.footprintZ;
+        f.height = SimScalar(tdf.height);
+
+        f.reclaimable = tdf.reclaimable;
+        f.autoreclaimable = tdf.autoreclaimable;
+        if (!tdf.featureReclamate.empty())
+        {
+            f.featureReclamate = getFeatureId(nextId, featureNameIndex, openQueue, openSet, tdf.featureReclamate);
+        }
+        f.metal = tdf.metal;
+        f.energy = tdf.energy;
+
+        f.flamable = tdf.flamable;
+        if (!tdf.featureBurnt.empty())
+        {
+            f.featureBurnt = getFeatureId(nextId, featureNameIndex, openQueue, openSet, tdf.featureBurnt);
+        }
+        f.burnMin = tdf.burnMin;
+        f.burnMax = tdf.burnMax;
+        f.sparkTime = tdf.sparkTime;
+        f.spreadChance = tdf.spreadChance;
+        f.burnWeapon = tdf.burnWeapon;
+
+        f.geothermal = tdf.geothermal;
+
+        f.hitDensity = tdf.hitDensity;
+
+        f.reproduce = tdf.reproduce;
+        f.reproduceArea = tdf.reproduceArea;
+
+        f.noDisplayInfo = tdf.noDisplayInfo;
+
+        f.permanent = tdf.permanent;
+
+        f.blocking = tdf.blocking;
+
+        f.indestructible = tdf.indestructible;
+        f.damage = tdf.damage;
+        if (!tdf.featureDead.empty())
+        {
+            f.featureDead = getFeatureId(nextId, featureNameIndex, openQueue, openSet, tdf.featureDead);
+        }
+
+        return f;
+    }
 }
@@ -1,19 +1,28 @@
 #pragma once
 
 #include <deque>
+#include <optional>
 #include <rwe/ColorPalette.h>
+#include <rwe/collections/SimpleVectorMap.h>
+#include <rwe/cob/CobProgram.h>
 #include <rwe/game/WeaponMediaInfo.h>
 #include <rwe/io/cob/Cob.h>
 #include <rwe/io/fbi/UnitFbi.h>
+#include <rwe/io/featuretdf/FeatureTdf.h>
 #include <rwe/io/moveinfotdf/MovementClassTdf.h>
+#include <rwe/io/tdf/TdfBlock.h>
 #include <rwe/io/tnt/TntArchive.h>
 #include <rwe/io/weapontdf/WeaponTdf.h>
+#include <rwe/sim/FeatureDefinition.h>
 #include <rwe/sim/FeatureDefinitionId.h>
 #include <rwe/sim/MapTerrain.h>
 #include <rwe/sim/MovementClassCollisionService.h>
 #include <rwe/sim/MovementClassDatabase.h>
 #include <rwe/sim/UnitDefinition.h>
+#include <rwe/sim/UnitDefinitionId.h>
 #include <rwe/sim/WeaponDefinition.h>
+#include <rwe/sim/WeaponDefinitionId.h>
+#include <rwe/util/ThreadPool.h>
 #include <rwe/vfs/AbstractVirtualFileSystem.h>
 #include <unordered_map>
 
@@ -21,7 +30,11 @@ namespace rwe
 {
     MovementClassCollisionService createMovementClassCollisionService(const MapTerrain& terrain, const MovementClassDatabase& movementClassDatabase);
 
-    std::unordered_map<std::string, CobScript> loadCobScripts(AbstractVirtualFileSystem& vfs);
+    /** Reads and parses the TDF file, throwing if it cannot be read. */
+    TdfBlock readTdf(const AbstractVirtualFileSystem& vfs, const std::string& path);
+
+    /** Parses and compiles every unit script, on the thread pool. */
+    std::unordered_map<std::string, CobProgram> loadCobScripts(AbstractVirtualFileSystem& vfs, ThreadPool& threadPool);
 
     std::vector<std::string> getFeatureNames(TntArchive& tnt);
 
@@ -39,7 +52,13 @@ namespace rwe
 
     MovementClassDefinition parseMovementClassDefinition(const MovementClassTdf& tdf);
 
-    WeaponDefinition parseWeaponDefinition(const WeaponTdf& tdf);
+    WeaponDefinition parseWeaponDefinition(const std::string& weaponType, const WeaponTdf& tdf);
+
+    /**
+     * Adds the definition under its weapon type name and returns its new id,
+     * or returns nothing if a definition with that name was already added.
+     */
+    std::optional<WeaponDefinitionId> addWeaponDefinition(SimpleVectorMap<WeaponDefinition, WeaponDefinitionIdTag>& weaponDefinitions, std::unordered_map<std::string, WeaponDefinitionId>& weaponNameIndex, WeaponDefinition&& weaponDefinition);
 
     std::optional<YardMapCell> parseYardMapCell(char c);
 
@@ -49,7 +68,15 @@ namespace rwe
 
     UnitDefinition parseUnitDefinition(const UnitFbi& fbi, MovementClassDatabase& movementClassDatabase);
 
+    /**
+     * Adds the definition under its unit type name and returns its new id,
+     * or returns nothing if a definition with that name was already added.
+     */
+    std::optional<UnitDefinitionId> addUnitDefinition(SimpleVectorMap<UnitDefinition, UnitDefinitionIdTag>& unitDefinitions, std::unordered_map<std::string, UnitDefinitionId>& unitNameIndex, UnitDefinition&& unitDefinition);
+
     WeaponMediaInfo parseWeaponMediaInfo(const std::vector<Color>& palette, const std::vector<Color>& guiPalette, const WeaponTdf& tdf);
 
     FeatureDefinitionId getFeatureId(FeatureDefinitionId& nextId, const std::unordered_map<std::string, FeatureDefinitionId>& featureNameIndex, std::deque<std::string>& openQueue, std::unordered_map<std::string, FeatureDefinitionId>& openSet, const std::string& featureName);
+
+    FeatureDefinition parseFeatureDefinition(const FeatureTdf& tdf, const std::string& featureName, FeatureDefinitionId& nextId, const std::unordered_map<std::string, FeatureDefinitionId>& featureNameIndex, std::deque<std::string>& openQueue, std::unordered_map<std::string, FeatureDefinitionId>& openSet);
 }
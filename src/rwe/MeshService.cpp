@@ -22,7 +22,7 @@ namespace rwe
     {
     }
 
-    MeshService::UnitMeshInfo MeshService::loadUnitMesh(const std::string& name)
+    MeshService::ParsedMesh MeshService::parseMesh(const std::string& name) const
     {
         auto bytes = vfs->readFile("objects3d/" + name + ".3do");
         if (!bytes)
@@ -33,37 +33,39 @@ namespace rwe
         rwe::SpanStream s(bytes->data(), bytes->size());
         auto objects = parse3doObjects(s, s.tellg());
         assert(objects.size() == 1);
-        auto selectionMesh = selectionMeshFrom3do(*graphics, objects.front());
 
         auto d = createUnitModelDefinition(
             simScalarFromFixed(findHighestVertex(objects.front()).y),
             unitMeshFrom3do(objects.front()));
 
-        std::vector<std::pair<std::string, UnitPieceMeshInfo>> meshes;
-        extractMeshes(*graphics, atlasMap, teamAtlasMap, atlasColorMap, objects.front(), meshes);
+        return ParsedMesh{std::move(objects.front()), std::move(d)};
+    }
 
-        return UnitMeshInfo{std::move(d), std::move(meshes), std::move(selectionMesh)};
+    MeshService::UnitMeshInfo MeshService::loadUnitMesh(const std::string& name)
+    {
+        return createUnitMesh(parseMesh(name));
     }
 
-    MeshService::ProjectileMeshInfo MeshService::loadProjectileMesh(const std::string& name)
+    MeshService::UnitMeshInfo MeshService::createUnitMesh(ParsedMesh&& mesh)
     {
-        auto bytes = vfs->readFile("objects3d/" + name + ".3do");
-        if (!bytes)
-        {
-            throw std::runtime_error("Failed to load object bytes: " + name);
-        }
+        auto selectionMesh = selectionMeshFrom3do(*graphics, mesh.object);
 
-        rwe::SpanStream s(bytes->data(), bytes->size());
-        auto objects = parse3doObjects(s, s.tellg());
-        assert(objects.size() == 1);
+        std::vector<std::pair<std::string, UnitPieceMeshInfo>> meshes;
+        extractMeshes(*graphics, atlasMap, teamAtlasMap, atlasColorMap, mesh.object, meshes);
 
-        auto d = createUnitModelDefinition(
-            simScalarFromFixed(findHighestVertex(objects.front()).y),
-            unitMeshFrom3do(objects.front()));
+        return UnitMeshInfo{std::move(mesh.modelDefinition), std::move(meshes), std::move(selectionMesh)};
+    }
+
+    MeshService::ProjectileMeshInfo MeshService::loadProjectileMesh(const std::string& name)
+    {
+        return createProjectileMesh(parseMesh(name));
+    }
 
+    MeshService::ProjectileMeshInfo MeshService::createProjectileMesh(ParsedMesh&& mesh)
+    {
         std::vector<std::pair<std::string, UnitPieceMeshInfo>> meshes;
-        extractMeshes(*graphics, atlasMap, teamAtlasMap, atlasColorMap, objects.front(), meshes);
+        extractMeshes(*graphics, atlasMap, teamAtlasMap, atlasColorMap, mesh.object, meshes);
 
-        return ProjectileMeshInfo{std::move(d), std::move(meshes)};
+        return ProjectileMeshInfo{std::move(mesh.modelDefinition), std::move(meshes)};
     }
 }
@@ -39,8 +39,24 @@ namespace rwe
             SelectionMesh selectionMesh;
         };
 
+        /** A model read from its 3DO file, before anything is uploaded for it. */
+        struct ParsedMesh
+        {
+            _3do::Object object;
+            UnitModelDefinition modelDefinition;
+        };
+
+        /**
+         * Reads and parses the model.
+         * Does not touch the graphics context, so it may be called from worker threads.
+         */
+        ParsedMesh parseMesh(const std::string& name) const;
+
         UnitMeshInfo loadUnitMesh(const std::string& name);
 
+        /** Uploads the meshes for a unit. Must be called on the graphics thread. */
+        UnitMeshInfo createUnitMesh(ParsedMesh&& mesh);
+
         struct ProjectileMeshInfo
         {
             UnitModelDefinition modelDefinition;
@@ -48,5 +64,8 @@ namespace rwe
         };
 
         ProjectileMeshInfo loadProjectileMesh(const std::string& name);
+
+        /** Uploads the meshes for a projectile or feature. Must be called on the graphics thread. */
+        ProjectileMeshInfo createProjectileMesh(ParsedMesh&& mesh);
     };
 }
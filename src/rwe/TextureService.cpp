@@ -6,32 +6,40 @@
 #include <rwe/io/pcx/pcx.h>
 #include <rwe/io/tnt/TntArchive.h>
 #include <rwe/util/rwe_string.h>
+#include <unordered_set>
 
 namespace rwe
 {
-    class BufferGafAdapter : public GafReaderAdapter
+    /** The most file bytes of parsed GAF archives to keep in memory. */
+    constexpr std::size_t TextureServiceGafCacheBudget = 64 * 1024 * 1024;
+
+    /** A frame of a GAF entry, decoded to colors but not yet uploaded. */
+    struct DecodedGafFrame
+    {
+        GafFrameData header;
+        std::vector<Color> pixels;
+    };
+
+    /** Decodes frames without touching the graphics context, so it may run on worker threads. */
+    class DecodeGafAdapter : public GafReaderAdapter
     {
     private:
-        GraphicsContext* graphics;
         const ColorPalette* palette;
-        std::vector<Color> buffer;
-        GafFrameData currentFrameHeader;
-
-        SpriteSeries spriteSeries;
+        std::vector<DecodedGafFrame> frames;
 
     public:
-        explicit BufferGafAdapter(GraphicsContext* graphics, const ColorPalette* palette) : graphics(graphics), palette(palette), currentFrameHeader() {}
+        explicit DecodeGafAdapter(const ColorPalette* palette) : palette(palette) {}
 
         void beginFrame(const GafFrameEntry& entry, const GafFrameData& header) override
         {
-            buffer.clear();
-            buffer.resize(header.width * header.height);
-            std::fill(buffer.begin(), buffer.end(), Color::Transparent);
-            currentFrameHeader = header;
+            frames.push_back(DecodedGafFrame{header, std::vector<Color>(header.width * header.height, Color::Transparent)});
         }
 
         void frameLayer(const LayerData& data) override
         {
+            auto& currentFrame = frames.back();
+            const auto& currentFrameHeader = currentFrame.header;
+
             for (std::size_t y = 0; y < data.height; ++y)
             {
                 for (std::size_t x = 0; x < data.width; ++x)
@@ -53,35 +61,45 @@ namespace rwe
                         continue;
                     }
 
-                    buffer[(outPosY * currentFrameHeader.width) + outPosX] = (*palette)[colorIndex];
+                    currentFrame.pixels[(outPosY * currentFrameHeader.width) + outPosX] = (*palette)[colorIndex];
                 }
             }
         }
 
         void endFrame() override
         {
-            SharedTextureHandle handle(graphics->createTexture(currentFrameHeader.width, currentFrameHeader.height, buffer));
+        }
+
+        std::vector<DecodedGafFrame> extractFrames()
+        {
+            return std::move(frames);
+        }
+    };
+
+    /** Uploads the decoded frames as textures. Must be called on the graphics thread. */
+    SpriteSeries createGafSpriteSeries(GraphicsContext& graphics, std::vector<DecodedGafFrame>&& frames)
+    {
+        SpriteSeries spriteSeries;
+        for (auto& frame : frames)
+        {
+            SharedTextureHandle handle(graphics.createTexture(frame.header.width, frame.header.height, frame.pixels));
 
             auto bounds = Rectangle2f::fromTopLeft(
-                -currentFrameHeader.posX,
-                -currentFrameHeader.posY,
-                currentFrameHeader.width,
-                currentFrameHeader.height);
+                -frame.header.posX,
+                -frame.header.posY,
+                frame.header.width,
+                frame.header.height);
 
             auto region = Rectangle2f::fromTopLeft(0.0f, 0.0f, 1.0f, 1.0f);
 
-            auto sprite = std::make_shared<Sprite>(graphics->createSprite(bounds, region, handle));
+            auto sprite = std::make_shared<Sprite>(graphics.createSprite(bounds, region, handle));
             spriteSeries.sprites.push_back(std::move(sprite));
         }
-
-        SpriteSeries extractSpriteSeries()
-        {
-            return std::move(spriteSeries);
-        }
-    };
+        return spriteSeries;
+    }
 
     TextureService::TextureService(GraphicsContext* graphics, AbstractVirtualFileSystem* fileSystem, const ColorPalette* palette)
-        : graphics(graphics), fileSystem(fileSystem), palette(palette)
+        : graphics(graphics), fileSystem(fileSystem), palette(palette), gafCache(fileSystem, TextureServiceGafCacheBudget)
     {
         SharedTextureHandle handle(graphics->createColorTexture(Color(255, 0, 255)));
         auto sprite = graphics->createSprite(
@@ -105,28 +123,75 @@ namespace rwe
             return it->second;
         }
 
-        auto gafBytes = fileSystem->readFile(gafName);
-        if (!gafBytes)
+        auto gafArchive = gafCache.getGaf(gafName);
+        if (!gafArchive)
         {
             return std::nullopt;
         }
 
-        rwe::SpanStream gafStream(gafBytes->data(), gafBytes->size());
-        GafArchive gafArchive(&gafStream);
-
-        auto gafEntry = gafArchive.findEntry(normEntryName);
+        auto gafEntry = (*gafArchive)->findEntry(normEntryName);
         if (!gafEntry)
         {
             return std::nullopt;
         }
 
-        BufferGafAdapter adapter(graphics, palette);
-        gafArchive.extract(*gafEntry, adapter);
-        auto ptr = std::make_shared<SpriteSeries>(adapter.extractSpriteSeries());
+        DecodeGafAdapter adapter(palette);
+        (*gafArchive)->extract(*gafEntry, adapter);
+        auto ptr = std::make_shared<SpriteSeries>(createGafSpriteSeries(*graphics, adapter.extractFrames()));
         animCache[key] = ptr;
         return ptr;
     }
 
+    void TextureService::preloadGafEntries(ThreadPool& threadPool, const std::vector<std::pair<std::string, std::string>>& entries)
+    {
+        struct PendingEntry
+        {
+            std::string key;
+            std::shared_ptr<GafCache::CachedGaf> gaf;
+            const GafArchive::Entry* entry;
+            std::vector<DecodedGafFrame> frames;
+        };
+
+        // find the entries on this thread, since the GAF cache is not thread-safe
+        std::vector<PendingEntry> pending;
+        std::unordered_set<std::string> pendingKeys;
+        for (const auto& [gafName, entryName] : entries)
+        {
+            auto key = gafName + "/" + toUpper(entryName);
+            if (animCache.find(key) != animCache.end() || !pendingKeys.insert(key).second)
+            {
+                continue;
+            }
+
+            auto gafArchive = gafCache.getGaf(gafName);
+            if (!gafArchive)
+            {
+                continue;
+            }
+
+            auto gafEntry = (*gafArchive)->findEntry(entryName);
+            if (!gafEntry)
+            {
+                continue;
+            }
+
+            pending.push_back(PendingEntry{std::move(key), *gafArchive, &gafEntry->get(), {}});
+        }
+
+        threadPool.parallelFor(pending.size(), [&](std::size_t i, unsigned int) {
+            auto& p = pending[i];
+            DecodeGafAdapter adapter(palette);
+            p.gaf->extract(*p.entry, adapter);
+            p.frames = adapter.extractFrames();
+        });
+
+        // upload in the order the entries were asked for
+        for (auto& p : pending)
+        {
+            animCache[p.key] = std::make_shared<SpriteSeries>(createGafSpriteSeries(*graphics, std::move(p.frames)));
+        }
+    }
+
     std::optional<std::shared_ptr<SpriteSeries>>
     TextureService::tryGetGafEntry(const std::string& gafName, const std::string& entryName)
     {
@@ -314,6 +379,11 @@ namespace rwe
         return series;
     }
 
+    GafCache& TextureService::getGafCache()
+    {
+        return gafCache;
+    }
+
     TextureService::TextureInfo::TextureInfo(unsigned int width, unsigned int height, const SharedTextureHandle& handle)
         : width(width), height(height), handle(handle)
     {
@@ -3,11 +3,15 @@
 #include <memory>
 #include <optional>
 #include <rwe/ColorPalette.h>
+#include <rwe/GafCache.h>
 #include <rwe/render/GraphicsContext.h>
 #include <rwe/render/SpriteSeries.h>
 #include <rwe/render/TextureHandle.h>
+#include <rwe/util/ThreadPool.h>
 #include <rwe/vfs/AbstractVirtualFileSystem.h>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace rwe
 {
@@ -30,6 +34,8 @@ namespace rwe
 
         std::shared_ptr<SpriteSeries> defaultSpriteSeries;
 
+        GafCache gafCache;
+
         std::unordered_map<std::string, std::shared_ptr<SpriteSeries>> animCache;
         std::unordered_map<std::string, TextureInfo> bitmapCache;
         std::unordered_map<std::string, std::shared_ptr<Sprite>> minimapCache;
@@ -39,6 +45,14 @@ namespace rwe
 
         std::optional<std::shared_ptr<SpriteSeries>> tryGetGafEntry(const std::string& gafName, const std::string& entryName);
         std::shared_ptr<SpriteSeries> getGafEntry(const std::string& gafName, const std::string& entryName);
+
+        /**
+         * Decodes the GAF entries on the thread pool, then uploads them,
+         * so that getting them later does not decode them on this thread.
+         * Entries that cannot be found are skipped.
+         */
+        void preloadGafEntries(ThreadPool& threadPool, const std::vector<std::pair<std::string, std::string>>& entries);
+
         std::optional<std::shared_ptr<SpriteSeries>> getGuiTexture(const std::string& guiName, const std::string& graphicName);
         SharedTextureHandle getBitmap(const std::string& bitmapName);
         std::shared_ptr<Sprite> getBitmapRegion(const std::string& bitmapName, int x, int y, int width, int height);
@@ -48,6 +62,9 @@ namespace rwe
         std::shared_ptr<Sprite> getMinimap(const std::string& mapName);
         std::shared_ptr<SpriteSeries> getFont(const std::string& fontName);
 
+        /** The GAF archives read by this service, for others that read GAFs from the same filesystem. */
+        GafCache& getGafCache();
+
     private:
         std::optional<std::shared_ptr<SpriteSeries>> getGafEntryInternal(const std::string& gafName, const std::string& entryName);
         TextureInfo getBitmapInternal(const std::string& bitmapName);
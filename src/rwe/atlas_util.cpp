@@ -1,6 +1,5 @@
 #include "atlas_util.h"
 #include <algorithm>
-#include <rwe/util/SpanStream.h>
 #include <rwe/BoxTreeSplit.h>
 #include <rwe/io/gaf/GafArchive.h>
 #include <rwe/util/Index.h>
@@ -85,25 +84,22 @@ namespace rwe
 
 
     std::pair<std::unordered_map<std::string, Rectangle2f>, std::vector<SharedTextureHandle>> createTeamColorAtlases(
-        AbstractVirtualFileSystem& vfs,
+        GafCache& gafCache,
         GraphicsContext& graphics,
         const ColorPalette& palette)
     {
-        auto bytes = vfs.readFile("textures/LOGOS.GAF");
-        if (!bytes)
+        auto gaf = gafCache.getGaf("textures/LOGOS.GAF");
+        if (!gaf)
         {
             throw std::runtime_error("textures/LOGOS.GAF could not be read");
         }
 
-        rwe::SpanStream stream(bytes->data(), bytes->size());
-        GafArchive gaf(&stream);
-
         std::vector<std::pair<std::string, std::vector<FrameInfo>>> entries;
-        for (const auto& e : gaf.entries())
+        for (const auto& e : (*gaf)->entries())
         {
             std::vector<FrameInfo> frames;
             FrameListGafAdapter adapter(&palette, &frames, &e.name);
-            gaf.extract(e, adapter);
+            (*gaf)->extract(e, adapter);
             entries.emplace_back(e.name, std::move(frames));
         }
 
@@ -171,7 +167,7 @@ namespace rwe
         return std::make_pair(std::move(atlasMap), std::move(atlases));
     }
 
-    TextureAtlasInfo createTextureAtlases(AbstractVirtualFileSystem* vfs, GraphicsContext* graphics, const ColorPalette* palette)
+    TextureAtlasInfo createTextureAtlases(AbstractVirtualFileSystem* vfs, GafCache* gafCache, GraphicsContext* graphics, const ColorPalette* palette)
     {
         auto gafs = vfs->getFileNames("textures", ".gaf");
 
@@ -186,20 +182,16 @@ namespace rwe
                 continue;
             }
 
-            auto bytes = vfs->readFile("textures/" + gafName);
-            if (!bytes)
+            auto gaf = gafCache->getGaf("textures/" + gafName);
+            if (!gaf)
             {
                 throw std::runtime_error("File in listing could not be read: " + gafName);
             }
 
-            rwe::SpanStream stream(bytes->data(), bytes->size());
-            GafArchive gaf(&stream);
-
-
-            for (const auto& e : gaf.entries())
+            for (const auto& e : (*gaf)->entries())
             {
                 FrameListGafAdapter adapter(palette, &frames, &e.name);
-                gaf.extract(e, adapter);
+                (*gaf)->extract(e, adapter);
             }
         }
 
@@ -265,7 +257,7 @@ namespace rwe
 
         SharedTextureHandle atlasTexture(graphics->createTexture(atlas));
 
-        auto teamColorInfo = createTeamColorAtlases(*vfs, *graphics, *palette);
+        auto teamColorInfo = createTeamColorAtlases(*gafCache, *graphics, *palette);
 
         return TextureAtlasInfo{
             std::move(atlasTexture),
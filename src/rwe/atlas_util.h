@@ -1,6 +1,7 @@
 #pragma once
 
 #include <rwe/ColorPalette.h>
+#include <rwe/GafCache.h>
 #include <rwe/geometry/Rectangle2f.h>
 #include <rwe/render/GraphicsContext.h>
 #include <rwe/render/TextureHandle.h>
@@ -22,5 +23,6 @@ namespace rwe
         std::unordered_map<std::string, Rectangle2f> teamTextureAtlasMap;
     };
 
-    TextureAtlasInfo createTextureAtlases(AbstractVirtualFileSystem* vfs, GraphicsContext* graphics, const ColorPalette* palette);
+    /** Packs every texture in the GAFs of the textures directory into atlases, reading the GAFs through the cache. */
+    TextureAtlasInfo createTextureAtlases(AbstractVirtualFileSystem* vfs, GafCache* gafCache, GraphicsContext* graphics, const ColorPalette* palette);
 }
@@ -4,8 +4,8 @@
 
 namespace rwe
 {
-    CobEnvironment::CobEnvironment(const CobScript* script)
-        : _script(script), _statics(script->staticVariableCount)
+    CobEnvironment::CobEnvironment(const CobProgram* program)
+        : _program(program), _script(&program->script), _statics(program->script.staticVariableCount)
     {
     }
 
@@ -24,6 +24,11 @@ namespace rwe
         return _script;
     }
 
+    const CobProgram* CobEnvironment::program()
+    {
+        return _program;
+    }
+
     std::optional<CobThread> CobEnvironment::createNonScheduledThread(const std::string& functionName, const std::vector<int>& params)
     {
         auto it = std::find_if(_script->functions.begin(), _script->functions.end(), [&functionName](const auto& i) { return i.name == functionName; });
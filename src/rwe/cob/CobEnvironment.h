@@ -6,6 +6,7 @@
 #include <rwe/cob/CobAngularSpeed.h>
 #include <rwe/cob/CobAxis.h>
 #include <rwe/cob/CobPosition.h>
+#include <rwe/cob/CobProgram.h>
 #include <rwe/cob/CobSfxType.h>
 #include <rwe/cob/CobSleepDuration.h>
 #include <rwe/cob/CobSpeed.h>
@@ -256,6 +257,8 @@ namespace rwe
         using Status = std::variant<SignalStatus, PieceCommandStatus, BlockedStatus, SleepStatus, QueryStatus, SetQueryStatus, FinishedStatus>;
 
     public:
+        const CobProgram* const _program;
+
         const CobScript* const _script;
 
         std::vector<int> _statics;
@@ -268,7 +271,7 @@ namespace rwe
         std::deque<CobThread*> finishedQueue;
 
     public:
-        explicit CobEnvironment(const CobScript* _script);
+        explicit CobEnvironment(const CobProgram* program);
 
         CobEnvironment(const CobEnvironment& other) = delete;
         CobEnvironment& operator=(const CobEnvironment& other) = delete;
@@ -282,6 +285,8 @@ namespace rwe
 
         const CobScript* script();
 
+        const CobProgram* program();
+
         std::optional<CobThread> createNonScheduledThread(const std::string& functionName, const std::vector<int>& params);
 
         CobThread createNonScheduledThread(unsigned int functionId, const std::vector<int>& params);
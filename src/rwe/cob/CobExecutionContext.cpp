@@ -118,7 +118,457 @@ namespace rwe
     {
     }
 
+// Dispatch straight from one handler to the next where the compiler allows it
+// (GCC and Clang's "labels as values"), otherwise go back round a switch.
+#if defined(__GNUC__) && !defined(RWE_COB_SWITCH_DISPATCH)
+#define RWE_COB_THREADED_DISPATCH
+#endif
+
+#ifdef RWE_COB_THREADED_DISPATCH
+#define RWE_COB_OP(name) \
+    case CobOp::name:    \
+    op_##name:
+#define RWE_COB_NEXT()                                       \
+    do                                                       \
+    {                                                        \
+        instruction = &code[frame->instructionIndex];        \
+        frame->instructionIndex = instruction->next;         \
+        goto* dispatchTable[static_cast<int>(instruction->op)]; \
+    } while (false)
+#else
+#define RWE_COB_OP(name) case CobOp::name:
+#define RWE_COB_NEXT() continue
+#endif
+
     CobEnvironment::Status CobExecutionContext::execute()
+    {
+        if (thread->callStack.empty())
+        {
+            return CobEnvironment::FinishedStatus();
+        }
+
+        const auto& code = env->program()->code;
+        auto frame = &thread->callStack.top();
+        if (frame->instructionIndex >= code.size())
+        {
+            throw std::out_of_range("COB instruction index out of range: " + std::to_string(frame->instructionIndex));
+        }
+
+#ifdef RWE_COB_THREADED_DISPATCH
+        // Must list every CobOp, in declaration order.
+        static const void* const dispatchTable[] = {
+            &&op_Move,
+            &&op_Turn,
+            &&op_Spin,
+            &&op_StopSpin,
+            &&op_Show,
+            &&op_Hide,
+            &&op_Cache,
+            &&op_DontCache,
+            &&op_MoveNow,
+            &&op_TurnNow,
+            &&op_Shade,
+            &&op_DontShade,
+            &&op_EmitSfx,
+            &&op_WaitForTurn,
+            &&op_WaitForMove,
+            &&op_Sleep,
+            &&op_PushConstant,
+            &&op_PushLocalVar,
+            &&op_PushStatic,
+            &&op_CreateLocalVar,
+            &&op_PopLocalVar,
+            &&op_PopStatic,
+            &&op_PopStack,
+            &&op_Add,
+            &&op_Sub,
+            &&op_Mul,
+            &&op_Div,
+            &&op_BitwiseAnd,
+            &&op_BitwiseOr,
+            &&op_BitwiseXor,
+            &&op_BitwiseNot,
+            &&op_Rand,
+            &&op_GetValue,
+            &&op_GetValueWithArgs,
+            &&op_SetValue,
+            &&op_SetLess,
+            &&op_SetLessOrEqual,
+            &&op_SetGreater,
+            &&op_SetGreaterOrEqual,
+            &&op_SetEqual,
+            &&op_SetNotEqual,
+            &&op_LogicalAnd,
+            &&op_LogicalOr,
+            &&op_LogicalXor,
+            &&op_LogicalNot,
+            &&op_StartScript,
+            &&op_CallScript,
+            &&op_Jump,
+            &&op_Return,
+            &&op_JumpIfZero,
+            &&op_Signal,
+            &&op_SetSignalMask,
+            &&op_Explode,
+            &&op_AttachUnit,
+            &&op_DropUnit,
+            &&op_Unsupported,
+            &&op_Malformed,
+            &&op_EndOfCode,
+        };
+        static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == static_cast<int>(CobOp::EndOfCode) + 1);
+#endif
+
+        const CobInstruction* instruction;
+        while (true)
+        {
+            instruction = &code[frame->instructionIndex];
+            frame->instructionIndex = instruction->next;
+            switch (instruction->op)
+            {
+                RWE_COB_OP(Rand)
+                {
+                    auto high = pop();
+                    auto low = pop();
+                    return CobEnvironment::QueryStatus{CobEnvironment::QueryStatus::Random{low, high}};
+                }
+                RWE_COB_OP(Add)
+                {
+                    add();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(Sub)
+                {
+                    subtract();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(Mul)
+                {
+                    multiply();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(Div)
+                {
+                    divide();
+                    RWE_COB_NEXT();
+                }
+
+                RWE_COB_OP(SetLess)
+                {
+                    compareLessThan();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(SetLessOrEqual)
+                {
+                    compareLessThanOrEqual();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(SetEqual)
+                {
+                    compareEqual();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(SetNotEqual)
+                {
+                    compareNotEqual();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(SetGreater)
+                {
+                    compareGreaterThan();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(SetGreaterOrEqual)
+                {
+                    compareGreaterThanOrEqual();
+                    RWE_COB_NEXT();
+                }
+
+                RWE_COB_OP(Jump)
+                {
+                    frame->instructionIndex = instruction->a;
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(JumpIfZero)
+                {
+                    if (pop() == 0)
+                    {
+                        frame->instructionIndex = instruction->a;
+                    }
+                    RWE_COB_NEXT();
+                }
+
+                RWE_COB_OP(LogicalAnd)
+                {
+                    logicalAnd();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(LogicalOr)
+                {
+                    logicalOr();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(LogicalXor)
+                {
+                    logicalXor();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(LogicalNot)
+                {
+                    logicalNot();
+                    RWE_COB_NEXT();
+                }
+
+                RWE_COB_OP(BitwiseAnd)
+                {
+                    bitwiseAnd();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(BitwiseOr)
+                {
+                    bitwiseOr();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(BitwiseXor)
+                {
+                    bitwiseXor();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(BitwiseNot)
+                {
+                    bitwiseNot();
+                    RWE_COB_NEXT();
+                }
+
+                RWE_COB_OP(Move)
+                {
+                    auto position = popPosition();
+                    auto speed = popSpeed();
+                    return CobEnvironment::PieceCommandStatus{
+                        instruction->a,
+                        CobEnvironment::PieceCommandStatus::Move{toAxis(instruction->b), position, speed}};
+                }
+                RWE_COB_OP(MoveNow)
+                {
+                    auto position = popPosition();
+                    return CobEnvironment::PieceCommandStatus{
+                        instruction->a,
+                        CobEnvironment::PieceCommandStatus::Move{toAxis(instruction->b), position, std::nullopt}};
+                }
+                RWE_COB_OP(Turn)
+                {
+                    auto angle = popAngle();
+                    auto speed = popAngularSpeed();
+                    return CobEnvironment::PieceCommandStatus{
+                        instruction->a,
+                        CobEnvironment::PieceCommandStatus::Turn{toAxis(instruction->b), angle, speed}};
+                }
+                RWE_COB_OP(TurnNow)
+                {
+                    auto angle = popAngle();
+                    return CobEnvironment::PieceCommandStatus{
+                        instruction->a,
+                        CobEnvironment::PieceCommandStatus::Turn{toAxis(instruction->b), angle, std::nullopt}};
+                }
+                RWE_COB_OP(Spin)
+                {
+                    auto targetSpeed = popAngularSpeed();
+                    auto acceleration = popAngularSpeed();
+                    return CobEnvironment::PieceCommandStatus{
+                        instruction->a,
+                        CobEnvironment::PieceCommandStatus::Spin{toAxis(instruction->b), targetSpeed, acceleration}};
+                }
+                RWE_COB_OP(StopSpin)
+                {
+                    auto deceleration = popAngularSpeed();
+                    return CobEnvironment::PieceCommandStatus{
+                        instruction->a,
+                        CobEnvironment::PieceCommandStatus::StopSpin{toAxis(instruction->b), deceleration}};
+                }
+                RWE_COB_OP(Explode)
+                {
+                    /*auto explosionType = */ pop();
+                    // TODO: this
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(EmitSfx)
+                {
+                    auto sfxType = popSfxType();
+                    return CobEnvironment::PieceCommandStatus{
+                        instruction->a,
+                        CobEnvironment::PieceCommandStatus::EmitSfx{sfxType}};
+                }
+                RWE_COB_OP(Show)
+                {
+                    return CobEnvironment::PieceCommandStatus{instruction->a, CobEnvironment::PieceCommandStatus::Show()};
+                }
+                RWE_COB_OP(Hide)
+                {
+                    return CobEnvironment::PieceCommandStatus{instruction->a, CobEnvironment::PieceCommandStatus::Hide()};
+                }
+                RWE_COB_OP(Shade)
+                {
+                    return CobEnvironment::PieceCommandStatus{instruction->a, CobEnvironment::PieceCommandStatus::EnableShading()};
+                }
+                RWE_COB_OP(DontShade)
+                {
+                    return CobEnvironment::PieceCommandStatus{instruction->a, CobEnvironment::PieceCommandStatus::DisableShading()};
+                }
+                RWE_COB_OP(Cache)
+                RWE_COB_OP(DontCache)
+                {
+                    // do nothing, RWE does not have the concept of caching
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(AttachUnit)
+                {
+                    attachUnit();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(DropUnit)
+                {
+                    detachUnit();
+                    RWE_COB_NEXT();
+                }
+
+                RWE_COB_OP(WaitForMove)
+                {
+                    return CobEnvironment::BlockedStatus(CobEnvironment::BlockedStatus::Move(instruction->a, toAxis(instruction->b)));
+                }
+                RWE_COB_OP(WaitForTurn)
+                {
+                    return CobEnvironment::BlockedStatus(CobEnvironment::BlockedStatus::Turn(instruction->a, toAxis(instruction->b)));
+                }
+                RWE_COB_OP(Sleep)
+                {
+                    auto duration = popSleepDuration();
+                    return CobEnvironment::SleepStatus{duration};
+                }
+
+                RWE_COB_OP(CallScript)
+                {
+                    auto params = popParams(instruction->b);
+                    thread->callStack.emplace(instruction->a, params);
+                    frame = &thread->callStack.top();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(Return)
+                {
+                    returnFromScript();
+                    if (thread->callStack.empty())
+                    {
+                        return CobEnvironment::FinishedStatus();
+                    }
+                    frame = &thread->callStack.top();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(StartScript)
+                {
+                    auto params = popParams(instruction->b);
+                    env->createThread(instruction->a, params, thread->signalMask);
+                    RWE_COB_NEXT();
+                }
+
+                RWE_COB_OP(Signal)
+                {
+                    sendSignal();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(SetSignalMask)
+                {
+                    setSignalMask();
+                    RWE_COB_NEXT();
+                }
+
+                RWE_COB_OP(CreateLocalVar)
+                {
+                    createLocalVariable();
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(PushConstant)
+                {
+                    push(instruction->a);
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(PushLocalVar)
+                {
+                    push(frame->locals.at(instruction->a));
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(PopLocalVar)
+                {
+                    auto value = pop();
+                    frame->locals.at(instruction->a) = value;
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(PushStatic)
+                {
+                    push(env->getStatic(instruction->a));
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(PopStatic)
+                {
+                    auto value = pop();
+                    env->setStatic(instruction->a, value);
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(PopStack)
+                {
+                    popStackOperation();
+                    RWE_COB_NEXT();
+                }
+
+                RWE_COB_OP(GetValue)
+                {
+                    auto valueId = popValueId();
+                    auto value = getValueInternal(valueId, 0, 0, 0, 0);
+                    if (auto v = std::get_if<CobEnvironment::QueryStatus::Query>(&value); v != nullptr)
+                    {
+                        return CobEnvironment::QueryStatus{*v};
+                    }
+                    push(std::get<int>(value));
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(GetValueWithArgs)
+                {
+                    auto arg4 = pop();
+                    auto arg3 = pop();
+                    auto arg2 = pop();
+                    auto arg1 = pop();
+                    auto valueId = popValueId();
+                    auto value = getValueInternal(valueId, arg1, arg2, arg3, arg4);
+                    if (auto v = std::get_if<CobEnvironment::QueryStatus::Query>(&value); v != nullptr)
+                    {
+                        return CobEnvironment::QueryStatus{*v};
+                    }
+                    push(std::get<int>(value));
+                    RWE_COB_NEXT();
+                }
+                RWE_COB_OP(SetValue)
+                {
+                    return setValue();
+                }
+
+                RWE_COB_OP(Unsupported)
+                {
+                    throw std::runtime_error("Unsupported opcode " + std::to_string(instruction->a));
+                }
+                RWE_COB_OP(Malformed)
+                {
+                    throw std::runtime_error("Malformed instruction with opcode " + std::to_string(instruction->a));
+                }
+                RWE_COB_OP(EndOfCode)
+                {
+                    throw std::out_of_range("COB execution ran past the end of the code");
+                }
+            }
+        }
+    }
+
+#undef RWE_COB_OP
+#undef RWE_COB_NEXT
+
+    CobEnvironment::Status CobExecutionContext::executeReference()
     {
         while (!thread->callStack.empty())
         {
@@ -213,7 +663,7 @@ namespace rwe
                     auto position = popPosition();
                     return CobEnvironment::PieceCommandStatus{
                         object,
-                        CobEnvironment::PieceCommandStatus::Move{axis, position}};
+                        CobEnvironment::PieceCommandStatus::Move{axis, position, std::nullopt}};
                 }
                 case OpCode::TURN:
                 {
@@ -232,7 +682,7 @@ namespace rwe
                     auto angle = popAngle();
                     return CobEnvironment::PieceCommandStatus{
                         object,
-                        CobEnvironment::PieceCommandStatus::Turn{axis, angle}};
+                        CobEnvironment::PieceCommandStatus::Turn{axis, angle, std::nullopt}};
                 }
                 case OpCode::SPIN:
                 {
@@ -580,13 +1030,7 @@ namespace rwe
     {
         auto functionId = nextInstruction();
         auto paramCount = nextInstruction();
-
-        // collect up the parameters
-        std::vector<int> params(paramCount);
-        for (unsigned int i = 0; i < paramCount; ++i)
-        {
-            params[i] = pop();
-        }
+        auto params = popParams(paramCount);
 
         const auto& functionInfo = env->script()->functions.at(functionId);
         thread->callStack.emplace(functionInfo.address, params);
@@ -596,12 +1040,7 @@ namespace rwe
     {
         auto functionId = nextInstruction();
         auto paramCount = nextInstruction();
-
-        std::vector<int> params(paramCount);
-        for (unsigned int i = 0; i < paramCount; ++i)
-        {
-            params[i] = pop();
-        }
+        auto params = popParams(paramCount);
 
         env->createThread(functionId, params, thread->signalMask);
     }
@@ -671,6 +1110,16 @@ namespace rwe
         return CobEnvironment::SetQueryStatus{setGetter(valueId, newValue)};
     }
 
+    std::vector<int> CobExecutionContext::popParams(unsigned int paramCount)
+    {
+        std::vector<int> params(paramCount);
+        for (unsigned int i = 0; i < paramCount; ++i)
+        {
+            params[i] = pop();
+        }
+        return params;
+    }
+
     int CobExecutionContext::pop()
     {
         // Malformed scripts may attempt to pop when the stack is empty.
@@ -737,7 +1186,11 @@ namespace rwe
 
     CobAxis CobExecutionContext::nextInstructionAsAxis()
     {
-        auto val = nextInstruction();
+        return toAxis(nextInstruction());
+    }
+
+    CobAxis CobExecutionContext::toAxis(unsigned int val)
+    {
         switch (val)
         {
             case 0:
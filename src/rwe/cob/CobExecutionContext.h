@@ -19,8 +19,18 @@ namespace rwe
     public:
         CobExecutionContext(CobEnvironment* env, CobThread* thread);
 
+        /**
+         * Runs the thread until it finishes or needs something from the engine,
+         * using the script's pre-decoded instructions.
+         */
         CobEnvironment::Status execute();
 
+        /**
+         * Does the same as execute, but decodes the raw instruction words as it goes.
+         * Kept as a reference to test and benchmark execute against.
+         */
+        CobEnvironment::Status executeReference();
+
     private:
         // arithmetic
         void add();
@@ -107,6 +117,8 @@ namespace rwe
 
         CobEnvironment::SetQueryStatus setValue();
 
+        std::vector<int> popParams(unsigned int paramCount);
+
         // non-commands
         int pop();
 
@@ -123,5 +135,6 @@ namespace rwe
 
         unsigned int nextInstruction();
         CobAxis nextInstructionAsAxis();
+        static CobAxis toAxis(unsigned int val);
     };
 }
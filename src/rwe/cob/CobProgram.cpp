@@ -0,0 +1,243 @@
+#include "CobProgram.h"
+#include <optional>
+#include <rwe/cob/CobOpCode.h>
+#include <utility>
+
+namespace rwe
+{
+    /** Returns the decoded operation and the number of operand words that follow it. */
+    std::optional<std::pair<CobOp, unsigned int>> getDecodedOp(uint32_t instruction)
+    {
+        switch (static_cast<OpCode>(instruction))
+        {
+            case OpCode::MOVE:
+                return std::make_pair(CobOp::Move, 2u);
+            case OpCode::TURN:
+                return std::make_pair(CobOp::Turn, 2u);
+            case OpCode::SPIN:
+                return std::make_pair(CobOp::Spin, 2u);
+            case OpCode::STOP_SPIN:
+                return std::make_pair(CobOp::StopSpin, 2u);
+            case OpCode::SHOW:
+                return std::make_pair(CobOp::Show, 1u);
+            case OpCode::HIDE:
+                return std::make_pair(CobOp::Hide, 1u);
+            case OpCode::CACHE:
+                return std::make_pair(CobOp::Cache, 1u);
+            case OpCode::DONT_CACHE:
+                return std::make_pair(CobOp::DontCache, 1u);
+            case OpCode::MOVE_NOW:
+                return std::make_pair(CobOp::MoveNow, 2u);
+            case OpCode::TURN_NOW:
+                return std::make_pair(CobOp::TurnNow, 2u);
+            case OpCode::SHADE:
+                return std::make_pair(CobOp::Shade, 1u);
+            case OpCode::DONT_SHADE:
+                return std::make_pair(CobOp::DontShade, 1u);
+            case OpCode::EMIT_SFX:
+                return std::make_pair(CobOp::EmitSfx, 1u);
+
+            case OpCode::WAIT_FOR_TURN:
+                return std::make_pair(CobOp::WaitForTurn, 2u);
+            case OpCode::WAIT_FOR_MOVE:
+                return std::make_pair(CobOp::WaitForMove, 2u);
+            case OpCode::SLEEP:
+                return std::make_pair(CobOp::Sleep, 0u);
+
+            case OpCode::PUSH_CONSTANT:
+                return std::make_pair(CobOp::PushConstant, 1u);
+            case OpCode::PUSH_LOCAL_VAR:
+                return std::make_pair(CobOp::PushLocalVar, 1u);
+            case OpCode::PUSH_STATIC:
+                return std::make_pair(CobOp::PushStatic, 1u);
+            case OpCode::CREATE_LOCAL_VAR:
+                return std::make_pair(CobOp::CreateLocalVar, 0u);
+            case OpCode::POP_LOCAL_VAR:
+                return std::make_pair(CobOp::PopLocalVar, 1u);
+            case OpCode::POP_STATIC:
+                return std::make_pair(CobOp::PopStatic, 1u);
+            case OpCode::POP_STACK:
+                return std::make_pair(CobOp::PopStack, 0u);
+
+            case OpCode::ADD:
+                return std::make_pair(CobOp::Add, 0u);
+            case OpCode::SUB:
+                return std::make_pair(CobOp::Sub, 0u);
+            case OpCode::MUL:
+                return std::make_pair(CobOp::Mul, 0u);
+            case OpCode::DIV:
+                return std::make_pair(CobOp::Div, 0u);
+
+            case OpCode::BITWISE_AND:
+                return std::make_pair(CobOp::BitwiseAnd, 0u);
+            case OpCode::BITWISE_OR:
+                return std::make_pair(CobOp::BitwiseOr, 0u);
+            case OpCode::BITWISE_XOR:
+                return std::make_pair(CobOp::BitwiseXor, 0u);
+            case OpCode::BITWISE_NOT:
+                return std::make_pair(CobOp::BitwiseNot, 0u);
+
+            case OpCode::RAND:
+                return std::make_pair(CobOp::Rand, 0u);
+            case OpCode::GET_VALUE:
+                return std::make_pair(CobOp::GetValue, 0u);
+            case OpCode::GET_VALUE_WITH_ARGS:
+                return std::make_pair(CobOp::GetValueWithArgs, 0u);
+
+            case OpCode::SET_VALUE:
+                return std::make_pair(CobOp::SetValue, 0u);
+
+            case OpCode::SET_LESS:
+                return std::make_pair(CobOp::SetLess, 0u);
+            case OpCode::SET_LESS_OR_EQUAL:
+                return std::make_pair(CobOp::SetLessOrEqual, 0u);
+            case OpCode::SET_GREATER:
+                return std::make_pair(CobOp::SetGreater, 0u);
+            case OpCode::SET_GREATER_OR_EQUAL:
+                return std::make_pair(CobOp::SetGreaterOrEqual, 0u);
+            case OpCode::SET_EQUAL:
+                return std::make_pair(CobOp::SetEqual, 0u);
+            case OpCode::SET_NOT_EQUAL:
+                return std::make_pair(CobOp::SetNotEqual, 0u);
+            case OpCode::LOGICAL_AND:
+                return std::make_pair(CobOp::LogicalAnd, 0u);
+            case OpCode::LOGICAL_OR:
+                return std::make_pair(CobOp::LogicalOr, 0u);
+            case OpCode::LOGICAL_XOR:
+                return std::make_pair(CobOp::LogicalXor, 0u);
+            case OpCode::LOGICAL_NOT:
+                return std::make_pair(CobOp::LogicalNot, 0u);
+
+            case OpCode::START_SCRIPT:
+                return std::make_pair(CobOp::StartScript, 2u);
+            case OpCode::CALL_SCRIPT:
+                return std::make_pair(CobOp::CallScript, 2u);
+            case OpCode::JUMP:
+                return std::make_pair(CobOp::Jump, 1u);
+            case OpCode::RETURN:
+                return std::make_pair(CobOp::Return, 0u);
+            case OpCode::JUMP_IF_ZERO:
+                return std::make_pair(CobOp::JumpIfZero, 1u);
+            case OpCode::SIGNAL:
+                return std::make_pair(CobOp::Signal, 0u);
+            case OpCode::SET_SIGNAL_MASK:
+                return std::make_pair(CobOp::SetSignalMask, 0u);
+
+            case OpCode::EXPLODE:
+                return std::make_pair(CobOp::Explode, 1u);
+
+            case OpCode::ATTACH_UNIT:
+                return std::make_pair(CobOp::AttachUnit, 0u);
+            case OpCode::DROP_UNIT:
+                return std::make_pair(CobOp::DropUnit, 0u);
+
+            default:
+                return std::nullopt;
+        }
+    }
+
+    bool hasAxisOperand(CobOp op)
+    {
+        switch (op)
+        {
+            case CobOp::Move:
+            case CobOp::MoveNow:
+            case CobOp::Turn:
+            case CobOp::TurnNow:
+            case CobOp::Spin:
+            case CobOp::StopSpin:
+            case CobOp::WaitForMove:
+            case CobOp::WaitForTurn:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    CobInstruction decodeCobInstruction(const CobScript& script, unsigned int index)
+    {
+        const auto& instructions = script.instructions;
+        auto size = static_cast<unsigned int>(instructions.size());
+        if (index >= size)
+        {
+            return CobInstruction{CobOp::EndOfCode, 0, 0, index};
+        }
+
+        auto decodedOp = getDecodedOp(instructions[index]);
+        if (!decodedOp)
+        {
+            return CobInstruction{CobOp::Unsupported, instructions[index], 0, index + 1};
+        }
+
+        auto [op, operandCount] = *decodedOp;
+        CobInstruction malformed{CobOp::Malformed, instructions[index], 0, index + 1};
+
+        if (operandCount > size - index - 1)
+        {
+            return malformed;
+        }
+
+        CobInstruction result{op, 0, 0, index + 1 + operandCount};
+        if (operandCount >= 1)
+        {
+            result.a = instructions[index + 1];
+        }
+        if (operandCount >= 2)
+        {
+            result.b = instructions[index + 2];
+        }
+
+        if (hasAxisOperand(op) && result.b > 2)
+        {
+            return malformed;
+        }
+
+        switch (op)
+        {
+            case CobOp::Jump:
+            case CobOp::JumpIfZero:
+                if (result.a >= size)
+                {
+                    return malformed;
+                }
+                break;
+            case CobOp::CallScript:
+            {
+                if (result.a >= script.functions.size())
+                {
+                    return malformed;
+                }
+
+                auto address = script.functions[result.a].address;
+                if (address >= size)
+                {
+                    return malformed;
+                }
+                result.a = address;
+                break;
+            }
+            case CobOp::StartScript:
+                if (result.a >= script.functions.size())
+                {
+                    return malformed;
+                }
+                break;
+            default:
+                break;
+        }
+
+        return result;
+    }
+
+    CobProgram compileCobScript(CobScript&& script)
+    {
+        std::vector<CobInstruction> code;
+        code.reserve(script.instructions.size() + 1);
+        for (unsigned int i = 0; i <= script.instructions.size(); ++i)
+        {
+            code.push_back(decodeCobInstruction(script, i));
+        }
+
+        return CobProgram{std::move(script), std::move(code)};
+    }
+}
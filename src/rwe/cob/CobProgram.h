@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <rwe/io/cob/Cob.h>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * The operation of a decoded COB instruction.
+     * Unlike OpCode, the values are dense so that they can index a dispatch table.
+     */
+    enum class CobOp : uint8_t
+    {
+        Move,
+        Turn,
+        Spin,
+        StopSpin,
+        Show,
+        Hide,
+        Cache,
+        DontCache,
+        MoveNow,
+        TurnNow,
+        Shade,
+        DontShade,
+        EmitSfx,
+
+        WaitForTurn,
+        WaitForMove,
+        Sleep,
+
+        PushConstant,
+        PushLocalVar,
+        PushStatic,
+        CreateLocalVar,
+        PopLocalVar,
+        PopStatic,
+        PopStack,
+
+        Add,
+        Sub,
+        Mul,
+        Div,
+
+        BitwiseAnd,
+        BitwiseOr,
+        BitwiseXor,
+        BitwiseNot,
+
+        Rand,
+        GetValue,
+        GetValueWithArgs,
+
+        SetValue,
+
+        SetLess,
+        SetLessOrEqual,
+        SetGreater,
+        SetGreaterOrEqual,
+        SetEqual,
+        SetNotEqual,
+        LogicalAnd,
+        LogicalOr,
+        LogicalXor,
+        LogicalNot,
+
+        StartScript,
+        CallScript,
+        Jump,
+        Return,
+        JumpIfZero,
+        Signal,
+        SetSignalMask,
+
+        Explode,
+
+        AttachUnit,
+        DropUnit,
+
+        /** An opcode RWE does not know. a holds the raw instruction. */
+        Unsupported,
+
+        /** A known opcode whose operands are missing or out of range. */
+        Malformed,
+
+        /** Placed just past the end of the code, to catch execution running off it. */
+        EndOfCode,
+    };
+
+    /**
+     * A COB instruction with its operands read out of the instruction stream
+     * and checked, so that the interpreter does not have to.
+     *
+     * What a and b hold depends on the operation:
+     * - piece commands: the piece index and, where there is one, the axis (0 to 2)
+     * - jumps: the target index
+     * - CallScript: the function's address and the number of parameters
+     * - StartScript: the function's index and the number of parameters
+     * - variable and constant pushes and pops: the operand
+     */
+    struct CobInstruction
+    {
+        CobOp op;
+        unsigned int a;
+        unsigned int b;
+
+        /** The index of the instruction that follows this one. */
+        unsigned int next;
+    };
+
+    /**
+     * A COB script together with its pre-decoded instructions.
+     *
+     * code has one entry for every word of the script's instructions,
+     * decoded as though execution started at that word,
+     * so addresses and jump targets index both in the same way.
+     * One extra EndOfCode entry follows.
+     */
+    struct CobProgram
+    {
+        CobScript script;
+        std::vector<CobInstruction> code;
+    };
+
+    CobInstruction decodeCobInstruction(const CobScript& script, unsigned int index);
+
+    CobProgram compileCobScript(CobScript&& script);
+}
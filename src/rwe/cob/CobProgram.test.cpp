@@ -0,0 +1,167 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/cob/CobExecutionContext.h>
+#include <rwe/cob/CobOpCode.h>
+#include <rwe/cob/CobProgram.h>
+
+namespace rwe
+{
+    unsigned int op(OpCode code)
+    {
+        return static_cast<unsigned int>(code);
+    }
+
+    /**
+     * Runs a function to completion, answering queries with zero,
+     * and returns the kind of each status along the way
+     * followed by the thread's return value.
+     */
+    template <typename Execute>
+    std::vector<int> runToCompletion(const CobProgram& program, unsigned int functionId, Execute execute)
+    {
+        CobEnvironment env(&program);
+        auto thread = env.createNonScheduledThread(functionId, {3});
+        CobExecutionContext context(&env, &thread);
+
+        std::vector<int> trace;
+        for (int i = 0; i < 100; ++i)
+        {
+            auto status = execute(context);
+            trace.push_back(static_cast<int>(status.index()));
+            if (auto pieceCommand = std::get_if<CobEnvironment::PieceCommandStatus>(&status); pieceCommand != nullptr)
+            {
+                trace.push_back(static_cast<int>(pieceCommand->piece));
+            }
+            if (std::holds_alternative<CobEnvironment::QueryStatus>(status))
+            {
+                thread.stack.push(0);
+            }
+            if (std::holds_alternative<CobEnvironment::FinishedStatus>(status))
+            {
+                break;
+            }
+        }
+
+        trace.push_back(thread.returnValue);
+        return trace;
+    }
+
+    CobScript makeTestScript()
+    {
+        CobScript script;
+        script.pieces = {"base", "turret", "barrel"};
+        script.staticVariableCount = 1;
+
+        // Main(x): moves the barrel while counting a local up to x + 2,
+        // sets static 0 to 4, queries health, calls Double(count)
+        // and returns static 0
+        script.functions.push_back(CobFunctionInfo{"Main", 0});
+        script.instructions = {
+            op(OpCode::CREATE_LOCAL_VAR),
+            op(OpCode::CREATE_LOCAL_VAR),
+            op(OpCode::PUSH_CONSTANT), 0,
+            op(OpCode::POP_LOCAL_VAR), 1,
+            // loop: 6
+            op(OpCode::PUSH_LOCAL_VAR), 1,
+            op(OpCode::PUSH_LOCAL_VAR), 0,
+            op(OpCode::PUSH_CONSTANT), 2,
+            op(OpCode::ADD),
+            op(OpCode::SET_LESS),
+            op(OpCode::JUMP_IF_ZERO), 32,
+            op(OpCode::PUSH_LOCAL_VAR), 1,
+            op(OpCode::PUSH_CONSTANT), 1,
+            op(OpCode::ADD),
+            op(OpCode::POP_LOCAL_VAR), 1,
+            op(OpCode::PUSH_CONSTANT), 5,
+            op(OpCode::PUSH_CONSTANT), 100,
+            op(OpCode::MOVE), 2, 1,
+            op(OpCode::JUMP), 6,
+            // end: 32
+            op(OpCode::PUSH_CONSTANT), 4,
+            op(OpCode::POP_STATIC), 0,
+            op(OpCode::PUSH_CONSTANT), static_cast<unsigned int>(CobValueId::Health),
+            op(OpCode::GET_VALUE),
+            op(OpCode::POP_STACK),
+            op(OpCode::PUSH_LOCAL_VAR), 1,
+            op(OpCode::CALL_SCRIPT), 1, 1,
+            op(OpCode::PUSH_STATIC), 0,
+            op(OpCode::RETURN),
+        };
+
+        // Double(x): returns x * 2
+        script.functions.push_back(CobFunctionInfo{"Double", static_cast<unsigned int>(script.instructions.size())});
+        script.instructions.insert(
+            script.instructions.end(),
+            {
+                op(OpCode::CREATE_LOCAL_VAR),
+                op(OpCode::PUSH_LOCAL_VAR), 0,
+                op(OpCode::PUSH_CONSTANT), 2,
+                op(OpCode::MUL),
+                op(OpCode::RETURN),
+            });
+
+        return script;
+    }
+
+    TEST_CASE("CobProgram")
+    {
+        SECTION("decodes operands")
+        {
+            auto program = compileCobScript(makeTestScript());
+            REQUIRE(program.code.size() == program.script.instructions.size() + 1);
+            REQUIRE(program.code.back().op == CobOp::EndOfCode);
+
+            const auto& move = program.code[27];
+            REQUIRE(move.op == CobOp::Move);
+            REQUIRE(move.a == 2);
+            REQUIRE(move.b == 1);
+            REQUIRE(move.next == 30);
+
+            const auto& jump = program.code[30];
+            REQUIRE(jump.op == CobOp::Jump);
+            REQUIRE(jump.a == 6);
+
+            const auto& call = program.code[42];
+            REQUIRE(call.op == CobOp::CallScript);
+            REQUIRE(call.a == program.script.functions[1].address);
+            REQUIRE(call.b == 1);
+        }
+
+        SECTION("marks bad instructions")
+        {
+            CobScript script;
+            script.staticVariableCount = 0;
+            script.functions.push_back(CobFunctionInfo{"Main", 0});
+            script.instructions = {
+                op(OpCode::JUMP), 100,
+                op(OpCode::CALL_SCRIPT), 7, 0,
+                op(OpCode::TURN_NOW), 0, 3,
+                0x12345678,
+                op(OpCode::PUSH_CONSTANT)};
+
+            auto program = compileCobScript(std::move(script));
+            REQUIRE(program.code[0].op == CobOp::Malformed);
+            REQUIRE(program.code[2].op == CobOp::Malformed);
+            REQUIRE(program.code[5].op == CobOp::Malformed);
+            REQUIRE(program.code[8].op == CobOp::Unsupported);
+            REQUIRE(program.code[9].op == CobOp::Malformed);
+
+            CobEnvironment env(&program);
+            auto thread = env.createNonScheduledThread(0, {});
+            CobExecutionContext context(&env, &thread);
+            REQUIRE_THROWS_AS(context.execute(), std::runtime_error);
+        }
+
+        SECTION("executes the same as the reference interpreter")
+        {
+            auto program = compileCobScript(makeTestScript());
+
+            auto expected = runToCompletion(program, 0, [](auto& c) { return c.executeReference(); });
+            auto actual = runToCompletion(program, 0, [](auto& c) { return c.execute(); });
+            REQUIRE(actual == expected);
+
+            // five moves, the health query, finishing, and the return value
+            REQUIRE(actual.size() == 5 * 2 + 1 + 1 + 1);
+            REQUIRE(actual.back() == 4);
+        }
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * A set of small non-negative integer keys that can be emptied in constant time.
+     * Intended to be kept around and reused for marking things as seen during a pass,
+     * where a hash set would need to be allocated and filled each time.
+     *
+     * Storage grows to the largest key inserted and is never released.
+     */
+    class StampedSet
+    {
+    private:
+        std::vector<uint32_t> stamps;
+        uint32_t currentStamp{1};
+
+    public:
+        /** Removes every key from the set. */
+        void clear()
+        {
+            if (currentStamp == std::numeric_limits<uint32_t>::max())
+            {
+                // Stamps have wrapped around, so old entries
+                // could be mistaken for current ones.
+                std::fill(stamps.begin(), stamps.end(), 0);
+                currentStamp = 1;
+                return;
+            }
+
+            ++currentStamp;
+        }
+
+        /**
+         * Adds the key to the set.
+         * Returns true if the key was added,
+         * or false if it was already present.
+         */
+        bool insert(std::size_t key)
+        {
+            if (key >= stamps.size())
+            {
+                stamps.resize(key + 1, 0);
+            }
+
+            if (stamps[key] == currentStamp)
+            {
+                return false;
+            }
+
+            stamps[key] = currentStamp;
+            return true;
+        }
+
+        bool contains(std::size_t key) const
+        {
+            return key < stamps.size() && stamps[key] == currentStamp;
+        }
+    };
+}
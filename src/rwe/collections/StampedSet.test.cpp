@@ -0,0 +1,31 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/collections/StampedSet.h>
+
+namespace rwe
+{
+    TEST_CASE("StampedSet")
+    {
+        SECTION("reports whether a key was already present")
+        {
+            StampedSet s;
+            REQUIRE(!s.contains(3));
+            REQUIRE(s.insert(3));
+            REQUIRE(s.contains(3));
+            REQUIRE(!s.insert(3));
+            REQUIRE(s.insert(0));
+            REQUIRE(!s.contains(1));
+        }
+
+        SECTION("is empty after clear")
+        {
+            StampedSet s;
+            s.insert(1);
+            s.insert(5);
+            s.clear();
+            REQUIRE(!s.contains(1));
+            REQUIRE(!s.contains(5));
+            REQUIRE(s.insert(5));
+            REQUIRE(!s.insert(5));
+        }
+    }
+}
@@ -229,7 +229,82 @@ namespace rwe
                 [&](OccupiedEntry& e) { return e.first == id ? iterator(it, vec.end()) : end(); });
         }
 
+        /** The number of slots, free or occupied. */
+        std::size_t getSlotCount() const
+        {
+            return vec.size();
+        }
+
+        /**
+         * The slot that holds the value with the given id.
+         * Slots are below getSlotCount() and are reused once freed,
+         * so they suit indexing into side tables.
+         */
+        static std::size_t getSlotIndex(Id id)
+        {
+            return extractIndex(id).value;
+        }
+
+        std::optional<unsigned int> getFirstFreeSlotIndex() const
+        {
+            return firstFreeSlotIndex ? std::make_optional(firstFreeSlotIndex->value) : std::nullopt;
+        }
+
+        /**
+         * Calls onFree(id, nextFreeSlotIndex) for each free slot
+         * and onOccupied(id, value) for each occupied one, in slot order.
+         * Together with the restore functions below this allows the map to be saved
+         * and recreated with the ids that future insertions will be given intact.
+         */
+        template <typename FreeFunc, typename OccupiedFunc>
+        void forEachSlot(FreeFunc onFree, OccupiedFunc onOccupied) const
+        {
+            for (const auto& entry : vec)
+            {
+                match(
+                    entry,
+                    [&](const FreeEntry& e) { onFree(e.id, e.nextIndex ? std::make_optional(e.nextIndex->value) : std::nullopt); },
+                    [&](const OccupiedEntry& e) { onOccupied(e.first, e.second); });
+            }
+        }
+
+        /** Removes every slot, so that the map can be rebuilt with the restore functions. */
+        void clearSlots()
+        {
+            vec.clear();
+            firstFreeSlotIndex = std::nullopt;
+        }
+
+        void restoreFreeSlot(Id id, std::optional<unsigned int> nextFreeSlotIndex)
+        {
+            checkRestoredId(id);
+            vec.emplace_back(FreeEntry(id, nextFreeSlotIndex ? std::make_optional(Index(*nextFreeSlotIndex)) : std::nullopt));
+        }
+
+        void restoreOccupiedSlot(Id id, T&& value)
+        {
+            checkRestoredId(id);
+            vec.emplace_back(std::make_pair(id, std::move(value)));
+        }
+
+        void restoreFirstFreeSlotIndex(std::optional<unsigned int> index)
+        {
+            if (index && *index >= vec.size())
+            {
+                throw std::runtime_error("First free slot index out of range");
+            }
+            firstFreeSlotIndex = index ? std::make_optional(Index(*index)) : std::nullopt;
+        }
+
     private:
+        void checkRestoredId(Id id) const
+        {
+            if (extractIndex(id).value != vec.size())
+            {
+                throw std::runtime_error("Restored ID does not match its slot");
+            }
+        }
+
         static Index extractIndex(Id id)
         {
             return Index(id.value >> 8u);
@@ -287,6 +287,35 @@ namespace rwe
             REQUIRE(c.find(dId) == c.end());
         }
 
+        SECTION("can be rebuilt slot by slot")
+        {
+            VectorMap<char, IdTag> m;
+            auto aId = m.emplace('a');
+            m.emplace('b');
+            auto cId = m.emplace('c');
+            m.emplace('d');
+            m.remove(aId);
+            m.remove(cId);
+
+            VectorMap<char, IdTag> copy;
+            copy.emplace('z');
+            copy.clearSlots();
+            m.forEachSlot(
+                [&](Id id, std::optional<unsigned int> next) { copy.restoreFreeSlot(id, next); },
+                [&](Id id, char value) { copy.restoreOccupiedSlot(id, char(value)); });
+            copy.restoreFirstFreeSlotIndex(m.getFirstFreeSlotIndex());
+
+            REQUIRE(copy.getSlotCount() == 4);
+            REQUIRE(copy.tryGet(Id(256)) == 'b');
+            REQUIRE(copy.tryGet(Id(768)) == 'd');
+            REQUIRE(!copy.tryGet(aId));
+
+            // new elements reuse the same slots, with the same generations
+            REQUIRE(copy.emplace('e') == m.emplace('e'));
+            REQUIRE(copy.emplace('f') == m.emplace('f'));
+            REQUIRE(copy.emplace('g') == m.emplace('g'));
+        }
+
         rc::prop("can insert and remove elements and it doesn't break", [](std::vector<std::optional<int>> ops) {
             VectorMap<int, IdTag> m;
 
@@ -0,0 +1,82 @@
+#include "DesyncSearch.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace rwe
+{
+    DesyncSearch::DesyncSearch(GameTime gameTime, PlayerId peer) : gameTime(gameTime), peer(peer)
+    {
+    }
+
+    GameTime DesyncSearch::getGameTime() const
+    {
+        return gameTime;
+    }
+
+    PlayerId DesyncSearch::getPeer() const
+    {
+        return peer;
+    }
+
+    const GameHashTree::Path& DesyncSearch::getCurrentPath() const
+    {
+        return currentPath;
+    }
+
+    bool DesyncSearch::isFinished() const
+    {
+        return result.has_value();
+    }
+
+    const std::optional<DesyncSearchResult>& DesyncSearch::getResult() const
+    {
+        return result;
+    }
+
+    void DesyncSearch::receiveChildren(const std::vector<GameHashTree::Child>& localChildren, const std::vector<GameHashTree::Child>& remoteChildren)
+    {
+        if (result)
+        {
+            throw std::logic_error("Desync search has already finished");
+        }
+
+        if (localChildren.empty() && remoteChildren.empty())
+        {
+            result = DesyncSearchResult{DesyncSearchResult::Kind::LeafDiffers, currentPath};
+            return;
+        }
+
+        auto findChild = [](const std::vector<GameHashTree::Child>& children, uint32_t key) {
+            return std::find_if(children.begin(), children.end(), [&](const auto& c) { return c.first == key; });
+        };
+
+        for (const auto& [key, hash] : localChildren)
+        {
+            auto remoteIt = findChild(remoteChildren, key);
+            if (remoteIt == remoteChildren.end())
+            {
+                currentPath.push_back(key);
+                result = DesyncSearchResult{DesyncSearchResult::Kind::OnlyLocal, currentPath};
+                return;
+            }
+
+            if (remoteIt->second != hash)
+            {
+                currentPath.push_back(key);
+                return;
+            }
+        }
+
+        for (const auto& [key, hash] : remoteChildren)
+        {
+            if (findChild(localChildren, key) == localChildren.end())
+            {
+                currentPath.push_back(key);
+                result = DesyncSearchResult{DesyncSearchResult::Kind::OnlyRemote, currentPath};
+                return;
+            }
+        }
+
+        result = DesyncSearchResult{DesyncSearchResult::Kind::Inconclusive, currentPath};
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <optional>
+#include <rwe/sim/GameHashTree.h>
+#include <rwe/sim/GameTime.h>
+#include <rwe/sim/PlayerId.h>
+#include <vector>
+
+namespace rwe
+{
+    struct DesyncSearchResult
+    {
+        enum class Kind
+        {
+            /** The node at the path is a leaf, such as a field of a unit, whose hash differs. */
+            LeafDiffers,
+            /** The node at the path exists only in the local tree. */
+            OnlyLocal,
+            /** The node at the path exists only in the remote tree. */
+            OnlyRemote,
+            /** The children of the node at the path all match, though the node itself did not. */
+            Inconclusive,
+        };
+
+        Kind kind;
+        GameHashTree::Path path;
+    };
+
+    /**
+     * Walks the local and a remote hash tree for the same tick
+     * down from the root to the first node where they differ.
+     *
+     * The caller fetches the children of getCurrentPath()
+     * from both trees and passes them to receiveChildren,
+     * until isFinished() returns true.
+     * This takes one round trip per level of the tree.
+     */
+    class DesyncSearch
+    {
+    private:
+        GameTime gameTime;
+        PlayerId peer;
+        GameHashTree::Path currentPath;
+        std::optional<DesyncSearchResult> result;
+
+    public:
+        DesyncSearch(GameTime gameTime, PlayerId peer);
+
+        GameTime getGameTime() const;
+
+        PlayerId getPeer() const;
+
+        /** The path of the node whose children are needed next. */
+        const GameHashTree::Path& getCurrentPath() const;
+
+        bool isFinished() const;
+
+        const std::optional<DesyncSearchResult>& getResult() const;
+
+        /**
+         * Compares the children of the current node in the local and remote trees.
+         * Descends into the first child whose hashes differ,
+         * or finishes if there is no such child.
+         */
+        void receiveChildren(const std::vector<GameHashTree::Child>& localChildren, const std::vector<GameHashTree::Child>& remoteChildren);
+    };
+}
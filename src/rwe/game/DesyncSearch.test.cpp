@@ -0,0 +1,51 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/game/DesyncSearch.h>
+
+namespace rwe
+{
+    TEST_CASE("DesyncSearch")
+    {
+        DesyncSearch search(GameTime(5), PlayerId(1));
+        REQUIRE(search.getCurrentPath().empty());
+        REQUIRE(!search.isFinished());
+
+        SECTION("descends into the first differing child down to a leaf")
+        {
+            search.receiveChildren({{0, GameHash(1)}, {2, GameHash(7)}, {3, GameHash(9)}}, {{0, GameHash(1)}, {2, GameHash(8)}, {3, GameHash(10)}});
+            REQUIRE(search.getCurrentPath() == GameHashTree::Path{2});
+            REQUIRE(!search.isFinished());
+
+            search.receiveChildren({{4, GameHash(3)}, {6, GameHash(4)}}, {{4, GameHash(3)}, {6, GameHash(5)}});
+            REQUIRE(search.getCurrentPath() == GameHashTree::Path{2, 6});
+
+            search.receiveChildren({}, {});
+            REQUIRE(search.isFinished());
+            REQUIRE(search.getResult()->kind == DesyncSearchResult::Kind::LeafDiffers);
+            REQUIRE(search.getResult()->path == GameHashTree::Path{2, 6});
+        }
+
+        SECTION("stops at a child that only exists locally")
+        {
+            search.receiveChildren({{1, GameHash(1)}, {2, GameHash(2)}}, {{2, GameHash(2)}});
+            REQUIRE(search.isFinished());
+            REQUIRE(search.getResult()->kind == DesyncSearchResult::Kind::OnlyLocal);
+            REQUIRE(search.getResult()->path == GameHashTree::Path{1});
+        }
+
+        SECTION("stops at a child that only exists remotely")
+        {
+            search.receiveChildren({{2, GameHash(2)}}, {{2, GameHash(2)}, {3, GameHash(1)}});
+            REQUIRE(search.isFinished());
+            REQUIRE(search.getResult()->kind == DesyncSearchResult::Kind::OnlyRemote);
+            REQUIRE(search.getResult()->path == GameHashTree::Path{3});
+        }
+
+        SECTION("is inconclusive when all children match")
+        {
+            search.receiveChildren({{2, GameHash(2)}}, {{2, GameHash(2)}});
+            REQUIRE(search.isFinished());
+            REQUIRE(search.getResult()->kind == DesyncSearchResult::Kind::Inconclusive);
+            REQUIRE(search.getResult()->path.empty());
+        }
+    }
+}
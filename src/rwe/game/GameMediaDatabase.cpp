@@ -1,4 +1,6 @@
 #include "GameMediaDatabase.h"
+#include <algorithm>
+#include <cmath>
 
 namespace rwe
 {
@@ -47,31 +49,14 @@ namespace rwe
         return it->second;
     }
 
-    const WeaponMediaInfo& GameMediaDatabase::getWeapon(const std::string& weaponName) const
+    const WeaponMediaInfo& GameMediaDatabase::getWeapon(WeaponDefinitionId weaponId) const
     {
-        auto it = weaponMap.find(toUpper(weaponName));
-        if (it == weaponMap.end())
-        {
-            throw std::runtime_error("No weapon found with name " + weaponName);
-        }
-
-        return it->second;
-    }
-
-    std::optional<std::reference_wrapper<const WeaponMediaInfo>> GameMediaDatabase::tryGetWeapon(const std::string& weaponName) const
-    {
-        auto it = weaponMap.find(toUpper(weaponName));
-        if (it == weaponMap.end())
-        {
-            return std::nullopt;
-        }
-
-        return it->second;
+        return weaponMap.get(weaponId);
     }
 
-    void GameMediaDatabase::addWeapon(const std::string& weaponName, WeaponMediaInfo&& weapon)
+    WeaponDefinitionId GameMediaDatabase::addWeapon(WeaponMediaInfo&& weapon)
     {
-        weaponMap.insert({toUpper(weaponName), std::move(weapon)});
+        return weaponMap.insert(std::move(weapon));
     }
 
     const SoundClass defaultSoundClass = SoundClass();
@@ -132,6 +117,14 @@ namespace rwe
 
     void GameMediaDatabase::addSelectionCollisionMesh(const std::string& objectName, std::shared_ptr<CollisionMesh> mesh)
     {
+        for (const auto& t : mesh->triangles)
+        {
+            for (const auto& v : {t.a, t.b, t.c})
+            {
+                maxSelectionCollisionMeshRadius = std::max(maxSelectionCollisionMeshRadius, std::sqrt((v.x * v.x) + (v.z * v.z)));
+            }
+        }
+
         selectionCollisionMeshesMap.insert({objectName, mesh});
     }
 
@@ -145,6 +138,11 @@ namespace rwe
         return it->second;
     }
 
+    float GameMediaDatabase::getMaxSelectionCollisionMeshRadius() const
+    {
+        return maxSelectionCollisionMeshRadius;
+    }
+
     const FeatureMediaInfo& GameMediaDatabase::getFeature(FeatureDefinitionId featureId) const
     {
         return featureMap.get(featureId);
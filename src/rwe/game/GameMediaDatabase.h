@@ -12,6 +12,7 @@
 #include <rwe/render/GlMesh.h>
 #include <rwe/render/SpriteSeries.h>
 #include <rwe/sim/FeatureDefinitionId.h>
+#include <rwe/sim/WeaponDefinitionId.h>
 #include <rwe/util/rwe_string.h>
 #include <utility>
 
@@ -63,7 +64,7 @@ namespace rwe
 
         std::unordered_map<std::pair<std::string, std::string>, std::shared_ptr<SpriteSeries>, CaseInsensitivePairHash, CaseInsensitivePairEquals> spritesMap;
 
-        std::unordered_map<std::string, WeaponMediaInfo> weaponMap;
+        SimpleVectorMap<WeaponMediaInfo, WeaponDefinitionIdTag> weaponMap;
 
         std::unordered_map<std::string, SoundClass> soundClassMap;
 
@@ -71,6 +72,8 @@ namespace rwe
 
         std::unordered_map<std::string, std::shared_ptr<CollisionMesh>> selectionCollisionMeshesMap;
 
+        float maxSelectionCollisionMeshRadius{0.0f};
+
         SimpleVectorMap<FeatureMediaInfo, FeatureDefinitionIdTag> featureMap;
 
     public:
@@ -86,11 +89,9 @@ namespace rwe
 
         std::optional<std::shared_ptr<SpriteSeries>> getSpriteSeries(const std::string& gaf, const std::string& anim) const;
 
-        const WeaponMediaInfo& getWeapon(const std::string& weaponName) const;
-
-        std::optional<std::reference_wrapper<const WeaponMediaInfo>> tryGetWeapon(const std::string& weaponName) const;
+        const WeaponMediaInfo& getWeapon(WeaponDefinitionId weaponId) const;
 
-        void addWeapon(const std::string& name, WeaponMediaInfo&& weapon);
+        WeaponDefinitionId addWeapon(WeaponMediaInfo&& weapon);
 
         const SoundClass& getSoundClassOrDefault(const std::string& className) const;
 
@@ -108,6 +109,13 @@ namespace rwe
 
         std::optional<std::shared_ptr<CollisionMesh>> getSelectionCollisionMesh(const std::string& objectName) const;
 
+        /**
+         * Returns the largest distance on the XZ plane
+         * between a model's origin and any point of its selection collision mesh,
+         * across all selection collision meshes.
+         */
+        float getMaxSelectionCollisionMeshRadius() const;
+
         const FeatureMediaInfo& getFeature(FeatureDefinitionId featureId) const;
 
         FeatureMediaInfo& getFeature(FeatureDefinitionId featureId);
@@ -62,6 +62,21 @@ namespace rwe
         });
     }
 
+    void GameNetworkService::requestHashTreeChildren(PlayerId peer, GameTime gameTime, const GameHashTree::Path& path)
+    {
+        asio::post(ioContext, [this, peer, gameTime, path]() {
+            auto it = std::find_if(endpoints.begin(), endpoints.end(), [&](const auto& e) { return e.playerId == peer; });
+            if (it == endpoints.end())
+            {
+                LOG_ERROR << "Requested hash tree from unknown player " << peer.value;
+                return;
+            }
+
+            it->pendingHashTreeRequest = std::make_pair(gameTime, path);
+            sendHashTreeRequest(*it);
+        });
+    }
+
     SceneTime GameNetworkService::estimateAvergeSceneTime(SceneTime localSceneTime)
     {
         std::promise<unsigned int> result;
@@ -188,6 +203,10 @@ namespace rwe
         for (auto& e : endpoints)
         {
             send(e);
+            if (e.pendingHashTreeRequest)
+            {
+                sendHashTreeRequest(e);
+            }
         }
     }
 
@@ -203,6 +222,33 @@ namespace rwe
         }
 
         auto message = createProtoMessage(packetId, localPlayerId, currentSceneTime, endpoint.nextCommandToSend, endpoint.nextCommandToReceive, endpoint.nextHashToSend, endpoint.nextHashToReceive, delay, endpoint.sendBuffer, endpoint.hashSendBuffer);
+        sendMessage(message, endpoint.endpoint);
+
+        auto nextSequenceNumber = SequenceNumber(endpoint.nextCommandToSend.value + (endpoint.sendBuffer.size()));
+        if (endpoint.sendTimes.empty() || endpoint.sendTimes.back().first < nextSequenceNumber)
+        {
+            endpoint.sendTimes.emplace_back(nextSequenceNumber, sendTime);
+        }
+    }
+
+    void GameNetworkService::sendHashTreeRequest(const EndpointInfo& endpoint)
+    {
+        const auto& [gameTime, path] = *endpoint.pendingHashTreeRequest;
+
+        proto::NetworkMessage outerMessage;
+        auto& m = *outerMessage.mutable_hash_tree_request();
+        m.set_player_id(localPlayerId.value);
+        m.set_game_time(gameTime.value);
+        for (auto key : path)
+        {
+            m.add_path(key);
+        }
+
+        sendMessage(outerMessage, endpoint.endpoint);
+    }
+
+    void GameNetworkService::sendMessage(const proto::NetworkMessage& message, const asio::ip::udp::endpoint& endpoint)
+    {
         auto messageSize = message.ByteSizeLong();
         if (messageSize > getSize(sendBuffer) - 4)
         {
@@ -216,13 +262,7 @@ namespace rwe
         // throw in a CRC to verify the message
         writeInt(&sendBuffer[messageSize], computeCrc(sendBuffer.data(), messageSize));
 
-        socket.send_to(asio::buffer(sendBuffer.data(), messageSize + 4), endpoint.endpoint);
-
-        auto nextSequenceNumber = SequenceNumber(endpoint.nextCommandToSend.value + (endpoint.sendBuffer.size()));
-        if (endpoint.sendTimes.empty() || endpoint.sendTimes.back().first < nextSequenceNumber)
-        {
-            endpoint.sendTimes.emplace_back(nextSequenceNumber, sendTime);
-        }
+        socket.send_to(asio::buffer(sendBuffer.data(), messageSize + 4), endpoint);
     }
 
     void GameNetworkService::receive(const asio::error_code& error, std::size_t receivedBytes)
@@ -265,6 +305,21 @@ namespace rwe
 
         proto::NetworkMessage outerMessage;
         outerMessage.ParseFromArray(receiveBuffer.data(), receivedBytes - 4);
+
+        EndpointInfo& endpoint = *endpointIt;
+
+        if (outerMessage.has_hash_tree_request())
+        {
+            receiveHashTreeRequest(endpoint, outerMessage.hash_tree_request());
+            return;
+        }
+
+        if (outerMessage.has_hash_tree_response())
+        {
+            receiveHashTreeResponse(endpoint, outerMessage.hash_tree_response());
+            return;
+        }
+
         if (!outerMessage.has_game_update())
         {
             // message wasn't a game update, ignore it
@@ -272,8 +327,6 @@ namespace rwe
             return;
         }
 
-        EndpointInfo& endpoint = *endpointIt;
-
         const auto& message = outerMessage.game_update();
 
         LOG_DEBUG << "Packet received with ID " << message.packet_id();
@@ -366,4 +419,87 @@ namespace rwe
             endpoint.nextHashToReceive += GameTime(1);
         }
     }
+
+    void GameNetworkService::receiveHashTreeRequest(const EndpointInfo& endpoint, const proto::HashTreeRequestMessage& message)
+    {
+        if (message.player_id() != endpoint.playerId.value)
+        {
+            LOG_ERROR << "Player " << endpoint.playerId.value << " endpoint sent wrong player ID: " << message.player_id();
+            return;
+        }
+
+        GameTime gameTime(message.game_time());
+        GameHashTree::Path path(message.path().begin(), message.path().end());
+        auto children = playerCommandService->getLocalHashTreeChildren(gameTime, path);
+
+        proto::NetworkMessage outerMessage;
+        auto& m = *outerMessage.mutable_hash_tree_response();
+        m.set_player_id(localPlayerId.value);
+        m.set_game_time(gameTime.value);
+        for (auto key : path)
+        {
+            m.add_path(key);
+        }
+        m.set_available(children.has_value());
+        if (children)
+        {
+            for (const auto& [key, hash] : *children)
+            {
+                m.add_child_keys(key);
+                m.add_child_hashes(hash.value);
+            }
+        }
+
+        if (outerMessage.ByteSizeLong() > getSize(sendBuffer) - 4)
+        {
+            LOG_ERROR << "Hash tree node has too many children to send (" << children->size() << ")";
+            m.set_available(false);
+            m.clear_child_keys();
+            m.clear_child_hashes();
+        }
+
+        sendMessage(outerMessage, endpoint.endpoint);
+    }
+
+    void GameNetworkService::receiveHashTreeResponse(EndpointInfo& endpoint, const proto::HashTreeResponseMessage& message)
+    {
+        if (message.player_id() != endpoint.playerId.value)
+        {
+            LOG_ERROR << "Player " << endpoint.playerId.value << " endpoint sent wrong player ID: " << message.player_id();
+            return;
+        }
+
+        if (!endpoint.pendingHashTreeRequest)
+        {
+            return;
+        }
+
+        GameTime gameTime(message.game_time());
+        GameHashTree::Path path(message.path().begin(), message.path().end());
+        if (endpoint.pendingHashTreeRequest->first != gameTime || endpoint.pendingHashTreeRequest->second != path)
+        {
+            // response to an earlier request, ignore it
+            return;
+        }
+
+        endpoint.pendingHashTreeRequest = std::nullopt;
+
+        std::optional<std::vector<GameHashTree::Child>> children;
+        if (message.available())
+        {
+            if (message.child_keys_size() != message.child_hashes_size())
+            {
+                LOG_ERROR << "Hash tree response has " << message.child_keys_size() << " keys but " << message.child_hashes_size() << " hashes";
+                return;
+            }
+
+            children.emplace();
+            for (int i = 0; i < message.child_keys_size(); ++i)
+            {
+                children->emplace_back(message.child_keys(i), GameHash(message.child_hashes(i)));
+            }
+        }
+
+        playerCommandService->pushHashTreeResponse(HashTreeResponse{endpoint.playerId, gameTime, std::move(path), std::move(children)});
+    }
 }
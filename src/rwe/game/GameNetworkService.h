@@ -10,6 +10,7 @@
 #include <rwe/game/PlayerCommandService.h>
 #include <rwe/rwe_time.h>
 #include <rwe/sim/GameHash.h>
+#include <rwe/sim/GameHashTree.h>
 #include <rwe/sim/GameTime.h>
 #include <rwe/sim/PlayerId.h>
 #include <rwe/util/OpaqueId.h>
@@ -53,6 +54,12 @@ namespace rwe
 
             std::deque<GameHash> hashSendBuffer;
 
+            /**
+             * The hash tree node whose children we have asked this peer for
+             * and not yet received. The request is resent until answered.
+             */
+            std::optional<std::pair<GameTime, GameHashTree::Path>> pendingHashTreeRequest;
+
             /**
              * Records the time at which we first sent a packet
              * finishing at the given sequence number.
@@ -116,6 +123,13 @@ namespace rwe
 
         void submitGameHash(GameHash hash);
 
+        /**
+         * Asks a peer for the children of a node in its hash tree for the given tick.
+         * The answer is delivered through PlayerCommandService::tryPopHashTreeResponse.
+         * Replaces any request to that peer that has not yet been answered.
+         */
+        void requestHashTreeChildren(PlayerId peer, GameTime gameTime, const GameHashTree::Path& path);
+
         SceneTime estimateAvergeSceneTime(SceneTime localSceneTime);
 
         float getMaxAverageRttMillis();
@@ -131,6 +145,14 @@ namespace rwe
 
         void send(EndpointInfo& endpoint);
 
+        void sendHashTreeRequest(const EndpointInfo& endpoint);
+
+        void sendMessage(const proto::NetworkMessage& message, const asio::ip::udp::endpoint& endpoint);
+
         void receive(const asio::error_code& error, std::size_t receivedBytes);
+
+        void receiveHashTreeRequest(const EndpointInfo& endpoint, const proto::HashTreeRequestMessage& message);
+
+        void receiveHashTreeResponse(EndpointInfo& endpoint, const proto::HashTreeResponseMessage& message);
     };
 }
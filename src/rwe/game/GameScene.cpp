@@ -6,10 +6,12 @@
 #include <rwe/Mesh.h>
 #include <rwe/camera_util.h>
 #include <rwe/game/GameScene_util.h>
+#include <rwe/game/PlayerCommand_util.h>
 #include <rwe/game/dump_util.h>
 #include <rwe/game/matrix_util.h>
 #include <rwe/resource_io.h>
 #include <rwe/sim/SimTicksPerSecond.h>
+#include <rwe/sim/UnitMemoryReport.h>
 #include <rwe/ui/UiStagedButton.h>
 #include <rwe/util/Index.h>
 #include <rwe/util/match.h>
@@ -19,7 +21,7 @@ namespace rwe
 {
     bool isValidUnitType(const GameSimulation& simulation, const std::string& unitType)
     {
-        return simulation.unitDefinitions.find(unitType) != simulation.unitDefinitions.end();
+        return simulation.tryGetUnitDefinitionId(unitType).has_value();
     }
 
     std::optional<std::reference_wrapper<const std::vector<GuiEntry>>> getBuilderGui(const BuilderGuisDatabase& db, const std::string& unitType, unsigned int page)
@@ -55,28 +57,28 @@ namespace rwe
     bool unitCanAttack(const GameSimulation& sim, UnitId unitId)
     {
         const auto& unit = sim.getUnitState(unitId);
-        const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = sim.unitDefinitions.get(unit.unitType);
         return unitDefinition.canAttack;
     }
 
     bool unitCanMove(const GameSimulation& sim, UnitId unitId)
     {
         const auto& unit = sim.getUnitState(unitId);
-        const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = sim.unitDefinitions.get(unit.unitType);
         return unitDefinition.canMove;
     }
 
     bool unitCanGuard(const GameSimulation& sim, UnitId unitId)
     {
         const auto& unit = sim.getUnitState(unitId);
-        const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = sim.unitDefinitions.get(unit.unitType);
         return unitDefinition.canGuard;
     }
 
     bool unitIsBuilder(const GameSimulation& sim, UnitId unitId)
     {
         const auto& unit = sim.getUnitState(unitId);
-        const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = sim.unitDefinitions.get(unit.unitType);
         return unitDefinition.builder;
     }
 
@@ -87,21 +89,21 @@ namespace rwe
             return false;
         }
         const auto& unit = sim.getUnitState(*singleSelectedUnit);
-        const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = sim.unitDefinitions.get(unit.unitType);
         return unitDefinition.builder;
     }
 
     bool unitIsBeingBuilt(const GameSimulation& sim, UnitId unitId)
     {
         const auto& unit = sim.getUnitState(unitId);
-        const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = sim.unitDefinitions.get(unit.unitType);
         return unit.isBeingBuilt(unitDefinition);
     }
 
     bool unitIsSelectableBy(const GameSimulation& sim, UnitId unitId, PlayerId playerId)
     {
         const auto& unit = sim.getUnitState(unitId);
-        const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = sim.unitDefinitions.get(unit.unitType);
         return unit.isSelectableBy(unitDefinition, playerId);
     }
 
@@ -116,7 +118,7 @@ namespace rwe
         {
             return false;
         }
-        const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = sim.unitDefinitions.get(unit.unitType);
         return unitDefinition.builder;
     }
 
@@ -214,7 +216,8 @@ namespace rwe
         const std::shared_ptr<SpriteSeries>& guiFont,
         PlayerId localPlayerId,
         TdfBlock* audioLookup,
-        std::optional<std::ofstream>&& stateLogStream)
+        std::optional<StateLogWriter>&& stateLog,
+        std::optional<ReplayWriter>&& replayWriter)
         : sceneContext(sceneContext),
           worldViewport(CroppedViewport(this->sceneContext.viewport, GuiSizeLeft, GuiSizeTop, GuiSizeRight, GuiSizeBottom)),
           playerCommandService(std::move(playerCommandService)),
@@ -236,7 +239,8 @@ namespace rwe
           guiFont(guiFont),
           localPlayerId(localPlayerId),
           uiFactory(sceneContext.textureService, sceneContext.audioService, audioLookup, sceneContext.vfs, sceneContext.pathMapping, sceneContext.viewport->width(), sceneContext.viewport->height()),
-          stateLogStream(std::move(stateLogStream))
+          stateLog(std::move(stateLog)),
+          replayWriter(std::move(replayWriter))
     {
     }
 
@@ -419,7 +423,7 @@ namespace rwe
         if (hoveredUnit)
         {
             const auto& unit = getUnit(*hoveredUnit);
-            const auto& unitDefinition = simulation.unitDefinitions.at(unit.unitType);
+            const auto& unitDefinition = simulation.unitDefinitions.get(unit.unitType);
             if (logos)
             {
                 const auto& rect = localSideData.logo2.toDiscreteRect();
@@ -496,7 +500,7 @@ namespace rwe
         }
         else if (auto hoveredBuildButtonUnitType = getUnitBuildButtonUnderCursor(); hoveredBuildButtonUnitType)
         {
-            const auto& unitDefinition = simulation.unitDefinitions.at(*hoveredBuildButtonUnitType);
+            const auto& unitDefinition = simulation.unitDefinitions.get(simulation.getUnitDefinitionId(*hoveredBuildButtonUnitType));
 
             {
                 const auto& rect = localSideData._name;
@@ -565,7 +569,7 @@ namespace rwe
             if (const auto buildOrder = std::get_if<BuildOrder>(&order))
             {
                 const auto& unitType = buildOrder->unitType;
-                const auto& unitDefinition = simulation.unitDefinitions.at(unitType);
+                const auto& unitDefinition = simulation.unitDefinitions.get(simulation.getUnitDefinitionId(unitType));
                 auto mc = simulation.getAdHocMovementClass(unitDefinition.movementCollisionInfo);
                 auto footprintRect = simulation.computeFootprintRegion(buildOrder->position, unitDefinition.movementCollisionInfo);
 
@@ -726,7 +730,7 @@ namespace rwe
         if (auto selectedUnit = getSingleSelectedUnit(); selectedUnit && movementClassGridVisible)
         {
             const auto& unit = simulation.getUnitState(*selectedUnit);
-            const auto& unitDefinition = simulation.unitDefinitions.at(unit.unitType);
+            const auto& unitDefinition = simulation.unitDefinitions.get(unit.unitType);
             match(
                 unitDefinition.movementCollisionInfo,
                 [&](const UnitDefinition::NamedMovementClass& c) {
@@ -745,7 +749,7 @@ namespace rwe
         for (const auto& selectedUnitId : selectedUnits)
         {
             const auto& unit = getUnit(selectedUnitId);
-            const auto& unitDefinition = simulation.unitDefinitions.at(unit.unitType);
+            const auto& unitDefinition = simulation.unitDefinitions.get(unit.unitType);
             drawSelectionRect(gameMediaDatabase, viewProjectionMatrix, unit, unitDefinition, interpolationFraction, selectionRectBatch);
         }
         worldRenderService.drawLineLoopsBatch(selectionRectBatch);
@@ -755,8 +759,8 @@ namespace rwe
         UnitShadowMeshBatch unitShadowMeshBatch;
         for (const auto& [_, unit] : simulation.units)
         {
-            const auto& unitDefinition = simulation.unitDefinitions.at(unit.unitType);
-            const auto& modelDefinition = simulation.unitModelDefinitions.at(unitDefinition.objectName);
+            const auto& unitDefinition = simulation.unitDefinitions.get(unit.unitType);
+            const auto& modelDefinition = *unit.modelDefinition;
 
             auto groundHeight = simulation.terrain.getHeightAt(unit.position.x, unit.position.z);
             if (unitDefinition.floater || unitDefinition.canHover)
@@ -783,8 +787,8 @@ namespace rwe
         UnitMeshBatch unitMeshBatch;
         for (const auto& [_, unit] : simulation.units)
         {
-            const auto& unitDefinition = simulation.unitDefinitions.at(unit.unitType);
-            const auto& unitModelDefinition = simulation.unitModelDefinitions.at(unitDefinition.objectName);
+            const auto& unitDefinition = simulation.unitDefinitions.get(unit.unitType);
+            const auto& unitModelDefinition = *unit.modelDefinition;
             drawUnit(gameMediaDatabase, viewProjectionMatrix, unit, unitDefinition, unitModelDefinition, getPlayer(unit.owner).color, interpolationFraction, unitTextureAtlas.get(), unitTeamTextureAtlases, unitMeshBatch);
         }
         for (const auto& [_, feature] : simulation.features)
@@ -918,7 +922,7 @@ namespace rwe
                     continue;
                 }
 
-                const auto& unitDefinition = simulation.unitDefinitions.at(unit.unitType);
+                const auto& unitDefinition = simulation.unitDefinitions.get(unit.unitType);
 
                 auto uiPos = worldUiRenderService.getInverseViewProjectionMatrix()
                     * viewProjectionMatrix
@@ -1124,6 +1128,101 @@ namespace rwe
         }
     }
 
+    void renderTickProfilerSection(const TickProfiler& profiler, const SimpleVectorMap<UnitDefinition, UnitDefinitionIdTag>& unitDefinitions)
+    {
+        if (!TickProfiler::Enabled)
+        {
+            ImGui::Text("Tick profiler disabled at compile time (RWE_TICK_PROFILER=0)");
+            return;
+        }
+
+        auto count = profiler.getHistoryCount();
+        if (count == 0)
+        {
+            ImGui::Text("No ticks recorded yet");
+            return;
+        }
+
+        ImGui::Text("Last tick time: %.2fms (budget %dms)", profiler.getRecentTotalMs(0), SimMillisecondsPerTick);
+        ImGui::PlotLines("Tick Times", profiler.getTotalHistory().data(), TickProfiler::HistorySize, profiler.getHistoryOffset());
+
+        if (ImGui::BeginTable("Tick Phases", 4))
+        {
+            ImGui::TableSetupColumn("Phase");
+            ImGui::TableSetupColumn("Last (ms)");
+            ImGui::TableSetupColumn("Mean (ms)");
+            ImGui::TableSetupColumn("Max (ms)");
+            ImGui::TableHeadersRow();
+            for (int p = 0; p < TickPhaseCount; ++p)
+            {
+                auto phase = static_cast<TickPhase>(p);
+                auto total = 0.0f;
+                auto max = 0.0f;
+                for (int n = 0; n < count; ++n)
+                {
+                    auto ms = profiler.getRecentPhaseMs(phase, n);
+                    total += ms;
+                    max = std::max(max, ms);
+                }
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s", getTickPhaseName(phase));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", profiler.getRecentPhaseMs(phase, 0));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", total / count);
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f", max);
+            }
+            ImGui::EndTable();
+        }
+
+        if (ImGui::TreeNode("Unit Types"))
+        {
+            auto unitTypes = profiler.getUnitTypeStats();
+            std::sort(unitTypes.begin(), unitTypes.end(), [](const auto& a, const auto& b) { return a.second.lastTickMs > b.second.lastTickMs; });
+            if (ImGui::BeginTable("Unit Types", 3))
+            {
+                ImGui::TableSetupColumn("Unit Type");
+                ImGui::TableSetupColumn("Last (ms)");
+                ImGui::TableSetupColumn("Max (ms)");
+                ImGui::TableHeadersRow();
+                for (const auto& [unitType, stats] : unitTypes)
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%s", unitDefinitions.get(unitType).unitType.c_str());
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", stats.lastTickMs);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", stats.maxTickMs);
+                }
+                ImGui::EndTable();
+            }
+            ImGui::TreePop();
+        }
+
+        if (ImGui::Button("Dump CSV"))
+        {
+            std::ofstream phaseStream("tick-phases.csv");
+            profiler.writePhaseCsv(phaseStream);
+            std::ofstream unitTypeStream("tick-unit-types.csv");
+            profiler.writeUnitTypeCsv(unitTypeStream, [&](UnitDefinitionId id) { return unitDefinitions.get(id).unitType; });
+            LOG_INFO << "Wrote tick profile to tick-phases.csv and tick-unit-types.csv";
+        }
+    }
+
+    void renderUnitMemorySection(const GameSimulation& simulation)
+    {
+        auto report = createUnitMemoryReport(simulation);
+        ImGui::LabelText("Units", "%zu", report.unitCount);
+        ImGui::LabelText("Bytes per unit", "%zu", report.getBytesPerUnit());
+        ImGui::LabelText("Bytes per unit (per-unit piece names)", "%zu", report.getBytesPerUnitWithCopies());
+        ImGui::LabelText("Shared piece metadata", "%zu bytes", report.sharedBytes);
+        ImGui::LabelText("Saved by sharing", "%zu bytes", report.perUnitCopyBytes);
+    }
+
     void GameScene::renderDebugWindow()
     {
         if (!showDebugWindow)
@@ -1148,7 +1247,10 @@ namespace rwe
         ImGui::Separator();
         ImGui::Checkbox("Cursor terrain dot", &cursorTerrainDotVisible);
         ImGui::Checkbox("Occupied grid", &occupiedGridVisible);
-        ImGui::Checkbox("Pathfinding visualisation", &pathfindingVisualisationVisible);
+        if (ImGui::Checkbox("Pathfinding visualisation", &pathfindingVisualisationVisible))
+        {
+            simulation.pathFindingService.debugInfoEnabled = pathfindingVisualisationVisible;
+        }
         ImGui::Checkbox("Movement class grid", &movementClassGridVisible);
         ImGui::InputInt("Side", &unitSpawnPlayer);
         if (ImGui::InputText("Spawn Unit", unitSpawnText, IM_ARRAYSIZE(unitSpawnText), ImGuiInputTextFlags_EnterReturnsTrue))
@@ -1171,6 +1273,20 @@ namespace rwe
             ImGui::LabelText("Sound volume", "%d", computeSoundVolume(getSize(playingUnitChannels)));
         }
 
+        if (ImGui::CollapsingHeader("Tick Profiler"))
+        {
+            ImGui::Indent();
+            renderTickProfilerSection(simulation.tickProfiler, simulation.unitDefinitions);
+            ImGui::Unindent();
+        }
+
+        if (ImGui::CollapsingHeader("Unit Memory"))
+        {
+            ImGui::Indent();
+            renderUnitMemorySection(simulation);
+            ImGui::Unindent();
+        }
+
         if (ImGui::CollapsingHeader("Selected Unit"))
         {
             ImGui::Indent();
@@ -1264,7 +1380,7 @@ namespace rwe
                 std::optional<UnitId> commanderUnitId;
                 for (const auto& [unitId, unit] : simulation.units)
                 {
-                    const auto& unitDefinition = simulation.unitDefinitions.at(unit.unitType);
+                    const auto& unitDefinition = simulation.unitDefinitions.get(unit.unitType);
                     if (unitDefinition.commander && unit.isOwnedBy(localPlayerId))
                     {
                         selectAdditionalUnit(unitId);
@@ -1450,7 +1566,7 @@ namespace rwe
                                     }
                                     else
                                     {
-                                        if (const auto& u = getUnit(*hoveredUnit); u.isBeingBuilt(simulation.unitDefinitions.at(u.unitType)))
+                                        if (const auto& u = getUnit(*hoveredUnit); u.isBeingBuilt(simulation.unitDefinitions.get(u.unitType)))
                                         {
                                             if (isShiftDown())
                                             {
@@ -1542,7 +1658,7 @@ namespace rwe
                                 }
                                 else
                                 {
-                                    if (const auto& u = getUnit(*hoveredUnit); u.isBeingBuilt(simulation.unitDefinitions.at(u.unitType)))
+                                    if (const auto& u = getUnit(*hoveredUnit); u.isBeingBuilt(simulation.unitDefinitions.get(u.unitType)))
                                     {
                                         if (isShiftDown())
                                         {
@@ -1599,7 +1715,7 @@ namespace rwe
 
                             if (sceneTime - state.startTime < SceneTime(30) && state.startPosition.maxSingleDimensionDistance(originRelativePos) < 32)
                             {
-                                if (hoveredUnit && getUnit(*hoveredUnit).isSelectableBy(simulation.unitDefinitions.at(getUnit(*hoveredUnit).unitType), localPlayerId))
+                                if (hoveredUnit && getUnit(*hoveredUnit).isSelectableBy(simulation.unitDefinitions.get(getUnit(*hoveredUnit).unitType), localPlayerId))
                                 {
                                     if (isShiftDown())
                                     {
@@ -1628,7 +1744,7 @@ namespace rwe
                                     }
                                     else
                                     {
-                                        if (const auto& u = getUnit(*hoveredUnit); u.isBeingBuilt(simulation.unitDefinitions.at(u.unitType)))
+                                        if (const auto& u = getUnit(*hoveredUnit); u.isBeingBuilt(simulation.unitDefinitions.get(u.unitType)))
                                         {
                                             for (const auto& selectedUnit : selectedUnits)
                                             {
@@ -1883,7 +1999,7 @@ namespace rwe
             {
                 const auto& unitType = buildCursor->unitType;
                 const auto& pos = *intersect;
-                const auto& unitDefinition = simulation.unitDefinitions.at(unitType);
+                const auto& unitDefinition = simulation.unitDefinitions.get(simulation.getUnitDefinitionId(unitType));
                 auto mc = simulation.getAdHocMovementClass(unitDefinition.movementCollisionInfo);
                 auto footprintRect = simulation.computeFootprintRegion(pos, unitDefinition.movementCollisionInfo);
                 auto isValid = simulation.canBeBuiltAt(mc, unitDefinition.yardMap, unitDefinition.yardMapContainsGeo, footprintRect.x, footprintRect.y);
@@ -2062,10 +2178,11 @@ namespace rwe
         if (unitId)
         {
             auto& unit = getUnit(*unitId);
-            const auto& unitDefinition = simulation.unitDefinitions.at(unit.unitType);
+            const auto& unitDefinition = simulation.unitDefinitions.get(unit.unitType);
             // units start as unbuilt nanoframes,
             // we we need to convert it immediately into a completed unit.
             unit.finishBuilding(unitDefinition);
+            simulation.markUnitChanged(*unitId);
 
             return unit;
         }
@@ -2156,9 +2273,9 @@ namespace rwe
         }
     }
 
-    std::optional<AudioService::SoundHandle> getSound(const GameSimulation& sim, const GameMediaDatabase& meshDb, const std::string& unitType, UnitSoundType soundType)
+    std::optional<AudioService::SoundHandle> getSound(const GameSimulation& sim, const GameMediaDatabase& meshDb, UnitDefinitionId unitType, UnitSoundType soundType)
     {
-        const auto& unitDefinition = sim.unitDefinitions.at(unitType);
+        const auto& unitDefinition = sim.unitDefinitions.get(unitType);
         const auto& soundClass = meshDb.getSoundClassOrDefault(unitDefinition.soundCategory);
         const auto& soundId = getSoundName(soundClass, soundType);
         if (soundId)
@@ -2168,7 +2285,7 @@ namespace rwe
         return std::nullopt;
     }
 
-    void GameScene::playUnitNotificationSound(const PlayerId& playerId, const std::string& unitType, UnitSoundType soundType)
+    void GameScene::playUnitNotificationSound(const PlayerId& playerId, UnitDefinitionId unitType, UnitSoundType soundType)
     {
         auto sound = getSound(simulation, gameMediaDatabase, unitType, soundType);
         if (sound)
@@ -2186,7 +2303,7 @@ namespace rwe
         sceneContext.audioService->setVolume(channel, computeSoundVolume(playingUnitChannels.size()));
     }
 
-    void GameScene::playWeaponStartSound(const Vector3f& position, const std::string& weaponType)
+    void GameScene::playWeaponStartSound(const Vector3f& position, WeaponDefinitionId weaponType)
     {
 
         const auto& weaponMediaInfo = gameMediaDatabase.getWeapon(weaponType);
@@ -2200,7 +2317,7 @@ namespace rwe
         }
     }
 
-    void GameScene::playWeaponImpactSound(const Vector3f& position, const std::string& weaponType, ImpactType impactType)
+    void GameScene::playWeaponImpactSound(const Vector3f& position, WeaponDefinitionId weaponType, ImpactType impactType)
     {
         const auto& weaponMediaInfo = gameMediaDatabase.getWeapon(weaponType);
         switch (impactType)
@@ -2232,7 +2349,7 @@ namespace rwe
         }
     }
 
-    void GameScene::spawnWeaponImpactExplosion(const Vector3f& position, const std::string& weaponType, ImpactType impactType)
+    void GameScene::spawnWeaponImpactExplosion(const Vector3f& position, WeaponDefinitionId weaponType, ImpactType impactType)
     {
         const auto& weaponMediaInfo = gameMediaDatabase.getWeapon(weaponType);
 
@@ -2320,15 +2437,127 @@ namespace rwe
         return inverseView * worldInverseProjection * minimapProjection;
     }
 
+    void GameScene::handleDesync()
+    {
+        auto now = getTimestamp();
+
+        if (!desyncDeadline)
+        {
+            auto mismatch = playerCommandService->getHashMismatch();
+            LOG_ERROR << "Desync detected at game time " << mismatch->gameTime.value;
+            for (const auto& [playerId, hash] : mismatch->hashes)
+            {
+                LOG_ERROR << "Player " << playerId.value << " hash: " << hash.value;
+            }
+
+            desyncDeadline = now + DesyncSearchTimeout;
+
+            auto localIt = std::find_if(mismatch->hashes.begin(), mismatch->hashes.end(), [&](const auto& p) { return p.first == localPlayerId; });
+            auto peerIt = std::find_if(mismatch->hashes.begin(), mismatch->hashes.end(), [&](const auto& p) { return p.second != localIt->second; });
+            if (localIt != mismatch->hashes.end() && peerIt != mismatch->hashes.end())
+            {
+                desyncSearch.emplace(mismatch->gameTime, peerIt->first);
+                gameNetworkService->requestHashTreeChildren(desyncSearch->getPeer(), desyncSearch->getGameTime(), desyncSearch->getCurrentPath());
+            }
+        }
+
+        while (desyncSearch && !desyncSearch->isFinished())
+        {
+            auto response = playerCommandService->tryPopHashTreeResponse();
+            if (!response)
+            {
+                break;
+            }
+
+            if (response->playerId != desyncSearch->getPeer() || response->gameTime != desyncSearch->getGameTime() || response->path != desyncSearch->getCurrentPath())
+            {
+                continue;
+            }
+
+            auto localChildren = playerCommandService->getLocalHashTreeChildren(desyncSearch->getGameTime(), desyncSearch->getCurrentPath());
+            if (!localChildren || !response->children)
+            {
+                LOG_ERROR << "Hash tree for game time " << desyncSearch->getGameTime().value << " is no longer available, giving up search";
+                desyncSearch = std::nullopt;
+                desyncDeadline = now;
+                break;
+            }
+
+            desyncSearch->receiveChildren(*localChildren, *response->children);
+            if (desyncSearch->isFinished())
+            {
+                LOG_ERROR << "Desync localised to " << describeHashTreePath(desyncSearch->getResult()->path);
+                desyncDeadline = now + DesyncLingerTime;
+                break;
+            }
+
+            gameNetworkService->requestHashTreeChildren(desyncSearch->getPeer(), desyncSearch->getGameTime(), desyncSearch->getCurrentPath());
+        }
+
+        if (now < *desyncDeadline)
+        {
+            return;
+        }
+
+        if (desyncSearch && !desyncSearch->isFinished())
+        {
+            LOG_ERROR << "Timed out comparing hash trees, stopped at " << describeHashTreePath(desyncSearch->getCurrentPath());
+        }
+
+        dumpDesync(desyncSearch ? desyncSearch->getResult() : std::nullopt);
+        throw std::runtime_error("Desync detected");
+    }
+
+    void GameScene::dumpDesync(const std::optional<DesyncSearchResult>& result)
+    {
+        // The simulation has carried on past the divergent tick while waiting for peer hashes,
+        // so this dumps current state rather than state at the time of the desync.
+        nlohmann::json dump;
+        if (result && result->path.size() >= 3 && result->path[0] == static_cast<uint32_t>(GameHashTree::Section::Units))
+        {
+            UnitId unitId(result->path[2]);
+            auto unit = simulation.tryGetUnitState(unitId);
+            dump = nlohmann::json{
+                {"gameTime", dumpJson(simulation.gameTime)},
+                {"desync", describeHashTreePath(result->path)},
+                {"unit", unit ? dumpJson(unit->get()) : nlohmann::json()},
+            };
+        }
+        else if (result && result->path.size() >= 3 && result->path[0] == static_cast<uint32_t>(GameHashTree::Section::Projectiles))
+        {
+            ProjectileId projectileId(result->path[2]);
+            auto projectile = simulation.projectiles.tryGet(projectileId);
+            dump = nlohmann::json{
+                {"gameTime", dumpJson(simulation.gameTime)},
+                {"desync", describeHashTreePath(result->path)},
+                {"projectile", projectile ? dumpJson(projectile->get()) : nlohmann::json()},
+            };
+        }
+        else if (result && result->path.size() >= 2 && result->path[0] == static_cast<uint32_t>(GameHashTree::Section::Players) && result->path[1] < simulation.players.size())
+        {
+            dump = nlohmann::json{
+                {"gameTime", dumpJson(simulation.gameTime)},
+                {"desync", describeHashTreePath(result->path)},
+                {"player", dumpJson(simulation.players[result->path[1]])},
+            };
+        }
+        else
+        {
+            dump = dumpJson(simulation);
+        }
+
+        std::ofstream dumpFile;
+        dumpFile.open("rwe-dump-" + std::to_string(std::rand()) + ".json");
+        dumpFile << dump;
+        dumpFile.close();
+    }
+
     void GameScene::tryTickGame()
     {
         if (!playerCommandService->checkHashes())
         {
-            std::ofstream dumpFile;
-            dumpFile.open("rwe-dump-" + std::to_string(std::rand()) + ".json");
-            dumpFile << dumpJson(simulation);
-            dumpFile.close();
-            throw std::runtime_error("Desync detected");
+            handleDesync();
+            return;
         }
 
         auto playerCommands = playerCommandService->tryPopCommands();
@@ -2342,17 +2571,28 @@ namespace rwe
 
         processActions();
 
+        if (replayWriter)
+        {
+            replayWriter->writeTick(simulation, *playerCommands);
+        }
+
         processPlayerCommands(*playerCommands);
 
         simulation.tick();
 
-        auto gameHash = simulation.computeHash();
+        auto [gameHash, hashDelta] = simulation.computeHashDelta();
+        playerCommandService->pushLocalHashDelta(simulation.gameTime, std::move(hashDelta));
         playerCommandService->pushHash(localPlayerId, gameHash);
         gameNetworkService->submitGameHash(gameHash);
 
-        if (stateLogStream)
+        if (replayWriter && simulation.gameTime.value % ReplayHashInterval == 0)
         {
-            *stateLogStream << dumpJson(simulation) << std::endl;
+            replayWriter->writeHash(simulation.gameTime, gameHash);
+        }
+
+        if (stateLog)
+        {
+            stateLog->writeFrame(simulation);
         }
 
         processSimEvents();
@@ -2453,21 +2693,43 @@ namespace rwe
 
     std::optional<UnitId> GameScene::getFirstCollidingUnit(const Ray3f& ray) const
     {
+        // Only units whose selection mesh can reach the ray's shadow
+        // on the XZ plane could possibly collide with it.
+        auto line = ray.toLine();
+        auto margin = gameMediaDatabase.getMaxSelectionCollisionMeshRadius();
+        SimVector min(
+            floatToSimScalar(std::min(line.start.x, line.end.x) - margin),
+            0_ss,
+            floatToSimScalar(std::min(line.start.z, line.end.z) - margin));
+        SimVector max(
+            floatToSimScalar(std::max(line.start.x, line.end.x) + margin),
+            0_ss,
+            floatToSimScalar(std::max(line.start.z, line.end.z) + margin));
+
+        std::vector<UnitId> candidates;
+        simulation.forEachUnitInRectangle(min, max, [&](UnitId unitId, const UnitState&) {
+            candidates.push_back(unitId);
+        });
+
+        // visit in ID order so that ties are broken consistently
+        std::sort(candidates.begin(), candidates.end());
+
         auto winnerIsMobile = false;
         auto bestDistance = std::numeric_limits<float>::infinity();
         std::optional<UnitId> it;
 
-        for (const auto& entry : simulation.units)
+        for (const auto& unitId : candidates)
         {
-            const auto& unitDefinition = simulation.unitDefinitions.at(entry.second.unitType);
+            const auto& unit = simulation.getUnitState(unitId);
+            const auto& unitDefinition = simulation.unitDefinitions.get(unit.unitType);
             auto selectionMesh = gameMediaDatabase.getSelectionCollisionMesh(unitDefinition.objectName);
-            auto distance = selectionIntersect(entry.second, *selectionMesh.value(), ray);
+            auto distance = selectionIntersect(unit, *selectionMesh.value(), ray);
             auto isMobile = unitDefinition.isMobile;
             if (distance && ((!winnerIsMobile && isMobile) || distance < bestDistance))
             {
                 winnerIsMobile = isMobile;
                 bestDistance = *distance;
-                it = entry.first;
+                it = unitId;
             }
         }
 
@@ -2601,45 +2863,11 @@ namespace rwe
         refreshBuildGuiTotal(unitId, unitType);
     }
 
-    void GameScene::issueUnitOrder(UnitId unitId, const UnitOrder& order)
-    {
-        auto unit = tryGetUnit(unitId);
-        if (unit)
-        {
-            unit->get().clearOrders();
-            unit->get().addOrder(order);
-        }
-    }
-
-    void GameScene::enqueueUnitOrder(UnitId unitId, const UnitOrder& order)
-    {
-        auto unit = tryGetUnit(unitId);
-        if (unit)
-        {
-            unit->get().addOrder(order);
-        }
-    }
-
-    void GameScene::stopUnit(UnitId unitId)
-    {
-        auto unit = tryGetUnit(unitId);
-        if (unit)
-        {
-            unit->get().clearOrders();
-        }
-    }
-
-    void GameScene::setFireOrders(UnitId unitId, UnitFireOrders orders)
+    void GameScene::onFireOrdersChanged(UnitId unitId, UnitFireOrders orders)
     {
-        auto unit = tryGetUnit(unitId);
-        if (unit)
+        if (auto selectedUnit = getSingleSelectedUnit(); selectedUnit && *selectedUnit == unitId)
         {
-            unit->get().fireOrders = orders;
-
-            if (auto selectedUnit = getSingleSelectedUnit(); selectedUnit && *selectedUnit == unitId)
-            {
-                fireOrders.next(orders);
-            }
+            fireOrders.next(orders);
         }
     }
 
@@ -2870,23 +3098,23 @@ namespace rwe
                     auto unit = tryGetUnit(e.unitId);
                     if (unit)
                     {
-                        const auto& unitDefinition = simulation.unitDefinitions.at(unit->get().unitType);
+                        const auto& unitDefinition = simulation.unitDefinitions.get(unit->get().unitType);
                         unitGuiInfos.insert_or_assign(e.unitId, UnitGuiInfo{unitDefinition.builder ? UnitGuiInfo::Section::Build : UnitGuiInfo::Section::Orders, 0});
                     }
                 },
 
                 [&](const UnitDiedEvent& e) {
-                    const auto& unitDefinition = simulation.unitDefinitions.at(e.unitType);
+                    const auto& unitDefinition = simulation.unitDefinitions.get(e.unitType);
 
                     if (!unitDefinition.explodeAs.empty())
                     {
                         switch (e.deathType)
                         {
                             case UnitDiedEvent::DeathType::NormalExploded:
-                                doProjectileImpact(e.position, unitDefinition.explodeAs, ImpactType::Normal);
+                                doProjectileImpact(e.position, simulation.getWeaponDefinitionId(unitDefinition.explodeAs), ImpactType::Normal);
                                 break;
                             case UnitDiedEvent::DeathType::WaterExploded:
-                                doProjectileImpact(e.position, unitDefinition.explodeAs, ImpactType::Water);
+                                doProjectileImpact(e.position, simulation.getWeaponDefinitionId(unitDefinition.explodeAs), ImpactType::Water);
                                 break;
                             case UnitDiedEvent::DeathType::Deleted:
                                 // do nothing
@@ -2951,7 +3179,7 @@ namespace rwe
             flashes.end());
     }
 
-    void GameScene::doProjectileImpact(const SimVector& position, const std::string& weaponType, ImpactType impactType)
+    void GameScene::doProjectileImpact(const SimVector& position, WeaponDefinitionId weaponType, ImpactType impactType)
     {
         playWeaponImpactSound(simVectorToFloat(position), weaponType, impactType);
         spawnWeaponImpactExplosion(simVectorToFloat(position), weaponType, impactType);
@@ -2988,7 +3216,7 @@ namespace rwe
     void GameScene::emitWake1FromPiece(UnitId unitId, const std::string& pieceName)
     {
         const auto& unit = getUnit(unitId);
-        const auto& unitDefinition = simulation.unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = simulation.unitDefinitions.get(unit.unitType);
         auto pieceTransform = toFloatMatrix(simulation.getUnitPieceTransform(unitId, pieceName));
         const auto& pieceMesh = gameMediaDatabase.getUnitPieceMesh(unitDefinition.objectName, pieceName).value().get();
         auto spawnPosition = pieceTransform * pieceMesh.firstVertexPosition;
@@ -3015,16 +3243,10 @@ namespace rwe
         spawnWake(spawnPosition2, velocity, duration);
     }
 
-    void GameScene::modifyBuildQueue(UnitId unitId, const std::string& unitType, int count)
+    void GameScene::onBuildQueueModified(UnitId unitId, const std::string& unitType, int count)
     {
-        auto unit = tryGetUnit(unitId);
-        if (unit)
-        {
-            unit->get().modifyBuildQueue(unitType, count);
-
-            updateUnconfirmedBuildQueueDelta(unitId, unitType, -count);
-            refreshBuildGuiTotal(unitId, unitType);
-        }
+        updateUnconfirmedBuildQueueDelta(unitId, unitType, -count);
+        refreshBuildGuiTotal(unitId, unitType);
     }
 
     struct CorpseSpawnInfo
@@ -3055,11 +3277,27 @@ namespace rwe
 
     void GameScene::processPlayerCommands(const std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>>& commands)
     {
+        applyPlayerCommands(simulation, commands);
+
         for (const auto& [_, playerCommands] : commands)
         {
             for (const auto& command : playerCommands)
             {
-                processPlayerCommand(command);
+                auto unitCommand = std::get_if<PlayerUnitCommand>(&command);
+                if (unitCommand == nullptr || !simulation.unitExists(unitCommand->unit))
+                {
+                    continue;
+                }
+
+                match(
+                    unitCommand->command,
+                    [&](const PlayerUnitCommand::ModifyBuildQueue& c) {
+                        onBuildQueueModified(unitCommand->unit, c.unitType, c.count);
+                    },
+                    [&](const PlayerUnitCommand::SetFireOrders& c) {
+                        onFireOrdersChanged(unitCommand->unit, c.orders);
+                    },
+                    [](const auto&) {});
             }
         }
     }
@@ -3230,13 +3468,13 @@ namespace rwe
 
                 const auto& unit = getUnit(*selectedUnit);
                 auto& guiInfo = unitGuiInfos.at(*selectedUnit);
-                auto pages = getBuildPageCount(builderGuisDatabase, unit.unitType);
+                auto pages = getBuildPageCount(builderGuisDatabase, simulation.unitDefinitions.get(unit.unitType).unitType);
                 guiInfo.currentBuildPage = (guiInfo.currentBuildPage + 1) % pages;
 
-                auto buildPanelDefinition = getBuilderGui(builderGuisDatabase, unit.unitType, guiInfo.currentBuildPage);
+                auto buildPanelDefinition = getBuilderGui(builderGuisDatabase, simulation.unitDefinitions.get(unit.unitType).unitType, guiInfo.currentBuildPage);
                 if (buildPanelDefinition)
                 {
-                    setNextPanel(createBuildPanel(unit.unitType + std::to_string(guiInfo.currentBuildPage + 1), *buildPanelDefinition, unit.getBuildQueueTotals()));
+                    setNextPanel(createBuildPanel(simulation.unitDefinitions.get(unit.unitType).unitType + std::to_string(guiInfo.currentBuildPage + 1), *buildPanelDefinition, unit.getBuildQueueTotals()));
                 }
             }
         }
@@ -3251,14 +3489,14 @@ namespace rwe
 
                 const auto& unit = getUnit(*selectedUnit);
                 auto& guiInfo = unitGuiInfos.at(*selectedUnit);
-                auto pages = getBuildPageCount(builderGuisDatabase, unit.unitType);
+                auto pages = getBuildPageCount(builderGuisDatabase, simulation.unitDefinitions.get(unit.unitType).unitType);
                 assert(pages != 0);
                 guiInfo.currentBuildPage = guiInfo.currentBuildPage == 0 ? pages - 1 : guiInfo.currentBuildPage - 1;
 
-                auto buildPanelDefinition = getBuilderGui(builderGuisDatabase, unit.unitType, guiInfo.currentBuildPage);
+                auto buildPanelDefinition = getBuilderGui(builderGuisDatabase, simulation.unitDefinitions.get(unit.unitType).unitType, guiInfo.currentBuildPage);
                 if (buildPanelDefinition)
                 {
-                    setNextPanel(createBuildPanel(unit.unitType + std::to_string(guiInfo.currentBuildPage + 1), *buildPanelDefinition, unit.getBuildQueueTotals()));
+                    setNextPanel(createBuildPanel(simulation.unitDefinitions.get(unit.unitType).unitType + std::to_string(guiInfo.currentBuildPage + 1), *buildPanelDefinition, unit.getBuildQueueTotals()));
                 }
             }
         }
@@ -3275,10 +3513,10 @@ namespace rwe
                 auto& guiInfo = unitGuiInfos.at(*selectedUnit);
                 guiInfo.section = UnitGuiInfo::Section::Build;
 
-                auto buildPanelDefinition = getBuilderGui(builderGuisDatabase, unit.unitType, guiInfo.currentBuildPage);
+                auto buildPanelDefinition = getBuilderGui(builderGuisDatabase, simulation.unitDefinitions.get(unit.unitType).unitType, guiInfo.currentBuildPage);
                 if (buildPanelDefinition)
                 {
-                    setNextPanel(createBuildPanel(unit.unitType + std::to_string(guiInfo.currentBuildPage + 1), *buildPanelDefinition, unit.getBuildQueueTotals()));
+                    setNextPanel(createBuildPanel(simulation.unitDefinitions.get(unit.unitType).unitType + std::to_string(guiInfo.currentBuildPage + 1), *buildPanelDefinition, unit.getBuildQueueTotals()));
                 }
             }
         }
@@ -3308,7 +3546,7 @@ namespace rwe
             if (auto selectedUnit = getSingleSelectedUnit(); selectedUnit)
             {
                 const auto& unit = getUnit(*selectedUnit);
-                const auto& unitDefinition = simulation.unitDefinitions.at(unit.unitType);
+                const auto& unitDefinition = simulation.unitDefinitions.get(unit.unitType);
                 if (unitDefinition.isMobile)
                 {
                     cursorMode.next(BuildCursorMode{message});
@@ -3351,7 +3589,7 @@ namespace rwe
 
         for (const auto& e : simulation.units)
         {
-            const auto& unitDefinition = simulation.unitDefinitions.at(e.second.unitType);
+            const auto& unitDefinition = simulation.unitDefinitions.get(e.second.unitType);
             if (!e.second.isSelectableBy(unitDefinition, localPlayerId))
             {
                 continue;
@@ -3475,10 +3713,10 @@ namespace rwe
             onOff.next(unit.activated);
 
             const auto& guiInfo = getGuiInfo(*unitId);
-            auto buildPanelDefinition = getBuilderGui(builderGuisDatabase, unit.unitType, guiInfo.currentBuildPage);
+            auto buildPanelDefinition = getBuilderGui(builderGuisDatabase, simulation.unitDefinitions.get(unit.unitType).unitType, guiInfo.currentBuildPage);
             if (guiInfo.section == UnitGuiInfo::Section::Build && buildPanelDefinition)
             {
-                setNextPanel(createBuildPanel(unit.unitType + std::to_string(guiInfo.currentBuildPage + 1), *buildPanelDefinition, unit.getBuildQueueTotals()));
+                setNextPanel(createBuildPanel(simulation.unitDefinitions.get(unit.unitType).unitType + std::to_string(guiInfo.currentBuildPage + 1), *buildPanelDefinition, unit.getBuildQueueTotals()));
             }
             else
             {
@@ -3583,57 +3821,6 @@ namespace rwe
         return panel;
     }
 
-    void GameScene::processPlayerCommand(const PlayerCommand& playerCommand)
-    {
-        match(
-            playerCommand,
-            [&](const PlayerUnitCommand& c) {
-                processUnitCommand(c);
-            },
-            [](const PlayerPauseGameCommand&) {
-                // TODO
-            },
-            [](const PlayerUnpauseGameCommand&) {
-                // TODO
-            });
-    }
-
-    void GameScene::processUnitCommand(const PlayerUnitCommand& unitCommand)
-    {
-        match(
-            unitCommand.command,
-            [&](const PlayerUnitCommand::IssueOrder& c) {
-                switch (c.issueKind)
-                {
-                    case PlayerUnitCommand::IssueOrder::IssueKind::Immediate:
-                        issueUnitOrder(unitCommand.unit, c.order);
-                        break;
-                    case PlayerUnitCommand::IssueOrder::IssueKind::Queued:
-                        enqueueUnitOrder(unitCommand.unit, c.order);
-                        break;
-                }
-            },
-            [&](const PlayerUnitCommand::ModifyBuildQueue& c) {
-                modifyBuildQueue(unitCommand.unit, c.unitType, c.count);
-            },
-            [&](const PlayerUnitCommand::Stop&) {
-                stopUnit(unitCommand.unit);
-            },
-            [&](const PlayerUnitCommand::SetFireOrders& c) {
-                setFireOrders(unitCommand.unit, c.orders);
-            },
-            [&](const PlayerUnitCommand::SetOnOff& c) {
-                if (c.on)
-                {
-                    simulation.activateUnit(unitCommand.unit);
-                }
-                else
-                {
-                    simulation.deactivateUnit(unitCommand.unit);
-                }
-            });
-    }
-
     bool GameScene::leftClickMode() const
     {
         return sceneContext.globalConfig->leftClickInterfaceMode;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <deque>
 #include <fstream>
 #include <functional>
@@ -14,6 +15,7 @@
 #include <rwe/UiRenderService.h>
 #include <rwe/Viewport.h>
 #include <rwe/game/BuilderGuisDatabase.h>
+#include <rwe/game/DesyncSearch.h>
 #include <rwe/game/GameCameraState.h>
 #include <rwe/game/GameMediaDatabase.h>
 #include <rwe/game/GameNetworkService.h>
@@ -21,12 +23,15 @@
 #include <rwe/game/Particle.h>
 #include <rwe/game/PlayerCommand.h>
 #include <rwe/game/PlayerCommandService.h>
+#include <rwe/game/Replay.h>
 #include <rwe/game/SceneTime.h>
+#include <rwe/game/StateLog.h>
 #include <rwe/game/UnitSoundType.h>
 #include <rwe/game/WeaponMediaInfo.h>
 #include <rwe/grid/DiscreteRect.h>
 #include <rwe/io/featuretdf/FeatureTdf.h>
 #include <rwe/observable/BehaviorSubject.h>
+#include <rwe/rwe_time.h>
 #include <rwe/scene/Scene.h>
 #include <rwe/scene/util.h>
 #include <rwe/sim/FeatureId.h>
@@ -34,8 +39,10 @@
 #include <rwe/sim/OccupiedGrid.h>
 #include <rwe/sim/PlayerId.h>
 #include <rwe/sim/SimScalar.h>
+#include <rwe/sim/UnitDefinitionId.h>
 #include <rwe/sim/UnitId.h>
 #include <rwe/sim/UnitState.h>
+#include <rwe/sim/WeaponDefinitionId.h>
 #include <rwe/ui/UiFactory.h>
 #include <rwe/ui/UiPanel.h>
 #include <unordered_set>
@@ -176,6 +183,12 @@ namespace rwe
          */
         static constexpr float CameraPanSpeed = 1000.0f;
 
+        /** How long to spend comparing hash trees with a peer before dumping everything. */
+        static constexpr std::chrono::seconds DesyncSearchTimeout{10};
+
+        /** How long to keep answering a peer's hash tree queries after our own search finishes. */
+        static constexpr std::chrono::seconds DesyncLingerTime{3};
+
         static const Rectangle2f minimapViewport;
 
         SceneContext sceneContext;
@@ -280,7 +293,14 @@ namespace rwe
 
         std::vector<std::pair<GameTime, GameHash>> gameHashes;
 
-        std::optional<std::ofstream> stateLogStream;
+        std::optional<StateLogWriter> stateLog;
+
+        std::optional<ReplayWriter> replayWriter;
+
+        std::optional<DesyncSearch> desyncSearch;
+
+        /** Once a desync is detected, the time at which to stop the game. */
+        std::optional<Timestamp> desyncDeadline;
 
         bool showDebugWindow{false};
         char unitSpawnText[20]{""};
@@ -326,7 +346,8 @@ namespace rwe
             const std::shared_ptr<SpriteSeries>& guiFont,
             PlayerId localPlayerId,
             TdfBlock* audioLookup,
-            std::optional<std::ofstream>&& stateLogStream);
+            std::optional<StateLogWriter>&& stateLog,
+            std::optional<ReplayWriter>&& replayWriter);
 
         void init() override;
 
@@ -361,17 +382,17 @@ namespace rwe
 
         void playNotificationSound(const PlayerId& playerId, const AudioService::SoundHandle& sound);
 
-        void playUnitNotificationSound(const PlayerId& playerId, const std::string& unitType, UnitSoundType soundType);
+        void playUnitNotificationSound(const PlayerId& playerId, UnitDefinitionId unitType, UnitSoundType soundType);
 
         void playSoundAt(const Vector3f& position, const AudioService::SoundHandle& sound);
 
-        void playWeaponStartSound(const Vector3f& position, const std::string& weaponType);
+        void playWeaponStartSound(const Vector3f& position, WeaponDefinitionId weaponType);
 
-        void playWeaponImpactSound(const Vector3f& position, const std::string& weaponType, ImpactType impactType);
+        void playWeaponImpactSound(const Vector3f& position, WeaponDefinitionId weaponType, ImpactType impactType);
 
-        void spawnWeaponImpactExplosion(const Vector3f& position, const std::string& weaponType, ImpactType impactType);
+        void spawnWeaponImpactExplosion(const Vector3f& position, WeaponDefinitionId weaponType, ImpactType impactType);
 
-        void doProjectileImpact(const SimVector& position, const std::string& weaponType, ImpactType impactType);
+        void doProjectileImpact(const SimVector& position, WeaponDefinitionId weaponType, ImpactType impactType);
 
         void createLightSmoke(const Vector3f& position);
 
@@ -383,7 +404,8 @@ namespace rwe
 
         void emitWake1FromPiece(UnitId unitId, const std::string& pieceName);
 
-        void modifyBuildQueue(UnitId unitId, const std::string& unitType, int count);
+        /** Updates the build menu after a unit's build queue was changed by a command. */
+        void onBuildQueueModified(UnitId unitId, const std::string& unitType, int count);
 
         void onChannelFinished(int channel);
 
@@ -393,6 +415,15 @@ namespace rwe
 
         void tryTickGame();
 
+        /**
+         * Called each frame once the players' game hashes have diverged.
+         * Walks our hash tree and a peer's down to the divergent entity,
+         * then dumps it and throws.
+         */
+        void handleDesync();
+
+        void dumpDesync(const std::optional<DesyncSearchResult>& result);
+
         std::optional<UnitId> getUnitUnderCursor() const;
         std::optional<FeatureId> getFeatureUnderCursor() const;
 
@@ -429,13 +460,8 @@ namespace rwe
 
         void localPlayerModifyBuildQueue(UnitId unitId, const std::string& unitType, int count);
 
-        void issueUnitOrder(UnitId unitId, const UnitOrder& order);
-
-        void enqueueUnitOrder(UnitId unitId, const UnitOrder& order);
-
-        void stopUnit(UnitId unitId);
-
-        void setFireOrders(UnitId unitId, UnitFireOrders orders);
+        /** Updates the orders menu after a unit's fire orders were changed by a command. */
+        void onFireOrdersChanged(UnitId unitId, UnitFireOrders orders);
 
         void startTrack();
 
@@ -471,12 +497,12 @@ namespace rwe
 
         void processActions();
 
+        /**
+         * Applies the commands to the simulation,
+         * then brings the interface up to date with their effects.
+         */
         void processPlayerCommands(const std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>>& commands);
 
-        void processPlayerCommand(const PlayerCommand& playerCommand);
-
-        void processUnitCommand(const PlayerUnitCommand& unitCommand);
-
         template <typename T>
         void delay(SceneTime interval, T&& f)
         {
@@ -61,14 +61,21 @@ namespace rwe
     {
         std::scoped_lock<std::mutex> lock(mutex);
 
+        if (hashMismatch)
+        {
+            return false;
+        }
+
         while (!std::any_of(gameTimeBuffers.begin(), gameTimeBuffers.end(), [](const auto& p) { return p.second.empty(); }))
         {
             std::optional<GameHash> baseHash;
             bool matching = true;
+            std::vector<std::pair<PlayerId, GameHash>> hashes;
             for (auto& p : gameTimeBuffers)
             {
                 auto hash = p.second.front();
                 p.second.pop_front();
+                hashes.emplace_back(p.first, hash);
 
                 if (!baseHash)
                 {
@@ -81,10 +88,53 @@ namespace rwe
 
             if (!matching)
             {
+                hashMismatch = GameHashMismatch{nextHashTime, std::move(hashes)};
                 return false;
             }
+
+            localHashHistory.forgetUntil(nextHashTime);
+
+            nextHashTime += GameTime(1);
         }
 
         return true;
     }
+
+    std::optional<GameHashMismatch> PlayerCommandService::getHashMismatch() const
+    {
+        std::scoped_lock<std::mutex> lock(mutex);
+        return hashMismatch;
+    }
+
+    void PlayerCommandService::pushLocalHashDelta(GameTime gameTime, GameHashDelta&& delta)
+    {
+        std::scoped_lock<std::mutex> lock(mutex);
+        localHashHistory.push(gameTime, std::move(delta));
+    }
+
+    std::optional<std::vector<GameHashTree::Child>> PlayerCommandService::getLocalHashTreeChildren(GameTime gameTime, const GameHashTree::Path& path) const
+    {
+        std::scoped_lock<std::mutex> lock(mutex);
+        return localHashHistory.getChildren(gameTime, path);
+    }
+
+    void PlayerCommandService::pushHashTreeResponse(HashTreeResponse&& response)
+    {
+        std::scoped_lock<std::mutex> lock(mutex);
+        hashTreeResponses.push_back(std::move(response));
+    }
+
+    std::optional<HashTreeResponse> PlayerCommandService::tryPopHashTreeResponse()
+    {
+        std::scoped_lock<std::mutex> lock(mutex);
+
+        if (hashTreeResponses.empty())
+        {
+            return std::nullopt;
+        }
+
+        auto response = std::move(hashTreeResponses.front());
+        hashTreeResponses.pop_front();
+        return response;
+    }
 }
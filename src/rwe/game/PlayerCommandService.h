@@ -5,6 +5,7 @@
 #include <rwe/game/PlayerCommand.h>
 #include <rwe/game/SceneTime.h>
 #include <rwe/sim/GameHash.h>
+#include <rwe/sim/GameHashHistory.h>
 #include <rwe/sim/GameTime.h>
 #include <rwe/sim/PlayerId.h>
 #include <unordered_map>
@@ -12,6 +13,22 @@
 
 namespace rwe
 {
+    struct GameHashMismatch
+    {
+        GameTime gameTime;
+        std::vector<std::pair<PlayerId, GameHash>> hashes;
+    };
+
+    struct HashTreeResponse
+    {
+        PlayerId playerId;
+        GameTime gameTime;
+        GameHashTree::Path path;
+
+        /** The children of the node, or nothing if the peer no longer has it. */
+        std::optional<std::vector<GameHashTree::Child>> children;
+    };
+
     class PlayerCommandService
     {
     private:
@@ -19,6 +36,20 @@ namespace rwe
         std::unordered_map<PlayerId, std::deque<std::vector<PlayerCommand>>> commandBuffers;
         std::unordered_map<PlayerId, std::deque<GameHash>> gameTimeBuffers;
 
+        /** The game time of the hashes at the front of gameTimeBuffers. */
+        GameTime nextHashTime{1};
+
+        /**
+         * Hashes of the local simulation for ticks
+         * whose hashes have not yet been checked against every player,
+         * from which their hash trees are rebuilt on request.
+         */
+        GameHashHistory localHashHistory;
+
+        std::optional<GameHashMismatch> hashMismatch;
+
+        std::deque<HashTreeResponse> hashTreeResponses;
+
     public:
         std::optional<std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>>> tryPopCommands();
 
@@ -30,6 +61,30 @@ namespace rwe
 
         void registerPlayer(PlayerId playerId);
 
+        /**
+         * Compares the hashes that every player has reported so far.
+         * Returns false if they differ for some tick,
+         * in which case the details can be retrieved from getHashMismatch.
+         */
         bool checkHashes();
+
+        std::optional<GameHashMismatch> getHashMismatch() const;
+
+        /**
+         * Keeps the local hash delta for the given tick
+         * until its hash has been checked against every player,
+         * so that peers can query its hash tree if the hashes differ.
+         */
+        void pushLocalHashDelta(GameTime gameTime, GameHashDelta&& delta);
+
+        /**
+         * Returns the children of a node in the local hash tree for the given tick.
+         * Returns nothing if the tick has been discarded or the node does not exist.
+         */
+        std::optional<std::vector<GameHashTree::Child>> getLocalHashTreeChildren(GameTime gameTime, const GameHashTree::Path& path) const;
+
+        void pushHashTreeResponse(HashTreeResponse&& response);
+
+        std::optional<HashTreeResponse> tryPopHashTreeResponse();
     };
 }
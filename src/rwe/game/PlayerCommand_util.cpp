@@ -0,0 +1,77 @@
+#include "PlayerCommand_util.h"
+#include <rwe/util/match.h>
+
+namespace rwe
+{
+    void applyPlayerUnitCommand(GameSimulation& simulation, const PlayerUnitCommand& command)
+    {
+        auto unit = simulation.tryGetUnitState(command.unit);
+        if (!unit)
+        {
+            return;
+        }
+
+        match(
+            command.command,
+            [&](const PlayerUnitCommand::IssueOrder& c) {
+                auto order = c.order;
+                simulation.resolveOrder(order);
+                switch (c.issueKind)
+                {
+                    case PlayerUnitCommand::IssueOrder::IssueKind::Immediate:
+                        unit->get().clearOrders();
+                        unit->get().addOrder(order);
+                        break;
+                    case PlayerUnitCommand::IssueOrder::IssueKind::Queued:
+                        unit->get().addOrder(order);
+                        break;
+                }
+            },
+            [&](const PlayerUnitCommand::ModifyBuildQueue& c) {
+                unit->get().modifyBuildQueue(c.unitType, c.count);
+            },
+            [&](const PlayerUnitCommand::Stop&) {
+                unit->get().clearOrders();
+            },
+            [&](const PlayerUnitCommand::SetFireOrders& c) {
+                unit->get().fireOrders = c.orders;
+                simulation.markUnitChanged(command.unit);
+            },
+            [&](const PlayerUnitCommand::SetOnOff& c) {
+                if (c.on)
+                {
+                    simulation.activateUnit(command.unit);
+                }
+                else
+                {
+                    simulation.deactivateUnit(command.unit);
+                }
+            });
+    }
+
+    void applyPlayerCommand(GameSimulation& simulation, const PlayerCommand& command)
+    {
+        match(
+            command,
+            [&](const PlayerUnitCommand& c) {
+                applyPlayerUnitCommand(simulation, c);
+            },
+            [](const PlayerPauseGameCommand&) {
+                // TODO
+            },
+            [](const PlayerUnpauseGameCommand&) {
+                // TODO
+            });
+    }
+
+    void applyPlayerCommands(GameSimulation& simulation, const std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>>& commands)
+    {
+        for (const auto& [_, playerCommands] : commands)
+        {
+            for (const auto& command : playerCommands)
+            {
+                applyPlayerCommand(simulation, command);
+            }
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <rwe/game/PlayerCommand.h>
+#include <rwe/sim/GameSimulation.h>
+#include <rwe/sim/PlayerId.h>
+#include <utility>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * Applies the effect of the command on the simulation.
+     * Commands for units that no longer exist are ignored.
+     * This is all a command does to the simulation,
+     * so replaying the same commands reproduces the same game.
+     */
+    void applyPlayerUnitCommand(GameSimulation& simulation, const PlayerUnitCommand& command);
+
+    void applyPlayerCommand(GameSimulation& simulation, const PlayerCommand& command);
+
+    /** Applies every player's commands for a tick, in the order given. */
+    void applyPlayerCommands(GameSimulation& simulation, const std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>>& commands);
+}
@@ -0,0 +1,262 @@
+#include "Replay.h"
+#include <algorithm>
+#include <iterator>
+#include <rwe/game/PlayerCommand_util.h>
+#include <rwe/sim/GameSnapshot.h>
+#include <rwe/util/match.h>
+#include <stdexcept>
+
+namespace rwe
+{
+    const char ReplayMagic[4] = {'R', 'W', 'E', 'R'};
+
+    enum class ReplayRecordKind : uint8_t
+    {
+        Tick = 0,
+        HashCheckpoint = 1,
+    };
+
+    template <typename Id>
+    std::vector<std::string> namesById(const std::unordered_map<std::string, Id>& nameIndex, Id nextId)
+    {
+        std::vector<std::string> names(nextId.value);
+        for (const auto& [name, id] : nameIndex)
+        {
+            names[id.value] = name;
+        }
+        return names;
+    }
+
+    ReplayHeader createReplayHeader(const std::string& mapName, unsigned int schemaIndex, const GameSimulation& simulation)
+    {
+        return ReplayHeader{
+            mapName,
+            schemaIndex,
+            namesById(simulation.unitNameIndex, simulation.unitDefinitions.getNextId()),
+            namesById(simulation.featureNameIndex, simulation.featureDefinitions.getNextId()),
+            namesById(simulation.weaponNameIndex, simulation.weaponDefinitions.getNextId()),
+        };
+    }
+
+    void checkReplayData(const ReplayHeader& header, const GameSimulation& simulation)
+    {
+        auto current = createReplayHeader(header.mapName, header.schemaIndex, simulation);
+        if (current.unitTypes != header.unitTypes || current.featureTypes != header.featureTypes || current.weaponTypes != header.weaponTypes)
+        {
+            throw std::runtime_error("Replay was recorded with different game data");
+        }
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const ReplayHeader& header)
+    {
+        writeSnapshot(w, header.mapName);
+        writeSnapshot(w, header.schemaIndex);
+        writeSnapshot(w, header.unitTypes);
+        writeSnapshot(w, header.featureTypes);
+        writeSnapshot(w, header.weaponTypes);
+    }
+
+    ReplayHeader readSnapshot(SnapshotReader& r, SnapshotTag<ReplayHeader>)
+    {
+        auto mapName = readSnapshotValue<std::string>(r);
+        auto schemaIndex = readSnapshotValue<unsigned int>(r);
+        auto unitTypes = readSnapshotValue<std::vector<std::string>>(r);
+        auto featureTypes = readSnapshotValue<std::vector<std::string>>(r);
+        auto weaponTypes = readSnapshotValue<std::vector<std::string>>(r);
+        return ReplayHeader{std::move(mapName), schemaIndex, std::move(unitTypes), std::move(featureTypes), std::move(weaponTypes)};
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const PlayerUnitCommand::IssueOrder& c)
+    {
+        writeSnapshot(w, c.order);
+        writeSnapshot(w, c.issueKind);
+    }
+
+    PlayerUnitCommand::IssueOrder readSnapshot(SnapshotReader& r, SnapshotTag<PlayerUnitCommand::IssueOrder>)
+    {
+        auto order = readSnapshotValue<UnitOrder>(r);
+        auto issueKind = readSnapshotValue<PlayerUnitCommand::IssueOrder::IssueKind>(r);
+        return PlayerUnitCommand::IssueOrder(order, issueKind);
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const PlayerUnitCommand::ModifyBuildQueue& c)
+    {
+        writeSnapshot(w, c.count);
+        writeSnapshot(w, c.unitType);
+    }
+
+    PlayerUnitCommand::ModifyBuildQueue readSnapshot(SnapshotReader& r, SnapshotTag<PlayerUnitCommand::ModifyBuildQueue>)
+    {
+        auto count = readSnapshotValue<int>(r);
+        auto unitType = readSnapshotValue<std::string>(r);
+        return PlayerUnitCommand::ModifyBuildQueue{count, std::move(unitType)};
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const PlayerUnitCommand::SetFireOrders& c)
+    {
+        writeSnapshot(w, c.orders);
+    }
+
+    PlayerUnitCommand::SetFireOrders readSnapshot(SnapshotReader& r, SnapshotTag<PlayerUnitCommand::SetFireOrders>)
+    {
+        return PlayerUnitCommand::SetFireOrders{readSnapshotValue<UnitFireOrders>(r)};
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const PlayerUnitCommand::SetOnOff& c)
+    {
+        writeSnapshot(w, c.on);
+    }
+
+    PlayerUnitCommand::SetOnOff readSnapshot(SnapshotReader& r, SnapshotTag<PlayerUnitCommand::SetOnOff>)
+    {
+        return PlayerUnitCommand::SetOnOff{readSnapshotValue<bool>(r)};
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const PlayerUnitCommand& c)
+    {
+        writeSnapshot(w, c.unit);
+        writeSnapshot(w, c.command);
+    }
+
+    PlayerUnitCommand readSnapshot(SnapshotReader& r, SnapshotTag<PlayerUnitCommand>)
+    {
+        auto unit = readSnapshotValue<UnitId>(r);
+        auto command = readSnapshotValue<PlayerUnitCommand::Command>(r);
+        return PlayerUnitCommand(unit, command);
+    }
+
+    ReplayWriter::ReplayWriter(std::unique_ptr<std::ostream> stream, const ReplayHeader& header)
+        : stream(std::move(stream)), writer(*this->stream)
+    {
+        writer.writeBytes(ReplayMagic, sizeof(ReplayMagic));
+        writeSnapshot(writer, ReplayVersion);
+        writeSnapshot(writer, header);
+    }
+
+    void ReplayWriter::writeTick(const GameSimulation& simulation, const ReplayTickCommands& commands)
+    {
+        if (!initialStateWritten)
+        {
+            saveSnapshot(simulation, *stream);
+            initialStateWritten = true;
+        }
+
+        writeSnapshot(writer, ReplayRecordKind::Tick);
+        writeSnapshot(writer, commands);
+    }
+
+    void ReplayWriter::writeHash(GameTime gameTime, GameHash hash)
+    {
+        if (!initialStateWritten)
+        {
+            throw std::logic_error("Replay hash written before the first tick");
+        }
+
+        writeSnapshot(writer, ReplayRecordKind::HashCheckpoint);
+        writeSnapshot(writer, gameTime);
+        writeSnapshot(writer, hash);
+    }
+
+    void ReplayWriter::flush()
+    {
+        stream->flush();
+    }
+
+    ReplayReader::ReplayReader(std::unique_ptr<std::istream> stream)
+        : stream(std::move(stream)), reader(*this->stream)
+    {
+        char magic[sizeof(ReplayMagic)];
+        reader.readBytes(magic, sizeof(magic));
+        if (!std::equal(std::begin(magic), std::end(magic), std::begin(ReplayMagic)))
+        {
+            throw std::runtime_error("Not a replay");
+        }
+
+        auto version = readSnapshotValue<uint32_t>(reader);
+        if (version != ReplayVersion)
+        {
+            throw std::runtime_error("Unsupported replay version: " + std::to_string(version));
+        }
+
+        header = readSnapshotValue<ReplayHeader>(reader);
+    }
+
+    const ReplayHeader& ReplayReader::getHeader() const
+    {
+        return header;
+    }
+
+    void ReplayReader::restoreInitialState(GameSimulation& simulation)
+    {
+        if (initialStateRead)
+        {
+            throw std::logic_error("Replay initial state already restored");
+        }
+
+        checkReplayData(header, simulation);
+        restoreSnapshot(simulation, *stream);
+        initialStateRead = true;
+    }
+
+    std::optional<ReplayRecord> ReplayReader::readRecord()
+    {
+        if (!initialStateRead)
+        {
+            throw std::logic_error("Replay initial state must be restored before reading records");
+        }
+
+        if (stream->peek() == std::istream::traits_type::eof())
+        {
+            return std::nullopt;
+        }
+
+        auto kind = readSnapshotValue<ReplayRecordKind>(reader);
+        switch (kind)
+        {
+            case ReplayRecordKind::Tick:
+                return ReplayTick{readSnapshotValue<ReplayTickCommands>(reader)};
+            case ReplayRecordKind::HashCheckpoint:
+            {
+                auto gameTime = readSnapshotValue<GameTime>(reader);
+                auto hash = readSnapshotValue<GameHash>(reader);
+                return ReplayHashCheckpoint{gameTime, hash};
+            }
+        }
+
+        throw std::runtime_error("Invalid replay record kind: " + std::to_string(static_cast<int>(kind)));
+    }
+
+    ReplayPlaybackResult playReplay(ReplayReader& reader, GameSimulation& simulation)
+    {
+        ReplayPlaybackResult result;
+        while (auto record = reader.readRecord())
+        {
+            auto mismatch = match(
+                *record,
+                [&](const ReplayTick& tick) -> std::optional<ReplayHashMismatch> {
+                    applyPlayerCommands(simulation, tick.commands);
+                    simulation.tick();
+                    simulation.events.clear();
+                    ++result.ticks;
+                    return std::nullopt;
+                },
+                [&](const ReplayHashCheckpoint& checkpoint) -> std::optional<ReplayHashMismatch> {
+                    auto hash = simulation.computeHash();
+                    if (checkpoint.gameTime != simulation.gameTime || checkpoint.hash != hash)
+                    {
+                        return ReplayHashMismatch{simulation.gameTime, checkpoint.hash, hash};
+                    }
+                    ++result.checkpointsVerified;
+                    return std::nullopt;
+                });
+
+            if (mismatch)
+            {
+                result.mismatch = mismatch;
+                break;
+            }
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <rwe/game/PlayerCommand.h>
+#include <rwe/sim/GameHash.h>
+#include <rwe/sim/GameSimulation.h>
+#include <rwe/sim/GameTime.h>
+#include <rwe/sim/PlayerId.h>
+#include <rwe/sim/SnapshotIo.h>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace rwe
+{
+    /** Bump whenever the layout of a replay changes. */
+    constexpr uint32_t ReplayVersion = 1;
+
+    /** The number of ticks between the hashes recorded in a replay. */
+    constexpr unsigned int ReplayHashInterval = 30;
+
+    using ReplayTickCommands = std::vector<std::pair<PlayerId, std::vector<PlayerCommand>>>;
+
+    /**
+     * Identifies the map and data a replay was recorded with.
+     * Definitions are listed by name in id order,
+     * so that playback can check it has loaded them in the same order.
+     */
+    struct ReplayHeader
+    {
+        std::string mapName;
+        unsigned int schemaIndex;
+        std::vector<std::string> unitTypes;
+        std::vector<std::string> featureTypes;
+        std::vector<std::string> weaponTypes;
+    };
+
+    ReplayHeader createReplayHeader(const std::string& mapName, unsigned int schemaIndex, const GameSimulation& simulation);
+
+    /**
+     * Throws std::runtime_error if the simulation's definitions
+     * do not match the ones the replay was recorded with.
+     */
+    void checkReplayData(const ReplayHeader& header, const GameSimulation& simulation);
+
+    /** The commands applied at the start of a tick. */
+    struct ReplayTick
+    {
+        ReplayTickCommands commands;
+    };
+
+    /** The hash of the simulation after the tick at the given game time. */
+    struct ReplayHashCheckpoint
+    {
+        GameTime gameTime;
+        GameHash hash;
+    };
+
+    using ReplayRecord = std::variant<ReplayTick, ReplayHashCheckpoint>;
+
+    /**
+     * Records a game as its starting state followed by the commands of each tick.
+     * Since the simulation is deterministic, this is enough to play the game again.
+     */
+    class ReplayWriter
+    {
+    private:
+        std::unique_ptr<std::ostream> stream;
+        SnapshotWriter writer;
+        bool initialStateWritten{false};
+
+    public:
+        ReplayWriter(std::unique_ptr<std::ostream> stream, const ReplayHeader& header);
+
+        /**
+         * Records the commands about to be applied to the simulation before it ticks.
+         * The first call also records the state of the simulation,
+         * so it must be made before any commands have been applied.
+         */
+        void writeTick(const GameSimulation& simulation, const ReplayTickCommands& commands);
+
+        void writeHash(GameTime gameTime, GameHash hash);
+
+        void flush();
+    };
+
+    class ReplayReader
+    {
+    private:
+        std::unique_ptr<std::istream> stream;
+        SnapshotReader reader;
+        ReplayHeader header;
+        bool initialStateRead{false};
+
+    public:
+        /** Throws std::runtime_error if the stream does not contain a supported replay. */
+        explicit ReplayReader(std::unique_ptr<std::istream> stream);
+
+        const ReplayHeader& getHeader() const;
+
+        /**
+         * Replaces the state of the simulation with the state the replay starts from.
+         * Must be called once, before the first call to readRecord.
+         */
+        void restoreInitialState(GameSimulation& simulation);
+
+        /** Returns the next record, or nullopt at the end of the replay. */
+        std::optional<ReplayRecord> readRecord();
+    };
+
+    struct ReplayHashMismatch
+    {
+        GameTime gameTime;
+        GameHash expected;
+        GameHash actual;
+    };
+
+    struct ReplayPlaybackResult
+    {
+        unsigned int ticks{0};
+        unsigned int checkpointsVerified{0};
+        std::optional<ReplayHashMismatch> mismatch;
+    };
+
+    /**
+     * Plays the rest of the replay on the simulation as fast as possible,
+     * checking the simulation's hash against every recorded hash.
+     * Stops at the first hash that does not match.
+     */
+    ReplayPlaybackResult playReplay(ReplayReader& reader, GameSimulation& simulation);
+}
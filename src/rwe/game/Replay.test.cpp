@@ -0,0 +1,142 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/game/PlayerCommand_util.h>
+#include <rwe/game/Replay.h>
+#include <sstream>
+
+namespace rwe
+{
+    GameSimulation createReplayTestSimulation()
+    {
+        GameSimulation simulation(MapTerrain(Grid<unsigned char>(32, 32, 10), 0_ss), 0, 1000, 3000);
+
+        UnitDefinition unitDefinition{};
+        unitDefinition.unitType = "TESTUNIT";
+        unitDefinition.objectName = "TESTMODEL";
+        unitDefinition.movementCollisionInfo = UnitDefinition::AdHocMovementClass{2, 2, 255, 255, 0, 255};
+        unitDefinition.maxHitPoints = 100;
+        unitDefinition.isMobile = true;
+        unitDefinition.maxVelocity = 2_ss;
+        unitDefinition.acceleration = 1_ss;
+        unitDefinition.brakeRate = 1_ss;
+        unitDefinition.turnRate = SimScalar(1000);
+        auto unitDefinitionId = simulation.unitDefinitions.insert(unitDefinition);
+        simulation.unitNameIndex.insert({"TESTUNIT", unitDefinitionId});
+
+        std::vector<UnitPieceDefinition> pieces{UnitPieceDefinition{"base", SimVector(0_ss, 0_ss, 0_ss), std::nullopt}};
+        simulation.unitModelDefinitions.insert({"TESTMODEL", createUnitModelDefinition(10_ss, std::move(pieces))});
+
+        CobScript script;
+        script.pieces = {"base"};
+        script.staticVariableCount = 0;
+        simulation.unitScriptDefinitions.insert({"TESTUNIT", compileCobScript(std::move(script))});
+
+        simulation.addPlayer(GamePlayerInfo{
+            .name = std::string("Alice"),
+            .type = GamePlayerType::Human,
+            .color = PlayerColorIndex(0),
+            .status = GamePlayerStatus::Alive,
+            .side = "ARM",
+            .metal = Metal(500),
+            .energy = Energy(700),
+            .maxMetal = Metal(1000),
+            .maxEnergy = Energy(1000),
+            .startingMetal = Metal(500),
+            .startingEnergy = Energy(700),
+        });
+
+        return simulation;
+    }
+
+    /** Plays a short game on the simulation, recording it to the returned replay. */
+    std::string recordTestReplay(GameSimulation& simulation, unsigned int ticks)
+    {
+        auto unit = simulation.trySpawnUnit("TESTUNIT", PlayerId(0), SimVector(-100_ss, 10_ss, -100_ss), std::nullopt);
+        REQUIRE(unit);
+
+        auto stream = std::make_unique<std::stringstream>();
+        auto& streamRef = *stream;
+        ReplayWriter writer(std::move(stream), createReplayHeader("TESTMAP", 0, simulation));
+
+        for (unsigned int i = 0; i < ticks; ++i)
+        {
+            ReplayTickCommands commands{{PlayerId(0), {}}};
+            if (i == 2)
+            {
+                commands[0].second.push_back(PlayerUnitCommand(*unit, PlayerUnitCommand::IssueOrder(createMoveOrder(SimVector(100_ss, 10_ss, 100_ss)), PlayerUnitCommand::IssueOrder::Immediate)));
+                commands[0].second.push_back(PlayerUnitCommand(*unit, PlayerUnitCommand::SetFireOrders{UnitFireOrders::HoldFire}));
+            }
+
+            writer.writeTick(simulation, commands);
+            applyPlayerCommands(simulation, commands);
+            simulation.tick();
+            simulation.events.clear();
+
+            if (simulation.gameTime.value % ReplayHashInterval == 0)
+            {
+                writer.writeHash(simulation.gameTime, simulation.computeHash());
+            }
+        }
+
+        writer.flush();
+        return streamRef.str();
+    }
+
+    TEST_CASE("Replay")
+    {
+        SECTION("plays back to the same state")
+        {
+            auto original = createReplayTestSimulation();
+            auto replay = recordTestReplay(original, 65);
+
+            ReplayReader reader(std::make_unique<std::stringstream>(replay));
+            REQUIRE(reader.getHeader().mapName == "TESTMAP");
+            REQUIRE(reader.getHeader().unitTypes == std::vector<std::string>{"TESTUNIT"});
+
+            auto playback = createReplayTestSimulation();
+            reader.restoreInitialState(playback);
+            auto result = playReplay(reader, playback);
+
+            REQUIRE(result.ticks == 65);
+            REQUIRE(result.checkpointsVerified == 2);
+            REQUIRE(!result.mismatch);
+            REQUIRE(playback.gameTime == original.gameTime);
+            REQUIRE(playback.computeHash() == original.computeHash());
+        }
+
+        SECTION("detects a hash that does not match")
+        {
+            auto original = createReplayTestSimulation();
+            auto replay = recordTestReplay(original, 30);
+
+            // the replay ends with the hash of its only checkpoint
+            replay.back() ^= 1;
+
+            ReplayReader reader(std::make_unique<std::stringstream>(replay));
+            auto playback = createReplayTestSimulation();
+            reader.restoreInitialState(playback);
+            auto result = playReplay(reader, playback);
+
+            REQUIRE(result.checkpointsVerified == 0);
+            REQUIRE(result.mismatch);
+            REQUIRE(result.mismatch->gameTime == GameTime(30));
+            REQUIRE(result.mismatch->actual != result.mismatch->expected);
+        }
+
+        SECTION("rejects a simulation loaded with different data")
+        {
+            auto original = createReplayTestSimulation();
+            auto replay = recordTestReplay(original, 1);
+
+            ReplayReader reader(std::make_unique<std::stringstream>(replay));
+            auto playback = createReplayTestSimulation();
+            playback.unitNameIndex.clear();
+            playback.unitNameIndex.insert({"OTHERUNIT", UnitDefinitionId(0)});
+            REQUIRE_THROWS_AS(reader.restoreInitialState(playback), std::runtime_error);
+        }
+
+        SECTION("rejects data that is not a replay")
+        {
+            REQUIRE_THROWS_AS(ReplayReader(std::make_unique<std::stringstream>("not a replay")), std::runtime_error);
+        }
+    }
+}
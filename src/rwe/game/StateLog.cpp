@@ -0,0 +1,498 @@
+#include "StateLog.h"
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <rwe/game/dump_util.h>
+#include <rwe/sim/GameSnapshot.h>
+#include <rwe/util/SpanStream.h>
+#include <span>
+#include <stdexcept>
+
+namespace rwe
+{
+    const char StateLogMagic[4] = {'R', 'W', 'E', 'L'};
+
+    enum class StateLogFrameKind : uint8_t
+    {
+        Keyframe = 0,
+        Delta = 1,
+    };
+
+    /**
+     * A field of an entity in the state log.
+     * Fields are matched by their position in the entity's field list,
+     * so new fields must be added at the end and the version bumped.
+     */
+    template <typename T>
+    struct StateLogField
+    {
+        const char* name;
+        void (*write)(SnapshotWriter& w, const T& entity);
+        nlohmann::json (*readJson)(SnapshotReader& r);
+    };
+
+    /**
+     * The most fields an entity may have,
+     * since the fields changed since the previous frame are written as a 32-bit mask.
+     */
+    constexpr std::size_t MaxStateLogFieldCount = 32;
+
+    template <typename>
+    struct StateLogMemberTraits;
+
+    template <typename C, typename F>
+    struct StateLogMemberTraits<F C::*>
+    {
+        using Class = C;
+        using Field = F;
+    };
+
+    template <auto Member>
+    StateLogField<typename StateLogMemberTraits<decltype(Member)>::Class> stateLogField(const char* name)
+    {
+        using Class = typename StateLogMemberTraits<decltype(Member)>::Class;
+        using Field = typename StateLogMemberTraits<decltype(Member)>::Field;
+        return StateLogField<Class>{
+            name,
+            [](SnapshotWriter& w, const Class& entity) { writeSnapshot(w, entity.*Member); },
+            [](SnapshotReader& r) { return dumpJson(readSnapshotValue<Field>(r)); }};
+    }
+
+    // The fields are the ones dumpJson writes.
+
+    std::span<const StateLogField<GamePlayerInfo>> getPlayerFields()
+    {
+        static const std::array fields{
+            stateLogField<&GamePlayerInfo::type>("type"),
+            stateLogField<&GamePlayerInfo::color>("color"),
+            stateLogField<&GamePlayerInfo::status>("status"),
+            stateLogField<&GamePlayerInfo::side>("side"),
+            stateLogField<&GamePlayerInfo::metal>("metal"),
+            stateLogField<&GamePlayerInfo::maxMetal>("maxMetal"),
+            stateLogField<&GamePlayerInfo::energy>("energy"),
+            stateLogField<&GamePlayerInfo::maxEnergy>("maxEnergy"),
+            stateLogField<&GamePlayerInfo::metalStalled>("metalStalled"),
+            stateLogField<&GamePlayerInfo::energyStalled>("energyStalled"),
+            stateLogField<&GamePlayerInfo::desiredMetalConsumptionBuffer>("desiredMetalConsumptionBuffer"),
+            stateLogField<&GamePlayerInfo::desiredEnergyConsumptionBuffer>("desiredEnergyConsumptionBuffer"),
+            stateLogField<&GamePlayerInfo::previousDesiredMetalConsumptionBuffer>("previousDesiredMetalConsumptionBuffer"),
+            stateLogField<&GamePlayerInfo::previousDesiredEnergyConsumptionBuffer>("previousDesiredEnergyConsumptionBuffer"),
+            stateLogField<&GamePlayerInfo::actualMetalConsumptionBuffer>("actualMetalConsumptionBuffer"),
+            stateLogField<&GamePlayerInfo::actualEnergyConsumptionBuffer>("actualEnergyConsumptionBuffer"),
+            stateLogField<&GamePlayerInfo::metalProductionBuffer>("metalProductionBuffer"),
+            stateLogField<&GamePlayerInfo::energyProductionBuffer>("energyProductionBuffer"),
+        };
+        static_assert(std::tuple_size_v<decltype(fields)> <= MaxStateLogFieldCount);
+        return fields;
+    }
+
+    std::span<const StateLogField<UnitState>> getUnitFields()
+    {
+        static const std::array fields{
+            stateLogField<&UnitState::unitType>("unitType"),
+            stateLogField<&UnitState::position>("position"),
+            stateLogField<&UnitState::owner>("owner"),
+            stateLogField<&UnitState::rotation>("rotation"),
+            stateLogField<&UnitState::physics>("physics"),
+            stateLogField<&UnitState::hitPoints>("hitPoints"),
+            stateLogField<&UnitState::lifeState>("lifeState"),
+            stateLogField<&UnitState::navigationState>("navigationState"),
+            stateLogField<&UnitState::behaviourState>("behaviourState"),
+            stateLogField<&UnitState::inBuildStance>("inBuildStance"),
+            stateLogField<&UnitState::yardOpen>("yardOpen"),
+            stateLogField<&UnitState::inCollision>("inCollision"),
+            stateLogField<&UnitState::fireOrders>("fireOrders"),
+            stateLogField<&UnitState::buildTimeCompleted>("buildTimeCompleted"),
+            stateLogField<&UnitState::activated>("activated"),
+            stateLogField<&UnitState::isSufficientlyPowered>("isSufficientlyPowered"),
+            stateLogField<&UnitState::energyProductionBuffer>("energyProductionBuffer"),
+            stateLogField<&UnitState::metalProductionBuffer>("metalProductionBuffer"),
+            stateLogField<&UnitState::previousEnergyConsumptionBuffer>("previousEnergyConsumptionBuffer"),
+            stateLogField<&UnitState::previousMetalConsumptionBuffer>("previousMetalConsumptionBuffer"),
+            stateLogField<&UnitState::energyConsumptionBuffer>("energyConsumptionBuffer"),
+            stateLogField<&UnitState::metalConsumptionBuffer>("metalConsumptionBuffer"),
+        };
+        static_assert(std::tuple_size_v<decltype(fields)> <= MaxStateLogFieldCount);
+        return fields;
+    }
+
+    std::span<const StateLogField<Projectile>> getProjectileFields()
+    {
+        static const std::array fields{
+            stateLogField<&Projectile::weaponType>("weaponType"),
+            stateLogField<&Projectile::owner>("owner"),
+            stateLogField<&Projectile::position>("position"),
+            stateLogField<&Projectile::origin>("origin"),
+            stateLogField<&Projectile::velocity>("velocity"),
+            stateLogField<&Projectile::damageRadius>("damageRadius"),
+        };
+        static_assert(std::tuple_size_v<decltype(fields)> <= MaxStateLogFieldCount);
+        return fields;
+    }
+
+    std::string_view StateLogEntity::getField(std::size_t index) const
+    {
+        auto begin = index == 0 ? 0 : fieldEnds[index - 1];
+        return std::string_view(bytes).substr(begin, fieldEnds[index] - begin);
+    }
+
+    template <typename T>
+    StateLogEntity encodeStateLogEntity(std::ostringstream& scratch, std::span<const StateLogField<T>> fields, const T& entity)
+    {
+        scratch.str(std::string());
+        SnapshotWriter w(scratch);
+
+        StateLogEntity result;
+        result.fieldEnds.reserve(fields.size());
+        for (const auto& field : fields)
+        {
+            field.write(w, entity);
+            result.fieldEnds.push_back(static_cast<uint32_t>(scratch.tellp()));
+        }
+        result.bytes = scratch.str();
+        return result;
+    }
+
+    StateLogFrame createStateLogFrame(const GameSimulation& simulation)
+    {
+        std::ostringstream scratch;
+        StateLogFrame frame;
+        frame.gameTime = simulation.gameTime;
+
+        for (std::size_t i = 0; i < simulation.players.size(); ++i)
+        {
+            frame.players.emplace(static_cast<uint32_t>(i), encodeStateLogEntity(scratch, getPlayerFields(), simulation.players[i]));
+        }
+
+        for (const auto& [id, unit] : simulation.units)
+        {
+            frame.units.emplace(id.value, encodeStateLogEntity(scratch, getUnitFields(), unit));
+        }
+
+        for (const auto& [id, projectile] : simulation.projectiles)
+        {
+            frame.projectiles.emplace(id.value, encodeStateLogEntity(scratch, getProjectileFields(), projectile));
+        }
+
+        return frame;
+    }
+
+    template <typename T>
+    nlohmann::json stateLogFieldToJson(std::span<const StateLogField<T>> fields, const StateLogEntity& entity, std::size_t index)
+    {
+        auto bytes = entity.getField(index);
+        SpanStream stream(bytes.data(), bytes.size());
+        SnapshotReader r(stream);
+        return fields[index].readJson(r);
+    }
+
+    template <typename T>
+    nlohmann::json stateLogEntityToJson(std::span<const StateLogField<T>> fields, const StateLogEntity& entity)
+    {
+        nlohmann::json j = nlohmann::json::object();
+        for (std::size_t i = 0; i < fields.size(); ++i)
+        {
+            j[fields[i].name] = stateLogFieldToJson(fields, entity, i);
+        }
+        return j;
+    }
+
+    /** Matches dumpJson for a VectorMap. */
+    template <typename T>
+    nlohmann::json stateLogSectionToJson(std::span<const StateLogField<T>> fields, const StateLogSection& section)
+    {
+        nlohmann::json j;
+        for (const auto& [id, entity] : section)
+        {
+            j.push_back(nlohmann::json{
+                {"first", dumpJson(id)},
+                {"second", stateLogEntityToJson(fields, entity)}});
+        }
+        return j;
+    }
+
+    nlohmann::json stateLogFrameToJson(const StateLogFrame& frame)
+    {
+        nlohmann::json players;
+        for (const auto& [_, player] : frame.players)
+        {
+            players.push_back(stateLogEntityToJson(getPlayerFields(), player));
+        }
+
+        return nlohmann::json{
+            {"gameTime", dumpJson(frame.gameTime)},
+            {"players", players},
+            {"units", stateLogSectionToJson(getUnitFields(), frame.units)},
+            {"projectiles", stateLogSectionToJson(getProjectileFields(), frame.projectiles)},
+        };
+    }
+
+    template <typename T>
+    nlohmann::json diffStateLogSections(std::span<const StateLogField<T>> fields, const StateLogSection& a, const StateLogSection& b)
+    {
+        auto j = nlohmann::json::array();
+
+        auto itA = a.begin();
+        auto itB = b.begin();
+        while (itA != a.end() || itB != b.end())
+        {
+            if (itB == b.end() || (itA != a.end() && itA->first < itB->first))
+            {
+                j.push_back(nlohmann::json{{"id", itA->first}, {"a", stateLogEntityToJson(fields, itA->second)}, {"b", nullptr}});
+                ++itA;
+            }
+            else if (itA == a.end() || itB->first < itA->first)
+            {
+                j.push_back(nlohmann::json{{"id", itB->first}, {"a", nullptr}, {"b", stateLogEntityToJson(fields, itB->second)}});
+                ++itB;
+            }
+            else
+            {
+                for (std::size_t i = 0; i < fields.size(); ++i)
+                {
+                    if (itA->second.getField(i) != itB->second.getField(i))
+                    {
+                        j.push_back(nlohmann::json{
+                            {"id", itA->first},
+                            {"field", fields[i].name},
+                            {"a", stateLogFieldToJson(fields, itA->second, i)},
+                            {"b", stateLogFieldToJson(fields, itB->second, i)}});
+                    }
+                }
+                ++itA;
+                ++itB;
+            }
+        }
+
+        return j;
+    }
+
+    nlohmann::json diffStateLogFrames(const StateLogFrame& a, const StateLogFrame& b)
+    {
+        nlohmann::json differences;
+
+        if (a.gameTime != b.gameTime)
+        {
+            differences["gameTime"] = nlohmann::json{{"a", dumpJson(a.gameTime)}, {"b", dumpJson(b.gameTime)}};
+        }
+
+        if (auto d = diffStateLogSections(getPlayerFields(), a.players, b.players); !d.empty())
+        {
+            differences["players"] = std::move(d);
+        }
+
+        if (auto d = diffStateLogSections(getUnitFields(), a.units, b.units); !d.empty())
+        {
+            differences["units"] = std::move(d);
+        }
+
+        if (auto d = diffStateLogSections(getProjectileFields(), a.projectiles, b.projectiles); !d.empty())
+        {
+            differences["projectiles"] = std::move(d);
+        }
+
+        if (!differences.is_null() && !differences.contains("gameTime"))
+        {
+            differences["gameTime"] = dumpJson(a.gameTime);
+        }
+
+        return differences;
+    }
+
+    uint32_t allStateLogFieldsMask(std::size_t fieldCount)
+    {
+        return fieldCount >= MaxStateLogFieldCount ? ~uint32_t(0) : (uint32_t(1) << fieldCount) - 1;
+    }
+
+    /**
+     * Writes the entities removed since the previous frame,
+     * then the fields of each entity that changed.
+     * New entities, and all entities in a keyframe, have every field written.
+     */
+    void writeStateLogSection(SnapshotWriter& w, const StateLogSection& previous, const StateLogSection& current, bool keyframe)
+    {
+        std::vector<uint32_t> removed;
+        if (!keyframe)
+        {
+            for (const auto& [id, _] : previous)
+            {
+                if (current.find(id) == current.end())
+                {
+                    removed.push_back(id);
+                }
+            }
+        }
+        writeSnapshot(w, removed);
+
+        std::vector<std::pair<const StateLogEntity*, std::pair<uint32_t, uint32_t>>> changed;
+        for (const auto& [id, entity] : current)
+        {
+            auto fieldCount = entity.fieldEnds.size();
+            auto mask = allStateLogFieldsMask(fieldCount);
+            if (!keyframe)
+            {
+                if (auto it = previous.find(id); it != previous.end())
+                {
+                    mask = 0;
+                    for (std::size_t i = 0; i < fieldCount; ++i)
+                    {
+                        if (entity.getField(i) != it->second.getField(i))
+                        {
+                            mask |= uint32_t(1) << i;
+                        }
+                    }
+                }
+            }
+
+            if (mask != 0)
+            {
+                changed.emplace_back(&entity, std::make_pair(id, mask));
+            }
+        }
+
+        writeSnapshotSize(w, changed.size());
+        for (const auto& [entity, idAndMask] : changed)
+        {
+            writeSnapshot(w, idAndMask.first);
+            writeSnapshot(w, idAndMask.second);
+            for (std::size_t i = 0; i < entity->fieldEnds.size(); ++i)
+            {
+                if (idAndMask.second & (uint32_t(1) << i))
+                {
+                    auto field = entity->getField(i);
+                    writeSnapshotSize(w, field.size());
+                    w.writeBytes(field.data(), field.size());
+                }
+            }
+        }
+    }
+
+    void readStateLogSection(SnapshotReader& r, StateLogSection& section, std::size_t fieldCount)
+    {
+        auto removed = readSnapshotValue<std::vector<uint32_t>>(r);
+        for (auto id : removed)
+        {
+            if (section.erase(id) == 0)
+            {
+                throw std::runtime_error("State log removes an unknown entity: " + std::to_string(id));
+            }
+        }
+
+        auto changedCount = readSnapshotSize(r);
+        for (std::size_t c = 0; c < changedCount; ++c)
+        {
+            auto id = readSnapshotValue<uint32_t>(r);
+            auto mask = readSnapshotValue<uint32_t>(r);
+            if ((mask & ~allStateLogFieldsMask(fieldCount)) != 0)
+            {
+                throw std::runtime_error("State log entity has unknown fields: " + std::to_string(id));
+            }
+
+            auto it = section.find(id);
+            if (it == section.end() && mask != allStateLogFieldsMask(fieldCount))
+            {
+                throw std::runtime_error("State log adds an entity without all of its fields: " + std::to_string(id));
+            }
+
+            StateLogEntity entity;
+            entity.fieldEnds.reserve(fieldCount);
+            for (std::size_t i = 0; i < fieldCount; ++i)
+            {
+                if (mask & (uint32_t(1) << i))
+                {
+                    auto size = readSnapshotSize(r);
+                    auto offset = entity.bytes.size();
+                    entity.bytes.resize(offset + size);
+                    r.readBytes(entity.bytes.data() + offset, size);
+                }
+                else
+                {
+                    entity.bytes.append(it->second.getField(i));
+                }
+                entity.fieldEnds.push_back(static_cast<uint32_t>(entity.bytes.size()));
+            }
+
+            section.insert_or_assign(id, std::move(entity));
+        }
+    }
+
+    StateLogWriter::StateLogWriter(std::unique_ptr<std::ostream> stream)
+        : stream(std::move(stream)), writer(*this->stream)
+    {
+        writer.writeBytes(StateLogMagic, sizeof(StateLogMagic));
+        writeSnapshot(writer, StateLogVersion);
+    }
+
+    void StateLogWriter::writeFrame(const GameSimulation& simulation)
+    {
+        auto frame = createStateLogFrame(simulation);
+        auto keyframe = framesSinceKeyframe == 0;
+
+        writeSnapshot(writer, keyframe ? StateLogFrameKind::Keyframe : StateLogFrameKind::Delta);
+        writeSnapshot(writer, frame.gameTime);
+        writeStateLogSection(writer, previousFrame.players, frame.players, keyframe);
+        writeStateLogSection(writer, previousFrame.units, frame.units, keyframe);
+        writeStateLogSection(writer, previousFrame.projectiles, frame.projectiles, keyframe);
+
+        previousFrame = std::move(frame);
+        framesSinceKeyframe = (framesSinceKeyframe + 1) % StateLogKeyframeInterval;
+    }
+
+    void StateLogWriter::flush()
+    {
+        stream->flush();
+    }
+
+    StateLogReader::StateLogReader(std::unique_ptr<std::istream> stream)
+        : stream(std::move(stream)), reader(*this->stream)
+    {
+        char magic[sizeof(StateLogMagic)];
+        reader.readBytes(magic, sizeof(magic));
+        if (!std::equal(std::begin(magic), std::end(magic), std::begin(StateLogMagic)))
+        {
+            throw std::runtime_error("Not a state log");
+        }
+
+        auto version = readSnapshotValue<uint32_t>(reader);
+        if (version != StateLogVersion)
+        {
+            throw std::runtime_error("Unsupported state log version: " + std::to_string(version));
+        }
+    }
+
+    bool StateLogReader::readFrame()
+    {
+        if (stream->peek() == std::istream::traits_type::eof())
+        {
+            return false;
+        }
+
+        auto kind = readSnapshotValue<StateLogFrameKind>(reader);
+        switch (kind)
+        {
+            case StateLogFrameKind::Keyframe:
+                frame = StateLogFrame();
+                break;
+            case StateLogFrameKind::Delta:
+                if (!anyFrameRead)
+                {
+                    throw std::runtime_error("State log does not start with a keyframe");
+                }
+                break;
+            default:
+                throw std::runtime_error("Invalid state log frame kind: " + std::to_string(static_cast<int>(kind)));
+        }
+
+        frame.gameTime = readSnapshotValue<GameTime>(reader);
+        readStateLogSection(reader, frame.players, getPlayerFields().size());
+        readStateLogSection(reader, frame.units, getUnitFields().size());
+        readStateLogSection(reader, frame.projectiles, getProjectileFields().size());
+        anyFrameRead = true;
+        return true;
+    }
+
+    const StateLogFrame& StateLogReader::getFrame() const
+    {
+        return frame;
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <ostream>
+#include <rwe/sim/GameSimulation.h>
+#include <rwe/sim/GameTime.h>
+#include <rwe/sim/SnapshotIo.h>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rwe
+{
+    /** Bump whenever the layout of a state log changes. */
+    constexpr uint32_t StateLogVersion = 1;
+
+    /** The number of ticks between frames that contain the full state. */
+    constexpr unsigned int StateLogKeyframeInterval = 300;
+
+    /**
+     * The fields of a player, unit or projectile that the state log records,
+     * each encoded in the snapshot format.
+     */
+    struct StateLogEntity
+    {
+        std::string bytes;
+
+        /** The offset in bytes at which each field ends. */
+        std::vector<uint32_t> fieldEnds;
+
+        std::string_view getField(std::size_t index) const;
+    };
+
+    /** Entities by id, in id order. */
+    using StateLogSection = std::map<uint32_t, StateLogEntity>;
+
+    /** The logged state of the simulation after a tick. */
+    struct StateLogFrame
+    {
+        GameTime gameTime{0};
+        StateLogSection players;
+        StateLogSection units;
+        StateLogSection projectiles;
+    };
+
+    StateLogFrame createStateLogFrame(const GameSimulation& simulation);
+
+    /** Returns the frame in the same form that dumpJson gives for the simulation. */
+    nlohmann::json stateLogFrameToJson(const StateLogFrame& frame);
+
+    /**
+     * Returns the fields that differ between the two frames,
+     * or null if the frames are the same.
+     */
+    nlohmann::json diffStateLogFrames(const StateLogFrame& a, const StateLogFrame& b);
+
+    /**
+     * Logs the state of the simulation after every tick.
+     * Each frame only contains the fields that changed since the previous frame,
+     * except for a keyframe every StateLogKeyframeInterval frames,
+     * which contains everything.
+     */
+    class StateLogWriter
+    {
+    private:
+        std::unique_ptr<std::ostream> stream;
+        SnapshotWriter writer;
+        StateLogFrame previousFrame;
+        unsigned int framesSinceKeyframe{0};
+
+    public:
+        explicit StateLogWriter(std::unique_ptr<std::ostream> stream);
+
+        void writeFrame(const GameSimulation& simulation);
+
+        void flush();
+    };
+
+    class StateLogReader
+    {
+    private:
+        std::unique_ptr<std::istream> stream;
+        SnapshotReader reader;
+        StateLogFrame frame;
+        bool anyFrameRead{false};
+
+    public:
+        /** Throws std::runtime_error if the stream does not contain a supported state log. */
+        explicit StateLogReader(std::unique_ptr<std::istream> stream);
+
+        /**
+         * Reads the next frame and returns true,
+         * or returns false at the end of the log.
+         */
+        bool readFrame();
+
+        const StateLogFrame& getFrame() const;
+    };
+}
@@ -0,0 +1,123 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/game/StateLog.h>
+#include <rwe/game/dump_util.h>
+#include <sstream>
+
+namespace rwe
+{
+    GameSimulation createStateLogTestSimulation()
+    {
+        GameSimulation simulation(MapTerrain(Grid<unsigned char>(32, 32, 10), 0_ss), 0, 1000, 3000);
+
+        UnitDefinition unitDefinition{};
+        unitDefinition.unitType = "TESTUNIT";
+        unitDefinition.objectName = "TESTMODEL";
+        unitDefinition.movementCollisionInfo = UnitDefinition::AdHocMovementClass{2, 2, 255, 255, 0, 255};
+        unitDefinition.maxHitPoints = 100;
+        unitDefinition.isMobile = true;
+        unitDefinition.maxVelocity = 2_ss;
+        unitDefinition.acceleration = 1_ss;
+        unitDefinition.brakeRate = 1_ss;
+        unitDefinition.turnRate = SimScalar(1000);
+        auto unitDefinitionId = simulation.unitDefinitions.insert(unitDefinition);
+        simulation.unitNameIndex.insert({"TESTUNIT", unitDefinitionId});
+
+        std::vector<UnitPieceDefinition> pieces{UnitPieceDefinition{"base", SimVector(0_ss, 0_ss, 0_ss), std::nullopt}};
+        simulation.unitModelDefinitions.insert({"TESTMODEL", createUnitModelDefinition(10_ss, std::move(pieces))});
+
+        CobScript script;
+        script.pieces = {"base"};
+        script.staticVariableCount = 0;
+        simulation.unitScriptDefinitions.insert({"TESTUNIT", compileCobScript(std::move(script))});
+
+        simulation.addPlayer(GamePlayerInfo{
+            .name = std::string("Alice"),
+            .type = GamePlayerType::Human,
+            .color = PlayerColorIndex(0),
+            .status = GamePlayerStatus::Alive,
+            .side = "ARM",
+            .metal = Metal(500),
+            .energy = Energy(700),
+            .maxMetal = Metal(1000),
+            .maxEnergy = Energy(1000),
+            .startingMetal = Metal(500),
+            .startingEnergy = Energy(700),
+        });
+
+        return simulation;
+    }
+
+    TEST_CASE("StateLog")
+    {
+        SECTION("reads back the state dumpJson gives for every tick")
+        {
+            auto simulation = createStateLogTestSimulation();
+            auto moving = simulation.trySpawnUnit("TESTUNIT", PlayerId(0), SimVector(-100_ss, 10_ss, -100_ss), std::nullopt);
+            auto killed = simulation.trySpawnUnit("TESTUNIT", PlayerId(0), SimVector(100_ss, 10_ss, -100_ss), std::nullopt);
+            REQUIRE(moving);
+            REQUIRE(killed);
+            simulation.getUnitState(*moving).addOrder(createMoveOrder(SimVector(100_ss, 10_ss, 100_ss)));
+
+            auto stream = std::make_unique<std::stringstream>();
+            auto& streamRef = *stream;
+            StateLogWriter writer(std::move(stream));
+
+            // long enough to cross a keyframe
+            std::vector<nlohmann::json> expected;
+            for (unsigned int i = 0; i < StateLogKeyframeInterval + 20; ++i)
+            {
+                if (i == 10)
+                {
+                    simulation.quietlyKillUnit(*killed);
+                    simulation.deleteDeadUnits();
+                }
+                if (i == 20)
+                {
+                    REQUIRE(simulation.trySpawnUnit("TESTUNIT", PlayerId(0), SimVector(0_ss, 10_ss, 100_ss), std::nullopt));
+                }
+
+                simulation.tick();
+                simulation.events.clear();
+                writer.writeFrame(simulation);
+                expected.push_back(dumpJson(simulation));
+            }
+            writer.flush();
+
+            StateLogReader reader(std::make_unique<std::stringstream>(streamRef.str()));
+            for (const auto& e : expected)
+            {
+                REQUIRE(reader.readFrame());
+                REQUIRE(stateLogFrameToJson(reader.getFrame()) == e);
+            }
+            REQUIRE(!reader.readFrame());
+        }
+
+        SECTION("diffs frames")
+        {
+            auto a = createStateLogTestSimulation();
+            auto b = createStateLogTestSimulation();
+            auto unitA = a.trySpawnUnit("TESTUNIT", PlayerId(0), SimVector(0_ss, 10_ss, 0_ss), std::nullopt);
+            auto unitB = b.trySpawnUnit("TESTUNIT", PlayerId(0), SimVector(0_ss, 10_ss, 0_ss), std::nullopt);
+            REQUIRE(unitA);
+            REQUIRE(unitB);
+
+            REQUIRE(diffStateLogFrames(createStateLogFrame(a), createStateLogFrame(b)).is_null());
+
+            b.getUnitState(*unitB).hitPoints = 42;
+            b.trySpawnUnit("TESTUNIT", PlayerId(0), SimVector(100_ss, 10_ss, 100_ss), std::nullopt);
+
+            auto diff = diffStateLogFrames(createStateLogFrame(a), createStateLogFrame(b));
+            REQUIRE(diff["units"].size() == 2);
+            REQUIRE(diff["units"][0]["id"] == unitA->value);
+            REQUIRE(diff["units"][0]["field"] == "hitPoints");
+            REQUIRE(diff["units"][0]["b"] == 42);
+            REQUIRE(diff["units"][1]["a"].is_null());
+            REQUIRE(!diff.contains("players"));
+        }
+
+        SECTION("rejects data that is not a state log")
+        {
+            REQUIRE_THROWS_AS(StateLogReader(std::make_unique<std::stringstream>("not a state log")), std::runtime_error);
+        }
+    }
+}
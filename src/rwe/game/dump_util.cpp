@@ -123,19 +123,13 @@ namespace rwe
     }
     nlohmann::json dumpJson(const Projectile& projectile)
     {
-        nlohmann::json j{
+        return nlohmann::json{
+            {"weaponType", dumpJson(projectile.weaponType)},
             {"owner", dumpJson(projectile.owner)},
             {"position", dumpJson(projectile.position)},
             {"origin", dumpJson(projectile.origin)},
             {"velocity", dumpJson(projectile.velocity)},
             {"damageRadius", dumpJson(projectile.damageRadius)}};
-
-        for (const auto& [t, damage] : projectile.damage)
-        {
-            j["damage"][t] = dumpJson(damage);
-        }
-
-        return j;
     }
     nlohmann::json dumpJson(const UnitBehaviorStateIdle&)
     {
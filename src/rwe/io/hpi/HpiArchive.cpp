@@ -1,9 +1,9 @@
 #include "HpiArchive.h"
 #include <algorithm>
+#include <cstring>
 #include <memory>
 #include <optional>
 #include <rwe/io/hpi/hpi_util.h>
-#include <rwe/io/io_util.h>
 #include <rwe/util/match.h>
 #include <rwe/util/rwe_string.h>
 
@@ -70,9 +70,15 @@ namespace rwe
         }
     }
 
-    HpiArchive::HpiArchive(std::istream* stream) : stream(stream)
+    HpiArchive::HpiArchive(const char* data, std::size_t size) : data(data), size(size)
     {
-        auto v = readRaw<HpiVersion>(*stream);
+        if (size < sizeof(HpiVersion) + sizeof(HpiHeader))
+        {
+            throw HpiException("File too small to be an HPI archive");
+        }
+
+        HpiVersion v;
+        std::memcpy(&v, data, sizeof(HpiVersion));
         if (v.marker != HpiMagicNumber)
         {
             throw HpiException("Invalid HPI file marker");
@@ -83,21 +89,21 @@ namespace rwe
             throw HpiException("Unsupported HPI version");
         }
 
-        auto h = readRaw<HpiHeader>(*stream);
+        HpiHeader h;
+        std::memcpy(&h, data + sizeof(HpiVersion), sizeof(HpiHeader));
 
         decryptionKey = transformKey(static_cast<unsigned char>(h.headerKey));
 
-        stream->seekg(h.start);
-        auto data = std::make_unique<char[]>(h.directorySize);
-        readAndDecrypt(*stream, decryptionKey, data.get() + h.start, h.directorySize - h.start);
-
         if (h.start + sizeof(HpiDirectoryData) > h.directorySize)
         {
             throw HpiException("Runaway root directory");
         }
 
-        auto directory = reinterpret_cast<HpiDirectoryData*>(data.get() + h.start);
-        _root = convertDirectory(*directory, data.get(), h.directorySize);
+        auto directoryData = std::make_unique<char[]>(h.directorySize);
+        readAndDecrypt(data, size, h.start, decryptionKey, directoryData.get() + h.start, h.directorySize - h.start);
+
+        auto directory = reinterpret_cast<HpiDirectoryData*>(directoryData.get() + h.start);
+        _root = convertDirectory(*directory, directoryData.get(), h.directorySize);
     }
 
     const HpiArchive::Directory& HpiArchive::root() const
@@ -107,15 +113,24 @@ namespace rwe
 
     void HpiArchive::extract(const HpiArchive::File& file, char* buffer) const
     {
-        stream->seekg(file.offset);
+        extractInternal(file, buffer, nullptr);
+    }
+
+    void HpiArchive::extract(const HpiArchive::File& file, char* buffer, ThreadPool& threadPool) const
+    {
+        extractInternal(file, buffer, &threadPool);
+    }
+
+    void HpiArchive::extractInternal(const HpiArchive::File& file, char* buffer, ThreadPool* threadPool) const
+    {
         switch (file.compressionScheme)
         {
             case HpiArchive::File::CompressionScheme::None:
-                readAndDecrypt(*stream, decryptionKey, buffer, file.size);
+                readAndDecrypt(data, size, file.offset, decryptionKey, buffer, file.size);
                 break;
             case HpiArchive::File::CompressionScheme::LZ77:
             case HpiArchive::File::CompressionScheme::ZLib:
-                extractCompressed(*stream, decryptionKey, buffer, file.size);
+                extractCompressed(data, size, file.offset, decryptionKey, buffer, file.size, threadPool);
                 break;
             default:
                 throw HpiException("Invalid file entry compression scheme");
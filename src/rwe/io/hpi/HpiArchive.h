@@ -2,9 +2,10 @@
 
 #include <cstdint>
 #include <functional>
-#include <istream>
 #include <optional>
 #include <rwe/io/hpi/hpi_headers.h>
+#include <rwe/util/ThreadPool.h>
+#include <string>
 #include <variant>
 #include <vector>
 
@@ -37,12 +38,19 @@ namespace rwe
         };
 
     private:
-        std::istream* stream;
+        const char* data;
+        std::size_t size;
         unsigned char decryptionKey;
         Directory _root;
 
     public:
-        explicit HpiArchive(std::istream* stream);
+        /**
+         * Reads the directory of the archive held in the given memory,
+         * which must outlive the archive.
+         * The archive keeps no read position of its own,
+         * so files may be extracted from several threads at once.
+         */
+        HpiArchive(const char* data, std::size_t size);
 
         const Directory& root() const;
 
@@ -51,5 +59,11 @@ namespace rwe
         std::optional<std::reference_wrapper<const Directory>> findDirectory(const std::string& path) const;
 
         void extract(const File& file, char* buffer) const;
+
+        /** Extracts the file, decompressing its chunks in parallel on the thread pool. */
+        void extract(const File& file, char* buffer, ThreadPool& threadPool) const;
+
+    private:
+        void extractInternal(const File& file, char* buffer, ThreadPool* threadPool) const;
     };
 }
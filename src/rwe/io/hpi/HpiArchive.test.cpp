@@ -0,0 +1,96 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/io/hpi/HpiArchive.h>
+#include <rwe/io/hpi/hpi_util.h>
+#include <rwe/io/hpi/hpi_write.h>
+#include <rwe/util/ThreadPool.h>
+#include <string>
+#include <vector>
+
+namespace rwe
+{
+    /** Data that compresses in some places and not in others. */
+    std::string createTestData(std::size_t size)
+    {
+        std::string data(size, '\0');
+        uint32_t noise = 1;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            noise = (noise * 1103515245) + 12345;
+            data[i] = (i / 65536) % 2 == 0 ? static_cast<char>((i * 7) ^ (i >> 9)) : static_cast<char>(noise >> 16);
+        }
+        return data;
+    }
+
+    std::string extractToString(const HpiArchive& archive, const HpiArchive::File& file)
+    {
+        std::string out(file.size, '\0');
+        archive.extract(file, out.data());
+        return out;
+    }
+
+    TEST_CASE("HpiArchive")
+    {
+        std::string readme = "Hello, world!";
+        auto big = createTestData(150000);
+        auto bytes = writeHpiArchive({{"readme.txt", readme, false}, {"data/big.bin", big, true}}, 0x7d);
+
+        SECTION("extracts stored and chunked files")
+        {
+            HpiArchive archive(bytes.data(), bytes.size());
+
+            auto readmeFile = archive.findFile("README.TXT");
+            REQUIRE(readmeFile);
+            REQUIRE(extractToString(archive, *readmeFile) == readme);
+
+            auto bigFile = archive.findFile("data/big.bin");
+            REQUIRE(bigFile);
+            REQUIRE(extractToString(archive, *bigFile) == big);
+
+            REQUIRE(archive.findDirectory("data"));
+            REQUIRE(!archive.findFile("data/missing.bin"));
+        }
+
+        SECTION("extracts the chunks of a file in parallel")
+        {
+            HpiArchive archive(bytes.data(), bytes.size());
+            const auto& bigFile = archive.findFile("data/big.bin")->get();
+
+            ThreadPool pool(4);
+            std::string out(bigFile.size, '\0');
+            archive.extract(bigFile, out.data(), pool);
+            REQUIRE(out == big);
+        }
+
+        SECTION("extracts from several threads at once")
+        {
+            HpiArchive archive(bytes.data(), bytes.size());
+            const auto& readmeFile = archive.findFile("readme.txt")->get();
+            const auto& bigFile = archive.findFile("data/big.bin")->get();
+
+            ThreadPool pool(4);
+            std::vector<std::string> results(64);
+            pool.parallelFor(results.size(), [&](std::size_t i, unsigned int) {
+                results[i] = extractToString(archive, i % 2 == 0 ? bigFile : readmeFile);
+            });
+
+            for (std::size_t i = 0; i < results.size(); ++i)
+            {
+                REQUIRE(results[i] == (i % 2 == 0 ? big : readme));
+            }
+        }
+
+        SECTION("rejects a file that runs past the end of the archive")
+        {
+            HpiArchive archive(bytes.data(), bytes.size() - 100);
+            auto bigFile = archive.findFile("data/big.bin");
+            REQUIRE(bigFile);
+            REQUIRE_THROWS_AS(extractToString(archive, *bigFile), HpiException);
+        }
+
+        SECTION("rejects data that is not an archive")
+        {
+            std::string notAnArchive = "not an archive at all";
+            REQUIRE_THROWS_AS(HpiArchive(notAnArchive.data(), notAnArchive.size()), HpiException);
+        }
+    }
+}
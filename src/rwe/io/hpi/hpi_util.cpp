@@ -3,49 +3,244 @@
 
 #include <memory>
 #include <rwe/io/hpi/hpi_headers.h>
+#include <vector>
 #include <zlib.h>
 
+// SSE2 is part of the x86-64 baseline, AVX2 is checked for at runtime.
+#if defined(__x86_64__) || defined(_M_X64)
+#define RWE_HPI_X86 1
+#endif
+
+#ifdef RWE_HPI_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define RWE_TARGET_AVX2
+#else
+#define RWE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
 namespace rwe
 {
     HpiException::HpiException(const char* message) : runtime_error(message) {}
 
-    /**
-     * Decrypts the contents of the buffer.
-     * @param key The decryption key.
-     * @param seed The seed for decryption,
-     * typically the position of the starting byte in the file.
-     * @param buf The buffer to decrypt.
-     * @param size The size of the buffer.
-     */
-    void decrypt(unsigned char key, unsigned char seed, char buf[], std::streamsize size)
+    void decryptScalar(unsigned char key, unsigned char seed, char buf[], std::size_t size)
     {
         if (key == 0)
         {
             return;
         }
 
-        for (std::streamsize i = 0; i < size; ++i)
+        for (std::size_t i = 0; i < size; ++i)
         {
             auto pos = seed + static_cast<unsigned char>(i);
             buf[i] = (pos ^ key) ^ buf[i];
         }
     }
 
-    void readAndDecrypt(std::istream& stream, unsigned char key, char buf[], std::streamsize size)
+    void decryptInnerScalar(char* buffer, std::size_t size)
     {
-        auto seed = static_cast<unsigned char>(stream.tellg());
-        stream.read(buf, size);
-        decrypt(key, seed, buf, stream.gcount());
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            auto pos = static_cast<unsigned char>(i);
+            buffer[i] = (buffer[i] - pos) ^ pos;
+        }
     }
 
-    unsigned char transformKey(unsigned char key)
+    uint32_t computeChecksumScalar(const char* buffer, std::size_t size)
     {
-        return (key << 2) | (key >> 6);
+        uint32_t sum = 0;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            sum += static_cast<unsigned char>(buffer[i]);
+        }
+
+        return sum;
+    }
+
+#ifdef RWE_HPI_X86
+    bool cpuSupportsAvx2()
+    {
+#ifdef _MSC_VER
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+
+        // the OS must also save the AVX registers on context switch
+        __cpuid(info, 1);
+        auto osxsave = (info[2] & (1 << 27)) != 0;
+        auto avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+        {
+            return false;
+        }
+
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+#else
+        return __builtin_cpu_supports("avx2");
+#endif
+    }
+
+    bool useAvx2()
+    {
+        static const bool supported = cpuSupportsAvx2();
+        return supported;
+    }
+
+    /** Bytes seed, seed + 1, ..., seed + 15, wrapping at 256. */
+    __m128i byteRamp128(unsigned char seed)
+    {
+        return _mm_add_epi8(_mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm_set1_epi8(static_cast<char>(seed)));
+    }
+
+    std::size_t decryptSse2(unsigned char key, unsigned char seed, char buf[], std::size_t size)
+    {
+        auto keys = _mm_set1_epi8(static_cast<char>(key));
+        auto positions = byteRamp128(seed);
+        auto step = _mm_set1_epi8(16);
+
+        std::size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            auto p = reinterpret_cast<__m128i*>(buf + i);
+            _mm_storeu_si128(p, _mm_xor_si128(_mm_loadu_si128(p), _mm_xor_si128(positions, keys)));
+            positions = _mm_add_epi8(positions, step);
+        }
+
+        return i;
+    }
+
+    std::size_t decryptInnerSse2(char* buffer, std::size_t size)
+    {
+        auto positions = byteRamp128(0);
+        auto step = _mm_set1_epi8(16);
+
+        std::size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            auto p = reinterpret_cast<__m128i*>(buffer + i);
+            _mm_storeu_si128(p, _mm_xor_si128(_mm_sub_epi8(_mm_loadu_si128(p), positions), positions));
+            positions = _mm_add_epi8(positions, step);
+        }
+
+        return i;
+    }
+
+    std::size_t checksumSse2(const char* buffer, std::size_t size, uint64_t& sum)
+    {
+        auto zero = _mm_setzero_si128();
+        auto sums = _mm_setzero_si128();
+
+        std::size_t i = 0;
+        for (; i + 16 <= size; i += 16)
+        {
+            // sums each half of the bytes into a 64-bit lane
+            auto v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buffer + i));
+            sums = _mm_add_epi64(sums, _mm_sad_epu8(v, zero));
+        }
+
+        alignas(16) uint64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), sums);
+        sum += lanes[0] + lanes[1];
+        return i;
+    }
+
+    RWE_TARGET_AVX2 __m256i byteRamp256(unsigned char seed)
+    {
+        auto ramp = _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+        return _mm256_add_epi8(ramp, _mm256_set1_epi8(static_cast<char>(seed)));
+    }
+
+    RWE_TARGET_AVX2 std::size_t decryptAvx2(unsigned char key, unsigned char seed, char buf[], std::size_t size)
+    {
+        auto keys = _mm256_set1_epi8(static_cast<char>(key));
+        auto positions = byteRamp256(seed);
+        auto step = _mm256_set1_epi8(32);
+
+        std::size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            auto p = reinterpret_cast<__m256i*>(buf + i);
+            _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_loadu_si256(p), _mm256_xor_si256(positions, keys)));
+            positions = _mm256_add_epi8(positions, step);
+        }
+
+        return i;
+    }
+
+    RWE_TARGET_AVX2 std::size_t decryptInnerAvx2(char* buffer, std::size_t size)
+    {
+        auto positions = byteRamp256(0);
+        auto step = _mm256_set1_epi8(32);
+
+        std::size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            auto p = reinterpret_cast<__m256i*>(buffer + i);
+            _mm256_storeu_si256(p, _mm256_xor_si256(_mm256_sub_epi8(_mm256_loadu_si256(p), positions), positions));
+            positions = _mm256_add_epi8(positions, step);
+        }
+
+        return i;
+    }
+
+    RWE_TARGET_AVX2 std::size_t checksumAvx2(const char* buffer, std::size_t size, uint64_t& sum)
+    {
+        auto zero = _mm256_setzero_si256();
+        auto sums = _mm256_setzero_si256();
+
+        std::size_t i = 0;
+        for (; i + 32 <= size; i += 32)
+        {
+            auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(buffer + i));
+            sums = _mm256_add_epi64(sums, _mm256_sad_epu8(v, zero));
+        }
+
+        alignas(32) uint64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), sums);
+        sum += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+        return i;
+    }
+#endif
+
+    const char* getHpiSimdLevel()
+    {
+#ifdef RWE_HPI_X86
+        return useAvx2() ? "AVX2" : "SSE2";
+#else
+        return "scalar";
+#endif
+    }
+
+    void decrypt(unsigned char key, unsigned char seed, char buf[], std::size_t size)
+    {
+        if (key == 0)
+        {
+            return;
+        }
+
+        std::size_t done = 0;
+#ifdef RWE_HPI_X86
+        done = useAvx2() ? decryptAvx2(key, seed, buf, size) : decryptSse2(key, seed, buf, size);
+#endif
+        decryptScalar(key, static_cast<unsigned char>(seed + done), buf + done, size - done);
     }
 
     void decryptInner(char* buffer, std::size_t size)
     {
-        for (std::size_t i = 0; i < size; ++i)
+        std::size_t done = 0;
+#ifdef RWE_HPI_X86
+        done = useAvx2() ? decryptInnerAvx2(buffer, size) : decryptInnerSse2(buffer, size);
+#endif
+
+        // The key is the position in the whole buffer,
+        // so the tail can't be handed to decryptInnerScalar.
+        for (std::size_t i = done; i < size; ++i)
         {
             auto pos = static_cast<unsigned char>(i);
             buffer[i] = (buffer[i] - pos) ^ pos;
@@ -54,13 +249,28 @@ namespace rwe
 
     uint32_t computeChecksum(const char* buffer, std::size_t size)
     {
-        uint32_t sum = 0;
-        for (std::size_t i = 0; i < size; ++i)
+        uint64_t sum = 0;
+        std::size_t done = 0;
+#ifdef RWE_HPI_X86
+        done = useAvx2() ? checksumAvx2(buffer, size, sum) : checksumSse2(buffer, size, sum);
+#endif
+        return static_cast<uint32_t>(sum) + computeChecksumScalar(buffer + done, size - done);
+    }
+
+    void readAndDecrypt(const char* archive, std::size_t archiveSize, std::size_t offset, unsigned char key, char buf[], std::size_t size)
+    {
+        if (offset > archiveSize || size > archiveSize - offset)
         {
-            sum += static_cast<unsigned char>(buffer[i]);
+            throw HpiException("Read past end of archive");
         }
 
-        return sum;
+        std::copy(archive + offset, archive + offset + size, buf);
+        decrypt(key, static_cast<unsigned char>(offset), buf, size);
+    }
+
+    unsigned char transformKey(unsigned char key)
+    {
+        return (key << 2) | (key >> 6);
     }
 
     void decompressLZ77(const char* in, std::size_t len, char* out, std::size_t maxBytes)
@@ -183,17 +393,88 @@ namespace rwe
         return std::nullopt;
     }
 
-    void extractCompressed(std::istream& stream, unsigned char decryptionKey, char* buffer, std::size_t size)
+    struct HpiChunkInfo
+    {
+        HpiChunk header;
+
+        /** Where the chunk's data starts in the archive. */
+        std::size_t position;
+
+        /** Where the chunk's data goes in the extracted file. */
+        std::size_t bufferOffset;
+    };
+
+    void extractChunk(const char* archive, std::size_t archiveSize, unsigned char decryptionKey, const HpiChunkInfo& chunk, char* buffer)
+    {
+        const auto& header = chunk.header;
+        auto out = buffer + chunk.bufferOffset;
+
+        // Stored chunks are decrypted where they will end up,
+        // everything else goes through a scratch buffer.
+        std::unique_ptr<char[]> chunkBuffer;
+        char* data;
+        if (header.compressionScheme == 0)
+        {
+            if (header.compressedSize != header.decompressedSize)
+            {
+                throw HpiException("Uncompressed chunk has different decompressed and compressed sizes");
+            }
+
+            data = out;
+        }
+        else
+        {
+            chunkBuffer = std::make_unique<char[]>(header.compressedSize);
+            data = chunkBuffer.get();
+        }
+
+        readAndDecrypt(archive, archiveSize, chunk.position, decryptionKey, data, header.compressedSize);
+
+        auto checksum = computeChecksum(data, header.compressedSize);
+        if (checksum != header.checksum)
+        {
+            throw HpiException("Invalid chunk checksum");
+        }
+
+        if (header.encrypted != 0)
+        {
+            decryptInner(data, header.compressedSize);
+        }
+
+        switch (header.compressionScheme)
+        {
+            case 0: // no compression
+                break;
+
+            case 1: // LZ77 compression
+                decompressLZ77(data, header.compressedSize, out, header.decompressedSize);
+                break;
+
+            case 2: // ZLib compression
+                decompressZLib(data, header.compressedSize, out, header.decompressedSize);
+                break;
+            default:
+                throw HpiException("Invalid compression scheme");
+        }
+    }
+
+    void extractCompressed(const char* archive, std::size_t archiveSize, std::size_t offset, unsigned char decryptionKey, char* buffer, std::size_t size, ThreadPool* threadPool)
     {
         auto chunkCount = (size / 65536) + (size % 65536 == 0 ? 0 : 1);
 
-        auto chunkSizes = std::make_unique<uint32_t[]>(chunkCount);
-        readAndDecryptRawArray(stream, decryptionKey, chunkSizes.get(), chunkCount);
+        // Skip the table of chunk sizes.
+        // Each chunk's header says how big it is.
+        auto position = offset + (chunkCount * sizeof(uint32_t));
 
+        // Walk the headers first to find where every chunk's data is
+        // and where its output goes, so the chunks can then be extracted in any order.
+        std::vector<HpiChunkInfo> chunks;
+        chunks.reserve(chunkCount);
         std::size_t bufferOffset = 0;
         for (std::size_t i = 0; i < chunkCount; ++i)
         {
-            auto chunkHeader = readAndDecryptRaw<HpiChunk>(stream, decryptionKey);
+            auto chunkHeader = readAndDecryptRaw<HpiChunk>(archive, archiveSize, position, decryptionKey);
+            position += sizeof(HpiChunk);
             if (chunkHeader.marker != HpiChunkMagicNumber)
             {
                 throw HpiException("Invalid chunk header");
@@ -204,43 +485,22 @@ namespace rwe
                 throw HpiException("Extracted file larger than expected");
             }
 
-            auto chunkBuffer = std::make_unique<char[]>(chunkHeader.compressedSize);
-            readAndDecrypt(stream, decryptionKey, chunkBuffer.get(), chunkHeader.compressedSize);
-
-            auto checksum = computeChecksum(chunkBuffer.get(), chunkHeader.compressedSize);
-            if (checksum != chunkHeader.checksum)
-            {
-                throw HpiException("Invalid chunk checksum");
-            }
-
-            if (chunkHeader.encrypted != 0)
-            {
-                decryptInner(chunkBuffer.get(), chunkHeader.compressedSize);
-            }
+            chunks.push_back(HpiChunkInfo{chunkHeader, position, bufferOffset});
+            position += chunkHeader.compressedSize;
+            bufferOffset += chunkHeader.decompressedSize;
+        }
 
-            switch (chunkHeader.compressionScheme)
+        if (threadPool != nullptr && chunks.size() > 1)
+        {
+            threadPool->parallelFor(chunks.size(), [&](std::size_t i, unsigned int) {
+                extractChunk(archive, archiveSize, decryptionKey, chunks[i], buffer);
+            });
+        }
+        else
+        {
+            for (const auto& chunk : chunks)
             {
-                case 0: // no compression
-                    if (chunkHeader.compressedSize != chunkHeader.decompressedSize)
-                    {
-                        throw HpiException("Uncompressed chunk has different decompressed and compressed sizes");
-                    }
-
-                    std::copy(chunkBuffer.get(), chunkBuffer.get() + chunkHeader.compressedSize, buffer + bufferOffset);
-                    bufferOffset += chunkHeader.decompressedSize;
-                    break;
-
-                case 1: // LZ77 compression
-                    decompressLZ77(chunkBuffer.get(), chunkHeader.compressedSize, buffer + bufferOffset, chunkHeader.decompressedSize);
-                    bufferOffset += chunkHeader.decompressedSize;
-                    break;
-
-                case 2: // ZLib compression
-                    decompressZLib(chunkBuffer.get(), chunkHeader.compressedSize, buffer + bufferOffset, chunkHeader.decompressedSize);
-                    bufferOffset += chunkHeader.decompressedSize;
-                    break;
-                default:
-                    throw HpiException("Invalid compression scheme");
+                extractChunk(archive, archiveSize, decryptionKey, chunk, buffer);
             }
         }
     }
@@ -1,7 +1,9 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
-#include <istream>
 #include <optional>
+#include <rwe/util/ThreadPool.h>
+#include <stdexcept>
 
 namespace rwe
 {
@@ -11,9 +13,21 @@ namespace rwe
         explicit HpiException(const char* message);
     };
 
-    void decrypt(unsigned char key, unsigned char seed, char buf[], std::streamsize size);
+    /**
+     * Decrypts the contents of the buffer.
+     * @param key The decryption key.
+     * @param seed The seed for decryption,
+     * typically the position of the starting byte in the file.
+     * @param buf The buffer to decrypt.
+     * @param size The size of the buffer.
+     */
+    void decrypt(unsigned char key, unsigned char seed, char buf[], std::size_t size);
 
-    void readAndDecrypt(std::istream& stream, unsigned char key, char buf[], std::streamsize size);
+    /**
+     * Copies size bytes from the given offset in the archive into buf and decrypts them.
+     * Throws HpiException if the bytes run past the end of the archive.
+     */
+    void readAndDecrypt(const char* archive, std::size_t archiveSize, std::size_t offset, unsigned char key, char buf[], std::size_t size);
 
     unsigned char transformKey(unsigned char key);
 
@@ -21,25 +35,35 @@ namespace rwe
 
     uint32_t computeChecksum(const char* buffer, std::size_t size);
 
+    /**
+     * Byte-at-a-time versions of decrypt, decryptInner and computeChecksum.
+     * The versions above use SSE2 or AVX2 where the CPU has them
+     * and give the same results.
+     */
+    void decryptScalar(unsigned char key, unsigned char seed, char buf[], std::size_t size);
+    void decryptInnerScalar(char* buffer, std::size_t size);
+    uint32_t computeChecksumScalar(const char* buffer, std::size_t size);
+
+    /** The instruction set decrypt, decryptInner and computeChecksum use on this machine. */
+    const char* getHpiSimdLevel();
+
     void decompressLZ77(const char* in, std::size_t len, char* out, std::size_t maxBytes);
 
     void decompressZLib(const char* in, std::size_t len, char* out, std::size_t maxBytes);
 
     std::optional<std::size_t> stringSize(const char* begin, const char* end);
 
-    void extractCompressed(std::istream& stream, unsigned char decryptionKey, char* buffer, std::size_t size);
+    /**
+     * Extracts the chunked file at the given offset in the archive into buffer.
+     * If a thread pool is given, the chunks are decompressed in parallel on it.
+     */
+    void extractCompressed(const char* archive, std::size_t archiveSize, std::size_t offset, unsigned char decryptionKey, char* buffer, std::size_t size, ThreadPool* threadPool);
 
     template <typename T>
-    T readAndDecryptRaw(std::istream& stream, unsigned char key)
+    T readAndDecryptRaw(const char* archive, std::size_t archiveSize, std::size_t offset, unsigned char key)
     {
         T val;
-        readAndDecrypt(stream, key, reinterpret_cast<char*>(&val), sizeof(T));
+        readAndDecrypt(archive, archiveSize, offset, key, reinterpret_cast<char*>(&val), sizeof(T));
         return val;
     }
-
-    template <typename T>
-    void readAndDecryptRawArray(std::istream& stream, unsigned char key, T* buffer, std::size_t size)
-    {
-        readAndDecrypt(stream, key, reinterpret_cast<char*>(buffer), sizeof(T) * size);
-    }
 }
@@ -0,0 +1,73 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/io/hpi/hpi_util.h>
+#include <string>
+
+namespace rwe
+{
+    std::string createHpiUtilTestData(std::size_t size)
+    {
+        std::string data(size, '\0');
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            data[i] = static_cast<char>((i * 131) ^ (i >> 3));
+        }
+        return data;
+    }
+
+    TEST_CASE("hpi_util")
+    {
+        // odd sizes and offsets to cover the vector loops and their tails
+        auto data = createHpiUtilTestData(1000);
+
+        SECTION("decrypt matches decryptScalar")
+        {
+            for (std::size_t offset : {0, 1, 7})
+            {
+                for (std::size_t size : {0, 1, 15, 16, 17, 31, 32, 33, 100, 257, 993})
+                {
+                    for (unsigned char seed : {0, 1, 200, 255})
+                    {
+                        auto expected = data;
+                        auto actual = data;
+                        decryptScalar(0x9a, seed, expected.data() + offset, size);
+                        decrypt(0x9a, seed, actual.data() + offset, size);
+                        REQUIRE(actual == expected);
+                    }
+                }
+            }
+        }
+
+        SECTION("decryptInner matches decryptInnerScalar")
+        {
+            for (std::size_t offset : {0, 3})
+            {
+                for (std::size_t size : {0, 1, 15, 16, 17, 31, 32, 33, 100, 257, 997})
+                {
+                    auto expected = data;
+                    auto actual = data;
+                    decryptInnerScalar(expected.data() + offset, size);
+                    decryptInner(actual.data() + offset, size);
+                    REQUIRE(actual == expected);
+                }
+            }
+        }
+
+        SECTION("computeChecksum matches computeChecksumScalar")
+        {
+            for (std::size_t offset : {0, 5})
+            {
+                for (std::size_t size : {0, 1, 15, 16, 17, 31, 32, 33, 100, 257, 995})
+                {
+                    REQUIRE(computeChecksum(data.data() + offset, size) == computeChecksumScalar(data.data() + offset, size));
+                }
+            }
+        }
+
+        SECTION("computeChecksum wraps around like computeChecksumScalar")
+        {
+            // enough 0xFF bytes to overflow 32 bits
+            std::string ones(17'000'000, '\xff');
+            REQUIRE(computeChecksum(ones.data(), ones.size()) == computeChecksumScalar(ones.data(), ones.size()));
+        }
+    }
+}
@@ -0,0 +1,198 @@
+#include "hpi_write.h"
+#include <cstring>
+#include <optional>
+#include <rwe/io/hpi/hpi_headers.h>
+#include <rwe/io/hpi/hpi_util.h>
+#include <rwe/util/rwe_string.h>
+#include <stdexcept>
+#include <zlib.h>
+
+namespace rwe
+{
+    struct HpiWriteNode
+    {
+        std::string name;
+        std::vector<std::size_t> children;
+
+        /** The file this node holds, or empty if it is a directory. */
+        std::optional<std::size_t> fileIndex;
+    };
+
+    template <typename T>
+    void appendHpiRaw(std::string& out, const T& value)
+    {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void writeHpiRaw(std::string& out, std::size_t offset, const T& value)
+    {
+        std::memcpy(out.data() + offset, &value, sizeof(T));
+    }
+
+    std::string writeHpiChunks(const std::string& data)
+    {
+        auto chunkCount = (data.size() / 65536) + (data.size() % 65536 == 0 ? 0 : 1);
+
+        // the table of chunk sizes, filled in as we go
+        std::string out(chunkCount * sizeof(uint32_t), '\0');
+
+        for (std::size_t i = 0; i < chunkCount; ++i)
+        {
+            auto chunk = data.substr(i * 65536, 65536);
+
+            auto bound = compressBound(static_cast<uLong>(chunk.size()));
+            std::string stored(bound, '\0');
+            if (compress(reinterpret_cast<Bytef*>(stored.data()), &bound, reinterpret_cast<const Bytef*>(chunk.data()), static_cast<uLong>(chunk.size())) != Z_OK)
+            {
+                throw std::runtime_error("ZLib compress failed");
+            }
+            stored.resize(bound);
+
+            uint8_t compressionScheme = 2;
+            if (stored.size() >= chunk.size())
+            {
+                compressionScheme = 0;
+                stored = chunk;
+            }
+
+            // the inverse of decryptInner
+            for (std::size_t j = 0; j < stored.size(); ++j)
+            {
+                auto pos = static_cast<unsigned char>(j);
+                stored[j] = static_cast<char>((static_cast<unsigned char>(stored[j]) ^ pos) + pos);
+            }
+
+            HpiChunk header{
+                HpiChunkMagicNumber,
+                2,
+                compressionScheme,
+                1,
+                static_cast<uint32_t>(stored.size()),
+                static_cast<uint32_t>(chunk.size()),
+                computeChecksum(stored.data(), stored.size())};
+            writeHpiRaw(out, i * sizeof(uint32_t), static_cast<uint32_t>(sizeof(HpiChunk) + stored.size()));
+            appendHpiRaw(out, header);
+            out += stored;
+        }
+
+        return out;
+    }
+
+    /**
+     * Appends the directory to the directory block, which starts at the given offset in the archive.
+     * Returns the offset of the directory's data.
+     */
+    uint32_t writeHpiDirectory(
+        const std::vector<HpiWriteNode>& nodes,
+        const std::vector<HpiWriteFile>& files,
+        std::size_t nodeIndex,
+        uint32_t start,
+        std::string& out,
+        std::vector<std::pair<std::size_t, std::size_t>>& fileDataPositions)
+    {
+        const auto& node = nodes[nodeIndex];
+
+        auto directoryOffset = static_cast<uint32_t>(start + out.size());
+        auto entriesOffset = static_cast<uint32_t>(directoryOffset + sizeof(HpiDirectoryData));
+        appendHpiRaw(out, HpiDirectoryData{static_cast<uint32_t>(node.children.size()), entriesOffset});
+        out.resize(out.size() + (node.children.size() * sizeof(HpiDirectoryEntry)));
+
+        for (std::size_t i = 0; i < node.children.size(); ++i)
+        {
+            const auto& child = nodes[node.children[i]];
+
+            auto nameOffset = static_cast<uint32_t>(start + out.size());
+            out += child.name;
+            out += '\0';
+
+            uint32_t dataOffset;
+            if (child.fileIndex)
+            {
+                const auto& file = files[*child.fileIndex];
+                dataOffset = static_cast<uint32_t>(start + out.size());
+                fileDataPositions.emplace_back(out.size(), *child.fileIndex);
+
+                // the data offset is filled in once we know where the file goes
+                appendHpiRaw(out, HpiFileData{0, static_cast<uint32_t>(file.data.size()), static_cast<uint8_t>(file.compressed ? 2 : 0)});
+            }
+            else
+            {
+                dataOffset = writeHpiDirectory(nodes, files, node.children[i], start, out, fileDataPositions);
+            }
+
+            auto entryPosition = entriesOffset - start + (i * sizeof(HpiDirectoryEntry));
+            writeHpiRaw(out, entryPosition, HpiDirectoryEntry{nameOffset, dataOffset, static_cast<uint8_t>(child.fileIndex ? 0 : 1)});
+        }
+
+        return directoryOffset;
+    }
+
+    std::string writeHpiArchive(const std::vector<HpiWriteFile>& files, uint32_t headerKey)
+    {
+        // build the directory tree
+        std::vector<HpiWriteNode> nodes(1);
+        for (std::size_t i = 0; i < files.size(); ++i)
+        {
+            auto components = split(files[i].path, '/');
+            std::size_t nodeIndex = 0;
+            for (std::size_t c = 0; c < components.size(); ++c)
+            {
+                auto isFile = c == components.size() - 1;
+
+                std::optional<std::size_t> existing;
+                for (auto childIndex : nodes[nodeIndex].children)
+                {
+                    if (toUpper(nodes[childIndex].name) == toUpper(components[c]))
+                    {
+                        existing = childIndex;
+                    }
+                }
+
+                if (existing && (isFile || nodes[*existing].fileIndex))
+                {
+                    throw std::runtime_error("Duplicate path in archive: " + files[i].path);
+                }
+
+                if (existing)
+                {
+                    nodeIndex = *existing;
+                    continue;
+                }
+
+                auto newIndex = nodes.size();
+                nodes.push_back(HpiWriteNode{components[c], {}, isFile ? std::make_optional(i) : std::nullopt});
+                nodes[nodeIndex].children.push_back(newIndex);
+                nodeIndex = newIndex;
+            }
+        }
+
+        const auto start = static_cast<uint32_t>(sizeof(HpiVersion) + sizeof(HpiHeader));
+
+        std::string directory;
+        std::vector<std::pair<std::size_t, std::size_t>> fileDataPositions;
+        writeHpiDirectory(nodes, files, 0, start, directory, fileDataPositions);
+        auto directorySize = static_cast<uint32_t>(start + directory.size());
+
+        // lay out the file data after the directory
+        std::string fileData;
+        for (const auto& [position, fileIndex] : fileDataPositions)
+        {
+            const auto& file = files[fileIndex];
+            auto dataOffset = static_cast<uint32_t>(directorySize + fileData.size());
+            writeHpiRaw(directory, position, dataOffset);
+            fileData += file.compressed ? writeHpiChunks(file.data) : file.data;
+        }
+
+        std::string archive;
+        appendHpiRaw(archive, HpiVersion{HpiMagicNumber, HpiVersionNumber});
+        appendHpiRaw(archive, HpiHeader{directorySize, headerKey, start});
+        archive += directory;
+        archive += fileData;
+
+        // encrypting is the same as decrypting
+        decrypt(transformKey(static_cast<unsigned char>(headerKey)), static_cast<unsigned char>(start), archive.data() + start, archive.size() - start);
+
+        return archive;
+    }
+}
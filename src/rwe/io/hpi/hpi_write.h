@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rwe
+{
+    struct HpiWriteFile
+    {
+        /** The path of the file inside the archive, with directories separated by '/'. */
+        std::string path;
+
+        std::string data;
+
+        /**
+         * If true, the file is stored in encrypted chunks, compressed with zlib
+         * where that makes them smaller.
+         * Otherwise it is stored as it is.
+         */
+        bool compressed;
+    };
+
+    /**
+     * Packs the files into an HPI archive encrypted with the given key.
+     * Used to generate archives for tests and benchmarks.
+     */
+    std::string writeHpiArchive(const std::vector<HpiWriteFile>& files, uint32_t headerKey);
+}
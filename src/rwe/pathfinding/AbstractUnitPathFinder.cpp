@@ -3,13 +3,15 @@
 namespace rwe
 {
     AbstractUnitPathFinder::AbstractUnitPathFinder(
+        GridAStarWorkspace* workspace,
         const GameSimulation* simulation,
         const MovementClassCollisionService* collisionService,
         UnitId self,
         std::optional<MovementClassId> movementClass,
         unsigned int footprintX,
         unsigned int footprintZ)
-        : simulation(simulation),
+        : GridAStarPathFinder(workspace),
+          simulation(simulation),
           collisionService(collisionService),
           self(self),
           movementClass(movementClass),
@@ -18,20 +20,22 @@ namespace rwe
     {
     }
 
-    std::vector<AbstractUnitPathFinder::VertexInfo>
-    AbstractUnitPathFinder::getSuccessors(const VertexInfo& info)
+    void AbstractUnitPathFinder::getSuccessors(const GridAStarVertex& info, Successors& successors)
     {
         std::optional<Direction> prevDirection;
         if (info.predecessor)
         {
-            prevDirection = pointToDirection(info.vertex - (*info.predecessor)->vertex);
+            prevDirection = pointToDirection(info.vertex - *info.predecessor);
         }
 
-        auto neighbours = getNeighbours(info.vertex);
-
-        std::vector<VertexInfo> vs;
-        for (const auto& neighbour : neighbours)
+        for (auto d : Directions)
         {
+            auto neighbour = step(info.vertex, d);
+            if (!isWalkable(neighbour))
+            {
+                continue;
+            }
+
             auto direction = pointToDirection(neighbour - info.vertex);
             auto distance = octileDistance(info.vertex, neighbour);
             assert(distance.diagonal == 0 || distance.straight == 0);
@@ -42,10 +46,8 @@ namespace rwe
             }
             unsigned int turns = prevDirection ? directionDistance(*prevDirection, direction) : 0;
             PathCost cost(distance, turns);
-            vs.push_back(VertexInfo{info.costToReach + cost, neighbour, &info});
+            successors.push(GridAStarVertex{neighbour, info.costToReach + cost, info.vertex});
         }
-
-        return vs;
     }
 
     bool AbstractUnitPathFinder::isWalkable(const Point& p) const
@@ -70,24 +72,4 @@ namespace rwe
         auto directionVector = directionToPoint(d);
         return p + directionVector;
     }
-
-    std::vector<Point> AbstractUnitPathFinder::getNeighbours(const Point& p)
-    {
-        std::vector<Point> neighbours;
-        neighbours.reserve(Directions.size());
-
-        for (auto d : Directions)
-        {
-            auto newPosition = step(p, d);
-
-            if (!isWalkable(newPosition))
-            {
-                continue;
-            }
-
-            neighbours.push_back(newPosition);
-        }
-
-        return neighbours;
-    }
 }
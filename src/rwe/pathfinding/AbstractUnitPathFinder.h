@@ -2,7 +2,7 @@
 
 #include <rwe/grid/DiscreteRect.h>
 #include <rwe/grid/EightWayDirection.h>
-#include <rwe/pathfinding/AStarPathFinder.h>
+#include <rwe/pathfinding/GridAStarPathFinder.h>
 #include <rwe/pathfinding/PathCost.h>
 #include <rwe/pathfinding/pathfinding_utils.h>
 #include <rwe/sim/GameSimulation.h>
@@ -14,7 +14,7 @@ namespace rwe
     /**
      * Standard unit pathfinder.
      */
-    class AbstractUnitPathFinder : public AStarPathFinder<Point, PathCost>
+    class AbstractUnitPathFinder : public GridAStarPathFinder
     {
     private:
         const GameSimulation* const simulation;
@@ -26,6 +26,7 @@ namespace rwe
 
     public:
         AbstractUnitPathFinder(
+            GridAStarWorkspace* workspace,
             const GameSimulation* simulation,
             const MovementClassCollisionService* collisionService,
             UnitId self,
@@ -34,7 +35,7 @@ namespace rwe
             unsigned int footprintZ);
 
     protected:
-        std::vector<VertexInfo> getSuccessors(const VertexInfo& vertex) override;
+        void getSuccessors(const GridAStarVertex& vertex, Successors& successors) override;
 
     private:
         bool isWalkable(const Point& p) const;
@@ -44,7 +45,5 @@ namespace rwe
         bool isRoughTerrain(const Point& p) const;
 
         Point step(const Point& p, Direction d) const;
-
-        std::vector<Point> getNeighbours(const Point& p);
     };
 }
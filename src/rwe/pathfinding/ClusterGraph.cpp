@@ -0,0 +1,541 @@
+#include "ClusterGraph.h"
+#include <cassert>
+#include <cstdlib>
+#include <queue>
+#include <rwe/grid/EightWayDirection.h>
+#include <rwe/pathfinding/AStarPathFinder.h>
+#include <rwe/pathfinding/pathfinding_utils.h>
+
+namespace rwe
+{
+    static const OctileDistance StraightStep(1, 0);
+    static const OctileDistance DiagonalStep(0, 1);
+
+    /**
+     * Adds transitions for an open stretch of border running from first to last inclusive.
+     */
+    template <typename MakeTransition, typename Transition>
+    static void appendEntrance(std::vector<Transition>& transitions, int first, int last, MakeTransition makeTransition)
+    {
+        if (last - first + 1 < ClusterGraph::WideEntranceWidth)
+        {
+            transitions.push_back(makeTransition((first + last) / 2));
+        }
+        else
+        {
+            transitions.push_back(makeTransition(first));
+            transitions.push_back(makeTransition(last));
+        }
+    }
+
+    /**
+     * A* over the abstract graph,
+     * with the start and goal temporarily linked into their clusters.
+     */
+    class ClusterGraphSearch : public AStarPathFinder<Point, OctileDistance>
+    {
+    private:
+        const ClusterGraph* graph;
+        Point start;
+        Point goal;
+        int goalCluster;
+        const std::vector<ClusterGraphEdge>* startEdges;
+        const std::vector<ClusterGraphEdge>* goalEdges;
+
+    public:
+        ClusterGraphSearch(
+            const ClusterGraph* graph,
+            const Point& start,
+            const Point& goal,
+            const std::vector<ClusterGraphEdge>* startEdges,
+            const std::vector<ClusterGraphEdge>* goalEdges)
+            : graph(graph),
+              start(start),
+              goal(goal),
+              goalCluster(graph->getClusterIndex(goal)),
+              startEdges(startEdges),
+              goalEdges(goalEdges)
+        {
+        }
+
+    protected:
+        bool isGoal(const Point& vertex) override
+        {
+            return vertex == goal;
+        }
+
+        OctileDistance estimateCostToGoal(const Point& vertex) override
+        {
+            return octileDistance(vertex, goal);
+        }
+
+        std::vector<VertexInfo> getSuccessors(const VertexInfo& vertex) override
+        {
+            std::vector<VertexInfo> successors;
+
+            if (vertex.vertex == start)
+            {
+                for (const auto& e : *startEdges)
+                {
+                    successors.push_back(VertexInfo{vertex.costToReach + e.cost, e.destination, &vertex});
+                }
+            }
+
+            if (const auto* node = graph->findNode(vertex.vertex); node != nullptr)
+            {
+                for (const auto& e : node->edges)
+                {
+                    successors.push_back(VertexInfo{vertex.costToReach + e.cost, e.destination, &vertex});
+                }
+            }
+
+            if (graph->getClusterIndex(vertex.vertex) == goalCluster)
+            {
+                for (const auto& e : *goalEdges)
+                {
+                    if (e.destination == vertex.vertex)
+                    {
+                        successors.push_back(VertexInfo{vertex.costToReach + e.cost, goal, &vertex});
+                    }
+                }
+            }
+
+            return successors;
+        }
+    };
+
+    ClusterGraph::ClusterGraph(Grid<char>&& passable)
+        : passable(std::move(passable)),
+          clustersX((this->passable.getWidth() + ClusterSize - 1) / ClusterSize),
+          clustersY((this->passable.getHeight() + ClusterSize - 1) / ClusterSize),
+          clusterNodes(clustersX * clustersY),
+          eastTransitions(clustersX * clustersY),
+          southTransitions(clustersX * clustersY),
+          dirtyClusters(clustersX * clustersY, 1),
+          anyDirty(true)
+    {
+        repair();
+    }
+
+    int ClusterGraph::getWidth() const
+    {
+        return passable.getWidth();
+    }
+
+    int ClusterGraph::getHeight() const
+    {
+        return passable.getHeight();
+    }
+
+    bool ClusterGraph::contains(const Point& p) const
+    {
+        return p.x >= 0 && p.y >= 0 && p.x < passable.getWidth() && p.y < passable.getHeight();
+    }
+
+    bool ClusterGraph::isPassable(const Point& p) const
+    {
+        return passable.get(p.x, p.y) != 0;
+    }
+
+    const Grid<char>& ClusterGraph::getPassableGrid() const
+    {
+        return passable;
+    }
+
+    void ClusterGraph::setPassable(const Point& p, bool value)
+    {
+        if (isPassable(p) == value)
+        {
+            return;
+        }
+
+        passable.set(p.x, p.y, value ? 1 : 0);
+        markDirty(p.x / ClusterSize, p.y / ClusterSize);
+    }
+
+    bool ClusterGraph::needsRepair() const
+    {
+        return anyDirty;
+    }
+
+    void ClusterGraph::repair()
+    {
+        if (!anyDirty)
+        {
+            return;
+        }
+
+        // A change in one cluster can alter the transitions on any of its four borders,
+        // which in turn alters the nodes of the clusters on the other side.
+        std::vector<char> clustersToRebuild(clusterNodes.size(), 0);
+        for (int cy = 0; cy < clustersY; ++cy)
+        {
+            for (int cx = 0; cx < clustersX; ++cx)
+            {
+                if (!dirtyClusters[(cy * clustersX) + cx])
+                {
+                    continue;
+                }
+
+                rebuildEastTransitions(cx, cy);
+                rebuildSouthTransitions(cx, cy);
+                if (cx > 0)
+                {
+                    rebuildEastTransitions(cx - 1, cy);
+                    clustersToRebuild[(cy * clustersX) + cx - 1] = 1;
+                }
+                if (cy > 0)
+                {
+                    rebuildSouthTransitions(cx, cy - 1);
+                    clustersToRebuild[((cy - 1) * clustersX) + cx] = 1;
+                }
+                if (cx + 1 < clustersX)
+                {
+                    clustersToRebuild[(cy * clustersX) + cx + 1] = 1;
+                }
+                if (cy + 1 < clustersY)
+                {
+                    clustersToRebuild[((cy + 1) * clustersX) + cx] = 1;
+                }
+                clustersToRebuild[(cy * clustersX) + cx] = 1;
+            }
+        }
+
+        for (int cy = 0; cy < clustersY; ++cy)
+        {
+            for (int cx = 0; cx < clustersX; ++cx)
+            {
+                if (clustersToRebuild[(cy * clustersX) + cx])
+                {
+                    rebuildNodes(cx, cy);
+                }
+            }
+        }
+
+        std::fill(dirtyClusters.begin(), dirtyClusters.end(), 0);
+        anyDirty = false;
+    }
+
+    int ClusterGraph::getClusterCount() const
+    {
+        return clustersX * clustersY;
+    }
+
+    int ClusterGraph::getClusterIndex(const Point& p) const
+    {
+        return ((p.y / ClusterSize) * clustersX) + (p.x / ClusterSize);
+    }
+
+    const std::vector<ClusterGraphNode>& ClusterGraph::getClusterNodes(int clusterIndex) const
+    {
+        return clusterNodes[clusterIndex];
+    }
+
+    const ClusterGraphNode* ClusterGraph::findNode(const Point& p) const
+    {
+        for (const auto& node : clusterNodes[getClusterIndex(p)])
+        {
+            if (node.position == p)
+            {
+                return &node;
+            }
+        }
+
+        return nullptr;
+    }
+
+    std::optional<std::vector<Point>> ClusterGraph::findPath(const Point& start, const Point& goal, unsigned int& expandedNodeCount) const
+    {
+        assert(!anyDirty);
+
+        expandedNodeCount = 0;
+
+        if (!contains(start) || !contains(goal) || !isPassable(goal))
+        {
+            return std::nullopt;
+        }
+
+        if (start == goal)
+        {
+            return std::vector<Point>{start};
+        }
+
+        auto startCluster = getClusterIndex(start);
+        auto goalCluster = getClusterIndex(goal);
+
+        std::vector<Point> startTargets;
+        for (const auto& node : clusterNodes[startCluster])
+        {
+            startTargets.push_back(node.position);
+        }
+        if (startCluster == goalCluster)
+        {
+            startTargets.push_back(goal);
+        }
+        unsigned int startClusterExpandedCount = 0;
+        auto startEdges = searchCluster(startCluster, start, startTargets, startClusterExpandedCount);
+
+        std::vector<Point> goalTargets;
+        for (const auto& node : clusterNodes[goalCluster])
+        {
+            goalTargets.push_back(node.position);
+        }
+        unsigned int goalClusterExpandedCount = 0;
+        auto goalEdges = searchCluster(goalCluster, goal, goalTargets, goalClusterExpandedCount);
+
+        ClusterGraphSearch search(this, start, goal, &startEdges, &goalEdges);
+        auto result = search.findPath(start);
+        expandedNodeCount = startClusterExpandedCount + goalClusterExpandedCount + static_cast<unsigned int>(result.closedVertices.size());
+        if (result.type != AStarPathType::Complete)
+        {
+            return std::nullopt;
+        }
+
+        auto isBorderCrossing = [&](const Point& a, const Point& b) {
+            return std::abs(b.x - a.x) <= 1 && std::abs(b.y - a.y) <= 1 && getClusterIndex(a) != getClusterIndex(b);
+        };
+
+        // Drop the near side of each border crossing,
+        // unless we only just arrived there by crossing another border.
+        std::vector<Point> waypoints;
+        waypoints.push_back(result.path.front());
+        for (std::size_t i = 1; i < result.path.size() - 1; ++i)
+        {
+            const auto& previous = result.path[i - 1];
+            const auto& p = result.path[i];
+            const auto& next = result.path[i + 1];
+            if (!isBorderCrossing(p, next) || isBorderCrossing(previous, p))
+            {
+                waypoints.push_back(p);
+            }
+        }
+        waypoints.push_back(result.path.back());
+
+        return waypoints;
+    }
+
+    DiscreteRect ClusterGraph::getClusterBounds(int clusterIndex) const
+    {
+        auto x = (clusterIndex % clustersX) * ClusterSize;
+        auto y = (clusterIndex / clustersX) * ClusterSize;
+        auto width = std::min(ClusterSize, passable.getWidth() - x);
+        auto height = std::min(ClusterSize, passable.getHeight() - y);
+        return DiscreteRect(x, y, width, height);
+    }
+
+    void ClusterGraph::markDirty(int clusterX, int clusterY)
+    {
+        dirtyClusters[(clusterY * clustersX) + clusterX] = 1;
+        anyDirty = true;
+    }
+
+    void ClusterGraph::rebuildEastTransitions(int clusterX, int clusterY)
+    {
+        auto index = (clusterY * clustersX) + clusterX;
+        auto& transitions = eastTransitions[index];
+        transitions.clear();
+
+        if (clusterX + 1 >= clustersX)
+        {
+            return;
+        }
+
+        auto bounds = getClusterBounds(index);
+        auto x = bounds.x + bounds.width - 1;
+        auto makeTransition = [x](int y) { return Transition{Point(x, y), Point(x + 1, y)}; };
+
+        std::optional<int> runStart;
+        for (int y = bounds.y; y < bounds.y + bounds.height; ++y)
+        {
+            if (isPassable(Point(x, y)) && isPassable(Point(x + 1, y)))
+            {
+                if (!runStart)
+                {
+                    runStart = y;
+                }
+                continue;
+            }
+
+            if (runStart)
+            {
+                appendEntrance(transitions, *runStart, y - 1, makeTransition);
+                runStart = std::nullopt;
+            }
+        }
+
+        if (runStart)
+        {
+            appendEntrance(transitions, *runStart, bounds.y + bounds.height - 1, makeTransition);
+        }
+    }
+
+    void ClusterGraph::rebuildSouthTransitions(int clusterX, int clusterY)
+    {
+        auto index = (clusterY * clustersX) + clusterX;
+        auto& transitions = southTransitions[index];
+        transitions.clear();
+
+        if (clusterY + 1 >= clustersY)
+        {
+            return;
+        }
+
+        auto bounds = getClusterBounds(index);
+        auto y = bounds.y + bounds.height - 1;
+        auto makeTransition = [y](int x) { return Transition{Point(x, y), Point(x, y + 1)}; };
+
+        std::optional<int> runStart;
+        for (int x = bounds.x; x < bounds.x + bounds.width; ++x)
+        {
+            if (isPassable(Point(x, y)) && isPassable(Point(x, y + 1)))
+            {
+                if (!runStart)
+                {
+                    runStart = x;
+                }
+                continue;
+            }
+
+            if (runStart)
+            {
+                appendEntrance(transitions, *runStart, x - 1, makeTransition);
+                runStart = std::nullopt;
+            }
+        }
+
+        if (runStart)
+        {
+            appendEntrance(transitions, *runStart, bounds.x + bounds.width - 1, makeTransition);
+        }
+    }
+
+    void ClusterGraph::rebuildNodes(int clusterX, int clusterY)
+    {
+        auto index = (clusterY * clustersX) + clusterX;
+        auto& nodes = clusterNodes[index];
+        nodes.clear();
+
+        auto addCrossing = [&](const Point& inside, const Point& outside) {
+            auto it = std::find_if(nodes.begin(), nodes.end(), [&](const auto& n) { return n.position == inside; });
+            if (it == nodes.end())
+            {
+                nodes.push_back(ClusterGraphNode{inside, {}});
+                it = nodes.end() - 1;
+            }
+            it->edges.push_back(ClusterGraphEdge{outside, StraightStep});
+        };
+
+        if (clusterX > 0)
+        {
+            for (const auto& t : eastTransitions[index - 1])
+            {
+                addCrossing(t.second, t.first);
+            }
+        }
+        if (clusterY > 0)
+        {
+            for (const auto& t : southTransitions[index - clustersX])
+            {
+                addCrossing(t.second, t.first);
+            }
+        }
+        for (const auto& t : eastTransitions[index])
+        {
+            addCrossing(t.first, t.second);
+        }
+        for (const auto& t : southTransitions[index])
+        {
+            addCrossing(t.first, t.second);
+        }
+
+        std::vector<Point> positions;
+        for (const auto& node : nodes)
+        {
+            positions.push_back(node.position);
+        }
+
+        for (auto& node : nodes)
+        {
+            unsigned int expandedNodeCount = 0;
+            auto edges = searchCluster(index, node.position, positions, expandedNodeCount);
+            node.edges.insert(node.edges.end(), edges.begin(), edges.end());
+        }
+    }
+
+    std::vector<ClusterGraphEdge> ClusterGraph::searchCluster(int clusterIndex, const Point& source, const std::vector<Point>& targets, unsigned int& expandedNodeCount) const
+    {
+        expandedNodeCount = 0;
+
+        auto bounds = getClusterBounds(clusterIndex);
+        auto toLocal = [&](const Point& p) { return ((p.y - bounds.y) * bounds.width) + (p.x - bounds.x); };
+
+        std::vector<std::optional<OctileDistance>> costs(bounds.width * bounds.height);
+        std::vector<char> closed(bounds.width * bounds.height, 0);
+
+        using Entry = std::pair<OctileDistance, Point>;
+        auto isLowerPriority = [&](const Entry& a, const Entry& b) {
+            if (b.first < a.first)
+            {
+                return true;
+            }
+            if (a.first < b.first)
+            {
+                return false;
+            }
+            return toLocal(a.second) > toLocal(b.second);
+        };
+        std::priority_queue<Entry, std::vector<Entry>, decltype(isLowerPriority)> open(isLowerPriority);
+
+        costs[toLocal(source)] = OctileDistance();
+        open.emplace(OctileDistance(), source);
+
+        while (!open.empty())
+        {
+            auto [cost, p] = open.top();
+            open.pop();
+
+            auto local = toLocal(p);
+            if (closed[local])
+            {
+                continue;
+            }
+            closed[local] = 1;
+            ++expandedNodeCount;
+
+            for (auto d : Directions)
+            {
+                auto step = directionToPoint(d);
+                auto neighbour = p + step;
+                if (!bounds.contains(neighbour) || !isPassable(neighbour))
+                {
+                    continue;
+                }
+
+                auto neighbourCost = cost + (step.x != 0 && step.y != 0 ? DiagonalStep : StraightStep);
+                auto& existingCost = costs[toLocal(neighbour)];
+                if (!existingCost || neighbourCost < *existingCost)
+                {
+                    existingCost = neighbourCost;
+                    open.emplace(neighbourCost, neighbour);
+                }
+            }
+        }
+
+        std::vector<ClusterGraphEdge> edges;
+        for (const auto& target : targets)
+        {
+            if (target == source)
+            {
+                continue;
+            }
+
+            const auto& cost = costs[toLocal(target)];
+            if (cost)
+            {
+                edges.push_back(ClusterGraphEdge{target, *cost});
+            }
+        }
+
+        return edges;
+    }
+}
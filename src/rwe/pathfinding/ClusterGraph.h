@@ -0,0 +1,143 @@
+#pragma once
+
+#include <optional>
+#include <rwe/grid/Grid.h>
+#include <rwe/grid/Point.h>
+#include <rwe/pathfinding/OctileDistance.h>
+#include <vector>
+
+namespace rwe
+{
+    struct ClusterGraphEdge
+    {
+        Point destination;
+        OctileDistance cost;
+    };
+
+    struct ClusterGraphNode
+    {
+        Point position;
+        std::vector<ClusterGraphEdge> edges;
+    };
+
+    /**
+     * Abstract graph over a passability grid for hierarchical pathfinding (HPA*).
+     *
+     * The grid is divided into square clusters.
+     * Wherever two neighbouring clusters share an open stretch of border,
+     * a node is placed on either side of it and the two are joined by an edge.
+     * Nodes within the same cluster are joined by edges whose cost
+     * is the length of the shortest path between them inside the cluster.
+     *
+     * Changing the passability of a cell marks its cluster as dirty.
+     * repair() then rebuilds only the dirty clusters and their neighbours.
+     * The repaired graph is identical to one built from scratch.
+     */
+    class ClusterGraph
+    {
+    public:
+        static constexpr int ClusterSize = 16;
+
+        /**
+         * Open stretches of border at least this wide
+         * get a node at each end rather than a single one in the middle.
+         */
+        static constexpr int WideEntranceWidth = 6;
+
+    private:
+        struct Transition
+        {
+            /** The cell on the top or left side of the border. */
+            Point first;
+            /** The cell on the bottom or right side of the border. */
+            Point second;
+        };
+
+        Grid<char> passable;
+        int clustersX;
+        int clustersY;
+
+        std::vector<std::vector<ClusterGraphNode>> clusterNodes;
+
+        /** Transitions across the right-hand border of each cluster. */
+        std::vector<std::vector<Transition>> eastTransitions;
+
+        /** Transitions across the bottom border of each cluster. */
+        std::vector<std::vector<Transition>> southTransitions;
+
+        std::vector<char> dirtyClusters;
+        bool anyDirty{false};
+
+    public:
+        /**
+         * Builds the graph over the given grid,
+         * where a nonzero cell is passable.
+         */
+        explicit ClusterGraph(Grid<char>&& passable);
+
+        int getWidth() const;
+
+        int getHeight() const;
+
+        bool contains(const Point& p) const;
+
+        bool isPassable(const Point& p) const;
+
+        /** The passability grid the graph was built over, including changes from setPassable. */
+        const Grid<char>& getPassableGrid() const;
+
+        /**
+         * Changes the passability of a cell.
+         * The graph is not updated until repair() is called.
+         */
+        void setPassable(const Point& p, bool value);
+
+        bool needsRepair() const;
+
+        /** Rebuilds the parts of the graph affected by calls to setPassable. */
+        void repair();
+
+        int getClusterCount() const;
+
+        int getClusterIndex(const Point& p) const;
+
+        const std::vector<ClusterGraphNode>& getClusterNodes(int clusterIndex) const;
+
+        /** Returns the node at the given position, if there is one. */
+        const ClusterGraphNode* findNode(const Point& p) const;
+
+        /**
+         * Finds a route from start to goal through the abstract graph.
+         * The result begins with start, ends with goal,
+         * and the way from each waypoint to the next stays within one cluster
+         * apart from a final step across a border.
+         * Where the route crosses a border, only the cell on the far side is kept.
+         *
+         * Returns nothing if either point is outside the grid,
+         * the goal is not passable, or the goal cannot be reached.
+         * The start cell itself does not need to be passable.
+         *
+         * expandedNodeCount is set to the number of cells and graph nodes the search expanded,
+         * whether or not a route was found.
+         */
+        std::optional<std::vector<Point>> findPath(const Point& start, const Point& goal, unsigned int& expandedNodeCount) const;
+
+    private:
+        DiscreteRect getClusterBounds(int clusterIndex) const;
+
+        void markDirty(int clusterX, int clusterY);
+
+        void rebuildEastTransitions(int clusterX, int clusterY);
+
+        void rebuildSouthTransitions(int clusterX, int clusterY);
+
+        void rebuildNodes(int clusterX, int clusterY);
+
+        /**
+         * Returns edges from the source to each of the targets
+         * that can be reached from it without leaving the cluster.
+         * expandedNodeCount is set to the number of cells the search expanded.
+         */
+        std::vector<ClusterGraphEdge> searchCluster(int clusterIndex, const Point& source, const std::vector<Point>& targets, unsigned int& expandedNodeCount) const;
+    };
+}
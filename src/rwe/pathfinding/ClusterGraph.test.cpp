@@ -0,0 +1,232 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <random>
+#include <rwe/pathfinding/ClusterGraph.h>
+#include <rwe/util/SimpleLogger.h>
+
+namespace rwe
+{
+    bool clusterGraphsEqual(const ClusterGraph& a, const ClusterGraph& b)
+    {
+        if (a.getClusterCount() != b.getClusterCount())
+        {
+            return false;
+        }
+
+        for (int i = 0; i < a.getClusterCount(); ++i)
+        {
+            const auto& nodesA = a.getClusterNodes(i);
+            const auto& nodesB = b.getClusterNodes(i);
+            if (nodesA.size() != nodesB.size())
+            {
+                return false;
+            }
+
+            for (std::size_t j = 0; j < nodesA.size(); ++j)
+            {
+                if (nodesA[j].position != nodesB[j].position || nodesA[j].edges.size() != nodesB[j].edges.size())
+                {
+                    return false;
+                }
+
+                for (std::size_t k = 0; k < nodesA[j].edges.size(); ++k)
+                {
+                    const auto& edgeA = nodesA[j].edges[k];
+                    const auto& edgeB = nodesB[j].edges[k];
+                    if (edgeA.destination != edgeB.destination || edgeA.cost != edgeB.cost)
+                    {
+                        return false;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    TEST_CASE("ClusterGraph")
+    {
+        // the abstract search is an AStarPathFinder, which logs its results
+        auto logPath = (std::filesystem::temp_directory_path() / "rwe_test_cluster_graph.log").string();
+        setGlobalLogger(std::make_shared<SimpleLogger>(logPath, true));
+
+        SECTION("places one node each side of a narrow entrance")
+        {
+            // two clusters side by side, joined by a three cell gap
+            Grid<char> grid(32, 16, 1);
+            for (int y = 0; y < 16; ++y)
+            {
+                if (y < 5 || y > 7)
+                {
+                    grid.set(15, y, 0);
+                }
+            }
+
+            ClusterGraph graph(std::move(grid));
+            REQUIRE(graph.getClusterCount() == 2);
+
+            const auto& left = graph.getClusterNodes(0);
+            REQUIRE(left.size() == 1);
+            REQUIRE(left[0].position == Point(15, 6));
+
+            const auto& right = graph.getClusterNodes(1);
+            REQUIRE(right.size() == 1);
+            REQUIRE(right[0].position == Point(16, 6));
+            REQUIRE(right[0].edges.size() == 1);
+            REQUIRE(right[0].edges[0].destination == Point(15, 6));
+            REQUIRE(right[0].edges[0].cost == OctileDistance(1, 0));
+        }
+
+        SECTION("places a node at each end of a wide entrance, joined within the cluster")
+        {
+            Grid<char> grid(32, 16, 1);
+            ClusterGraph graph(std::move(grid));
+
+            const auto& left = graph.getClusterNodes(0);
+            REQUIRE(left.size() == 2);
+            REQUIRE(left[0].position == Point(15, 0));
+            REQUIRE(left[1].position == Point(15, 15));
+
+            auto node = graph.findNode(Point(15, 0));
+            REQUIRE(node != nullptr);
+            auto it = std::find_if(node->edges.begin(), node->edges.end(), [](const auto& e) { return e.destination == Point(15, 15); });
+            REQUIRE(it != node->edges.end());
+            REQUIRE(it->cost == OctileDistance(15, 0));
+        }
+
+        SECTION("finds a route through a gap in a wall")
+        {
+            Grid<char> grid(64, 64, 1);
+            for (int y = 0; y < 64; ++y)
+            {
+                if (y != 40)
+                {
+                    grid.set(30, y, 0);
+                }
+            }
+
+            ClusterGraph graph(std::move(grid));
+            unsigned int expandedNodeCount = 0;
+            auto path = graph.findPath(Point(2, 2), Point(60, 2), expandedNodeCount);
+            REQUIRE(path);
+            REQUIRE(path->front() == Point(2, 2));
+            REQUIRE(path->back() == Point(60, 2));
+
+            graph.setPassable(Point(30, 40), false);
+            graph.repair();
+            REQUIRE(!graph.findPath(Point(2, 2), Point(60, 2), expandedNodeCount));
+        }
+
+        SECTION("finds a direct route within one cluster")
+        {
+            Grid<char> grid(64, 64, 1);
+            ClusterGraph graph(std::move(grid));
+            unsigned int expandedNodeCount = 0;
+            auto path = graph.findPath(Point(2, 2), Point(10, 12), expandedNodeCount);
+            REQUIRE(path);
+            REQUIRE(*path == std::vector<Point>{Point(2, 2), Point(10, 12)});
+        }
+
+        SECTION("returns nothing when the goal is walled off or blocked")
+        {
+            Grid<char> grid(64, 64, 1);
+            for (int y = 0; y < 64; ++y)
+            {
+                grid.set(30, y, 0);
+            }
+            grid.set(5, 5, 0);
+
+            ClusterGraph graph(std::move(grid));
+            unsigned int expandedNodeCount = 0;
+            REQUIRE(!graph.findPath(Point(2, 2), Point(60, 2), expandedNodeCount));
+            REQUIRE(!graph.findPath(Point(2, 2), Point(5, 5), expandedNodeCount));
+            REQUIRE(!graph.findPath(Point(2, 2), Point(64, 2), expandedNodeCount));
+        }
+
+        SECTION("counts the cells and nodes it expands, even when there is no route")
+        {
+            Grid<char> grid(64, 64, 1);
+            for (int y = 0; y < 64; ++y)
+            {
+                grid.set(30, y, 0);
+            }
+
+            ClusterGraph graph(std::move(grid));
+            unsigned int expandedNodeCount = 0;
+            REQUIRE(!graph.findPath(Point(2, 2), Point(60, 2), expandedNodeCount));
+
+            // The start and goal clusters are open, so each is searched in full.
+            auto clusterCellCount = static_cast<unsigned int>(ClusterGraph::ClusterSize * ClusterGraph::ClusterSize);
+            REQUIRE(expandedNodeCount > 2 * clusterCellCount);
+
+            REQUIRE(!graph.findPath(Point(2, 2), Point(64, 2), expandedNodeCount));
+            REQUIRE(expandedNodeCount == 0);
+        }
+
+        SECTION("repair reopens a route when a wall is removed")
+        {
+            Grid<char> grid(64, 64, 1);
+            for (int y = 0; y < 64; ++y)
+            {
+                grid.set(30, y, 0);
+            }
+
+            ClusterGraph graph(std::move(grid));
+            unsigned int expandedNodeCount = 0;
+            REQUIRE(!graph.findPath(Point(2, 2), Point(60, 2), expandedNodeCount));
+
+            graph.setPassable(Point(30, 50), true);
+            REQUIRE(graph.needsRepair());
+            graph.repair();
+            REQUIRE(!graph.needsRepair());
+
+            auto path = graph.findPath(Point(2, 2), Point(60, 2), expandedNodeCount);
+            REQUIRE(path);
+        }
+
+        SECTION("a repaired graph matches one built from scratch")
+        {
+            const int width = 70;
+            const int height = 50;
+            std::minstd_rand rng(99);
+            std::uniform_int_distribution<int> xDist(0, width - 1);
+            std::uniform_int_distribution<int> yDist(0, height - 1);
+            std::uniform_int_distribution<int> wallDist(0, 99);
+
+            Grid<char> grid(width, height, 1);
+            for (int y = 0; y < height; ++y)
+            {
+                for (int x = 0; x < width; ++x)
+                {
+                    grid.set(x, y, wallDist(rng) < 20 ? 0 : 1);
+                }
+            }
+
+            auto copy = grid;
+            ClusterGraph graph(std::move(copy));
+
+            for (int round = 0; round < 20; ++round)
+            {
+                // place or remove a small "building"
+                Point p(xDist(rng), yDist(rng));
+                char value = round % 2 == 0 ? 0 : 1;
+                for (int dy = 0; dy < 3 && p.y + dy < height; ++dy)
+                {
+                    for (int dx = 0; dx < 4 && p.x + dx < width; ++dx)
+                    {
+                        grid.set(p.x + dx, p.y + dy, value);
+                        graph.setPassable(Point(p.x + dx, p.y + dy), value != 0);
+                    }
+                }
+
+                graph.repair();
+
+                auto fresh = grid;
+                ClusterGraph freshGraph(std::move(fresh));
+                REQUIRE(clusterGraphsEqual(graph, freshGraph));
+            }
+        }
+
+        setGlobalLogger(nullptr);
+    }
+}
@@ -0,0 +1,189 @@
+#include "FlowField.h"
+#include <queue>
+#include <rwe/pathfinding/OctileDistance.h>
+#include <rwe/sim/SnapshotIo.h>
+
+namespace rwe
+{
+    static const OctileDistance FlowFieldStraightStep(1, 0);
+    static const OctileDistance FlowFieldDiagonalStep(0, 1);
+
+    FlowField::FlowField(const Grid<char>& passable, const std::vector<Point>& goals)
+        : directions(passable.getWidth(), passable.getHeight(), UnreachableCell)
+    {
+        auto width = passable.getWidth();
+        auto height = passable.getHeight();
+        auto isPassable = [&](const Point& p) {
+            return p.x >= 0 && p.y >= 0 && p.x < width && p.y < height && passable.get(p.x, p.y) != 0;
+        };
+
+        std::vector<std::optional<OctileDistance>> costs(static_cast<std::size_t>(width) * height);
+        std::vector<char> closed(costs.size(), 0);
+
+        using Entry = std::pair<OctileDistance, Point>;
+        auto isLowerPriority = [&](const Entry& a, const Entry& b) {
+            if (b.first < a.first)
+            {
+                return true;
+            }
+            if (a.first < b.first)
+            {
+                return false;
+            }
+            return passable.toIndex(a.second.x, a.second.y) > passable.toIndex(b.second.x, b.second.y);
+        };
+        std::priority_queue<Entry, std::vector<Entry>, decltype(isLowerPriority)> open(isLowerPriority);
+
+        for (const auto& goal : goals)
+        {
+            if (!isPassable(goal))
+            {
+                continue;
+            }
+
+            costs[passable.toIndex(goal.x, goal.y)] = OctileDistance();
+            directions.set(goal.x, goal.y, GoalCell);
+            open.emplace(OctileDistance(), goal);
+        }
+
+        while (!open.empty())
+        {
+            auto [cost, p] = open.top();
+            open.pop();
+
+            auto index = passable.toIndex(p.x, p.y);
+            if (closed[index])
+            {
+                continue;
+            }
+            closed[index] = 1;
+
+            for (auto d : Directions)
+            {
+                auto step = directionToPoint(d);
+                auto neighbour = p + step;
+                if (!isPassable(neighbour))
+                {
+                    continue;
+                }
+
+                auto neighbourCost = cost + (step.x != 0 && step.y != 0 ? FlowFieldDiagonalStep : FlowFieldStraightStep);
+                auto& existingCost = costs[passable.toIndex(neighbour.x, neighbour.y)];
+                if (!existingCost || neighbourCost < *existingCost)
+                {
+                    existingCost = neighbourCost;
+                    open.emplace(neighbourCost, neighbour);
+                }
+            }
+        }
+
+        // Point each cell at its cheapest neighbour.
+        // The costs are unique whatever order the search ran in,
+        // and ties are broken by the fixed order of Directions,
+        // so the field is too.
+        for (int y = 0; y < height; ++y)
+        {
+            for (int x = 0; x < width; ++x)
+            {
+                const auto& cost = costs[passable.toIndex(x, y)];
+                if (!cost || directions.get(x, y) == GoalCell)
+                {
+                    continue;
+                }
+
+                std::optional<std::pair<OctileDistance, unsigned char>> best;
+                for (unsigned char i = 0; i < Directions.size(); ++i)
+                {
+                    auto neighbour = Point(x, y) + directionToPoint(Directions[i]);
+                    if (!isPassable(neighbour))
+                    {
+                        continue;
+                    }
+
+                    const auto& neighbourCost = costs[passable.toIndex(neighbour.x, neighbour.y)];
+                    if (neighbourCost && *neighbourCost < *cost && (!best || *neighbourCost < best->first))
+                    {
+                        best = std::make_pair(*neighbourCost, i);
+                    }
+                }
+
+                if (best)
+                {
+                    directions.set(x, y, best->second);
+                }
+            }
+        }
+    }
+
+    FlowField::FlowField(Grid<unsigned char>&& directions) : directions(std::move(directions))
+    {
+    }
+
+    FlowField FlowField::restoreSnapshot(SnapshotReader& r)
+    {
+        return FlowField(readSnapshotValue<Grid<unsigned char>>(r));
+    }
+
+    void FlowField::saveSnapshot(SnapshotWriter& w) const
+    {
+        writeSnapshot(w, directions);
+    }
+
+    int FlowField::getWidth() const
+    {
+        return directions.getWidth();
+    }
+
+    int FlowField::getHeight() const
+    {
+        return directions.getHeight();
+    }
+
+    bool FlowField::contains(const Point& p) const
+    {
+        return p.x >= 0 && p.y >= 0 && p.x < directions.getWidth() && p.y < directions.getHeight();
+    }
+
+    bool FlowField::isReachable(const Point& p) const
+    {
+        return contains(p) && directions.get(p.x, p.y) != UnreachableCell;
+    }
+
+    bool FlowField::isGoal(const Point& p) const
+    {
+        return contains(p) && directions.get(p.x, p.y) == GoalCell;
+    }
+
+    std::optional<Direction> FlowField::getDirection(const Point& p) const
+    {
+        if (!contains(p))
+        {
+            return std::nullopt;
+        }
+
+        auto value = directions.get(p.x, p.y);
+        if (value == GoalCell || value == UnreachableCell)
+        {
+            return std::nullopt;
+        }
+
+        return Directions[value];
+    }
+
+    std::optional<std::vector<Point>> FlowField::tracePath(const Point& start) const
+    {
+        if (!isReachable(start))
+        {
+            return std::nullopt;
+        }
+
+        // Every step is to a strictly cheaper cell, so this always ends at a goal.
+        std::vector<Point> path{start};
+        while (auto direction = getDirection(path.back()))
+        {
+            path.push_back(path.back() + directionToPoint(*direction));
+        }
+
+        return path;
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <optional>
+#include <rwe/grid/EightWayDirection.h>
+#include <rwe/grid/Grid.h>
+#include <rwe/grid/Point.h>
+#include <vector>
+
+namespace rwe
+{
+    class SnapshotReader;
+    class SnapshotWriter;
+
+    /**
+     * For every cell of a passability grid, the direction to step in
+     * to head towards the nearest of a set of goal cells.
+     *
+     * Built with a single Dijkstra search outwards from the goals,
+     * after which any number of units can follow it to the goal
+     * without searching for themselves.
+     * The field depends only on the grid and the goals,
+     * so every peer builds an identical one.
+     */
+    class FlowField
+    {
+    private:
+        static constexpr unsigned char GoalCell = 8;
+        static constexpr unsigned char UnreachableCell = 9;
+
+        /** Index into Directions, or one of the special values above. */
+        Grid<unsigned char> directions;
+
+    public:
+        /**
+         * Builds the field over the given grid, where a nonzero cell is passable.
+         * Goals that are outside the grid or not passable are ignored.
+         */
+        FlowField(const Grid<char>& passable, const std::vector<Point>& goals);
+
+        static FlowField restoreSnapshot(SnapshotReader& r);
+
+        int getWidth() const;
+
+        int getHeight() const;
+
+        bool contains(const Point& p) const;
+
+        /** True if a goal can be reached from the cell. */
+        bool isReachable(const Point& p) const;
+
+        bool isGoal(const Point& p) const;
+
+        /**
+         * The direction to step in from the cell.
+         * Returns nothing if the cell is a goal, is outside the grid,
+         * or cannot reach a goal.
+         */
+        std::optional<Direction> getDirection(const Point& p) const;
+
+        /**
+         * Follows the field from the start cell to a goal.
+         * The result begins with start and ends with the goal reached.
+         * Returns nothing if no goal can be reached from start.
+         */
+        std::optional<std::vector<Point>> tracePath(const Point& start) const;
+
+        void saveSnapshot(SnapshotWriter& w) const;
+
+    private:
+        explicit FlowField(Grid<unsigned char>&& directions);
+    };
+}
@@ -0,0 +1,65 @@
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/pathfinding/FlowField.h>
+
+namespace rwe
+{
+    TEST_CASE("FlowField")
+    {
+        SECTION("leads straight to the goal on open ground")
+        {
+            Grid<char> grid(10, 10, 1);
+            FlowField field(grid, {Point(8, 2)});
+
+            REQUIRE(field.isGoal(Point(8, 2)));
+            REQUIRE(!field.getDirection(Point(8, 2)));
+            REQUIRE(field.getDirection(Point(2, 2)) == Direction::EAST);
+
+            auto path = field.tracePath(Point(2, 2));
+            REQUIRE(path);
+            REQUIRE(path->size() == 7);
+            REQUIRE(path->front() == Point(2, 2));
+            REQUIRE(path->back() == Point(8, 2));
+        }
+
+        SECTION("goes around walls")
+        {
+            // wall down the middle with a gap at the bottom
+            Grid<char> grid(10, 10, 1);
+            for (int y = 0; y < 9; ++y)
+            {
+                grid.set(5, y, 0);
+            }
+
+            FlowField field(grid, {Point(8, 0)});
+            auto path = field.tracePath(Point(2, 0));
+            REQUIRE(path);
+            REQUIRE(path->back() == Point(8, 0));
+            REQUIRE(std::find(path->begin(), path->end(), Point(5, 9)) != path->end());
+        }
+
+        SECTION("heads for the nearest of several goals")
+        {
+            Grid<char> grid(20, 5, 1);
+            FlowField field(grid, {Point(0, 2), Point(19, 2)});
+
+            REQUIRE(field.tracePath(Point(4, 2))->back() == Point(0, 2));
+            REQUIRE(field.tracePath(Point(15, 2))->back() == Point(19, 2));
+        }
+
+        SECTION("reports cells that cannot reach a goal")
+        {
+            Grid<char> grid(10, 10, 1);
+            for (int y = 0; y < 10; ++y)
+            {
+                grid.set(5, y, 0);
+            }
+
+            FlowField field(grid, {Point(8, 2), Point(5, 5), Point(20, 2)});
+            REQUIRE(!field.isReachable(Point(2, 2)));
+            REQUIRE(!field.tracePath(Point(2, 2)));
+            REQUIRE(!field.tracePath(Point(5, 5)));
+            REQUIRE(field.isReachable(Point(9, 9)));
+        }
+    }
+}
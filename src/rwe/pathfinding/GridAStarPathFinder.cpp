@@ -0,0 +1,325 @@
+#include "GridAStarPathFinder.h"
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace rwe
+{
+    GridAStarWorkspace::GridAStarWorkspace(int width, int height)
+    {
+        resize(width, height);
+    }
+
+    void GridAStarWorkspace::resize(int newWidth, int newHeight)
+    {
+        if (newWidth == width && newHeight == height)
+        {
+            return;
+        }
+
+        width = newWidth;
+        height = newHeight;
+        generation = 0;
+
+        auto size = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+        stamps.assign(size, 0);
+        states.assign(size, CellState::Open);
+        costsToReach.assign(size, PathCost());
+        predecessors.assign(size, -1);
+        heapPositions.assign(size, -1);
+    }
+
+    void GridAStarWorkspace::beginSearch()
+    {
+        generation += 1;
+        if (generation == 0)
+        {
+            // The generation counter wrapped around,
+            // so old stamps could be mistaken for current ones.
+            std::fill(stamps.begin(), stamps.end(), 0);
+            generation = 1;
+        }
+
+        heap.clear();
+        closedCells.clear();
+    }
+
+    int GridAStarWorkspace::getWidth() const
+    {
+        return width;
+    }
+
+    int GridAStarWorkspace::getHeight() const
+    {
+        return height;
+    }
+
+    bool GridAStarWorkspace::contains(const Point& p) const
+    {
+        return p.x >= 0 && p.y >= 0 && p.x < width && p.y < height;
+    }
+
+    int GridAStarWorkspace::toCell(const Point& p) const
+    {
+        assert(contains(p));
+        return (p.y * width) + p.x;
+    }
+
+    Point GridAStarWorkspace::toPoint(int cell) const
+    {
+        return Point(cell % width, cell / width);
+    }
+
+    bool GridAStarWorkspace::isVisited(int cell) const
+    {
+        return stamps[cell] == generation;
+    }
+
+    bool GridAStarWorkspace::isClosed(int cell) const
+    {
+        return isVisited(cell) && states[cell] == CellState::Closed;
+    }
+
+    const PathCost& GridAStarWorkspace::getCostToReach(int cell) const
+    {
+        return costsToReach[cell];
+    }
+
+    int GridAStarWorkspace::getPredecessor(int cell) const
+    {
+        return predecessors[cell];
+    }
+
+    const std::vector<int>& GridAStarWorkspace::getClosedCells() const
+    {
+        return closedCells;
+    }
+
+    std::unordered_map<Point, AStarVertexInfo<Point, PathCost>> GridAStarWorkspace::getClosedVertices() const
+    {
+        std::unordered_map<Point, AStarVertexInfo<Point, PathCost>> closedVertices;
+        for (auto cell : getClosedCells())
+        {
+            auto p = toPoint(cell);
+            closedVertices.insert({p, AStarVertexInfo<Point, PathCost>{getCostToReach(cell), p, std::nullopt}});
+        }
+
+        // A vertex's predecessor is always closed before the vertex itself is,
+        // so every predecessor is in the map.
+        for (auto cell : getClosedCells())
+        {
+            auto predecessor = getPredecessor(cell);
+            if (predecessor != -1)
+            {
+                closedVertices.at(toPoint(cell)).predecessor = &closedVertices.at(toPoint(predecessor));
+            }
+        }
+
+        return closedVertices;
+    }
+
+    bool GridAStarWorkspace::heapEmpty() const
+    {
+        return heap.empty();
+    }
+
+    int GridAStarWorkspace::popAndClose()
+    {
+        // Same sequence of moves as MinHeap::pop,
+        // so that ties are broken the same way.
+        auto firstEntry = heap.front();
+        auto lastEntry = heap.back();
+        heap.pop_back();
+
+        if (!heap.empty())
+        {
+            siftDown(0, lastEntry);
+        }
+
+        states[firstEntry.cell] = CellState::Closed;
+        heapPositions[firstEntry.cell] = -1;
+        closedCells.push_back(firstEntry.cell);
+        return firstEntry.cell;
+    }
+
+    bool GridAStarWorkspace::pushOrDecrease(int cell, const PathCost& estimatedTotalCost, const PathCost& costToReach, int predecessor)
+    {
+        HeapEntry entry{estimatedTotalCost, cell};
+
+        if (!isVisited(cell))
+        {
+            stamps[cell] = generation;
+            states[cell] = CellState::Open;
+            costsToReach[cell] = costToReach;
+            predecessors[cell] = predecessor;
+            heap.resize(heap.size() + 1);
+            siftUp(heap.size() - 1, entry);
+            return true;
+        }
+
+        if (states[cell] == CellState::Closed)
+        {
+            return false;
+        }
+
+        auto position = static_cast<std::size_t>(heapPositions[cell]);
+        if (!(estimatedTotalCost < heap[position].estimatedTotalCost))
+        {
+            return false;
+        }
+
+        costsToReach[cell] = costToReach;
+        predecessors[cell] = predecessor;
+        siftUp(position, entry);
+        return true;
+    }
+
+    void GridAStarWorkspace::siftUp(std::size_t position, const HeapEntry& entry)
+    {
+        while (position > 0)
+        {
+            auto parentPosition = (position - 1) / 2;
+            const auto& parentEntry = heap[parentPosition];
+            if (!(entry.estimatedTotalCost < parentEntry.estimatedTotalCost))
+            {
+                break;
+            }
+
+            heap[position] = parentEntry;
+            heapPositions[parentEntry.cell] = static_cast<int>(position);
+            position = parentPosition;
+        }
+
+        heap[position] = entry;
+        heapPositions[entry.cell] = static_cast<int>(position);
+    }
+
+    void GridAStarWorkspace::siftDown(std::size_t position, const HeapEntry& entry)
+    {
+        auto firstLeafPosition = heap.size() / 2;
+        while (position < firstLeafPosition)
+        {
+            auto smallestChildPosition = (position * 2) + 1;
+            const auto* smallestChild = &heap[smallestChildPosition];
+            auto rightChildPosition = (position * 2) + 2;
+            if (rightChildPosition < heap.size())
+            {
+                const auto* rightChild = &heap[rightChildPosition];
+                if (rightChild->estimatedTotalCost < smallestChild->estimatedTotalCost)
+                {
+                    smallestChildPosition = rightChildPosition;
+                    smallestChild = rightChild;
+                }
+            }
+
+            if (entry.estimatedTotalCost < smallestChild->estimatedTotalCost)
+            {
+                break;
+            }
+
+            heap[position] = *smallestChild;
+            heapPositions[smallestChild->cell] = static_cast<int>(position);
+            position = smallestChildPosition;
+        }
+
+        heap[position] = entry;
+        heapPositions[entry.cell] = static_cast<int>(position);
+    }
+
+    void GridAStarPathFinder::Successors::push(const GridAStarVertex& v)
+    {
+        assert(count < MaxSuccessors);
+        items[count] = v;
+        ++count;
+    }
+
+    GridAStarPathFinder::GridAStarPathFinder(GridAStarWorkspace* workspace)
+        : workspace(workspace)
+    {
+    }
+
+    GridAStarPathInfo GridAStarPathFinder::findPath(const Point& start)
+    {
+        auto& ws = *workspace;
+        if (!ws.contains(start))
+        {
+            throw std::logic_error("Path search start is outside the grid");
+        }
+
+        ws.beginSearch();
+        ws.pushOrDecrease(ws.toCell(start), estimateCostToGoal(start), PathCost(), -1);
+
+        std::optional<std::pair<PathCost, int>> closestVertex;
+
+        unsigned int openListPopsPerformed = 0;
+
+        Successors successors;
+
+        while (!ws.heapEmpty() && openListPopsPerformed < MaxOpenListQueries)
+        {
+            auto currentCell = ws.popAndClose();
+            openListPopsPerformed += 1;
+
+            auto current = getVertex(currentCell);
+
+            if (isGoal(current.vertex))
+            {
+                return GridAStarPathInfo{AStarPathType::Complete, walkPath(currentCell), openListPopsPerformed};
+            }
+
+            auto estimatedCostToGoal = estimateCostToGoal(current.vertex);
+            if (!closestVertex || estimatedCostToGoal < closestVertex->first)
+            {
+                closestVertex = std::pair<PathCost, int>(estimatedCostToGoal, currentCell);
+            }
+
+            successors.count = 0;
+            getSuccessors(current, successors);
+            for (int i = 0; i < successors.count; ++i)
+            {
+                const auto& s = successors.items[i];
+
+                // Walkable cells always lie inside the grid,
+                // but don't trust subclasses with our memory.
+                if (!ws.contains(s.vertex))
+                {
+                    continue;
+                }
+
+                auto cell = ws.toCell(s.vertex);
+                if (ws.isClosed(cell))
+                {
+                    continue;
+                }
+
+                auto estimatedTotalCost = s.costToReach + estimateCostToGoal(s.vertex);
+                ws.pushOrDecrease(cell, estimatedTotalCost, s.costToReach, currentCell);
+            }
+        }
+
+        return GridAStarPathInfo{AStarPathType::Partial, walkPath(closestVertex->second), openListPopsPerformed};
+    }
+
+    GridAStarVertex GridAStarPathFinder::getVertex(int cell) const
+    {
+        const auto& ws = *workspace;
+        auto predecessor = ws.getPredecessor(cell);
+        return GridAStarVertex{
+            ws.toPoint(cell),
+            ws.getCostToReach(cell),
+            predecessor == -1 ? std::nullopt : std::make_optional(ws.toPoint(predecessor))};
+    }
+
+    std::vector<Point> GridAStarPathFinder::walkPath(int cell) const
+    {
+        const auto& ws = *workspace;
+        std::vector<Point> items;
+        for (auto c = cell; c != -1; c = ws.getPredecessor(c))
+        {
+            items.push_back(ws.toPoint(c));
+        }
+
+        std::reverse(items.begin(), items.end());
+        return items;
+    }
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <array>
+#include <optional>
+#include <rwe/grid/Point.h>
+#include <rwe/pathfinding/AStarPathFinder.h>
+#include <rwe/pathfinding/PathCost.h>
+#include <unordered_map>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * Scratch memory for GridAStarPathFinder.
+     * Sized to the grid being searched and reused across searches,
+     * so that a search does not need to allocate.
+     *
+     * Every cell is stamped with the generation of the search that last touched it.
+     * Starting a new search just bumps the generation,
+     * which invalidates all cells without clearing them.
+     */
+    class GridAStarWorkspace
+    {
+    public:
+        enum class CellState : unsigned char
+        {
+            Open,
+            Closed
+        };
+
+        struct HeapEntry
+        {
+            PathCost estimatedTotalCost;
+            int cell;
+        };
+
+    private:
+        int width{0};
+        int height{0};
+        unsigned int generation{0};
+
+        std::vector<unsigned int> stamps;
+        std::vector<CellState> states;
+        std::vector<PathCost> costsToReach;
+        std::vector<int> predecessors;
+        std::vector<int> heapPositions;
+
+        std::vector<HeapEntry> heap;
+        std::vector<int> closedCells;
+
+    public:
+        GridAStarWorkspace() = default;
+
+        GridAStarWorkspace(int width, int height);
+
+        /**
+         * Sets the size of the grid to be searched.
+         * Does nothing if the size has not changed.
+         */
+        void resize(int newWidth, int newHeight);
+
+        /** Forgets everything from the previous search. */
+        void beginSearch();
+
+        int getWidth() const;
+
+        int getHeight() const;
+
+        bool contains(const Point& p) const;
+
+        int toCell(const Point& p) const;
+
+        Point toPoint(int cell) const;
+
+        bool isVisited(int cell) const;
+
+        bool isClosed(int cell) const;
+
+        const PathCost& getCostToReach(int cell) const;
+
+        /** Returns the predecessor of the cell, or -1 if it has none. */
+        int getPredecessor(int cell) const;
+
+        /** The cells closed by the current search, in the order they were closed. */
+        const std::vector<int>& getClosedCells() const;
+
+        /**
+         * Builds the closed set of the most recent search in the form used by
+         * the pathfinding debug visualisation.
+         * This allocates, so it should only be called when the visualisation is on.
+         */
+        std::unordered_map<Point, AStarVertexInfo<Point, PathCost>> getClosedVertices() const;
+
+        bool heapEmpty() const;
+
+        /**
+         * Removes the top of the open heap and marks that cell as closed.
+         */
+        int popAndClose();
+
+        /**
+         * Adds a cell to the open heap, or updates it if the new cost is lower.
+         * Returns true if the cell was added or updated.
+         */
+        bool pushOrDecrease(int cell, const PathCost& estimatedTotalCost, const PathCost& costToReach, int predecessor);
+
+    private:
+        void siftUp(std::size_t position, const HeapEntry& entry);
+
+        void siftDown(std::size_t position, const HeapEntry& entry);
+    };
+
+    struct GridAStarVertex
+    {
+        Point vertex;
+        PathCost costToReach;
+        std::optional<Point> predecessor;
+    };
+
+    struct GridAStarPathInfo
+    {
+        AStarPathType type;
+        std::vector<Point> path;
+        unsigned int closedVertexCount;
+    };
+
+    /**
+     * A* search over a grid of points.
+     *
+     * Expands vertices in exactly the same order as AStarPathFinder
+     * and produces the same paths, but keeps all its bookkeeping
+     * in a GridAStarWorkspace instead of in hash maps.
+     */
+    class GridAStarPathFinder
+    {
+    public:
+        static constexpr int MaxSuccessors = 8;
+
+        struct Successors
+        {
+            std::array<GridAStarVertex, MaxSuccessors> items;
+            int count{0};
+
+            void push(const GridAStarVertex& v);
+        };
+
+    private:
+        GridAStarWorkspace* workspace;
+
+    public:
+        explicit GridAStarPathFinder(GridAStarWorkspace* workspace);
+
+        virtual ~GridAStarPathFinder() = default;
+
+        /**
+         * Searches from start towards the goal.
+         * The start must lie within the workspace grid.
+         */
+        GridAStarPathInfo findPath(const Point& start);
+
+    protected:
+        virtual bool isGoal(const Point& vertex) = 0;
+
+        virtual PathCost estimateCostToGoal(const Point& vertex) = 0;
+
+        virtual void getSuccessors(const GridAStarVertex& vertex, Successors& successors) = 0;
+
+    private:
+        GridAStarVertex getVertex(int cell) const;
+
+        std::vector<Point> walkPath(int cell) const;
+    };
+}
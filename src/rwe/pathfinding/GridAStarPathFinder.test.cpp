@@ -0,0 +1,226 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <random>
+#include <rwe/grid/EightWayDirection.h>
+#include <rwe/grid/Grid.h>
+#include <rwe/pathfinding/AStarPathFinder.h>
+#include <rwe/pathfinding/GridAStarPathFinder.h>
+#include <rwe/pathfinding/pathfinding_utils.h>
+#include <rwe/util/SimpleLogger.h>
+
+namespace rwe
+{
+    PathCost testStepCost(const Point& from, const Point& to, const std::optional<Point>& predecessor)
+    {
+        auto distance = octileDistance(from, to);
+        auto direction = pointToDirection(to - from);
+        unsigned int turns = predecessor ? directionDistance(pointToDirection(from - *predecessor), direction) : 0;
+        return PathCost(distance, turns);
+    }
+
+    PathCost testEstimate(const Point& p, const Point& goal)
+    {
+        auto distance = octileDistance(p, goal);
+        unsigned int turns = (distance.straight > 0 && distance.diagonal > 0) ? 1 : 0;
+        return PathCost(distance, turns);
+    }
+
+    bool testIsWalkable(const Grid<unsigned char>& walls, const Point& p)
+    {
+        return p.x >= 0 && p.y >= 0 && p.x < walls.getWidth() && p.y < walls.getHeight() && !walls.get(p.x, p.y);
+    }
+
+    class TestGridAStarPathFinder : public GridAStarPathFinder
+    {
+    private:
+        const Grid<unsigned char>* walls;
+        Point goal;
+
+    public:
+        TestGridAStarPathFinder(GridAStarWorkspace* workspace, const Grid<unsigned char>* walls, const Point& goal)
+            : GridAStarPathFinder(workspace), walls(walls), goal(goal)
+        {
+        }
+
+    protected:
+        bool isGoal(const Point& vertex) override
+        {
+            return vertex == goal;
+        }
+
+        PathCost estimateCostToGoal(const Point& vertex) override
+        {
+            return testEstimate(vertex, goal);
+        }
+
+        void getSuccessors(const GridAStarVertex& vertex, Successors& successors) override
+        {
+            for (auto d : Directions)
+            {
+                auto neighbour = vertex.vertex + directionToPoint(d);
+                if (testIsWalkable(*walls, neighbour))
+                {
+                    successors.push(GridAStarVertex{neighbour, vertex.costToReach + testStepCost(vertex.vertex, neighbour, vertex.predecessor), vertex.vertex});
+                }
+            }
+        }
+    };
+
+    class TestReferencePathFinder : public AStarPathFinder<Point, PathCost>
+    {
+    private:
+        const Grid<unsigned char>* walls;
+        Point goal;
+
+    public:
+        TestReferencePathFinder(const Grid<unsigned char>* walls, const Point& goal) : walls(walls), goal(goal)
+        {
+        }
+
+    protected:
+        bool isGoal(const Point& vertex) override
+        {
+            return vertex == goal;
+        }
+
+        PathCost estimateCostToGoal(const Point& vertex) override
+        {
+            return testEstimate(vertex, goal);
+        }
+
+        std::vector<VertexInfo> getSuccessors(const VertexInfo& vertex) override
+        {
+            std::optional<Point> predecessor;
+            if (vertex.predecessor)
+            {
+                predecessor = (*vertex.predecessor)->vertex;
+            }
+
+            std::vector<VertexInfo> vs;
+            for (auto d : Directions)
+            {
+                auto neighbour = vertex.vertex + directionToPoint(d);
+                if (testIsWalkable(*walls, neighbour))
+                {
+                    vs.push_back(VertexInfo{vertex.costToReach + testStepCost(vertex.vertex, neighbour, predecessor), neighbour, &vertex});
+                }
+            }
+            return vs;
+        }
+    };
+
+    TEST_CASE("GridAStarPathFinder")
+    {
+        SECTION("finds a path around a wall")
+        {
+            Grid<unsigned char> walls(5, 5, 0);
+            walls.set(2, 0, 1);
+            walls.set(2, 1, 1);
+            walls.set(2, 2, 1);
+            walls.set(2, 3, 1);
+
+            GridAStarWorkspace workspace(5, 5);
+            TestGridAStarPathFinder finder(&workspace, &walls, Point(4, 0));
+            auto result = finder.findPath(Point(0, 0));
+
+            REQUIRE(result.type == AStarPathType::Complete);
+            REQUIRE(result.path.front() == Point(0, 0));
+            REQUIRE(result.path.back() == Point(4, 0));
+            REQUIRE(std::find(result.path.begin(), result.path.end(), Point(2, 4)) != result.path.end());
+            REQUIRE(result.closedVertexCount == workspace.getClosedVertices().size());
+        }
+
+        SECTION("returns a partial path to the closest vertex when the goal is unreachable")
+        {
+            Grid<unsigned char> walls(5, 5, 0);
+            for (int y = 0; y < 5; ++y)
+            {
+                walls.set(3, y, 1);
+            }
+
+            GridAStarWorkspace workspace(5, 5);
+            TestGridAStarPathFinder finder(&workspace, &walls, Point(4, 2));
+            auto result = finder.findPath(Point(0, 2));
+
+            REQUIRE(result.type == AStarPathType::Partial);
+            REQUIRE(result.path.back() == Point(2, 2));
+        }
+
+        SECTION("rejects a start outside the grid")
+        {
+            Grid<unsigned char> walls(5, 5, 0);
+            GridAStarWorkspace workspace(5, 5);
+            TestGridAStarPathFinder finder(&workspace, &walls, Point(4, 2));
+            REQUIRE_THROWS(finder.findPath(Point(-1, 2)));
+        }
+
+        SECTION("debug closed set links each vertex to its predecessor")
+        {
+            Grid<unsigned char> walls(6, 6, 0);
+            walls.set(3, 1, 1);
+            walls.set(3, 2, 1);
+            walls.set(3, 3, 1);
+
+            GridAStarWorkspace workspace(6, 6);
+            TestGridAStarPathFinder finder(&workspace, &walls, Point(5, 2));
+            auto result = finder.findPath(Point(0, 2));
+            auto closed = workspace.getClosedVertices();
+
+            REQUIRE(closed.size() == result.closedVertexCount);
+            REQUIRE(!closed.at(Point(0, 2)).predecessor);
+            for (const auto& [p, info] : closed)
+            {
+                if (p != Point(0, 2))
+                {
+                    REQUIRE(info.predecessor);
+                    REQUIRE(closed.find((*info.predecessor)->vertex) != closed.end());
+                }
+            }
+        }
+
+        SECTION("matches the generic A* on random maps, reusing one workspace")
+        {
+            const int width = 40;
+            const int height = 30;
+            std::minstd_rand rng(1234);
+            std::uniform_int_distribution<int> xDist(0, width - 1);
+            std::uniform_int_distribution<int> yDist(0, height - 1);
+            std::uniform_int_distribution<int> wallDist(0, 99);
+
+            // AStarPathFinder logs the outcome of every search
+            auto logPath = (std::filesystem::temp_directory_path() / "rwe_test_grid_astar.log").string();
+            setGlobalLogger(std::make_shared<SimpleLogger>(logPath, true));
+
+            GridAStarWorkspace workspace(width, height);
+
+            for (int i = 0; i < 200; ++i)
+            {
+                Grid<unsigned char> walls(width, height, 0);
+                auto density = i % 40;
+                for (int y = 0; y < height; ++y)
+                {
+                    for (int x = 0; x < width; ++x)
+                    {
+                        walls.set(x, y, wallDist(rng) < density ? 1 : 0);
+                    }
+                }
+
+                Point start(xDist(rng), yDist(rng));
+                Point goal(xDist(rng), yDist(rng));
+                walls.set(start.x, start.y, 0);
+
+                TestGridAStarPathFinder gridFinder(&workspace, &walls, goal);
+                TestReferencePathFinder referenceFinder(&walls, goal);
+
+                auto gridResult = gridFinder.findPath(start);
+                auto referenceResult = referenceFinder.findPath(start);
+
+                REQUIRE(gridResult.type == referenceResult.type);
+                REQUIRE(gridResult.path == referenceResult.path);
+                REQUIRE(gridResult.closedVertexCount == referenceResult.closedVertices.size());
+            }
+
+            setGlobalLogger(nullptr);
+        }
+    }
+}
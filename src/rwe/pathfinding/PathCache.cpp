@@ -0,0 +1,166 @@
+#include "PathCache.h"
+#include <algorithm>
+#include <rwe/sim/SnapshotIo.h>
+
+namespace rwe
+{
+    bool PathCacheKey::operator==(const PathCacheKey& rhs) const
+    {
+        return movementClass == rhs.movementClass
+            && footprintX == rhs.footprintX
+            && footprintZ == rhs.footprintZ
+            && startCell == rhs.startCell
+            && goal == rhs.goal
+            && goalIsRect == rhs.goalIsRect;
+    }
+
+    bool PathCacheKey::operator!=(const PathCacheKey& rhs) const
+    {
+        return !(rhs == *this);
+    }
+
+    static int floorDivide(int a, int b)
+    {
+        auto quotient = a / b;
+        return (a % b != 0 && (a < 0) != (b < 0)) ? quotient - 1 : quotient;
+    }
+
+    Point PathCache::toCell(const Point& p)
+    {
+        return Point(floorDivide(p.x, CellSize), floorDivide(p.y, CellSize));
+    }
+
+    std::optional<std::size_t> PathCache::findExitIndex(const std::vector<Point>& path)
+    {
+        if (path.empty())
+        {
+            return std::nullopt;
+        }
+
+        auto startCell = toCell(path.front());
+        auto it = std::find_if(path.begin(), path.end(), [&](const auto& p) { return toCell(p) != startCell; });
+        if (it == path.end())
+        {
+            return std::nullopt;
+        }
+
+        return it - path.begin();
+    }
+
+    const std::vector<Point>* PathCache::find(const PathCacheKey& key, GameTime now) const
+    {
+        auto it = entries.find(key);
+        if (it == entries.end() || now - it->second.creationTime >= GameTime(MaxAgeInTicks))
+        {
+            return nullptr;
+        }
+
+        return &it->second.path;
+    }
+
+    void PathCache::insert(const PathCacheKey& key, const std::vector<Point>& path, GameTime now)
+    {
+        if (!findExitIndex(path))
+        {
+            return;
+        }
+
+        auto minX = path.front().x;
+        auto maxX = path.front().x;
+        auto minY = path.front().y;
+        auto maxY = path.front().y;
+        for (const auto& p : path)
+        {
+            minX = std::min(minX, p.x);
+            maxX = std::max(maxX, p.x);
+            minY = std::min(minY, p.y);
+            maxY = std::max(maxY, p.y);
+        }
+
+        DiscreteRect bounds(minX, minY, maxX - minX + key.footprintX, maxY - minY + key.footprintZ);
+        entries.insert_or_assign(key, Entry{path, bounds, now});
+    }
+
+    void PathCache::invalidate(const DiscreteRect& area)
+    {
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (it->second.bounds.intersection(area))
+            {
+                it = entries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void PathCache::removeExpired(GameTime now)
+    {
+        for (auto it = entries.begin(); it != entries.end();)
+        {
+            if (now - it->second.creationTime >= GameTime(MaxAgeInTicks))
+            {
+                it = entries.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    std::size_t PathCache::size() const
+    {
+        return entries.size();
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const PathCacheKey& key)
+    {
+        writeSnapshot(w, key.movementClass);
+        writeSnapshot(w, key.footprintX);
+        writeSnapshot(w, key.footprintZ);
+        writeSnapshot(w, key.startCell);
+        writeSnapshot(w, key.goal);
+        writeSnapshot(w, key.goalIsRect);
+    }
+
+    PathCacheKey readSnapshot(SnapshotReader& r, SnapshotTag<PathCacheKey>)
+    {
+        PathCacheKey key;
+        key.movementClass = readSnapshotValue<MovementClassId>(r);
+        key.footprintX = readSnapshotValue<int>(r);
+        key.footprintZ = readSnapshotValue<int>(r);
+        key.startCell = readSnapshotValue<Point>(r);
+        key.goal = readSnapshotValue<DiscreteRect>(r);
+        key.goalIsRect = readSnapshotValue<bool>(r);
+        return key;
+    }
+
+    void PathCache::saveSnapshot(SnapshotWriter& w) const
+    {
+        writeSnapshotSize(w, entries.size());
+        for (const auto& [key, entry] : entries)
+        {
+            writeSnapshot(w, key);
+            writeSnapshot(w, entry.path);
+            writeSnapshot(w, entry.bounds);
+            writeSnapshot(w, entry.creationTime);
+        }
+    }
+
+    void PathCache::restoreSnapshot(SnapshotReader& r)
+    {
+        entries.clear();
+        auto size = readSnapshotSize(r);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            auto key = readSnapshotValue<PathCacheKey>(r);
+            auto path = readSnapshotValue<std::vector<Point>>(r);
+            auto bounds = readSnapshotValue<DiscreteRect>(r);
+            auto creationTime = readSnapshotValue<GameTime>(r);
+            entries.insert_or_assign(key, Entry{std::move(path), bounds, creationTime});
+        }
+    }
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <rwe/grid/DiscreteRect.h>
+#include <rwe/grid/Point.h>
+#include <rwe/sim/GameTime.h>
+#include <rwe/sim/MovementClassId.h>
+#include <rwe/util/hash_combine.h>
+#include <unordered_map>
+#include <vector>
+
+namespace rwe
+{
+    struct PathCacheKey
+    {
+        MovementClassId movementClass;
+        int footprintX;
+        int footprintZ;
+
+        /** The coarse cell containing the start of the path. */
+        Point startCell;
+
+        /**
+         * The footprint at the destination point,
+         * or the destination rect expanded by the footprint.
+         */
+        DiscreteRect goal;
+        bool goalIsRect;
+
+        bool operator==(const PathCacheKey& rhs) const;
+
+        bool operator!=(const PathCacheKey& rhs) const;
+    };
+}
+
+namespace std
+{
+    template <>
+    struct hash<rwe::PathCacheKey>
+    {
+        std::size_t operator()(const rwe::PathCacheKey& k) const noexcept
+        {
+            std::size_t seed = 0;
+            rwe::hashCombine(seed, std::hash<rwe::MovementClassId>{}(k.movementClass));
+            rwe::hashCombine(seed, std::hash<int>{}(k.footprintX));
+            rwe::hashCombine(seed, std::hash<int>{}(k.footprintZ));
+            rwe::hashCombine(seed, std::hash<rwe::Point>{}(k.startCell));
+            rwe::hashCombine(seed, std::hash<rwe::DiscreteRect>{}(k.goal));
+            rwe::hashCombine(seed, std::hash<bool>{}(k.goalIsRect));
+            return seed;
+        }
+    };
+}
+
+namespace rwe
+{
+    class SnapshotReader;
+    class SnapshotWriter;
+
+    /**
+     * Recently found paths, for reuse by units that start nearby
+     * and are heading to the same place.
+     *
+     * Paths are grouped by the coarse cell they start in.
+     * A unit starting elsewhere in the same cell can join a cached path
+     * with a short search instead of searching all the way to the goal.
+     */
+    class PathCache
+    {
+    public:
+        /** The width and height of the coarse cells, in heightmap cells. */
+        static constexpr int CellSize = 16;
+
+        /** Paths older than this are not reused. */
+        static constexpr unsigned int MaxAgeInTicks = 150;
+
+    private:
+        struct Entry
+        {
+            std::vector<Point> path;
+
+            /** The area covered by the footprint anywhere along the path. */
+            DiscreteRect bounds;
+
+            GameTime creationTime;
+        };
+
+        std::unordered_map<PathCacheKey, Entry> entries;
+
+    public:
+        /**
+         * Returns the coarse cell containing the point.
+         * Cells are aligned to the origin, so negative coordinates
+         * fall in negative cells rather than sharing cell 0.
+         */
+        static Point toCell(const Point& p);
+
+        /**
+         * Returns the index of the first point on the path
+         * that lies outside the coarse cell the path starts in,
+         * or nothing if the path never leaves it.
+         */
+        static std::optional<std::size_t> findExitIndex(const std::vector<Point>& path);
+
+        /** Returns the cached path, or null if there is none or it has expired. */
+        const std::vector<Point>* find(const PathCacheKey& key, GameTime now) const;
+
+        /**
+         * Stores a path from start to goal, replacing any existing path with the same key.
+         * Paths that never leave their starting cell are not stored,
+         * since there would be nothing to join.
+         */
+        void insert(const PathCacheKey& key, const std::vector<Point>& path, GameTime now);
+
+        /**
+         * Forgets every path whose footprint passes through the given area.
+         * Called when a building or feature changes there.
+         */
+        void invalidate(const DiscreteRect& area);
+
+        /** Forgets paths that are too old to be reused. */
+        void removeExpired(GameTime now);
+
+        std::size_t size() const;
+
+        void saveSnapshot(SnapshotWriter& w) const;
+
+        void restoreSnapshot(SnapshotReader& r);
+    };
+}
@@ -0,0 +1,74 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/pathfinding/PathCache.h>
+
+namespace rwe
+{
+    std::vector<Point> straightPath(int fromX, int toX, int y)
+    {
+        std::vector<Point> path;
+        for (int x = fromX; x <= toX; ++x)
+        {
+            path.emplace_back(x, y);
+        }
+        return path;
+    }
+
+    TEST_CASE("PathCache")
+    {
+        PathCacheKey key{MovementClassId(1), 2, 2, Point(0, 0), DiscreteRect(40, 4, 2, 2), false};
+
+        SECTION("finds the exit from the starting cell")
+        {
+            REQUIRE(PathCache::findExitIndex(straightPath(3, 40, 4)) == std::optional<std::size_t>(13));
+            REQUIRE(!PathCache::findExitIndex(straightPath(3, 10, 4)));
+        }
+
+        SECTION("puts negative coordinates in negative cells")
+        {
+            REQUIRE(PathCache::toCell(Point(0, 15)) == Point(0, 0));
+            REQUIRE(PathCache::toCell(Point(-1, -15)) == Point(-1, -1));
+            REQUIRE(PathCache::toCell(Point(-16, 16)) == Point(-1, 1));
+            REQUIRE(PathCache::toCell(Point(-17, -32)) == Point(-2, -2));
+            REQUIRE(PathCache::findExitIndex(straightPath(-3, 5, 4)) == std::optional<std::size_t>(3));
+        }
+
+        SECTION("returns stored paths until they expire")
+        {
+            PathCache cache;
+            cache.insert(key, straightPath(3, 40, 4), GameTime(10));
+
+            auto path = cache.find(key, GameTime(10 + PathCache::MaxAgeInTicks - 1));
+            REQUIRE(path != nullptr);
+            REQUIRE(*path == straightPath(3, 40, 4));
+
+            REQUIRE(cache.find(key, GameTime(10 + PathCache::MaxAgeInTicks)) == nullptr);
+
+            auto otherKey = key;
+            otherKey.footprintX = 3;
+            REQUIRE(cache.find(otherKey, GameTime(10)) == nullptr);
+
+            cache.removeExpired(GameTime(10 + PathCache::MaxAgeInTicks));
+            REQUIRE(cache.size() == 0);
+        }
+
+        SECTION("does not store paths that stay in their starting cell")
+        {
+            PathCache cache;
+            cache.insert(key, straightPath(3, 10, 4), GameTime(0));
+            REQUIRE(cache.size() == 0);
+        }
+
+        SECTION("forgets paths that pass through a changed area")
+        {
+            PathCache cache;
+            cache.insert(key, straightPath(3, 40, 4), GameTime(0));
+
+            // just clear of the footprint along the path
+            cache.invalidate(DiscreteRect(20, 6, 3, 3));
+            REQUIRE(cache.size() == 1);
+
+            cache.invalidate(DiscreteRect(20, 5, 3, 3));
+            REQUIRE(cache.size() == 0);
+        }
+    }
+}
@@ -1,77 +1,497 @@
 #include "PathFindingService.h"
+#include <algorithm>
 #include <rwe/pathfinding/UnitPathFinder.h>
 #include <rwe/pathfinding/UnitPerimeterPathFinder.h>
 #include <rwe/pathfinding/pathfinding_utils.h>
-#include <rwe/util/Index.h>
+#include <rwe/sim/GameSimulation.h>
+#include <rwe/sim/SnapshotIo.h>
 
 namespace rwe
 {
     static const unsigned int MaxTasksPerTick = 10;
 
+    /** The number of closed vertices the searches may use up in one tick. */
+    static const int PathBudgetPerTick = 16000;
+
+    /**
+     * The number of requests whose searches run in parallel before being committed.
+     * This must not depend on the number of threads,
+     * or peers with different hardware would disagree about which requests were served.
+     */
+    static const std::size_t MaxRequestsPerBatch = 32;
+
+    /**
+     * Searches at least this many cells long (in the longer axis)
+     * go through the abstract graph rather than searching the grid directly.
+     */
+    static const unsigned int HierarchicalSearchMinDistance = 2 * ClusterGraph::ClusterSize;
+
+    /**
+     * When at least this many pending requests for a new goal share a destination,
+     * they follow a flow field instead of searching individually.
+     */
+    static const std::size_t FlowFieldMinGroupSize = 16;
+
+    /**
+     * Flow fields are dropped this long after they were built, however often they are used,
+     * so that later orders to the same place are routed around the units there now.
+     */
+    static const unsigned int FlowFieldMaxAgeTicks = 300;
+
+    /** Beyond this many flow fields, the oldest are dropped. */
+    static const std::size_t MaxFlowFields = 8;
+
+    bool FlowFieldKey::operator==(const FlowFieldKey& rhs) const
+    {
+        return movementClass == rhs.movementClass && goal == rhs.goal && goalIsRect == rhs.goalIsRect;
+    }
+
+    bool FlowFieldKey::operator!=(const FlowFieldKey& rhs) const
+    {
+        return !(rhs == *this);
+    }
+
+    std::optional<MovementClassId> getNamedMovementClass(const UnitDefinition& unitDefinition)
+    {
+        return match(
+            unitDefinition.movementCollisionInfo, [&](const UnitDefinition::NamedMovementClass& mc) { return std::make_optional(mc.movementClassId); }, [&](const auto&) { return std::optional<MovementClassId>(); });
+    }
+
+    bool isLongDistance(const OctileDistance& distance)
+    {
+        return distance.straight + distance.diagonal >= HierarchicalSearchMinDistance;
+    }
+
+    bool isStaticObstacleInRect(const GameSimulation& simulation, const DiscreteRect& rect)
+    {
+        auto region = simulation.occupiedGrid.tryToRegion(rect);
+        if (!region)
+        {
+            return true;
+        }
+
+        return simulation.occupiedGrid.any(*region, [&](const auto& cell) { return simulation.isStaticObstacle(cell); });
+    }
+
+    bool isStaticallyPassable(const GameSimulation& simulation, MovementClassId movementClass, const Point& p)
+    {
+        const auto& movementClassDefinition = simulation.movementClassDatabase.getMovementClass(movementClass);
+        DiscreteRect rect(p.x, p.y, movementClassDefinition.footprintX, movementClassDefinition.footprintZ);
+        return simulation.movementClassCollisionService.isWalkable(movementClass, p) && !isStaticObstacleInRect(simulation, rect);
+    }
+
+    /**
+     * Returns the cell touching the perimeter of the goal rect
+     * that is passable and nearest to the given point.
+     */
+    std::optional<Point> findNearestPassablePerimeterCell(const ClusterGraph& graph, const DiscreteRect& goalRect, const Point& from)
+    {
+        std::optional<std::pair<OctileDistance, Point>> nearest;
+        for (int y = goalRect.y; y <= goalRect.y + goalRect.height; ++y)
+        {
+            for (int x = goalRect.x; x <= goalRect.x + goalRect.width; ++x)
+            {
+                Point p(x, y);
+                if (!goalRect.topLeftTouchesPerimeter(x, y) || !graph.contains(p) || !graph.isPassable(p))
+                {
+                    continue;
+                }
+
+                auto distance = octileDistance(from, p);
+                if (!nearest || distance < nearest->first)
+                {
+                    nearest = std::make_pair(distance, p);
+                }
+            }
+        }
+
+        if (!nearest)
+        {
+            return std::nullopt;
+        }
+
+        return nearest->second;
+    }
+
     void PathFindingService::update(GameSimulation& simulation)
     {
-        int remainingBudget = 4000;
+        if (!threadPool)
+        {
+            threadPool = std::make_unique<ThreadPool>(ThreadPool::getDefaultThreadCount());
+            workspaces.resize(threadPool->getThreadCount());
+        }
+
+        for (auto& workspace : workspaces)
+        {
+            workspace.resize(simulation.occupiedGrid.getWidth(), simulation.occupiedGrid.getHeight());
+        }
+
+        repairClusterGraphs(simulation);
+        pathCache.removeExpired(simulation.gameTime);
+        removeExpiredFlowFields(simulation.gameTime);
+
+        int remainingBudget = PathBudgetPerTick;
 
         auto& requests = simulation.pathRequests;
+
+        // Count how many pending requests for a new goal share each destination,
+        // to find the groups large enough to be worth a flow field.
+        // Other requests are repaths, e.g. after a collision,
+        // which need the per-unit search that routes around mobile units.
+        std::unordered_map<FlowFieldKey, std::size_t> groupSizes;
+        for (const auto& request : requests)
+        {
+            if (!request.isNewGoal)
+            {
+                continue;
+            }
+
+            if (auto query = makeQuery(simulation, request.unitId); query)
+            {
+                if (auto key = getFlowFieldKey(*query); key)
+                {
+                    ++groupSizes[*key];
+                }
+            }
+        }
+
+        std::vector<PlannedRequest> plans;
+        std::vector<std::size_t> searches;
+        std::vector<std::size_t> joins;
         while (!requests.empty() && remainingBudget > 0)
         {
-            auto& request = requests.front();
+            auto batchSize = std::min(requests.size(), MaxRequestsPerBatch);
+
+            // Decide up front which requests follow a flow field, which search from scratch
+            // and which join a path that is cached or being found by an earlier request in the batch.
+            // Worker threads only read from the service and the simulation,
+            // so any graphs and flow fields the batch needs are also built here.
+            plans.clear();
+            searches.clear();
+            joins.clear();
+            std::unordered_map<PathCacheKey, std::size_t> searchesByKey;
+            for (std::size_t i = 0; i < batchSize; ++i)
+            {
+                auto& plan = plans.emplace_back();
+                plan.query = makeQuery(simulation, requests[i].unitId);
+                if (!plan.query)
+                {
+                    continue;
+                }
+
+                if (plan.query->movementClass)
+                {
+                    buildClusterGraph(simulation, *plan.query->movementClass);
+                }
+
+                if (auto flowFieldKey = getFlowFieldKey(*plan.query); flowFieldKey && requests[i].isNewGoal)
+                {
+                    auto isLargeGroup = groupSizes[*flowFieldKey] >= FlowFieldMinGroupSize;
+                    plan.flowFieldIndex = getFlowField(simulation, *flowFieldKey, isLargeGroup);
+                    if (plan.flowFieldIndex)
+                    {
+                        searches.push_back(i);
+                        continue;
+                    }
+                }
+
+                plan.cacheKey = getCacheKey(*plan.query);
+                if (plan.cacheKey)
+                {
+                    plan.cachedPath = pathCache.find(*plan.cacheKey, simulation.gameTime);
+                    if (plan.cachedPath == nullptr)
+                    {
+                        if (auto it = searchesByKey.find(*plan.cacheKey); it != searchesByKey.end())
+                        {
+                            plan.leader = it->second;
+                        }
+                        else
+                        {
+                            searchesByKey.emplace(*plan.cacheKey, i);
+                        }
+                    }
+                }
+
+                if (plan.cachedPath != nullptr || plan.leader)
+                {
+                    joins.push_back(i);
+                }
+                else
+                {
+                    searches.push_back(i);
+                }
+            }
 
-            auto unit = simulation.tryGetUnitState(request.unitId);
-            if (!unit)
+            const auto& constSimulation = simulation;
+            threadPool->parallelFor(searches.size(), [&](std::size_t i, unsigned int workerIndex) {
+                auto& plan = plans[searches[i]];
+                auto& workspace = workspaces[workerIndex];
+
+                if (plan.flowFieldIndex)
+                {
+                    const auto& query = *plan.query;
+                    if (auto flowPath = flowFields[*plan.flowFieldIndex].field.tracePath(Point(query.start.x, query.start.y)); flowPath)
+                    {
+                        auto tracedCells = static_cast<unsigned int>(flowPath->size());
+                        plan.result = toFindPathResult(constSimulation, nullptr, query, GridAStarPathInfo{AStarPathType::Complete, std::move(*flowPath), tracedCells});
+                        return;
+                    }
+                }
+
+                auto path = searchPath(constSimulation, workspace, *plan.query);
+                if (plan.cacheKey && path.type == AStarPathType::Complete)
+                {
+                    plan.cacheablePath = path.path;
+                }
+                plan.result = toFindPathResult(constSimulation, &workspace, *plan.query, std::move(path));
+            });
+
+            threadPool->parallelFor(joins.size(), [&](std::size_t i, unsigned int workerIndex) {
+                auto& plan = plans[joins[i]];
+                auto& workspace = workspaces[workerIndex];
+                const auto* cachedPath = plan.leader ? &plans[*plan.leader].cacheablePath : plan.cachedPath;
+
+                unsigned int failedJoinCost = 0;
+                auto path = joinPath(constSimulation, workspace, *plan.query, *cachedPath, failedJoinCost);
+                if (!path)
+                {
+                    path = searchPath(constSimulation, workspace, *plan.query);
+                    path->closedVertexCount += failedJoinCost;
+                }
+                plan.result = toFindPathResult(constSimulation, &workspace, *plan.query, std::move(*path));
+            });
+
+            // Commit in request order, stopping exactly where serving the requests
+            // one at a time would have stopped.
+            // Results past that point are thrown away and computed again next tick.
+            for (std::size_t i = 0; i < batchSize && remainingBudget > 0; ++i)
             {
-                // Unit that made the request no longer exists.
-                // Possibly the unit died. Just skip it.
+                auto& request = requests.front();
+                auto& plan = plans[i];
+                if (plan.result)
+                {
+                    auto& movingState = std::get<NavigationStateMoving>(simulation.getUnitState(request.unitId).navigationState.state);
+                    movingState.path = PathFollowingInfo(std::move(plan.result->path), simulation.gameTime);
+                    movingState.pathRequested = false;
+                    simulation.markUnitChanged(request.unitId);
+
+                    remainingBudget -= static_cast<int>(plan.result->closedVertexCount);
+
+                    if (plan.result->debugInfo)
+                    {
+                        lastPathDebugInfo = std::move(*plan.result->debugInfo);
+                    }
+
+                    if (!plan.cacheablePath.empty())
+                    {
+                        pathCache.insert(*plan.cacheKey, plan.cacheablePath, simulation.gameTime);
+                    }
+                }
+
                 requests.pop_front();
-                continue;
             }
+        }
+    }
+
+    std::optional<PathFindingService::PathQuery> PathFindingService::makeQuery(const GameSimulation& simulation, UnitId unitId) const
+    {
+        auto unit = simulation.tryGetUnitState(unitId);
+        if (!unit)
+        {
+            // Unit that made the request no longer exists.
+            // Possibly the unit died. Just skip it.
+            return std::nullopt;
+        }
 
-            if (auto movingState = std::get_if<NavigationStateMoving>(&unit->get().navigationState.state); movingState != nullptr)
+        auto movingState = std::get_if<NavigationStateMoving>(&unit->get().navigationState.state);
+        if (movingState == nullptr)
+        {
+            return std::nullopt;
+        }
+
+        const auto& unitDefinition = simulation.unitDefinitions.get(unit->get().unitType);
+        auto start = simulation.computeFootprintRegion(unit->get().position, unitDefinition.movementCollisionInfo);
+
+        auto goal = match(
+            movingState->pathDestination,
+            [&](const SimVector& pos) {
+                return simulation.computeFootprintRegion(pos, unitDefinition.movementCollisionInfo);
+            },
+            [&](const DiscreteRect& rect) {
+                // expand the goal rect to take into account our own collision rect
+                return rect.expandTopLeft(start.width, start.height);
+            });
+
+        return PathQuery{unitId, unit->get().position, getNamedMovementClass(unitDefinition), start, goal, movingState->pathDestination};
+    }
+
+    std::optional<PathCacheKey> PathFindingService::getCacheKey(const PathQuery& query) const
+    {
+        if (!query.movementClass)
+        {
+            return std::nullopt;
+        }
+
+        return PathCacheKey{
+            *query.movementClass,
+            query.start.width,
+            query.start.height,
+            PathCache::toCell(Point(query.start.x, query.start.y)),
+            query.goal,
+            std::holds_alternative<DiscreteRect>(query.destination)};
+    }
+
+    std::optional<FlowFieldKey> PathFindingService::getFlowFieldKey(const PathQuery& query) const
+    {
+        if (!query.movementClass)
+        {
+            return std::nullopt;
+        }
+
+        return FlowFieldKey{*query.movementClass, query.goal, std::holds_alternative<DiscreteRect>(query.destination)};
+    }
+
+    std::optional<std::size_t> PathFindingService::getFlowField(const GameSimulation& simulation, const FlowFieldKey& key, bool createIfMissing)
+    {
+        auto it = std::find_if(flowFields.begin(), flowFields.end(), [&](const auto& e) { return e.key == key; });
+        if (it != flowFields.end())
+        {
+            return it - flowFields.begin();
+        }
+
+        if (!createIfMissing)
+        {
+            return std::nullopt;
+        }
+
+        const auto& goal = key.goal;
+        std::vector<Point> goalCells;
+        if (key.goalIsRect)
+        {
+            for (int y = goal.y; y <= goal.y + goal.height; ++y)
             {
-                auto path = match(
-                    movingState->pathDestination,
-                    [&](const SimVector& pos) {
-                        return findPath(simulation, request.unitId, pos);
-                    },
-                    [&](const DiscreteRect& pos) {
-                        return findPath(simulation, request.unitId, pos);
-                    });
-
-                movingState->path = PathFollowingInfo(std::move(path), simulation.gameTime);
-                movingState->pathRequested = false;
-
-                // HACK: we know that lastPathDebugInfo is set by the call to findPath,
-                // so we'll exploit it here to deduct from out budget.
-                remainingBudget -= getSize(lastPathDebugInfo.closedVertices);
+                for (int x = goal.x; x <= goal.x + goal.width; ++x)
+                {
+                    if (goal.topLeftTouchesPerimeter(x, y))
+                    {
+                        goalCells.emplace_back(x, y);
+                    }
+                }
             }
+        }
+        else
+        {
+            goalCells.emplace_back(goal.x, goal.y);
+        }
 
-            requests.pop_front();
+        // The cluster graph's grid already holds the static passability for the movement class.
+        const auto& passable = clusterGraphs.at(key.movementClass).getPassableGrid();
+        flowFields.push_back(FlowFieldEntry{key, FlowField(passable, goalCells), simulation.gameTime});
+        return flowFields.size() - 1;
+    }
+
+    void PathFindingService::removeExpiredFlowFields(GameTime now)
+    {
+        flowFields.erase(
+            std::remove_if(flowFields.begin(), flowFields.end(), [&](const auto& e) { return now - e.creationTime >= GameTime(FlowFieldMaxAgeTicks); }),
+            flowFields.end());
+
+        while (flowFields.size() > MaxFlowFields)
+        {
+            auto it = std::min_element(flowFields.begin(), flowFields.end(), [](const auto& a, const auto& b) { return a.creationTime < b.creationTime; });
+            flowFields.erase(it);
         }
     }
 
-    UnitPath PathFindingService::findPath(const GameSimulation& simulation, UnitId unitId, const DiscreteRect& destination)
+    GridAStarPathInfo PathFindingService::searchPath(const GameSimulation& simulation, GridAStarWorkspace& workspace, const PathQuery& query) const
+    {
+        const auto& start = query.start;
+        const auto& goal = query.goal;
+        Point startPoint(start.x, start.y);
+
+        return match(
+            query.destination,
+            [&](const SimVector&) {
+                Point goalPoint(goal.x, goal.y);
+
+                std::optional<GridAStarPathInfo> hierarchicalPath;
+                unsigned int graphSearchCost = 0;
+                if (query.movementClass && isLongDistance(octileDistance(startPoint, goalPoint)))
+                {
+                    hierarchicalPath = findHierarchicalPath(simulation, workspace, query.unitId, *query.movementClass, start, goalPoint, std::nullopt, graphSearchCost);
+                }
+
+                auto path = hierarchicalPath
+                    ? std::move(*hierarchicalPath)
+                    : UnitPathFinder(&workspace, &simulation, &simulation.movementClassCollisionService, query.unitId, query.movementClass, start.width, start.height, goalPoint).findPath(startPoint);
+                path.closedVertexCount += graphSearchCost;
+                return path;
+            },
+            [&](const DiscreteRect&) {
+                std::optional<GridAStarPathInfo> hierarchicalPath;
+                unsigned int graphSearchCost = 0;
+                if (query.movementClass && isLongDistance(goal.octileDistanceToTopLeftTouching(start.x, start.y)))
+                {
+                    const auto& graph = clusterGraphs.at(*query.movementClass);
+                    if (auto goalCell = findNearestPassablePerimeterCell(graph, goal, startPoint); goalCell)
+                    {
+                        hierarchicalPath = findHierarchicalPath(simulation, workspace, query.unitId, *query.movementClass, start, *goalCell, goal, graphSearchCost);
+                    }
+                }
+
+                auto path = hierarchicalPath
+                    ? std::move(*hierarchicalPath)
+                    : UnitPerimeterPathFinder(&workspace, &simulation, &simulation.movementClassCollisionService, query.unitId, query.movementClass, start.width, start.height, goal).findPath(startPoint);
+                path.closedVertexCount += graphSearchCost;
+                return path;
+            });
+    }
+
+    std::optional<GridAStarPathInfo> PathFindingService::joinPath(
+        const GameSimulation& simulation,
+        GridAStarWorkspace& workspace,
+        const PathQuery& query,
+        const std::vector<Point>& path,
+        unsigned int& failedJoinCost) const
     {
-        const auto& unit = simulation.getUnitState(unitId);
-        const auto& unitDefinition = simulation.unitDefinitions.at(unit.unitType);
+        auto exitIndex = PathCache::findExitIndex(path);
+        if (!exitIndex)
+        {
+            return std::nullopt;
+        }
 
-        auto start = simulation.computeFootprintRegion(unit.position, unitDefinition.movementCollisionInfo);
-        // expand the goal rect to take into account our own collision rect
-        auto goal = destination.expandTopLeft(start.width, start.height);
+        const auto& start = query.start;
+        auto join = UnitPathFinder(&workspace, &simulation, &simulation.movementClassCollisionService, query.unitId, query.movementClass, start.width, start.height, path[*exitIndex]).findPath(Point(start.x, start.y));
+        if (join.type != AStarPathType::Complete)
+        {
+            failedJoinCost = join.closedVertexCount;
+            return std::nullopt;
+        }
 
-        auto movementClassId = match(
-            unitDefinition.movementCollisionInfo, [&](const UnitDefinition::NamedMovementClass& mc) { return std::make_optional(mc.movementClassId); }, [&](const auto&) { return std::optional<MovementClassId>(); });
+        join.path.insert(join.path.end(), path.begin() + *exitIndex + 1, path.end());
+        return join;
+    }
 
-        UnitPerimeterPathFinder pathFinder(&simulation, &simulation.movementClassCollisionService, unitId, movementClassId, start.width, start.height, goal);
+    PathFindingService::FindPathResult PathFindingService::toFindPathResult(const GameSimulation& simulation, const GridAStarWorkspace* workspace, const PathQuery& query, GridAStarPathInfo&& path) const
+    {
+        auto debugInfo = getDebugInfo(workspace, path);
+
+        const auto& start = query.start;
+        const auto& goal = query.goal;
+        auto destination = std::get_if<SimVector>(&query.destination);
 
-        auto path = pathFinder.findPath(Point(start.x, start.y));
-        lastPathDebugInfo = AStarPathInfo<Point, PathCost>{path.type, path.path, std::move(path.closedVertices)};
+        if (destination != nullptr && path.type == AStarPathType::Partial)
+        {
+            path.path.emplace_back(goal.x, goal.y);
+        }
 
         assert(path.path.size() >= 1);
 
         if (path.path.size() == 1)
         {
             // The path is trivial, we are already at the goal.
-            return UnitPath{std::vector<SimVector>{unit.position}};
+            auto position = destination != nullptr ? *destination : query.position;
+            return FindPathResult{UnitPath{std::vector<SimVector>{position}}, path.closedVertexCount, std::move(debugInfo)};
         }
 
         auto simplifiedPath = runSimplifyPath(path.path);
@@ -82,51 +502,187 @@ namespace rwe
             waypoints.push_back(getWorldCenter(simulation, DiscreteRect(it->x, it->y, start.width, start.height)));
         }
 
-        return UnitPath{std::move(waypoints)};
+        if (destination != nullptr)
+        {
+            waypoints.back() = *destination;
+        }
+
+        return FindPathResult{UnitPath{std::move(waypoints)}, path.closedVertexCount, std::move(debugInfo)};
     }
 
-    UnitPath PathFindingService::findPath(const GameSimulation& simulation, UnitId unitId, const SimVector& destination)
+    void PathFindingService::notifyObstaclesChanged(const DiscreteRect& area)
     {
-        const auto& unit = simulation.getUnitState(unitId);
-        const auto& unitDefinition = simulation.unitDefinitions.at(unit.unitType);
+        pathCache.invalidate(area);
 
-        auto start = simulation.computeFootprintRegion(unit.position, unitDefinition.movementCollisionInfo);
-        auto goal = simulation.computeFootprintRegion(destination, unitDefinition.movementCollisionInfo);
+        // Flow fields cover the whole map, so any change may affect them.
+        flowFields.clear();
 
-        auto movementClassId = match(
-            unitDefinition.movementCollisionInfo, [&](const UnitDefinition::NamedMovementClass& mc) { return std::make_optional(mc.movementClassId); }, [&](const auto&) { return std::optional<MovementClassId>(); });
+        // Graphs built later will see the change anyway.
+        if (clusterGraphs.empty())
+        {
+            return;
+        }
 
-        UnitPathFinder pathFinder(&simulation, &simulation.movementClassCollisionService, unitId, movementClassId, start.width, start.height, Point(goal.x, goal.y));
+        changedObstacleAreas.push_back(area);
+    }
 
-        auto path = pathFinder.findPath(Point(start.x, start.y));
-        lastPathDebugInfo = AStarPathInfo<Point, PathCost>{path.type, path.path, std::move(path.closedVertices)};
+    void writeSnapshot(SnapshotWriter& w, const FlowFieldKey& key)
+    {
+        writeSnapshot(w, key.movementClass);
+        writeSnapshot(w, key.goal);
+        writeSnapshot(w, key.goalIsRect);
+    }
 
-        if (path.type == AStarPathType::Partial)
+    FlowFieldKey readSnapshot(SnapshotReader& r, SnapshotTag<FlowFieldKey>)
+    {
+        auto movementClass = readSnapshotValue<MovementClassId>(r);
+        auto goal = readSnapshotValue<DiscreteRect>(r);
+        auto goalIsRect = readSnapshotValue<bool>(r);
+        return FlowFieldKey{movementClass, goal, goalIsRect};
+    }
+
+    void PathFindingService::saveSnapshot(SnapshotWriter& w) const
+    {
+        pathCache.saveSnapshot(w);
+
+        writeSnapshotSize(w, flowFields.size());
+        for (const auto& entry : flowFields)
         {
-            path.path.emplace_back(goal.x, goal.y);
+            writeSnapshot(w, entry.key);
+            entry.field.saveSnapshot(w);
+            writeSnapshot(w, entry.creationTime);
         }
+    }
 
-        assert(path.path.size() >= 1);
+    void PathFindingService::restoreSnapshot(SnapshotReader& r)
+    {
+        pathCache.restoreSnapshot(r);
 
-        if (path.path.size() == 1)
+        flowFields.clear();
+        auto flowFieldCount = readSnapshotSize(r);
+        for (std::size_t i = 0; i < flowFieldCount; ++i)
         {
-            // The path is trivial, we are already at the goal.
-            return UnitPath{std::vector<SimVector>{destination}};
+            auto key = readSnapshotValue<FlowFieldKey>(r);
+            auto field = FlowField::restoreSnapshot(r);
+            auto creationTime = readSnapshotValue<GameTime>(r);
+            flowFields.push_back(FlowFieldEntry{key, std::move(field), creationTime});
         }
 
-        auto simplifiedPath = runSimplifyPath(path.path);
+        clusterGraphs.clear();
+        changedObstacleAreas.clear();
+        lastPathDebugInfo = AStarPathInfo<Point, PathCost>();
+    }
 
-        std::vector<SimVector> waypoints;
-        for (auto it = ++simplifiedPath.cbegin(); it != simplifiedPath.cend(); ++it)
+    void PathFindingService::buildClusterGraph(const GameSimulation& simulation, MovementClassId movementClass)
+    {
+        if (clusterGraphs.find(movementClass) != clusterGraphs.end())
         {
-            waypoints.push_back(getWorldCenter(simulation, DiscreteRect(it->x, it->y, start.width, start.height)));
+            return;
+        }
+
+        const auto& walkableGrid = simulation.movementClassCollisionService.getGrid(movementClass);
+        auto passable = Grid<char>::from(walkableGrid.getWidth(), walkableGrid.getHeight(), [&](const auto& c) {
+            return static_cast<char>(isStaticallyPassable(simulation, movementClass, Point(c.x, c.y)));
+        });
+
+        clusterGraphs.emplace(movementClass, ClusterGraph(std::move(passable)));
+    }
+
+    void PathFindingService::repairClusterGraphs(const GameSimulation& simulation)
+    {
+        if (changedObstacleAreas.empty())
+        {
+            return;
+        }
+
+        for (auto& [movementClass, graph] : clusterGraphs)
+        {
+            const auto& movementClassDefinition = simulation.movementClassDatabase.getMovementClass(movementClass);
+            int footprintX = movementClassDefinition.footprintX;
+            int footprintZ = movementClassDefinition.footprintZ;
+
+            for (const auto& area : changedObstacleAreas)
+            {
+                // A cell is affected if the footprint placed there overlaps the area.
+                for (int y = area.y - footprintZ + 1; y < area.y + area.height; ++y)
+                {
+                    for (int x = area.x - footprintX + 1; x < area.x + area.width; ++x)
+                    {
+                        Point p(x, y);
+                        if (graph.contains(p))
+                        {
+                            graph.setPassable(p, isStaticallyPassable(simulation, movementClass, p));
+                        }
+                    }
+                }
+            }
+
+            graph.repair();
+        }
+
+        changedObstacleAreas.clear();
+    }
+
+    std::optional<GridAStarPathInfo> PathFindingService::findHierarchicalPath(
+        const GameSimulation& simulation,
+        GridAStarWorkspace& workspace,
+        UnitId unitId,
+        MovementClassId movementClass,
+        const DiscreteRect& start,
+        const Point& goal,
+        const std::optional<DiscreteRect>& goalRect,
+        unsigned int& graphSearchCost) const
+    {
+        const auto& graph = clusterGraphs.at(movementClass);
+
+        auto waypoints = graph.findPath(Point(start.x, start.y), goal, graphSearchCost);
+        if (!waypoints)
+        {
+            return std::nullopt;
+        }
+
+        GridAStarPathInfo result{AStarPathType::Complete, std::vector<Point>{Point(start.x, start.y)}, 0};
+        for (std::size_t i = 1; i < waypoints->size(); ++i)
+        {
+            auto segmentStart = result.path.back();
+            auto isFinalSegment = i == waypoints->size() - 1;
+
+            auto segment = isFinalSegment && goalRect
+                ? UnitPerimeterPathFinder(&workspace, &simulation, &simulation.movementClassCollisionService, unitId, movementClass, start.width, start.height, *goalRect).findPath(segmentStart)
+                : UnitPathFinder(&workspace, &simulation, &simulation.movementClassCollisionService, unitId, movementClass, start.width, start.height, (*waypoints)[i]).findPath(segmentStart);
+
+            result.closedVertexCount += segment.closedVertexCount;
+            result.path.insert(result.path.end(), segment.path.begin() + 1, segment.path.end());
+
+            if (segment.type == AStarPathType::Partial)
+            {
+                // Something not in the abstract graph, such as another unit, is in the way.
+                // Stop at the furthest point we got to.
+                result.type = AStarPathType::Partial;
+                break;
+            }
+        }
+
+        return result;
+    }
+
+    std::optional<AStarPathInfo<Point, PathCost>> PathFindingService::getDebugInfo(const GridAStarWorkspace* workspace, const GridAStarPathInfo& path) const
+    {
+        if (!debugInfoEnabled)
+        {
+            return std::nullopt;
+        }
+
+        if (workspace == nullptr)
+        {
+            return AStarPathInfo<Point, PathCost>{path.type, path.path, {}};
         }
-        waypoints.back() = destination;
 
-        return UnitPath{std::move(waypoints)};
+        // For hierarchical searches, the closed set is that of the final leg.
+        return AStarPathInfo<Point, PathCost>{path.type, path.path, workspace->getClosedVertices()};
     }
 
-    SimVector PathFindingService::getWorldCenter(const GameSimulation& simulation, const DiscreteRect& rect)
+    SimVector PathFindingService::getWorldCenter(const GameSimulation& simulation, const DiscreteRect& rect) const
     {
         auto corner = simulation.terrain.heightmapIndexToWorldCorner(rect.x, rect.y);
 
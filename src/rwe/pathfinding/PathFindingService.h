@@ -3,27 +3,261 @@
 #include <rwe/grid/DiscreteRect.h>
 #include <rwe/grid/Point.h>
 #include <rwe/pathfinding/AStarPathFinder.h>
+#include <rwe/pathfinding/ClusterGraph.h>
+#include <rwe/pathfinding/FlowField.h>
+#include <rwe/pathfinding/GridAStarPathFinder.h>
+#include <rwe/pathfinding/PathCache.h>
 #include <rwe/pathfinding/PathCost.h>
 #include <rwe/pathfinding/UnitPath.h>
 #include <rwe/sim/MovementClassCollisionService.h>
+#include <rwe/sim/GameTime.h>
+#include <rwe/sim/MovementClassId.h>
 #include <rwe/sim/SimVector.h>
 #include <rwe/sim/UnitId.h>
+#include <rwe/sim/UnitState.h>
+#include <rwe/util/ThreadPool.h>
+#include <rwe/util/hash_combine.h>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace rwe
+{
+    struct FlowFieldKey
+    {
+        MovementClassId movementClass;
+
+        /**
+         * The footprint at the destination point,
+         * or the destination rect expanded by the footprint.
+         */
+        DiscreteRect goal;
+        bool goalIsRect;
+
+        bool operator==(const FlowFieldKey& rhs) const;
+
+        bool operator!=(const FlowFieldKey& rhs) const;
+    };
+}
+
+namespace std
+{
+    template <>
+    struct hash<rwe::FlowFieldKey>
+    {
+        std::size_t operator()(const rwe::FlowFieldKey& k) const noexcept
+        {
+            std::size_t seed = 0;
+            rwe::hashCombine(seed, std::hash<rwe::MovementClassId>{}(k.movementClass));
+            rwe::hashCombine(seed, std::hash<rwe::DiscreteRect>{}(k.goal));
+            rwe::hashCombine(seed, std::hash<bool>{}(k.goalIsRect));
+            return seed;
+        }
+    };
+}
 
 namespace rwe
 {
     struct GameSimulation;
+    class SnapshotReader;
+    class SnapshotWriter;
 
     class PathFindingService
     {
+    private:
+        struct FindPathResult
+        {
+            UnitPath path;
+            unsigned int closedVertexCount;
+            std::optional<AStarPathInfo<Point, PathCost>> debugInfo;
+        };
+
+        /** Everything a search needs to know about a request. */
+        struct PathQuery
+        {
+            UnitId unitId;
+            SimVector position;
+            std::optional<MovementClassId> movementClass;
+            DiscreteRect start;
+
+            /**
+             * The footprint at the destination point,
+             * or the destination rect expanded by our footprint.
+             */
+            DiscreteRect goal;
+
+            PathDestination destination;
+        };
+
+        struct PlannedRequest
+        {
+            /** Empty if the unit no longer exists or no longer wants a path. */
+            std::optional<PathQuery> query;
+
+            /** The flow field this request follows, if it is for a new goal shared by a large group. */
+            std::optional<std::size_t> flowFieldIndex;
+
+            std::optional<PathCacheKey> cacheKey;
+
+            /** A cached path for this request to join, if there is one. */
+            const std::vector<Point>* cachedPath{nullptr};
+
+            /**
+             * An earlier request in the batch with the same cache key.
+             * This request joins the path that one finds instead of searching itself.
+             */
+            std::optional<std::size_t> leader;
+
+            /** The path found by this request, if it is worth caching. */
+            std::vector<Point> cacheablePath;
+
+            std::optional<FindPathResult> result;
+        };
+
+        struct FlowFieldEntry
+        {
+            FlowFieldKey key;
+            FlowField field;
+            GameTime creationTime;
+        };
+
+        /** Runs the searches for each batch of requests in parallel. Created on first use. */
+        std::unique_ptr<ThreadPool> threadPool;
+
+        /** Search scratch space for each thread in the pool. */
+        std::vector<GridAStarWorkspace> workspaces;
+
+        /**
+         * Abstract graphs of the static obstacles on the map
+         * (terrain, buildings and blocking features),
+         * built on first use for each movement class.
+         * Mobile units are left to the local searches that refine abstract paths.
+         */
+        std::unordered_map<MovementClassId, ClusterGraph> clusterGraphs;
+
+        /** Areas where buildings or features have changed since the graphs were last repaired. */
+        std::vector<DiscreteRect> changedObstacleAreas;
+
+        /**
+         * Recent paths, reused by units starting near each other
+         * and heading for the same place, such as a group given one move order.
+         */
+        PathCache pathCache;
+
+        /**
+         * Flow fields for destinations shared by many units given the same move order.
+         * Only added to during an update, so that requests can refer to them by index.
+         */
+        std::vector<FlowFieldEntry> flowFields;
+
     public:
+        /**
+         * Info about the most recent search, for the pathfinding visualisation.
+         * Only filled in while debugInfoEnabled is set,
+         * since building the closed set is expensive.
+         */
         AStarPathInfo<Point, PathCost> lastPathDebugInfo;
 
+        bool debugInfoEnabled{false};
+
         void update(GameSimulation& simulation);
 
+        /**
+         * Tells the service that a building or feature has appeared,
+         * disappeared or changed within the given area.
+         * The abstract graphs are repaired at the start of the next update
+         * and cached paths and flow fields affected by it are forgotten.
+         */
+        void notifyObstaclesChanged(const DiscreteRect& area);
+
+        /**
+         * Writes the cached paths and flow fields,
+         * since whether a request finds one decides the path it gets.
+         * The abstract graphs are not written.
+         * They are rebuilt on first use after a restore,
+         * and a rebuilt graph is identical to a repaired one.
+         */
+        void saveSnapshot(SnapshotWriter& w) const;
+
+        void restoreSnapshot(SnapshotReader& r);
+
     private:
-        UnitPath findPath(const GameSimulation& simulation, UnitId unitId, const SimVector& destination);
-        UnitPath findPath(const GameSimulation& simulation, UnitId unitId, const DiscreteRect& destination);
+        /**
+         * Gathers what is needed to serve the request.
+         * Returns nothing if the unit no longer exists or no longer wants a path.
+         */
+        std::optional<PathQuery> makeQuery(const GameSimulation& simulation, UnitId unitId) const;
+
+        /** Returns the key under which paths for the query are cached, or nothing if they are not. */
+        std::optional<PathCacheKey> getCacheKey(const PathQuery& query) const;
+
+        /**
+         * Searches all the way from the start to the goal.
+         * Like the other search functions, this modifies nothing except the workspace,
+         * so that requests can be served in parallel.
+         */
+        GridAStarPathInfo searchPath(const GameSimulation& simulation, GridAStarWorkspace& workspace, const PathQuery& query) const;
+
+        /**
+         * Searches from the start to the point where the given path
+         * leaves its starting coarse cell, then follows the path from there.
+         * Returns nothing if the join point cannot be reached,
+         * in which case failedJoinCost is set to the cost of the failed search.
+         */
+        std::optional<GridAStarPathInfo> joinPath(
+            const GameSimulation& simulation,
+            GridAStarWorkspace& workspace,
+            const PathQuery& query,
+            const std::vector<Point>& path,
+            unsigned int& failedJoinCost) const;
+
+        /**
+         * Converts a grid path into waypoints for the unit.
+         * The workspace is that of the search that found the path,
+         * or null if the path did not come from a search.
+         */
+        FindPathResult toFindPathResult(const GameSimulation& simulation, const GridAStarWorkspace* workspace, const PathQuery& query, GridAStarPathInfo&& path) const;
+
+        /** Returns the key of the flow field that could serve the query, or nothing if it has none. */
+        std::optional<FlowFieldKey> getFlowFieldKey(const PathQuery& query) const;
+
+        /**
+         * Returns the index of the flow field for the key.
+         * If there is none, builds one if createIfMissing is set,
+         * otherwise returns nothing.
+         */
+        std::optional<std::size_t> getFlowField(const GameSimulation& simulation, const FlowFieldKey& key, bool createIfMissing);
+
+        /** Drops flow fields that were built too long ago, and the oldest if there are too many. */
+        void removeExpiredFlowFields(GameTime now);
+
+        /** Builds the graph for the movement class if it does not exist yet. */
+        void buildClusterGraph(const GameSimulation& simulation, MovementClassId movementClass);
+
+        void repairClusterGraphs(const GameSimulation& simulation);
+
+        /**
+         * Finds a route to the goal through the abstract graph,
+         * then refines each leg of it with a local search.
+         * If goalRect is given, the final leg searches for its perimeter
+         * rather than for the goal cell.
+         * Returns nothing if the abstract graph has no route.
+         *
+         * graphSearchCost is set to the number of nodes the abstract search expanded.
+         * It is not included in the returned path's closed vertex count.
+         */
+        std::optional<GridAStarPathInfo> findHierarchicalPath(
+            const GameSimulation& simulation,
+            GridAStarWorkspace& workspace,
+            UnitId unitId,
+            MovementClassId movementClass,
+            const DiscreteRect& start,
+            const Point& goal,
+            const std::optional<DiscreteRect>& goalRect,
+            unsigned int& graphSearchCost) const;
+
+        std::optional<AStarPathInfo<Point, PathCost>> getDebugInfo(const GridAStarWorkspace* workspace, const GridAStarPathInfo& path) const;
 
-        SimVector getWorldCenter(const GameSimulation& simulation, const DiscreteRect& discreteRect);
+        SimVector getWorldCenter(const GameSimulation& simulation, const DiscreteRect& discreteRect) const;
     };
 }
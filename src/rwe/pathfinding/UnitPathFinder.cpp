@@ -3,6 +3,7 @@
 namespace rwe
 {
     UnitPathFinder::UnitPathFinder(
+        GridAStarWorkspace* workspace,
         const GameSimulation* simulation,
         const MovementClassCollisionService* collisionService,
         UnitId self,
@@ -11,6 +12,7 @@ namespace rwe
         unsigned int footprintZ,
         const Point& goal)
         : AbstractUnitPathFinder(
+            workspace,
             simulation,
             collisionService,
             self,
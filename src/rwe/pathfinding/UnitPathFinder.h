@@ -19,6 +19,7 @@ namespace rwe
 
     public:
         UnitPathFinder(
+            GridAStarWorkspace* workspace,
             const GameSimulation* simulation,
             const MovementClassCollisionService* collisionService,
             UnitId self,
@@ -3,6 +3,7 @@
 namespace rwe
 {
     UnitPerimeterPathFinder::UnitPerimeterPathFinder(
+        GridAStarWorkspace* workspace,
         const GameSimulation* simulation,
         const MovementClassCollisionService* collisionService,
         const UnitId& self,
@@ -10,7 +11,8 @@ namespace rwe
         unsigned int footprintX,
         unsigned int footprintZ,
         const DiscreteRect& goalRect)
-        : AbstractUnitPathFinder(simulation,
+        : AbstractUnitPathFinder(workspace,
+            simulation,
             collisionService,
             self,
             movementClass,
@@ -17,6 +17,7 @@ namespace rwe
     protected:
     public:
         UnitPerimeterPathFinder(
+            GridAStarWorkspace* workspace,
             const GameSimulation* simulation,
             const MovementClassCollisionService* collisionService,
             const UnitId& self,
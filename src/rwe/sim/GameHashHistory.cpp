@@ -0,0 +1,96 @@
+#include "GameHashHistory.h"
+#include <algorithm>
+
+namespace rwe
+{
+    void applyEntityChanges(std::map<uint32_t, GameHashTree::FieldHashes>& entities, const std::vector<GameHashDelta::Change>& changes, bool isComplete)
+    {
+        if (isComplete)
+        {
+            entities.clear();
+        }
+
+        for (const auto& [id, fieldHashes] : changes)
+        {
+            if (fieldHashes)
+            {
+                entities.insert_or_assign(id, *fieldHashes);
+            }
+            else
+            {
+                entities.erase(id);
+            }
+        }
+    }
+
+    std::vector<GameHashTree::Entity> toEntityList(const std::map<uint32_t, GameHashTree::FieldHashes>& entities)
+    {
+        // id values hold the slot index in their high bits,
+        // so the map's order is slot order.
+        return std::vector<GameHashTree::Entity>(entities.begin(), entities.end());
+    }
+
+    void GameHashHistory::push(GameTime gameTime, GameHashDelta&& delta)
+    {
+        deltas.emplace_back(gameTime, std::move(delta));
+    }
+
+    void GameHashHistory::forgetUntil(GameTime gameTime)
+    {
+        while (!deltas.empty() && deltas.front().first <= gameTime)
+        {
+            const auto& delta = deltas.front().second;
+            applyEntityChanges(baseUnits, delta.units, delta.isComplete);
+            applyEntityChanges(baseProjectiles, delta.projectiles, delta.isComplete);
+            deltas.pop_front();
+        }
+
+        if (cachedTree && cachedTree->first <= gameTime)
+        {
+            cachedTree = std::nullopt;
+        }
+    }
+
+    int GameHashHistory::size() const
+    {
+        return static_cast<int>(deltas.size());
+    }
+
+    std::optional<GameHashTree> GameHashHistory::buildTree(GameTime gameTime) const
+    {
+        auto end = std::find_if(deltas.begin(), deltas.end(), [&](const auto& p) { return p.first == gameTime; });
+        if (end == deltas.end())
+        {
+            return std::nullopt;
+        }
+        ++end;
+
+        auto units = baseUnits;
+        auto projectiles = baseProjectiles;
+        for (auto it = deltas.begin(); it != end; ++it)
+        {
+            const auto& delta = it->second;
+            applyEntityChanges(units, delta.units, delta.isComplete);
+            applyEntityChanges(projectiles, delta.projectiles, delta.isComplete);
+        }
+
+        const auto& delta = std::prev(end)->second;
+        auto players = delta.players;
+        return GameHashTree(delta.gameTimeHash, std::move(players), toEntityList(units), toEntityList(projectiles));
+    }
+
+    std::optional<std::vector<GameHashTree::Child>> GameHashHistory::getChildren(GameTime gameTime, const GameHashTree::Path& path) const
+    {
+        if (!cachedTree || cachedTree->first != gameTime)
+        {
+            auto tree = buildTree(gameTime);
+            if (!tree)
+            {
+                return std::nullopt;
+            }
+            cachedTree.emplace(gameTime, std::move(*tree));
+        }
+
+        return cachedTree->second.getChildren(path);
+    }
+}
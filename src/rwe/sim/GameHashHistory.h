@@ -0,0 +1,86 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <optional>
+#include <rwe/sim/GameHash.h>
+#include <rwe/sim/GameHashTree.h>
+#include <rwe/sim/GameTime.h>
+#include <utility>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * The hashes that went into the game hash of one tick
+     * that are needed to rebuild its GameHashTree later.
+     * Units and projectiles are only listed if their hash changed since the previous tick.
+     */
+    struct GameHashDelta
+    {
+        /** The id value of a unit or projectile and its field hashes, or nothing if it was removed. */
+        using Change = std::pair<uint32_t, std::optional<GameHashTree::FieldHashes>>;
+
+        GameHash gameTimeHash{0};
+
+        /** The field hashes of every player, by index. */
+        std::vector<GameHashTree::FieldHashes> players;
+
+        std::vector<Change> units;
+
+        std::vector<Change> projectiles;
+
+        /**
+         * True if every unit and projectile is listed,
+         * replacing the ones before rather than changing them,
+         * e.g. after a snapshot was restored.
+         */
+        bool isComplete{false};
+    };
+
+    /**
+     * Keeps enough of the local game hash of recent ticks
+     * to answer a peer's questions about any of their hash trees.
+     *
+     * Rather than a tree per tick, this keeps the hashes of every entity
+     * as of the oldest tick that might still be asked about,
+     * plus the delta of each tick since.
+     * A tree is rebuilt from these when a peer asks about its tick.
+     */
+    class GameHashHistory
+    {
+    private:
+        /** The field hashes of each unit, by id value, as of the last forgotten tick. */
+        std::map<uint32_t, GameHashTree::FieldHashes> baseUnits;
+
+        /** The field hashes of each projectile, by id value, as of the last forgotten tick. */
+        std::map<uint32_t, GameHashTree::FieldHashes> baseProjectiles;
+
+        std::deque<std::pair<GameTime, GameHashDelta>> deltas;
+
+        /** The tree most recently asked about, since a desync search asks about one tick repeatedly. */
+        mutable std::optional<std::pair<GameTime, GameHashTree>> cachedTree;
+
+    public:
+        /** Adds the delta of the next tick. */
+        void push(GameTime gameTime, GameHashDelta&& delta);
+
+        /**
+         * Folds the deltas of ticks up to and including the given time into the base,
+         * after which their trees can no longer be asked about.
+         */
+        void forgetUntil(GameTime gameTime);
+
+        /** The number of ticks whose trees can be asked about. */
+        int size() const;
+
+        /** Rebuilds the hash tree of the given tick, or returns nothing if the tick is not held. */
+        std::optional<GameHashTree> buildTree(GameTime gameTime) const;
+
+        /**
+         * Returns the children of the node at the given path in the tree of the given tick,
+         * or nothing if the tick is not held or there is no such node.
+         */
+        std::optional<std::vector<GameHashTree::Child>> getChildren(GameTime gameTime, const GameHashTree::Path& path) const;
+    };
+}
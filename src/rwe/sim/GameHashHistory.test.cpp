@@ -0,0 +1,68 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/sim/GameHashHistory.h>
+
+namespace rwe
+{
+    GameHashDelta createTestDelta(uint32_t gameTime, std::vector<GameHashDelta::Change>&& units)
+    {
+        GameHashDelta delta;
+        delta.gameTimeHash = GameHash(gameTime);
+        delta.players = {{GameHash(gameTime * 10)}};
+        delta.units = std::move(units);
+        return delta;
+    }
+
+    TEST_CASE("GameHashHistory")
+    {
+        auto unitsSection = static_cast<uint32_t>(GameHashTree::Section::Units);
+
+        GameHashHistory history;
+        history.push(GameTime(1), createTestDelta(1, {{0x101, {{GameHash(1), GameHash(10)}}}, {0x202, {{GameHash(2), GameHash(20)}}}}));
+        history.push(GameTime(2), createTestDelta(2, {{0x101, {{GameHash(1), GameHash(11)}}}}));
+        history.push(GameTime(3), createTestDelta(3, {{0x202, std::nullopt}, {0x301, {{GameHash(3), GameHash(30)}}}}));
+
+        SECTION("rebuilds the tree of each tick from the changes up to it")
+        {
+            auto first = history.buildTree(GameTime(1));
+            REQUIRE(first);
+            REQUIRE(first->getRootHash() == GameHash(1 + 10 + 11 + 22));
+            REQUIRE(first->getChildren({unitsSection, 0}) == std::vector<GameHashTree::Child>{{0x101, GameHash(11)}, {0x202, GameHash(22)}});
+
+            auto second = history.buildTree(GameTime(2));
+            REQUIRE(second);
+            REQUIRE(second->getChildren({unitsSection, 0, 0x101}) == std::vector<GameHashTree::Child>{{0, GameHash(1)}, {1, GameHash(11)}});
+            REQUIRE(second->getChildren({unitsSection, 0, 0x202}) == std::vector<GameHashTree::Child>{{0, GameHash(2)}, {1, GameHash(20)}});
+
+            auto third = history.buildTree(GameTime(3));
+            REQUIRE(third);
+            REQUIRE(third->getChildren({unitsSection, 0}) == std::vector<GameHashTree::Child>{{0x101, GameHash(12)}, {0x301, GameHash(33)}});
+        }
+
+        SECTION("keeps answering about later ticks after forgetting earlier ones")
+        {
+            auto before = history.buildTree(GameTime(3));
+            history.forgetUntil(GameTime(2));
+            REQUIRE(history.size() == 1);
+            REQUIRE(!history.buildTree(GameTime(2)));
+            REQUIRE(!history.getChildren(GameTime(1), {}));
+
+            auto after = history.buildTree(GameTime(3));
+            REQUIRE(after);
+            REQUIRE(after->getRootHash() == before->getRootHash());
+            REQUIRE(history.getChildren(GameTime(3), {unitsSection, 0}) == before->getChildren({unitsSection, 0}));
+        }
+
+        SECTION("replaces every entity with a complete delta")
+        {
+            auto delta = createTestDelta(4, {{0x401, {{GameHash(4)}}}});
+            delta.isComplete = true;
+            history.push(GameTime(4), std::move(delta));
+
+            REQUIRE(history.getChildren(GameTime(4), {unitsSection, 0}) == std::vector<GameHashTree::Child>{{0x401, GameHash(4)}});
+
+            history.forgetUntil(GameTime(4));
+            history.push(GameTime(5), createTestDelta(5, {}));
+            REQUIRE(history.getChildren(GameTime(5), {unitsSection, 0}) == std::vector<GameHashTree::Child>{{0x401, GameHash(4)}});
+        }
+    }
+}
@@ -0,0 +1,252 @@
+#include "GameHashTree.h"
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <rwe/sim/GameHash_util.h>
+#include <rwe/sim/GameSimulation.h>
+
+namespace rwe
+{
+    /** Returns the range an entity id falls in. Ids hold the slot index above the low 8 generation bits. */
+    uint32_t getHashTreeRange(uint32_t idValue)
+    {
+        return (idValue >> 8u) / GameHashTree::RangeSize;
+    }
+
+    GameHash sumFieldHashes(const GameHashTree::FieldHashes& fieldHashes)
+    {
+        GameHash sum(0);
+        for (const auto& hash : fieldHashes)
+        {
+            sum += hash;
+        }
+        return sum;
+    }
+
+    GameHash sumEntityHashes(const std::vector<GameHashTree::Entity>& entities)
+    {
+        GameHash sum(0);
+        for (const auto& entity : entities)
+        {
+            sum += sumFieldHashes(entity.second);
+        }
+        return sum;
+    }
+
+    /**
+     * Returns the children of a player, unit or projectile at the given depth of the path,
+     * or nothing if the path goes below the fields.
+     */
+    std::optional<std::vector<GameHashTree::Child>> getFieldChildren(const GameHashTree::FieldHashes& fieldHashes, const GameHashTree::Path& path, std::size_t depth)
+    {
+        if (path.size() == depth)
+        {
+            std::vector<GameHashTree::Child> children;
+            children.reserve(fieldHashes.size());
+            for (uint32_t i = 0; i < fieldHashes.size(); ++i)
+            {
+                children.emplace_back(i, fieldHashes[i]);
+            }
+            return children;
+        }
+
+        if (path.size() == depth + 1 && path[depth] < fieldHashes.size())
+        {
+            return std::vector<GameHashTree::Child>();
+        }
+
+        return std::nullopt;
+    }
+
+    /**
+     * Returns the children of the node at the given path below a units or projectiles section,
+     * with path[0] being the section itself.
+     */
+    std::optional<std::vector<GameHashTree::Child>> getEntityChildren(const std::vector<GameHashTree::Entity>& entities, const GameHashTree::Path& path)
+    {
+        if (path.size() == 1)
+        {
+            std::vector<GameHashTree::Child> ranges;
+            for (const auto& [id, fieldHashes] : entities)
+            {
+                auto range = getHashTreeRange(id);
+                if (ranges.empty() || ranges.back().first != range)
+                {
+                    ranges.emplace_back(range, GameHash(0));
+                }
+                ranges.back().second += sumFieldHashes(fieldHashes);
+            }
+            return ranges;
+        }
+
+        auto range = path[1];
+        auto begin = std::partition_point(entities.begin(), entities.end(), [&](const auto& e) { return getHashTreeRange(e.first) < range; });
+        auto end = std::partition_point(begin, entities.end(), [&](const auto& e) { return getHashTreeRange(e.first) == range; });
+        if (begin == end)
+        {
+            return std::nullopt;
+        }
+
+        if (path.size() == 2)
+        {
+            std::vector<GameHashTree::Child> children;
+            children.reserve(end - begin);
+            for (auto it = begin; it != end; ++it)
+            {
+                children.emplace_back(it->first, sumFieldHashes(it->second));
+            }
+            return children;
+        }
+
+        auto it = std::find_if(begin, end, [&](const auto& e) { return e.first == path[2]; });
+        if (it == end)
+        {
+            return std::nullopt;
+        }
+
+        return getFieldChildren(it->second, path, 3);
+    }
+
+    GameHashTree::GameHashTree(GameHash gameTimeHash, std::vector<FieldHashes>&& players, std::vector<Entity>&& units, std::vector<Entity>&& projectiles)
+        : gameTimeHash(gameTimeHash),
+          players(std::move(players)),
+          units(std::move(units)),
+          projectiles(std::move(projectiles))
+    {
+        for (const auto& fieldHashes : this->players)
+        {
+            playersHash += sumFieldHashes(fieldHashes);
+        }
+        unitsHash = sumEntityHashes(this->units);
+        projectilesHash = sumEntityHashes(this->projectiles);
+    }
+
+    GameHash GameHashTree::getRootHash() const
+    {
+        return gameTimeHash + playersHash + unitsHash + projectilesHash;
+    }
+
+    std::optional<std::vector<GameHashTree::Child>> GameHashTree::getChildren(const Path& path) const
+    {
+        if (path.empty())
+        {
+            return std::vector<Child>{
+                {static_cast<uint32_t>(Section::GameTime), gameTimeHash},
+                {static_cast<uint32_t>(Section::Players), playersHash},
+                {static_cast<uint32_t>(Section::Units), unitsHash},
+                {static_cast<uint32_t>(Section::Projectiles), projectilesHash},
+            };
+        }
+
+        switch (static_cast<Section>(path[0]))
+        {
+            case Section::GameTime:
+                return path.size() == 1 ? std::make_optional(std::vector<Child>()) : std::nullopt;
+            case Section::Players:
+                if (path.size() == 1)
+                {
+                    std::vector<Child> children;
+                    children.reserve(players.size());
+                    for (uint32_t i = 0; i < players.size(); ++i)
+                    {
+                        children.emplace_back(i, sumFieldHashes(players[i]));
+                    }
+                    return children;
+                }
+                return path[1] < players.size() ? getFieldChildren(players[path[1]], path, 2) : std::nullopt;
+            case Section::Units:
+                return getEntityChildren(units, path);
+            case Section::Projectiles:
+                return getEntityChildren(projectiles, path);
+            default:
+                return std::nullopt;
+        }
+    }
+
+    GameHashTree buildHashTree(const GameSimulation& simulation)
+    {
+        std::vector<GameHashTree::FieldHashes> players;
+        players.reserve(simulation.players.size());
+        for (const auto& player : simulation.players)
+        {
+            players.push_back(computeFieldHashes(player));
+        }
+
+        std::vector<GameHashTree::Entity> units;
+        for (const auto& [id, unit] : simulation.units)
+        {
+            units.emplace_back(id.value, computeEntityFieldHashes(id, unit));
+        }
+
+        std::vector<GameHashTree::Entity> projectiles;
+        for (const auto& [id, projectile] : simulation.projectiles)
+        {
+            projectiles.emplace_back(id.value, computeEntityFieldHashes(id, projectile));
+        }
+
+        return GameHashTree(computeHashOf(simulation.gameTime), std::move(players), std::move(units), std::move(projectiles));
+    }
+
+    template <std::size_t N>
+    std::string describeField(const std::array<const char*, N>& names, uint32_t key, bool hasId)
+    {
+        if (hasId)
+        {
+            if (key == 0)
+            {
+                return "id";
+            }
+            --key;
+        }
+
+        return key < names.size() ? names[key] : "field " + std::to_string(key);
+    }
+
+    std::string describeHashTreePath(const GameHashTree::Path& path)
+    {
+        if (path.empty())
+        {
+            return "game";
+        }
+
+        std::string description;
+        switch (static_cast<GameHashTree::Section>(path[0]))
+        {
+            case GameHashTree::Section::GameTime:
+                return "game time";
+            case GameHashTree::Section::Players:
+                description = "players";
+                if (path.size() > 1)
+                {
+                    description += " > player " + std::to_string(path[1]);
+                }
+                if (path.size() > 2)
+                {
+                    description += " > " + describeField(playerHashedFieldNames, path[2], false);
+                }
+                return description;
+            case GameHashTree::Section::Units:
+            case GameHashTree::Section::Projectiles:
+            {
+                auto isUnits = static_cast<GameHashTree::Section>(path[0]) == GameHashTree::Section::Units;
+                description = isUnits ? "units" : "projectiles";
+                if (path.size() > 1)
+                {
+                    auto firstSlot = path[1] * GameHashTree::RangeSize;
+                    description += " > slots " + std::to_string(firstSlot) + "-" + std::to_string(firstSlot + GameHashTree::RangeSize - 1);
+                }
+                if (path.size() > 2)
+                {
+                    description += (isUnits ? " > unit " : " > projectile ") + std::to_string(path[2]);
+                }
+                if (path.size() > 3)
+                {
+                    description += " > " + (isUnits ? describeField(unitHashedFieldNames, path[3], true) : describeField(projectileHashedFieldNames, path[3], true));
+                }
+                return description;
+            }
+            default:
+                return "unknown section " + std::to_string(path[0]);
+        }
+    }
+}
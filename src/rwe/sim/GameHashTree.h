@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <rwe/sim/GameHash.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace rwe
+{
+    class GameSimulation;
+
+    /**
+     * Breaks a game hash down by the parts of the simulation it covers.
+     *
+     * The children of the root are the sections listed in Section.
+     * Players are keyed by their index.
+     * Units and projectiles are grouped into ranges of RangeSize slots,
+     * keyed by the index of the range, and within a range keyed by their id.
+     * The children of a player, unit or projectile are its hashed fields,
+     * keyed by their position in forEachHashedField.
+     * For units and projectiles the id comes first, followed by the fields.
+     *
+     * Every node's hash is the sum of its children's hashes,
+     * so the root hash equals computeHashOf(GameSimulation).
+     * Two peers whose game hashes differ can walk down their trees together
+     * to find the first entity and field that diverged.
+     *
+     * Trees are only built when a peer asks for one,
+     * see GameHashHistory, so the entity and range levels
+     * are summed up when they are asked for.
+     */
+    class GameHashTree
+    {
+    public:
+        enum class Section : uint32_t
+        {
+            GameTime = 0,
+            Players,
+            Units,
+            Projectiles,
+        };
+
+        static constexpr uint32_t RangeSize = 64;
+
+        /** The keys of the nodes leading from the root to a node. */
+        using Path = std::vector<uint32_t>;
+
+        /** The key and hash of a child node. */
+        using Child = std::pair<uint32_t, GameHash>;
+
+        /** The hash of each field of a player, unit or projectile, in tree order. */
+        using FieldHashes = std::vector<GameHash>;
+
+        /** The id value and field hashes of a unit or projectile. */
+        using Entity = std::pair<uint32_t, FieldHashes>;
+
+    private:
+        GameHash gameTimeHash;
+        std::vector<FieldHashes> players;
+
+        /** Sorted by id slot. */
+        std::vector<Entity> units;
+
+        /** Sorted by id slot. */
+        std::vector<Entity> projectiles;
+
+        GameHash playersHash{0};
+        GameHash unitsHash{0};
+        GameHash projectilesHash{0};
+
+    public:
+        /**
+         * Units and projectiles must be sorted by id slot, as VectorMap iterates them.
+         * Sorting by id value gives the same order.
+         */
+        GameHashTree(GameHash gameTimeHash, std::vector<FieldHashes>&& players, std::vector<Entity>&& units, std::vector<Entity>&& projectiles);
+
+        GameHash getRootHash() const;
+
+        /** Returns the children of the node at the given path, or nothing if there is no such node. */
+        std::optional<std::vector<Child>> getChildren(const Path& path) const;
+    };
+
+    GameHash sumFieldHashes(const GameHashTree::FieldHashes& fieldHashes);
+
+    /** Builds the hash tree of the simulation, hashing every entity from scratch. */
+    GameHashTree buildHashTree(const GameSimulation& simulation);
+
+    /** Returns a human-readable description of the node at the given path. */
+    std::string describeHashTreePath(const GameHashTree::Path& path);
+}
@@ -0,0 +1,100 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/sim/GameHashTree.h>
+#include <rwe/sim/GameHash_util.h>
+
+namespace rwe
+{
+    TEST_CASE("GameHashTree")
+    {
+        auto players = static_cast<uint32_t>(GameHashTree::Section::Players);
+        auto units = static_cast<uint32_t>(GameHashTree::Section::Units);
+        auto projectiles = static_cast<uint32_t>(GameHashTree::Section::Projectiles);
+
+        // slots 1 and 2 fall in range 0, slot 65 in range 1
+        GameHashTree tree(
+            GameHash(1),
+            {{GameHash(4), GameHash(6)}, {GameHash(20)}},
+            {{0x101, {GameHash(60), GameHash(40)}}, {0x202, {GameHash(200)}}, {0x4101, {GameHash(100), GameHash(200)}}},
+            {});
+
+        SECTION("sums everything into the root")
+        {
+            REQUIRE(tree.getRootHash() == GameHash(631));
+
+            auto children = tree.getChildren({});
+            REQUIRE(children);
+            REQUIRE(*children == std::vector<GameHashTree::Child>{{0, GameHash(1)}, {players, GameHash(30)}, {units, GameHash(600)}, {projectiles, GameHash(0)}});
+        }
+
+        SECTION("lists players by index")
+        {
+            auto children = tree.getChildren({players});
+            REQUIRE(children);
+            REQUIRE(*children == std::vector<GameHashTree::Child>{{0, GameHash(10)}, {1, GameHash(20)}});
+
+            auto fields = tree.getChildren({players, 0});
+            REQUIRE(fields);
+            REQUIRE(*fields == std::vector<GameHashTree::Child>{{0, GameHash(4)}, {1, GameHash(6)}});
+
+            auto leafChildren = tree.getChildren({players, 0, 1});
+            REQUIRE(leafChildren);
+            REQUIRE(leafChildren->empty());
+
+            REQUIRE(!tree.getChildren({players, 0, 2}));
+            REQUIRE(!tree.getChildren({players, 2}));
+        }
+
+        SECTION("groups units into ranges of slots")
+        {
+            auto ranges = tree.getChildren({units});
+            REQUIRE(ranges);
+            REQUIRE(*ranges == std::vector<GameHashTree::Child>{{0, GameHash(300)}, {1, GameHash(300)}});
+
+            auto range0 = tree.getChildren({units, 0});
+            REQUIRE(range0);
+            REQUIRE(*range0 == std::vector<GameHashTree::Child>{{0x101, GameHash(100)}, {0x202, GameHash(200)}});
+
+            auto range1 = tree.getChildren({units, 1});
+            REQUIRE(range1);
+            REQUIRE(*range1 == std::vector<GameHashTree::Child>{{0x4101, GameHash(300)}});
+
+            REQUIRE(!tree.getChildren({units, 2}));
+        }
+
+        SECTION("lists the fields of a unit as leaves")
+        {
+            auto fields = tree.getChildren({units, 1, 0x4101});
+            REQUIRE(fields);
+            REQUIRE(*fields == std::vector<GameHashTree::Child>{{0, GameHash(100)}, {1, GameHash(200)}});
+
+            auto leafChildren = tree.getChildren({units, 1, 0x4101, 1});
+            REQUIRE(leafChildren);
+            REQUIRE(leafChildren->empty());
+
+            REQUIRE(!tree.getChildren({units, 1, 0x101}));
+            REQUIRE(!tree.getChildren({units, 1, 0x4101, 2}));
+            REQUIRE(!tree.getChildren({units, 1, 0x4101, 0, 0}));
+        }
+
+        SECTION("has no ranges for an empty section")
+        {
+            auto ranges = tree.getChildren({projectiles});
+            REQUIRE(ranges);
+            REQUIRE(ranges->empty());
+            REQUIRE(!tree.getChildren({projectiles, 0}));
+        }
+    }
+
+    TEST_CASE("describeHashTreePath")
+    {
+        auto units = static_cast<uint32_t>(GameHashTree::Section::Units);
+        auto players = static_cast<uint32_t>(GameHashTree::Section::Players);
+        REQUIRE(describeHashTreePath({}) == "game");
+        REQUIRE(describeHashTreePath({players, 2}) == "players > player 2");
+        REQUIRE(describeHashTreePath({units, 1}) == "units > slots 64-127");
+        REQUIRE(describeHashTreePath({units, 1, 0x4101}) == "units > slots 64-127 > unit 16641");
+        REQUIRE(describeHashTreePath({units, 1, 0x4101, 0}) == "units > slots 64-127 > unit 16641 > id");
+        REQUIRE(describeHashTreePath({units, 1, 0x4101, 2}) == "units > slots 64-127 > unit 16641 > position");
+        REQUIRE(describeHashTreePath({players, 2, 1}) == "players > player 2 > color");
+    }
+}
@@ -2,6 +2,61 @@
 
 namespace rwe
 {
+    const std::array<const char*, 18> playerHashedFieldNames{
+        "type",
+        "color",
+        "status",
+        "side",
+        "metal",
+        "maxMetal",
+        "energy",
+        "maxEnergy",
+        "metalStalled",
+        "energyStalled",
+        "desiredMetalConsumptionBuffer",
+        "desiredEnergyConsumptionBuffer",
+        "previousDesiredMetalConsumptionBuffer",
+        "previousDesiredEnergyConsumptionBuffer",
+        "actualMetalConsumptionBuffer",
+        "actualEnergyConsumptionBuffer",
+        "metalProductionBuffer",
+        "energyProductionBuffer",
+    };
+
+    const std::array<const char*, 22> unitHashedFieldNames{
+        "unitType",
+        "position",
+        "owner",
+        "rotation",
+        "physics",
+        "hitPoints",
+        "lifeState",
+        "navigationState",
+        "behaviourState",
+        "inBuildStance",
+        "yardOpen",
+        "inCollision",
+        "fireOrders",
+        "buildTimeCompleted",
+        "activated",
+        "isSufficientlyPowered",
+        "energyProductionBuffer",
+        "metalProductionBuffer",
+        "previousEnergyConsumptionBuffer",
+        "previousMetalConsumptionBuffer",
+        "energyConsumptionBuffer",
+        "metalConsumptionBuffer",
+    };
+
+    const std::array<const char*, 6> projectileHashedFieldNames{
+        "weaponType",
+        "owner",
+        "position",
+        "origin",
+        "velocity",
+        "damageRadius",
+    };
+
     GameHash computeHashOf(GameHash hash)
     {
         return hash;
@@ -49,52 +104,12 @@ namespace rwe
 
     GameHash computeHashOf(const GamePlayerInfo& p)
     {
-        return combineHashes(
-            p.type,
-            p.color,
-            p.status,
-            p.side,
-            p.metal,
-            p.maxMetal,
-            p.energy,
-            p.maxEnergy,
-            p.metalStalled,
-            p.energyStalled,
-            p.desiredMetalConsumptionBuffer,
-            p.desiredEnergyConsumptionBuffer,
-            p.previousDesiredMetalConsumptionBuffer,
-            p.previousDesiredEnergyConsumptionBuffer,
-            p.actualMetalConsumptionBuffer,
-            p.actualEnergyConsumptionBuffer,
-            p.metalProductionBuffer,
-            p.energyProductionBuffer);
+        return sumHashedFields(p);
     }
 
     GameHash computeHashOf(const UnitState& u)
     {
-        return combineHashes(
-            u.unitType,
-            u.position,
-            u.owner,
-            u.rotation,
-            u.physics,
-            u.hitPoints,
-            u.lifeState,
-            u.navigationState,
-            u.behaviourState,
-            u.inBuildStance,
-            u.yardOpen,
-            u.inCollision,
-            u.fireOrders,
-            u.buildTimeCompleted,
-            u.activated,
-            u.isSufficientlyPowered,
-            u.energyProductionBuffer,
-            u.metalProductionBuffer,
-            u.previousEnergyConsumptionBuffer,
-            u.previousMetalConsumptionBuffer,
-            u.energyConsumptionBuffer,
-            u.metalConsumptionBuffer);
+        return sumHashedFields(u);
     }
 
     GameHash computeHashOf(const UnitPhysicsInfoGround& p)
@@ -134,18 +149,7 @@ namespace rwe
 
     GameHash computeHashOf(const Projectile& projectile)
     {
-        GameHash h = combineHashes(
-            projectile.owner,
-            projectile.position,
-            projectile.origin,
-            projectile.velocity,
-            projectile.damageRadius);
-
-        for (const auto& [_, damage] : projectile.damage)
-        {
-            h += computeHashOf(damage);
-        }
-        return h;
+        return sumHashedFields(projectile);
     }
 
     GameHash computeHashOf(const UnitBehaviorStateIdle&)
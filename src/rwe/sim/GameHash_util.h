@@ -1,9 +1,11 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
 #include <rwe/sim/GameHash.h>
 #include <rwe/sim/GameSimulation.h>
 #include <rwe/util/match.h>
+#include <vector>
 
 namespace rwe
 {
@@ -122,6 +124,114 @@ namespace rwe
         return computeHashOf(p.first) + computeHashOf(p.second);
     }
 
+    /** The names of the fields visited by forEachHashedField, in visiting order. */
+    extern const std::array<const char*, 18> playerHashedFieldNames;
+    extern const std::array<const char*, 22> unitHashedFieldNames;
+    extern const std::array<const char*, 6> projectileHashedFieldNames;
+
+    /**
+     * Calls f with each field that contributes to the hash of the player, in order.
+     * computeHashOf(const GamePlayerInfo&) is the sum of the hashes of these fields.
+     */
+    template <typename F>
+    void forEachHashedField(const GamePlayerInfo& p, F&& f)
+    {
+        f(p.type);
+        f(p.color);
+        f(p.status);
+        f(p.side);
+        f(p.metal);
+        f(p.maxMetal);
+        f(p.energy);
+        f(p.maxEnergy);
+        f(p.metalStalled);
+        f(p.energyStalled);
+        f(p.desiredMetalConsumptionBuffer);
+        f(p.desiredEnergyConsumptionBuffer);
+        f(p.previousDesiredMetalConsumptionBuffer);
+        f(p.previousDesiredEnergyConsumptionBuffer);
+        f(p.actualMetalConsumptionBuffer);
+        f(p.actualEnergyConsumptionBuffer);
+        f(p.metalProductionBuffer);
+        f(p.energyProductionBuffer);
+    }
+
+    /**
+     * Calls f with each field that contributes to the hash of the unit, in order.
+     * computeHashOf(const UnitState&) is the sum of the hashes of these fields.
+     */
+    template <typename F>
+    void forEachHashedField(const UnitState& u, F&& f)
+    {
+        f(u.unitType);
+        f(u.position);
+        f(u.owner);
+        f(u.rotation);
+        f(u.physics);
+        f(u.hitPoints);
+        f(u.lifeState);
+        f(u.navigationState);
+        f(u.behaviourState);
+        f(u.inBuildStance);
+        f(u.yardOpen);
+        f(u.inCollision);
+        f(u.fireOrders);
+        f(u.buildTimeCompleted);
+        f(u.activated);
+        f(u.isSufficientlyPowered);
+        f(u.energyProductionBuffer);
+        f(u.metalProductionBuffer);
+        f(u.previousEnergyConsumptionBuffer);
+        f(u.previousMetalConsumptionBuffer);
+        f(u.energyConsumptionBuffer);
+        f(u.metalConsumptionBuffer);
+    }
+
+    /**
+     * Calls f with each field that contributes to the hash of the projectile, in order.
+     * computeHashOf(const Projectile&) is the sum of the hashes of these fields.
+     */
+    template <typename F>
+    void forEachHashedField(const Projectile& p, F&& f)
+    {
+        f(p.weaponType);
+        f(p.owner);
+        f(p.position);
+        f(p.origin);
+        f(p.velocity);
+        f(p.damageRadius);
+    }
+
+    /** Returns the sum of the hashes of the fields visited by forEachHashedField. */
+    template <typename T>
+    GameHash sumHashedFields(const T& item)
+    {
+        GameHash sum(0);
+        forEachHashedField(item, [&](const auto& field) { sum += computeHashOf(field); });
+        return sum;
+    }
+
+    /** Returns the hash of each field visited by forEachHashedField, in order. */
+    template <typename T>
+    std::vector<GameHash> computeFieldHashes(const T& item)
+    {
+        std::vector<GameHash> hashes;
+        forEachHashedField(item, [&](const auto& field) { hashes.push_back(computeHashOf(field)); });
+        return hashes;
+    }
+
+    /**
+     * Returns the hash of the id followed by the hash of each field of a unit or projectile,
+     * which sum to the entity's contribution to the game hash.
+     */
+    template <typename Id, typename T>
+    std::vector<GameHash> computeEntityFieldHashes(const Id& id, const T& item)
+    {
+        std::vector<GameHash> hashes{computeHashOf(id)};
+        forEachHashedField(item, [&](const auto& field) { hashes.push_back(computeHashOf(field)); });
+        return hashes;
+    }
+
     template <typename... Ts>
     GameHash combineHashes(const Ts&... items)
     {
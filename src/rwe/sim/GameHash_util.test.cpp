@@ -101,4 +101,28 @@ namespace rwe
             REQUIRE(hash == GameHash(30));
         }
     }
+
+    TEST_CASE("forEachHashedField")
+    {
+        SECTION("visits one field per name")
+        {
+            Projectile projectile{};
+            std::size_t count = 0;
+            forEachHashedField(projectile, [&](const auto&) { ++count; });
+            REQUIRE(count == projectileHashedFieldNames.size());
+        }
+
+        SECTION("sums to the hash of the whole")
+        {
+            Projectile projectile{};
+            projectile.weaponType = WeaponDefinitionId(3);
+            projectile.position = SimVector(1_ss, 2_ss, 3_ss);
+            projectile.damageRadius = 16_ss;
+
+            GameHash sum(0);
+            forEachHashedField(projectile, [&](const auto& field) { sum += computeHashOf(field); });
+            REQUIRE(sum == computeHashOf(projectile));
+            REQUIRE(sumHashedFields(projectile) == computeHashOf(projectile));
+        }
+    }
 }
@@ -4,6 +4,7 @@
 #include <rwe/sim/SimScalar.h>
 #include <rwe/sim/SimTicksPerSecond.h>
 #include <rwe/sim/UnitBehaviorService.h>
+#include <rwe/sim/UnitBehaviorService_util.h>
 #include <rwe/sim/cob.h>
 #include <rwe/sim/movement.h>
 #include <rwe/sim/util.h>
@@ -12,7 +13,7 @@
 #include <rwe/util/match.h>
 #include <rwe/util/rwe_string.h>
 #include <type_traits>
-#include <unordered_set>
+#include <utility>
 
 namespace rwe
 {
@@ -87,8 +88,11 @@ namespace rwe
     GameSimulation::GameSimulation(MapTerrain&& terrain, unsigned char surfaceMetal, int minWindSpeed, int maxWindSpeed)
         : terrain(std::move(terrain)),
           occupiedGrid(this->terrain.getHeightMap().getWidth() - 1, this->terrain.getHeightMap().getHeight() - 1, OccupiedCell()),
+          unitSpatialIndex(this->terrain.getHeightMap().getWidth() - 1, this->terrain.getHeightMap().getHeight() - 1),
+          flyingUnitSpatialIndex(this->terrain.getHeightMap().getWidth() - 1, this->terrain.getHeightMap().getHeight() - 1),
           metalGrid(this->terrain.getHeightMap().getWidth() - 1, this->terrain.getHeightMap().getHeight() - 1, surfaceMetal),
           geoGrid(this->terrain.getHeightMap().getWidth() - 1, this->terrain.getHeightMap().getHeight() - 1, false),
+          unitsTargetingChangedSincePlanning(this->terrain.getHeightMap().getWidth() - 1, this->terrain.getHeightMap().getHeight() - 1),
           minWindSpeed(minWindSpeed),
           maxWindSpeed(maxWindSpeed),
           nextWindSpeedChange(gameTime)
@@ -114,6 +118,11 @@ namespace rwe
             cell.featureId = featureId;
         });
 
+        if (featureDefinition.blocking)
+        {
+            pathFindingService.notifyObstaclesChanged(footprintRegion);
+        }
+
         if (!featureDefinition.blocking && featureDefinition.indestructible && featureDefinition.metal)
         {
             metalGrid.set(metalGrid.clipRegion(footprintRegion), featureDefinition.metal);
@@ -179,31 +188,17 @@ namespace rwe
 
     std::optional<UnitWeapon> tryCreateWeapon(const GameSimulation& sim, const std::string& weaponType)
     {
-        if (sim.weaponDefinitions.find(toUpper(weaponType)) == sim.weaponDefinitions.end())
+        auto weaponDefinitionId = sim.tryGetWeaponDefinitionId(weaponType);
+        if (!weaponDefinitionId)
         {
             return std::nullopt;
         }
 
         UnitWeapon weapon;
-        weapon.weaponType = toUpper(weaponType);
+        weapon.weaponType = *weaponDefinitionId;
         return weapon;
     }
 
-    std::vector<UnitMesh> createUnitMeshes(const GameSimulation& sim, const std::string& objectName)
-    {
-        const auto& def = sim.unitModelDefinitions.at(objectName);
-
-        const auto& pieceDefs = def.pieces;
-
-        std::vector<UnitMesh> pieces(pieceDefs.size());
-        for (Index i = 0; i < getSize(pieces); ++i)
-        {
-            pieces[i].name = pieceDefs[i].name;
-        }
-
-        return pieces;
-    }
-
     UnitState createUnit(
         GameSimulation& simulation,
         const std::string& unitType,
@@ -211,24 +206,26 @@ namespace rwe
         const SimVector& position,
         std::optional<SimAngle> rotation)
     {
-        const auto& unitDefinition = simulation.unitDefinitions.at(unitType);
+        auto unitDefinitionId = simulation.getUnitDefinitionId(unitType);
+        const auto& unitDefinition = simulation.unitDefinitions.get(unitDefinitionId);
 
-        auto meshes = createUnitMeshes(simulation, unitDefinition.objectName);
-        auto modelDefinition = simulation.unitModelDefinitions.at(unitDefinition.objectName);
+        const auto& modelDefinition = simulation.unitModelDefinitions.at(unitDefinition.objectName);
+
+        const auto& script = simulation.unitScriptDefinitions.at(unitType);
+        const auto& cobPieceIndices = simulation.getCobPieceIndices(unitDefinitionId, script);
+
+        auto cobEnv = std::make_unique<CobEnvironment>(&script);
+        UnitState unit(&modelDefinition, std::move(cobEnv), &cobPieceIndices);
+        unit.unitType = unitDefinitionId;
 
         if (unitDefinition.isMobile)
         {
             // don't shade mobile units
-            for (auto& m : meshes)
+            for (auto& m : unit.pieces)
             {
                 m.shaded = false;
             }
         }
-
-        const auto& script = simulation.unitScriptDefinitions.at(unitType);
-        auto cobEnv = std::make_unique<CobEnvironment>(&script);
-        UnitState unit(meshes, std::move(cobEnv));
-        unit.unitType = toUpper(unitType);
         unit.owner = owner;
         unit.position = position;
         unit.previousPosition = position;
@@ -262,10 +259,22 @@ namespace rwe
         return unit;
     }
 
+    const std::vector<std::optional<int>>& GameSimulation::getCobPieceIndices(UnitDefinitionId unitType, const CobProgram& script)
+    {
+        auto it = unitCobPieceIndices.find(unitType);
+        if (it == unitCobPieceIndices.end())
+        {
+            const auto& modelDefinition = unitModelDefinitions.at(unitDefinitions.get(unitType).objectName);
+            it = unitCobPieceIndices.emplace(unitType, createCobPieceIndexMap(script.script.pieces, modelDefinition)).first;
+        }
+
+        return it->second;
+    }
+
     std::optional<UnitId> GameSimulation::trySpawnUnit(const std::string& unitType, PlayerId owner, const SimVector& position, std::optional<SimAngle> rotation)
     {
         auto unit = createUnit(*this, unitType, owner, position, rotation);
-        const auto& unitDefinition = unitDefinitions.at(unitType);
+        const auto& unitDefinition = unitDefinitions.get(unit.unitType);
         if (unitDefinition.floater || unitDefinition.canHover)
         {
             unit.position.y = rweMax(terrain.getSeaLevel(), unit.position.y);
@@ -286,7 +295,7 @@ namespace rwe
 
     std::optional<UnitId> GameSimulation::tryAddUnit(UnitState&& unit)
     {
-        const auto& unitDefinition = unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = unitDefinitions.get(unit.unitType);
 
         // set footprint area as occupied by the unit
         auto footprintRect = computeFootprintRegion(unit.position, unitDefinition.movementCollisionInfo);
@@ -296,6 +305,7 @@ namespace rwe
         }
 
         auto unitId = units.emplace(std::move(unit));
+        markUnitChanged(unitId);
         const auto& insertedUnit = units.tryGet(unitId)->get();
 
         auto footprintRegion = occupiedGrid.tryToRegion(footprintRect);
@@ -311,8 +321,12 @@ namespace rwe
             occupiedGrid.forEach2(footprintRegion->x, footprintRegion->y, *unitDefinition.yardMap, [&](auto& cell, const auto& yardMapCell) {
                 cell.buildingInfo = OccupiedCellBuildingInfo{unitId, isPassable(yardMapCell, insertedUnit.yardOpen)};
             });
+            pathFindingService.notifyObstaclesChanged(footprintRect);
         }
 
+        unitSpatialIndex.insert(unitId, terrain.worldToHeightmapCoordinate(insertedUnit.position));
+        markUnitTargetingChanged(unitId);
+
         return unitId;
     }
 
@@ -390,25 +404,7 @@ namespace rwe
     bool GameSimulation::isCollisionAt(const GridRegion& region) const
     {
         return occupiedGrid.any(region, [&](const auto& cell) {
-            if (cell.mobileUnitId)
-            {
-                return true;
-            }
-            if (cell.buildingInfo && !cell.buildingInfo->passable)
-            {
-                return true;
-            }
-            if (cell.featureId)
-            {
-                const auto& f = getFeature(*cell.featureId);
-                const auto& def = getFeatureDefinition(f.featureName);
-                if (def.blocking)
-                {
-                    return true;
-                }
-            }
-
-            return false;
+            return cell.mobileUnitId || isStaticObstacle(cell);
         });
     }
 
@@ -421,26 +417,27 @@ namespace rwe
         }
 
         return occupiedGrid.any(*region, [&](const auto& cell) {
-            if (cell.mobileUnitId && *cell.mobileUnitId != self)
-            {
-                return true;
-            }
-            if (cell.buildingInfo && !cell.buildingInfo->passable)
+            return (cell.mobileUnitId && *cell.mobileUnitId != self) || isStaticObstacle(cell);
+        });
+    }
+
+    bool GameSimulation::isStaticObstacle(const OccupiedCell& cell) const
+    {
+        if (cell.buildingInfo && !cell.buildingInfo->passable)
+        {
+            return true;
+        }
+        if (cell.featureId)
+        {
+            const auto& f = getFeature(*cell.featureId);
+            const auto& def = getFeatureDefinition(f.featureName);
+            if (def.blocking)
             {
                 return true;
             }
-            if (cell.featureId)
-            {
-                const auto& f = getFeature(*cell.featureId);
-                const auto& def = getFeatureDefinition(f.featureName);
-                if (def.blocking)
-                {
-                    return true;
-                }
-            }
+        }
 
-            return false;
-        });
+        return false;
     }
 
     bool GameSimulation::isYardmapBlocked(unsigned int x, unsigned int y, const Grid<YardMapCell>& yardMap, bool open, UnitId self) const
@@ -494,6 +491,11 @@ namespace rwe
         }
     }
 
+    void GameSimulation::showObject(UnitId unitId, int pieceIndex)
+    {
+        getUnitState(unitId).pieces[pieceIndex].visible = true;
+    }
+
     void GameSimulation::hideObject(UnitId unitId, const std::string& name)
     {
         auto mesh = getUnitState(unitId).findPiece(name);
@@ -503,6 +505,11 @@ namespace rwe
         }
     }
 
+    void GameSimulation::hideObject(UnitId unitId, int pieceIndex)
+    {
+        getUnitState(unitId).pieces[pieceIndex].visible = false;
+    }
+
     void GameSimulation::enableShading(UnitId unitId, const std::string& name)
     {
         auto mesh = getUnitState(unitId).findPiece(name);
@@ -512,6 +519,11 @@ namespace rwe
         }
     }
 
+    void GameSimulation::enableShading(UnitId unitId, int pieceIndex)
+    {
+        getUnitState(unitId).pieces[pieceIndex].shaded = true;
+    }
+
     void GameSimulation::disableShading(UnitId unitId, const std::string& name)
     {
         auto mesh = getUnitState(unitId).findPiece(name);
@@ -521,6 +533,11 @@ namespace rwe
         }
     }
 
+    void GameSimulation::disableShading(UnitId unitId, int pieceIndex)
+    {
+        getUnitState(unitId).pieces[pieceIndex].shaded = false;
+    }
+
     UnitState& GameSimulation::getUnitState(UnitId id)
     {
         auto it = units.find(id);
@@ -538,14 +555,14 @@ namespace rwe
     UnitInfo GameSimulation::getUnitInfo(UnitId id)
     {
         auto& state = getUnitState(id);
-        const auto& definition = unitDefinitions.at(state.unitType);
+        const auto& definition = unitDefinitions.get(state.unitType);
         return UnitInfo(id, &state, &definition);
     }
 
     ConstUnitInfo GameSimulation::getUnitInfo(UnitId id) const
     {
         auto& state = getUnitState(id);
-        const auto& definition = unitDefinitions.at(state.unitType);
+        const auto& definition = unitDefinitions.get(state.unitType);
         return ConstUnitInfo(id, &state, &definition);
     }
 
@@ -564,12 +581,69 @@ namespace rwe
         return tryFind(units, UnitId(id.value));
     }
 
+    void GameSimulation::markUnitChanged(UnitId id)
+    {
+        unitHashes.markChanged(id);
+    }
+
+    void GameSimulation::markUnitTargetingChanged(UnitId id)
+    {
+        auto position = terrain.worldToHeightmapCoordinate(getUnitState(id).position);
+        if (unitsTargetingChangedSincePlanning.contains(id))
+        {
+            unitsTargetingChangedSincePlanning.move(id, position);
+        }
+        else
+        {
+            unitsTargetingChangedSincePlanning.insert(id, position);
+        }
+    }
+
     bool GameSimulation::unitExists(UnitId id) const
     {
         auto it = units.find(id);
         return it != units.end();
     }
 
+    void GameSimulation::updateUnitSpatialIndex(UnitId unitId, const SimVector& position)
+    {
+        unitSpatialIndex.move(unitId, terrain.worldToHeightmapCoordinate(position));
+        markUnitTargetingChanged(unitId);
+    }
+
+    void GameSimulation::addFlyingUnit(UnitId unitId)
+    {
+        const auto& unit = getUnitState(unitId);
+        auto [footprintX, footprintZ] = getFootprintXZ(unitDefinitions.get(unit.unitType).movementCollisionInfo);
+        maxFlyingUnitFootprint = std::max({maxFlyingUnitFootprint, static_cast<int>(footprintX), static_cast<int>(footprintZ)});
+
+        flyingUnitsSet.insert(unitId);
+        flyingUnitSpatialIndex.insert(unitId, terrain.worldToHeightmapCoordinate(unit.position));
+    }
+
+    void GameSimulation::removeFlyingUnit(UnitId unitId)
+    {
+        flyingUnitsSet.erase(unitId);
+        flyingUnitSpatialIndex.remove(unitId);
+    }
+
+    void GameSimulation::updateFlyingUnitSpatialIndex(UnitId unitId, const SimVector& position)
+    {
+        flyingUnitSpatialIndex.move(unitId, terrain.worldToHeightmapCoordinate(position));
+    }
+
+    void GameSimulation::rebuildFlyingUnitSpatialIndex()
+    {
+        auto flyingUnits = std::move(flyingUnitsSet);
+        flyingUnitsSet.clear();
+        flyingUnitSpatialIndex = UnitSpatialIndex(terrain.getHeightMap().getWidth() - 1, terrain.getHeightMap().getHeight() - 1);
+        maxFlyingUnitFootprint = 0;
+        for (const auto& unitId : flyingUnits)
+        {
+            addFlyingUnit(unitId);
+        }
+    }
+
     MapFeature& GameSimulation::getFeature(FeatureId id)
     {
         auto it = features.find(id);
@@ -609,41 +683,81 @@ namespace rwe
         getUnitState(unitId).moveObject(name, axis, position, speed);
     }
 
+    void GameSimulation::moveObject(UnitId unitId, int pieceIndex, SimAxis axis, SimScalar position, SimScalar speed)
+    {
+        getUnitState(unitId).moveObject(pieceIndex, axis, position, speed);
+    }
+
     void GameSimulation::moveObjectNow(UnitId unitId, const std::string& name, SimAxis axis, SimScalar position)
     {
         getUnitState(unitId).moveObjectNow(name, axis, position);
     }
 
+    void GameSimulation::moveObjectNow(UnitId unitId, int pieceIndex, SimAxis axis, SimScalar position)
+    {
+        getUnitState(unitId).moveObjectNow(pieceIndex, axis, position);
+    }
+
     void GameSimulation::turnObject(UnitId unitId, const std::string& name, SimAxis axis, SimAngle angle, SimScalar speed)
     {
         getUnitState(unitId).turnObject(name, axis, angle, speed);
     }
 
+    void GameSimulation::turnObject(UnitId unitId, int pieceIndex, SimAxis axis, SimAngle angle, SimScalar speed)
+    {
+        getUnitState(unitId).turnObject(pieceIndex, axis, angle, speed);
+    }
+
     void GameSimulation::turnObjectNow(UnitId unitId, const std::string& name, SimAxis axis, SimAngle angle)
     {
         getUnitState(unitId).turnObjectNow(name, axis, angle);
     }
 
+    void GameSimulation::turnObjectNow(UnitId unitId, int pieceIndex, SimAxis axis, SimAngle angle)
+    {
+        getUnitState(unitId).turnObjectNow(pieceIndex, axis, angle);
+    }
+
     void GameSimulation::spinObject(UnitId unitId, const std::string& name, SimAxis axis, SimScalar speed, SimScalar acceleration)
     {
         getUnitState(unitId).spinObject(name, axis, speed, acceleration);
     }
 
+    void GameSimulation::spinObject(UnitId unitId, int pieceIndex, SimAxis axis, SimScalar speed, SimScalar acceleration)
+    {
+        getUnitState(unitId).spinObject(pieceIndex, axis, speed, acceleration);
+    }
+
     void GameSimulation::stopSpinObject(UnitId unitId, const std::string& name, SimAxis axis, SimScalar deceleration)
     {
         getUnitState(unitId).stopSpinObject(name, axis, deceleration);
     }
 
+    void GameSimulation::stopSpinObject(UnitId unitId, int pieceIndex, SimAxis axis, SimScalar deceleration)
+    {
+        getUnitState(unitId).stopSpinObject(pieceIndex, axis, deceleration);
+    }
+
     bool GameSimulation::isPieceMoving(UnitId unitId, const std::string& name, SimAxis axis) const
     {
         return getUnitState(unitId).isMoveInProgress(name, axis);
     }
 
+    bool GameSimulation::isPieceMoving(UnitId unitId, int pieceIndex, SimAxis axis) const
+    {
+        return getUnitState(unitId).isMoveInProgress(pieceIndex, axis);
+    }
+
     bool GameSimulation::isPieceTurning(UnitId unitId, const std::string& name, SimAxis axis) const
     {
         return getUnitState(unitId).isTurnInProgress(name, axis);
     }
 
+    bool GameSimulation::isPieceTurning(UnitId unitId, int pieceIndex, SimAxis axis) const
+    {
+        return getUnitState(unitId).isTurnInProgress(pieceIndex, axis);
+    }
+
     std::optional<SimVector> GameSimulation::intersectLineWithTerrain(const Line3x<SimScalar>& line) const
     {
         return terrain.intersectLine(line);
@@ -660,21 +774,23 @@ namespace rwe
         occupiedGrid.forEach(*newRegion, [unitId](auto& cell) { cell.mobileUnitId = unitId; });
     }
 
-    void GameSimulation::requestPath(UnitId unitId)
+    void GameSimulation::requestPath(UnitId unitId, bool isNewGoal)
     {
-        PathRequest request{unitId};
+        PathRequest request{unitId, isNewGoal};
 
         // If the unit is already in the queue for a path,
         // we'll assume that they no longer care about their old request
         // and that their new request is for some new path,
         // so we'll move them to the back of the queue for fairness.
+        // A new goal that has not been served yet is still new.
         auto it = std::find(pathRequests.begin(), pathRequests.end(), request);
         if (it != pathRequests.end())
         {
+            request.isNewGoal = request.isNewGoal || it->isNewGoal;
             pathRequests.erase(it);
         }
 
-        pathRequests.push_back(PathRequest{unitId});
+        pathRequests.push_back(request);
     }
 
     Projectile GameSimulation::createProjectileFromWeapon(
@@ -683,9 +799,9 @@ namespace rwe
         return createProjectileFromWeapon(owner, weapon.weaponType, position, direction, distanceToTarget, targetUnit);
     }
 
-    Projectile GameSimulation::createProjectileFromWeapon(PlayerId owner, const std::string& weaponType, const SimVector& position, const SimVector& direction, SimScalar distanceToTarget, std::optional<UnitId> targetUnit)
+    Projectile GameSimulation::createProjectileFromWeapon(PlayerId owner, WeaponDefinitionId weaponType, const SimVector& position, const SimVector& direction, SimScalar distanceToTarget, std::optional<UnitId> targetUnit)
     {
-        const auto& weaponDefinition = weaponDefinitions.at(weaponType);
+        const auto& weaponDefinition = weaponDefinitions.get(weaponType);
 
         Projectile projectile;
         projectile.weaponType = weaponType;
@@ -697,8 +813,6 @@ namespace rwe
 
         projectile.lastSmoke = gameTime;
 
-        projectile.damage = weaponDefinition.damage;
-
         projectile.damageRadius = weaponDefinition.damageRadius;
 
         if (weaponDefinition.weaponTimer)
@@ -764,7 +878,17 @@ namespace rwe
 
     bool GameSimulation::addResourceDelta(const UnitId& unitId, const Energy& apparentEnergy, const Metal& apparentMetal, const Energy& actualEnergy, const Metal& actualMetal)
     {
-        auto& unit = getUnitState(unitId);
+        markUnitChanged(unitId);
+        return addUnitResourceDelta(getUnitState(unitId), apparentEnergy, apparentMetal, actualEnergy, actualMetal);
+    }
+
+    bool GameSimulation::addUnitResourceDelta(UnitState& unit, const Energy& energy, const Metal& metal)
+    {
+        return addUnitResourceDelta(unit, energy, metal, energy, metal);
+    }
+
+    bool GameSimulation::addUnitResourceDelta(UnitState& unit, const Energy& apparentEnergy, const Metal& apparentMetal, const Energy& actualEnergy, const Metal& actualMetal)
+    {
         auto& player = getPlayer(unit.owner);
 
         unit.addEnergyDelta(apparentEnergy);
@@ -775,7 +899,7 @@ namespace rwe
     bool GameSimulation::trySetYardOpen(const UnitId& unitId, bool open)
     {
         auto& unit = getUnitState(unitId);
-        const auto& unitDefinition = unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = unitDefinitions.get(unit.unitType);
         auto footprintRect = computeFootprintRegion(unit.position, unitDefinition.movementCollisionInfo);
         auto footprintRegion = occupiedGrid.tryToRegion(footprintRect);
         assert(!!footprintRegion);
@@ -789,8 +913,10 @@ namespace rwe
         occupiedGrid.forEach2(footprintRegion->x, footprintRegion->y, *unitDefinition.yardMap, [&](auto& cell, const auto& yardMapCell) {
             cell.buildingInfo = OccupiedCellBuildingInfo{unitId, isPassable(yardMapCell, open)};
         });
+        pathFindingService.notifyObstaclesChanged(footprintRect);
 
         unit.yardOpen = open;
+        markUnitChanged(unitId);
 
         return true;
     }
@@ -798,7 +924,7 @@ namespace rwe
     void GameSimulation::emitBuggerOff(const UnitId& unitId)
     {
         auto& unit = getUnitState(unitId);
-        const auto& unitDefinition = unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = unitDefinitions.get(unit.unitType);
         auto footprintRect = computeFootprintRegion(unit.position, unitDefinition.movementCollisionInfo);
         auto footprintRegion = occupiedGrid.tryToRegion(footprintRect);
         assert(!!footprintRegion);
@@ -820,15 +946,122 @@ namespace rwe
         }
     }
 
-    GameHash GameSimulation::computeHash() const
+    /**
+     * Rehashes the marked entities of a running hash.
+     * tryGetEntity(id) returns the entity with that id, or nothing if it no longer exists.
+     * If changes is not null, the entities whose hash changed are added to it.
+     */
+    template <typename Id, typename F>
+    GameHash updateEntityHashes(IncrementalGameHash<Id>& hashes, std::vector<GameHashDelta::Change>* changes, F&& tryGetEntity)
     {
-        return computeHashOf(*this);
+        return hashes.update([&](const Id& id) -> std::optional<GameHash> {
+            auto entity = tryGetEntity(id);
+            if (!entity)
+            {
+                if (changes != nullptr && hashes.tryGetContribution(id))
+                {
+                    changes->emplace_back(id.value, std::nullopt);
+                }
+                return std::nullopt;
+            }
+
+            if (changes == nullptr)
+            {
+                return computeHashOf(id) + computeHashOf(entity->get());
+            }
+
+            auto fieldHashes = computeEntityFieldHashes(id, entity->get());
+            auto hash = sumFieldHashes(fieldHashes);
+            if (hashes.tryGetContribution(id) != hash)
+            {
+                changes->emplace_back(id.value, std::move(fieldHashes));
+            }
+            return hash;
+        });
+    }
+
+    GameHash GameSimulation::updateUnitsHash(std::vector<GameHashDelta::Change>* changes)
+    {
+        return updateEntityHashes(unitHashes, changes, [&](UnitId id) {
+            return std::as_const(*this).tryGetUnitState(id);
+        });
+    }
+
+    GameHash GameSimulation::updateProjectilesHash(std::vector<GameHashDelta::Change>* changes)
+    {
+        for (const auto& entry : projectiles)
+        {
+            projectileHashes.markChanged(entry.first);
+        }
+
+        return updateEntityHashes(projectileHashes, changes, [&](ProjectileId id) {
+            return tryFind(std::as_const(projectiles), id);
+        });
+    }
+
+    void GameSimulation::restartHashes()
+    {
+        unitHashes.clear();
+        for (const auto& entry : units)
+        {
+            unitHashes.markChanged(entry.first);
+        }
+
+        projectileHashes.clear();
+        hashesRestarted = true;
+    }
+
+    void GameSimulation::checkIncrementalHash(GameHash hash) const
+    {
+#ifndef NDEBUG
+        if (hashCheckInterval != 0 && gameTime.value % hashCheckInterval == 0)
+        {
+            auto fullHash = computeHashOf(*this);
+            if (hash != fullHash)
+            {
+                throw std::logic_error("Incremental game hash " + std::to_string(hash.value) + " does not match full hash " + std::to_string(fullHash.value) + " at tick " + std::to_string(gameTime.value));
+            }
+        }
+#endif
+    }
+
+    GameHash GameSimulation::computeHash()
+    {
+        auto unitsHash = updateUnitsHash(nullptr);
+        auto projectilesHash = updateProjectilesHash(nullptr);
+        auto hash = combineHashes(gameTime, players, unitsHash, projectilesHash);
+        checkIncrementalHash(hash);
+        return hash;
+    }
+
+    std::pair<GameHash, GameHashDelta> GameSimulation::computeHashDelta()
+    {
+        GameHashDelta delta;
+        delta.gameTimeHash = computeHashOf(gameTime);
+        delta.isComplete = hashesRestarted;
+        hashesRestarted = false;
+
+        delta.players.reserve(players.size());
+        GameHash playersHash(0);
+        for (const auto& player : players)
+        {
+            delta.players.push_back(computeFieldHashes(player));
+            playersHash += sumFieldHashes(delta.players.back());
+        }
+
+        auto unitsHash = updateUnitsHash(&delta.units);
+        auto projectilesHash = updateProjectilesHash(&delta.projectiles);
+
+        auto hash = delta.gameTimeHash + playersHash + unitsHash + projectilesHash;
+        checkIncrementalHash(hash);
+        return {hash, std::move(delta)};
     }
 
     void GameSimulation::activateUnit(UnitId unitId)
     {
         auto& unit = getUnitState(unitId);
         unit.activate();
+        markUnitChanged(unitId);
         events.push_back(UnitActivatedEvent{unitId});
     }
 
@@ -836,6 +1069,7 @@ namespace rwe
     {
         auto& unit = getUnitState(unitId);
         unit.deactivate();
+        markUnitChanged(unitId);
         events.push_back(UnitDeactivatedEvent{unitId});
     }
 
@@ -843,21 +1077,21 @@ namespace rwe
     {
         auto& unit = getUnitState(unitId);
         unit.markAsDeadNoCorpse();
+        markUnitChanged(unitId);
+        markUnitTargetingChanged(unitId);
     }
 
     Matrix4x<SimScalar> GameSimulation::getUnitPieceLocalTransform(UnitId unitId, const std::string& pieceName) const
     {
         const auto& unit = getUnitState(unitId);
-        const auto& unitDefinition = unitDefinitions.at(unit.unitType);
-        const auto& modelDef = unitModelDefinitions.at(unitDefinition.objectName);
+        const auto& modelDef = *unit.modelDefinition;
         return getPieceTransform(pieceName, modelDef, unit.pieces);
     }
 
     Matrix4x<SimScalar> GameSimulation::getUnitPieceTransform(UnitId unitId, const std::string& pieceName) const
     {
         const auto& unit = getUnitState(unitId);
-        const auto& unitDefinition = unitDefinitions.at(unit.unitType);
-        const auto& modelDef = unitModelDefinitions.at(unitDefinition.objectName);
+        const auto& modelDef = *unit.modelDefinition;
         auto pieceTransform = getPieceTransform(pieceName, modelDef, unit.pieces);
         return unit.getTransform() * pieceTransform;
     }
@@ -865,15 +1099,37 @@ namespace rwe
     SimVector GameSimulation::getUnitPiecePosition(UnitId unitId, const std::string& pieceName) const
     {
         const auto& unit = getUnitState(unitId);
-        const auto& unitDefinition = unitDefinitions.at(unit.unitType);
-        const auto& modelDef = unitModelDefinitions.at(unitDefinition.objectName);
+        const auto& modelDef = *unit.modelDefinition;
         auto pieceTransform = getPieceTransform(pieceName, modelDef, unit.pieces);
         return unit.getTransform() * pieceTransform * SimVector(0_ss, 0_ss, 0_ss);
     }
 
+    Matrix4x<SimScalar> GameSimulation::getUnitPieceLocalTransform(UnitId unitId, int pieceIndex) const
+    {
+        const auto& unit = getUnitState(unitId);
+        const auto& modelDef = *unit.modelDefinition;
+        return getPieceTransform(pieceIndex, modelDef, unit.pieces);
+    }
+
+    Matrix4x<SimScalar> GameSimulation::getUnitPieceTransform(UnitId unitId, int pieceIndex) const
+    {
+        const auto& unit = getUnitState(unitId);
+        return unit.getTransform() * getUnitPieceLocalTransform(unitId, pieceIndex);
+    }
+
+    SimVector GameSimulation::getUnitPiecePosition(UnitId unitId, int pieceIndex) const
+    {
+        return getUnitPieceTransform(unitId, pieceIndex) * SimVector(0_ss, 0_ss, 0_ss);
+    }
+
     void GameSimulation::setBuildStance(UnitId unitId, bool value)
     {
-        getUnitState(unitId).inBuildStance = value;
+        auto& unit = getUnitState(unitId);
+        if (unit.inBuildStance != value)
+        {
+            unit.inBuildStance = value;
+            markUnitChanged(unitId);
+        }
     }
 
     void GameSimulation::setYardOpen(UnitId unitId, bool value)
@@ -943,8 +1199,7 @@ namespace rwe
                 return false;
             }
 
-            const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
-            const auto& modelDefinition = sim.unitModelDefinitions.at(unitDefinition.objectName);
+            const auto& modelDefinition = *unit.modelDefinition;
 
             // ignore if the projectile is above or below the unit
             if (projectile.position.y < unit.position.y || projectile.position.y > unit.position.y + modelDefinition.height)
@@ -964,8 +1219,7 @@ namespace rwe
                 return false;
             }
 
-            const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
-            const auto& modelDefinition = sim.unitModelDefinitions.at(unitDefinition.objectName);
+            const auto& modelDefinition = *unit.modelDefinition;
 
             // ignore if the projectile is above or below the unit
             if (projectile.position.y < unit.position.y || projectile.position.y > unit.position.y + modelDefinition.height)
@@ -1003,7 +1257,7 @@ namespace rwe
             return false;
         }
 
-        const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = sim.unitDefinitions.get(unit.unitType);
 
         auto footprintRect = sim.computeFootprintRegion(unit.position, unitDefinition.movementCollisionInfo);
         auto heightMapPos = sim.terrain.worldToHeightmapCoordinate(projectile.position);
@@ -1013,7 +1267,7 @@ namespace rwe
             return false;
         }
 
-        const auto& modelDefinition = sim.unitModelDefinitions.at(unitDefinition.objectName);
+        const auto& modelDefinition = *unit.modelDefinition;
 
         // ignore if the projectile is above or below the unit
         if (projectile.position.y < unit.position.y || projectile.position.y > unit.position.y + modelDefinition.height)
@@ -1078,12 +1332,13 @@ namespace rwe
             }
 
             // detect collision with flying unit footprint
-            for (auto unitId : simulation.flyingUnitsSet)
+            auto hitsFlyingUnit = false;
+            simulation.forEachFlyingUnitNearCells(heightMapPos, heightMapPos, [&](UnitId unitId) {
+                hitsFlyingUnit = hitsFlyingUnit || projectileCollidesWithUnit(simulation, projectile, unitId);
+            });
+            if (hitsFlyingUnit)
             {
-                if (projectileCollidesWithUnit(simulation, projectile, unitId))
-                {
-                    return ProjectileCollisionInfoUnitOrFeatureOrBuilding();
-                }
+                return ProjectileCollisionInfoUnitOrFeatureOrBuilding();
             }
         }
 
@@ -1092,8 +1347,8 @@ namespace rwe
 
     BoundingBox3x<SimScalar> GameSimulation::createBoundingBox(const UnitState& unit) const
     {
-        const auto& unitDefinition = unitDefinitions.at(unit.unitType);
-        const auto& modelDefinition = unitModelDefinitions.at(unitDefinition.objectName);
+        const auto& unitDefinition = unitDefinitions.get(unit.unitType);
+        const auto& modelDefinition = *unit.modelDefinition;
         auto footprint = computeFootprintRegion(unit.position, unitDefinition.movementCollisionInfo);
         auto min = SimVector(SimScalar(footprint.x), unit.position.y, SimScalar(footprint.y));
         auto max = SimVector(SimScalar(footprint.x + footprint.width), unit.position.y + modelDefinition.height, SimScalar(footprint.y + footprint.height));
@@ -1105,9 +1360,11 @@ namespace rwe
     void GameSimulation::killUnit(UnitId unitId)
     {
         auto& unit = getUnitState(unitId);
-        const auto& unitDefinition = unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = unitDefinitions.get(unit.unitType);
 
         unit.markAsDead();
+        markUnitChanged(unitId);
+        markUnitTargetingChanged(unitId);
 
         auto deathType = unit.position.y < terrain.getSeaLevel() ? UnitDiedEvent::DeathType::WaterExploded : UnitDiedEvent::DeathType::NormalExploded;
         events.push_back(UnitDiedEvent{unitId, unit.unitType, unit.position, deathType});
@@ -1116,7 +1373,7 @@ namespace rwe
         if (!unitDefinition.explodeAs.empty())
         {
             auto impactType = unit.position.y < terrain.getSeaLevel() ? ImpactType::Water : ImpactType::Normal;
-            auto projectile = createProjectileFromWeapon(unit.owner, unitDefinition.explodeAs, unit.position, SimVector(0_ss, -1_ss, 0_ss), 0_ss, std::nullopt);
+            auto projectile = createProjectileFromWeapon(unit.owner, getWeaponDefinitionId(unitDefinition.explodeAs), unit.position, SimVector(0_ss, -1_ss, 0_ss), 0_ss, std::nullopt);
             doProjectileImpact(projectile, impactType);
         }
     }
@@ -1126,7 +1383,7 @@ namespace rwe
         auto& unit = getUnitState(unitId);
         if (unit.hitPoints <= damagePoints)
         {
-            const auto& unitDefinition = unitDefinitions.at(unit.unitType);
+            const auto& unitDefinition = unitDefinitions.get(unit.unitType);
             if (unit.isBeingBuilt(unitDefinition))
             {
                 // Units that are still under construction
@@ -1143,6 +1400,7 @@ namespace rwe
         else
         {
             unit.hitPoints -= damagePoints;
+            markUnitChanged(unitId);
         }
     }
 
@@ -1163,7 +1421,20 @@ namespace rwe
 
         auto radiusSquared = radius * radius;
 
-        std::unordered_set<UnitId> seenUnits;
+        const auto& weaponDefinition = weaponDefinitions.get(projectile.weaponType);
+
+        // Find every unit in range before damaging any of them.
+        // Damage can kill a unit whose explosion calls back into this function,
+        // so the scratch space must be done with by then.
+        struct Target
+        {
+            UnitId unitId;
+            SimScalar distanceSquared;
+            bool isFlying;
+        };
+        std::vector<Target> targets;
+
+        damageInRadiusSeenUnits.clear();
 
         auto region = GridRegion::fromCoordinates(minCell, maxCell);
 
@@ -1194,8 +1465,7 @@ namespace rwe
           }
 
           // check if the unit was seen/mark as seen
-          auto pair = seenUnits.insert(*u);
-          if (!pair.second) // the unit was already present
+          if (!damageInRadiusSeenUnits.insert(units.getSlotIndex(*u)))
           {
               return;
           }
@@ -1216,35 +1486,45 @@ namespace rwe
               return;
           }
 
-          // apply appropriate damage
-          auto damageScale = std::clamp(1_ss - (rweSqrt(unitDistanceSquared) / radius), 0_ss, 1_ss);
-          auto rawDamage = projectile.getDamage(unit.unitType);
-          auto scaledDamage = simScalarToUInt(SimScalar(rawDamage) * damageScale);
-          applyDamage(*u, scaledDamage); });
+          targets.push_back(Target{*u, unitDistanceSquared, false}); });
 
-        // Apply damage to flying units
-        for (const auto& flyingUnitId : flyingUnitsSet)
-        {
+        // Flying units are damaged in id order, after the ones on the ground.
+        auto firstFlyingTarget = targets.size();
+        forEachFlyingUnitNearCells(minPoint, maxPoint, [&](UnitId flyingUnitId) {
             const auto& unit = getUnitState(flyingUnitId);
 
             // skip units that are dying or dead
             if (!unit.isAlive())
             {
-                continue;
+                return;
             }
 
             // check if the unit is in range
             auto unitDistanceSquared = createBoundingBox(unit).distanceSquared(position);
             if (unitDistanceSquared > radiusSquared)
+            {
+                return;
+            }
+
+            targets.push_back(Target{flyingUnitId, unitDistanceSquared, true});
+        });
+        std::sort(targets.begin() + firstFlyingTarget, targets.end(), [](const auto& a, const auto& b) { return a.unitId < b.unitId; });
+
+        for (const auto& target : targets)
+        {
+            const auto& unit = getUnitState(target.unitId);
+
+            // an earlier target's death may have taken this unit with it
+            if (target.isFlying ? !unit.isAlive() : unit.isDead())
             {
                 continue;
             }
 
             // apply appropriate damage
-            auto damageScale = std::clamp(1_ss - (rweSqrt(unitDistanceSquared) / radius), 0_ss, 1_ss);
-            auto rawDamage = projectile.getDamage(unit.unitType);
+            auto damageScale = std::clamp(1_ss - (rweSqrt(target.distanceSquared) / radius), 0_ss, 1_ss);
+            auto rawDamage = weaponDefinition.getDamage(unit.unitType);
             auto scaledDamage = simScalarToUInt(SimScalar(rawDamage) * damageScale);
-            applyDamage(flyingUnitId, scaledDamage);
+            applyDamage(target.unitId, scaledDamage);
         }
     }
 
@@ -1260,7 +1540,7 @@ namespace rwe
             const auto& id = projectileEntry.first;
             auto& projectile = projectileEntry.second;
 
-            const auto& weaponDefinition = weaponDefinitions.at(projectile.weaponType);
+            const auto& weaponDefinition = weaponDefinitions.get(projectile.weaponType);
 
             // remove if it's time to die
             if (projectile.dieOnFrame && *projectile.dieOnFrame <= gameTime)
@@ -1358,7 +1638,7 @@ namespace rwe
         // if a commander died this frame, kill the player that owns it
         for (const auto& p : units)
         {
-            const auto& unitDefinition = unitDefinitions.at(p.second.unitType);
+            const auto& unitDefinition = unitDefinitions.get(p.second.unitType);
             if (unitDefinition.commander && p.second.isDead())
             {
                 killPlayer(p.second.owner);
@@ -1388,6 +1668,33 @@ namespace rwe
         }
     }
 
+    /** The hashed unit fields that updateResources rewrites each tick. */
+    struct UnitResourceState
+    {
+        Energy energyProductionBuffer;
+        Metal metalProductionBuffer;
+        Energy previousEnergyConsumptionBuffer;
+        Metal previousMetalConsumptionBuffer;
+        Energy energyConsumptionBuffer;
+        Metal metalConsumptionBuffer;
+        bool isSufficientlyPowered;
+
+        bool operator==(const UnitResourceState&) const = default;
+    };
+
+    UnitResourceState getUnitResourceState(const UnitState& unit)
+    {
+        return UnitResourceState{
+            unit.energyProductionBuffer,
+            unit.metalProductionBuffer,
+            unit.previousEnergyConsumptionBuffer,
+            unit.previousMetalConsumptionBuffer,
+            unit.energyConsumptionBuffer,
+            unit.metalConsumptionBuffer,
+            unit.isSufficientlyPowered,
+        };
+    }
+
     void GameSimulation::updateResources()
     {
         // run resource updates once per second
@@ -1403,7 +1710,7 @@ namespace rwe
             for (auto& entry : units)
             {
                 auto& unit = entry.second;
-                const auto& unitDefinition = unitDefinitions.at(unit.unitType);
+                const auto& unitDefinition = unitDefinitions.get(unit.unitType);
                 if (!unit.isBeingBuilt(unitDefinition))
                 {
                     auto& playerInfo = getPlayer(unit.owner);
@@ -1470,13 +1777,16 @@ namespace rwe
             {
                 const auto& unitId = entry.first;
                 auto& unit = entry.second;
-                const auto& unitDefinition = unitDefinitions.at(unit.unitType);
+                const auto& unitDefinition = unitDefinitions.get(unit.unitType);
 
+                // Most units make and use the same amounts every tick,
+                // so only mark the unit as changed if its buffers actually differ.
+                auto previousResourceState = getUnitResourceState(unit);
                 unit.resetResourceBuffers();
 
                 if (!unit.isBeingBuilt(unitDefinition))
                 {
-                    addResourceDelta(unitId, unitDefinition.energyMake, unitDefinition.metalMake);
+                    addUnitResourceDelta(unit, unitDefinition.energyMake, unitDefinition.metalMake);
                 }
 
                 if (unit.activated)
@@ -1484,7 +1794,7 @@ namespace rwe
                     if (unitDefinition.windGenerator != Energy(0))
                     {
                         // generate energy from wind
-                        addResourceDelta(unitId, unitDefinition.windGenerator * currentWindGenerationFactor, Metal(0));
+                        addUnitResourceDelta(unit, unitDefinition.windGenerator * currentWindGenerationFactor, Metal(0));
                     }
 
                     if (unit.isSufficientlyPowered)
@@ -1494,17 +1804,22 @@ namespace rwe
                         {
                             auto footprint = computeFootprintRegion(unit.position, unitDefinition.movementCollisionInfo);
                             auto metalValue = metalGrid.accumulate(metalGrid.clipRegion(footprint), 0u, std::plus<>());
-                            addResourceDelta(unitId, Energy(0), Metal(metalValue * unitDefinition.extractsMetal.value));
+                            addUnitResourceDelta(unit, Energy(0), Metal(metalValue * unitDefinition.extractsMetal.value));
                         }
 
                         // make metal
                         if (unitDefinition.makesMetal != Metal(0))
                         {
-                            addResourceDelta(unitId, Energy(0), unitDefinition.makesMetal);
+                            addUnitResourceDelta(unit, Energy(0), unitDefinition.makesMetal);
                         }
                     }
 
-                    unit.isSufficientlyPowered = addResourceDelta(unitId, -unitDefinition.energyUse, -unitDefinition.metalUse);
+                    unit.isSufficientlyPowered = addUnitResourceDelta(unit, -unitDefinition.energyUse, -unitDefinition.metalUse);
+                }
+
+                if (getUnitResourceState(unit) != previousResourceState)
+                {
+                    markUnitChanged(unitId);
                 }
             }
         }
@@ -1532,7 +1847,7 @@ namespace rwe
         for (auto it = units.begin(); it != units.end();)
         {
             const auto& unit = it->second;
-            const auto& unitDefinition = unitDefinitions.at(unit.unitType);
+            const auto& unitDefinition = unitDefinitions.get(unit.unitType);
             auto deadState = std::get_if<UnitState::LifeStateDead>(&unit.lifeState);
             if (deadState == nullptr)
             {
@@ -1555,7 +1870,7 @@ namespace rwe
             {
                 if (isFlying(unit.physics))
                 {
-                    flyingUnitsSet.erase(it->first);
+                    removeFlyingUnit(it->first);
                 }
                 else
                 {
@@ -1569,8 +1884,16 @@ namespace rwe
                   {
                       cell.buildingInfo = std::nullopt;
                   } });
+                pathFindingService.notifyObstaclesChanged(footprintRect);
             }
 
+            unitSpatialIndex.remove(it->first);
+            if (unitsTargetingChangedSincePlanning.contains(it->first))
+            {
+                unitsTargetingChangedSincePlanning.remove(it->first);
+            }
+            markUnitChanged(it->first);
+
             it = units.erase(it);
         }
 
@@ -1587,6 +1910,7 @@ namespace rwe
             const auto& projectile = it->second;
             if (projectile.isDead)
             {
+                projectileHashes.markChanged(it->first);
                 it = projectiles.erase(it);
             }
             else
@@ -1614,7 +1938,8 @@ namespace rwe
                     continue;
                 }
 
-                auto newUnitId = trySpawnUnit(s->unitType, s->owner, s->position, std::nullopt);
+                auto newUnitId = trySpawnUnit(unitDefinitions.get(s->unitType).unitType, s->owner, s->position, std::nullopt);
+                markUnitChanged(unitId);
                 if (!newUnitId)
                 {
                     s->status = UnitCreationStatusFailed();
@@ -1647,41 +1972,143 @@ namespace rwe
         unitCreationRequests.clear();
     }
 
+    void GameSimulation::planUnitUpdates()
+    {
+        unitUpdatePlans.resize(units.getSlotCount());
+        for (auto& plan : unitUpdatePlans)
+        {
+            plan.unitId = std::nullopt;
+        }
+
+        unitsTargetingChangedSincePlanning.clear();
+
+        if (!unitUpdatePlanningEnabled)
+        {
+            return;
+        }
+
+        auto threadCount = unitUpdateThreadCount == 0 ? ThreadPool::getDefaultThreadCount() : unitUpdateThreadCount;
+        if (!unitUpdateThreadPool || unitUpdateThreadPool->getThreadCount() != threadCount)
+        {
+            unitUpdateThreadPool = std::make_unique<ThreadPool>(threadCount);
+        }
+
+        plannedUnitIds.clear();
+        for (const auto& entry : units)
+        {
+            plannedUnitIds.push_back(entry.first);
+        }
+
+        // Each plan depends only on the state at the start of the tick
+        // and is written to its own slot, so the thread count does not matter.
+        const auto& constSimulation = *this;
+        unitUpdateThreadPool->parallelFor(plannedUnitIds.size(), [&](std::size_t i, unsigned int) {
+            auto unitId = plannedUnitIds[i];
+            planUnitUpdate(constSimulation, unitId, unitUpdatePlans[units.getSlotIndex(unitId)]);
+        });
+    }
+
+    const UnitUpdatePlan* GameSimulation::tryGetUnitUpdatePlan(UnitId unitId) const
+    {
+        auto slot = units.getSlotIndex(unitId);
+        if (slot >= unitUpdatePlans.size() || unitUpdatePlans[slot].unitId != unitId)
+        {
+            return nullptr;
+        }
+
+        return &unitUpdatePlans[slot];
+    }
+
+    bool GameSimulation::hasUnitTargetingChangedSincePlanning(UnitId unitId) const
+    {
+        return unitsTargetingChangedSincePlanning.contains(unitId);
+    }
+
     void GameSimulation::tick()
     {
         gameTime += GameTime(1);
 
-        updateWind();
+        RWE_PROFILE_BEGIN_TICK(tickProfiler, gameTime);
 
-        updateResources();
+        {
+            RWE_PROFILE_PHASE(tickProfiler, TickPhase::Wind);
+            updateWind();
+        }
 
-        pathFindingService.update(*this);
+        {
+            RWE_PROFILE_PHASE(tickProfiler, TickPhase::Resources);
+            updateResources();
+        }
+
+        {
+            RWE_PROFILE_PHASE(tickProfiler, TickPhase::PathFinding);
+            pathFindingService.update(*this);
+        }
+
+        {
+            RWE_PROFILE_PHASE(tickProfiler, TickPhase::UnitPlanning);
+            planUnitUpdates();
+        }
 
-        // run unit scripts
+        // Update units in id order, acting on their plans.
+        // Units created during the tick were not planned for,
+        // so their updates do their own scans instead.
+        UnitUpdatePlan unplanned;
         for (auto& entry : units)
         {
             auto unitId = entry.first;
             auto& unit = entry.second;
 
-            UnitBehaviorService(this).update(unitId);
+            RWE_PROFILE_UNIT_TYPE(tickProfiler, unit.unitType);
 
-            for (auto& piece : unit.pieces)
             {
-                piece.update(SimScalar(SimMillisecondsPerTick) / 1000_ss);
+                RWE_PROFILE_PHASE(tickProfiler, TickPhase::UnitBehavior);
+                const auto* plan = tryGetUnitUpdatePlan(unitId);
+                if (plan == nullptr)
+                {
+                    unplanned.unitId = unitId;
+                    plan = &unplanned;
+                }
+                UnitBehaviorService(this).update(unitId, *plan);
             }
 
-            runUnitCobScripts(*this, unitId);
+            {
+                RWE_PROFILE_PHASE(tickProfiler, TickPhase::Pieces);
+                unit.updatePieces(SimScalar(SimMillisecondsPerTick) / 1000_ss);
+            }
+
+            {
+                RWE_PROFILE_PHASE(tickProfiler, TickPhase::Cob);
+                runUnitCobScripts(*this, unitId);
+            }
+        }
+
+        {
+            RWE_PROFILE_PHASE(tickProfiler, TickPhase::Projectiles);
+            updateProjectiles();
         }
 
-        updateProjectiles();
+        {
+            RWE_PROFILE_PHASE(tickProfiler, TickPhase::VictoryCondition);
+            processVictoryCondition();
+        }
 
-        processVictoryCondition();
+        {
+            RWE_PROFILE_PHASE(tickProfiler, TickPhase::DeleteDeadUnits);
+            deleteDeadUnits();
+        }
 
-        deleteDeadUnits();
+        {
+            RWE_PROFILE_PHASE(tickProfiler, TickPhase::DeleteDeadProjectiles);
+            deleteDeadProjectiles();
+        }
 
-        deleteDeadProjectiles();
+        {
+            RWE_PROFILE_PHASE(tickProfiler, TickPhase::SpawnNewUnits);
+            spawnNewUnits();
+        }
 
-        spawnNewUnits();
+        RWE_PROFILE_END_TICK(tickProfiler);
     }
 
     std::optional<FeatureDefinitionId> GameSimulation::tryGetFeatureDefinitionId(const std::string& featureName) const
@@ -1698,4 +2125,80 @@ namespace rwe
     {
         return featureDefinitions.get(featureDefinitionId);
     }
+
+    std::optional<UnitDefinitionId> GameSimulation::tryGetUnitDefinitionId(const std::string& unitType) const
+    {
+        if (auto it = unitNameIndex.find(toUpper(unitType)); it != unitNameIndex.end())
+        {
+            return it->second;
+        }
+
+        return std::nullopt;
+    }
+
+    void GameSimulation::resolveOrder(UnitOrder& order) const
+    {
+        if (auto buildOrder = std::get_if<BuildOrder>(&order))
+        {
+            buildOrder->unitDefinitionId = tryGetUnitDefinitionId(buildOrder->unitType);
+        }
+    }
+
+    UnitDefinitionId GameSimulation::getUnitDefinitionId(const std::string& unitType) const
+    {
+        auto id = tryGetUnitDefinitionId(unitType);
+        if (!id)
+        {
+            throw std::runtime_error("Unknown unit type: " + unitType);
+        }
+
+        return *id;
+    }
+
+    const UnitDefinition& GameSimulation::getUnitDefinition(UnitDefinitionId unitDefinitionId) const
+    {
+        return unitDefinitions.get(unitDefinitionId);
+    }
+
+    std::optional<WeaponDefinitionId> GameSimulation::tryGetWeaponDefinitionId(const std::string& weaponType) const
+    {
+        if (auto it = weaponNameIndex.find(toUpper(weaponType)); it != weaponNameIndex.end())
+        {
+            return it->second;
+        }
+
+        return std::nullopt;
+    }
+
+    WeaponDefinitionId GameSimulation::getWeaponDefinitionId(const std::string& weaponType) const
+    {
+        auto id = tryGetWeaponDefinitionId(weaponType);
+        if (!id)
+        {
+            throw std::runtime_error("Unknown weapon type: " + weaponType);
+        }
+
+        return *id;
+    }
+
+    const WeaponDefinition& GameSimulation::getWeaponDefinition(WeaponDefinitionId weaponDefinitionId) const
+    {
+        return weaponDefinitions.get(weaponDefinitionId);
+    }
+
+    void GameSimulation::resolveWeaponDamage()
+    {
+        auto unitTypeCount = unitDefinitions.getNextId().value;
+        auto weaponTypeCount = weaponDefinitions.getNextId().value;
+        for (unsigned int w = 0; w < weaponTypeCount; ++w)
+        {
+            auto& weaponDefinition = weaponDefinitions.get(WeaponDefinitionId(w));
+            weaponDefinition.damageByUnitType.clear();
+            weaponDefinition.damageByUnitType.reserve(unitTypeCount);
+            for (unsigned int u = 0; u < unitTypeCount; ++u)
+            {
+                weaponDefinition.damageByUnitType.push_back(weaponDefinition.tryGetDamage(unitDefinitions.get(UnitDefinitionId(u)).unitType));
+            }
+        }
+    }
 }
@@ -1,8 +1,11 @@
 #pragma once
 
+#include <array>
+#include <memory>
 #include <random>
 #include <rwe/cob/CobUnitId.h>
 #include <rwe/collections/SimpleVectorMap.h>
+#include <rwe/collections/StampedSet.h>
 #include <rwe/collections/VectorMap.h>
 #include <rwe/game/PlayerColorIndex.h>
 #include <rwe/geometry/BoundingBox3x.h>
@@ -10,7 +13,9 @@
 #include <rwe/sim/FeatureDefinition.h>
 #include <rwe/sim/FeatureId.h>
 #include <rwe/sim/GameHash.h>
+#include <rwe/sim/GameHashHistory.h>
 #include <rwe/sim/GameTime.h>
+#include <rwe/sim/IncrementalGameHash.h>
 #include <rwe/sim/MapFeature.h>
 #include <rwe/sim/MapTerrain.h>
 #include <rwe/sim/MovementClassCollisionService.h>
@@ -21,10 +26,16 @@
 #include <rwe/sim/Projectile.h>
 #include <rwe/sim/ProjectileId.h>
 #include <rwe/sim/SimAxis.h>
+#include <rwe/sim/TickProfiler.h>
 #include <rwe/sim/UnitDefinition.h>
+#include <rwe/sim/UnitDefinitionId.h>
 #include <rwe/sim/UnitId.h>
 #include <rwe/sim/UnitModelDefinition.h>
+#include <rwe/sim/UnitSpatialIndex.h>
 #include <rwe/sim/UnitState.h>
+#include <rwe/sim/WeaponDefinition.h>
+#include <rwe/sim/WeaponDefinitionId.h>
+#include <rwe/util/ThreadPool.h>
 #include <set>
 #include <unordered_map>
 
@@ -87,11 +98,47 @@ namespace rwe
     {
         UnitId unitId;
 
+        /**
+         * True if the unit has just been given a new goal,
+         * rather than asking again for the goal it already had,
+         * e.g. after a collision or at the end of a partial path.
+         * Only requests for a new goal may follow a shared flow field,
+         * since flow fields ignore mobile units.
+         */
+        bool isNewGoal{false};
+
+        /** Requests are equal if they are for the same unit. */
         bool operator==(const PathRequest& rhs) const;
 
         bool operator!=(const PathRequest& rhs) const;
     };
 
+    /**
+     * The parts of a unit's update that only read the simulation,
+     * worked out for every unit in parallel at the start of the tick.
+     * The serial part of the update then acts on the plan.
+     */
+    struct UnitUpdatePlan
+    {
+        /**
+         * The unit this plan is for.
+         * Empty if the slot was free when the tick started.
+         */
+        std::optional<UnitId> unitId;
+
+        /**
+         * Whether each weapon was idle and free to pick its own target,
+         * and so has an entry in weaponTargets.
+         */
+        std::array<bool, 3> weaponTargetPlanned{};
+
+        /**
+         * For each planned weapon, the enemy it should start attacking,
+         * if any was in range at the start of the tick.
+         */
+        std::array<std::optional<UnitId>, 3> weaponTargets;
+    };
+
     struct WinStatusWon
     {
         PlayerId winner;
@@ -106,7 +153,7 @@ namespace rwe
 
     struct FireWeaponEvent
     {
-        std::string weaponType;
+        WeaponDefinitionId weaponType;
         /**
          * The number of this shot within the weapon's current burst.
          * If this is the first shot of the burst, it will be 0.
@@ -143,7 +190,7 @@ namespace rwe
     struct UnitDiedEvent
     {
         UnitId unitId;
-        std::string unitType;
+        UnitDefinitionId unitType;
         SimVector position;
         enum class DeathType
         {
@@ -181,7 +228,7 @@ namespace rwe
     struct ProjectileDiedEvent
     {
         ProjectileId projectileId;
-        std::string weaponType;
+        WeaponDefinitionId weaponType;
         SimVector position;
 
         enum class DeathType
@@ -245,16 +292,25 @@ namespace rwe
 
         MapTerrain terrain;
 
-        std::unordered_map<std::string, UnitDefinition> unitDefinitions;
+        SimpleVectorMap<UnitDefinition, UnitDefinitionIdTag> unitDefinitions;
+        std::unordered_map<std::string, UnitDefinitionId> unitNameIndex;
 
         SimpleVectorMap<FeatureDefinition, FeatureDefinitionIdTag> featureDefinitions;
         std::unordered_map<std::string, FeatureDefinitionId> featureNameIndex;
 
         std::unordered_map<std::string, UnitModelDefinition> unitModelDefinitions;
 
-        std::unordered_map<std::string, CobScript> unitScriptDefinitions;
+        std::unordered_map<std::string, CobProgram> unitScriptDefinitions;
 
-        std::unordered_map<std::string, WeaponDefinition> weaponDefinitions;
+        /**
+         * For each unit type, maps the pieces in its COB script
+         * to their indices in its model.
+         * Built when the first unit of the type is created.
+         */
+        std::unordered_map<UnitDefinitionId, std::vector<std::optional<int>>> unitCobPieceIndices;
+
+        SimpleVectorMap<WeaponDefinition, WeaponDefinitionIdTag> weaponDefinitions;
+        std::unordered_map<std::string, WeaponDefinitionId> weaponNameIndex;
 
         MovementClassDatabase movementClassDatabase;
         MovementClassCollisionService movementClassCollisionService;
@@ -262,8 +318,34 @@ namespace rwe
         PathFindingService pathFindingService;
 
         OccupiedGrid occupiedGrid;
+
+        /** Use addFlyingUnit and removeFlyingUnit to keep flyingUnitSpatialIndex in step. */
         std::set<UnitId> flyingUnitsSet;
 
+        /**
+         * Index of unit positions for proximity queries.
+         * Must be kept up to date whenever a unit moves on the XZ plane.
+         */
+        UnitSpatialIndex unitSpatialIndex;
+
+        /**
+         * Index of the positions of the units in flyingUnitsSet.
+         * Flying units are not in the occupied grid,
+         * so projectiles use this to find the ones they might hit.
+         */
+        UnitSpatialIndex flyingUnitSpatialIndex;
+
+        /**
+         * The largest footprint dimension, in heightmap cells,
+         * of any unit added to flyingUnitSpatialIndex.
+         * A flying unit can be hit anywhere in its footprint
+         * but is indexed by its position, so queries are padded by this.
+         */
+        int maxFlyingUnitFootprint{0};
+
+        /** Units already considered by the current applyDamageInRadius, by slot. */
+        StampedSet damageInRadiusSeenUnits;
+
         Grid<unsigned char> metalGrid;
 
         Grid<bool> geoGrid;
@@ -274,10 +356,70 @@ namespace rwe
 
         VectorMap<UnitState, UnitIdTag> units;
 
+        /**
+         * Running hash of the units.
+         * Units are marked as changed when they are added or removed.
+         * Code that modifies a hashed unit field must mark the unit
+         * through markUnitChanged.
+         */
+        IncrementalGameHash<UnitId> unitHashes;
+
+        /**
+         * In debug builds, every this many ticks computeHash checks
+         * the incremental hash against a full recomputation
+         * and throws if they differ. Zero disables the check.
+         */
+        unsigned int hashCheckInterval{30};
+
         VectorMap<Projectile, ProjectileIdTag> projectiles;
 
+        /**
+         * Running hash of the projectiles.
+         * Projectiles move every tick, so every one is rehashed,
+         * but removed ones must be marked when they are erased.
+         */
+        IncrementalGameHash<ProjectileId> projectileHashes;
+
+        /**
+         * True if the running hashes have been restarted since computeHashDelta was last called,
+         * so that the next delta must list every unit and projectile.
+         */
+        bool hashesRestarted{false};
+
         std::deque<PathRequest> pathRequests;
 
+        /** The plan for each unit in the current tick, by slot. */
+        std::vector<UnitUpdatePlan> unitUpdatePlans;
+
+        /** The units planned for in the current tick, in id order. */
+        std::vector<UnitId> plannedUnitIds;
+
+        /**
+         * The units whose position or life state has changed
+         * since the plans were made this tick, indexed by where they are now.
+         * Only these can have become better weapon targets than the planned ones,
+         * so plans are checked against the ones in range before they are acted on.
+         * Use markUnitTargetingChanged to add to it.
+         */
+        UnitSpatialIndex unitsTargetingChangedSincePlanning;
+
+        /**
+         * When false, units are not planned for and each unit's update
+         * scans for targets itself in the serial loop.
+         * Either way the outcome of the simulation is the same.
+         */
+        bool unitUpdatePlanningEnabled{true};
+
+        /**
+         * The number of threads that plan unit updates,
+         * or zero for one per hardware thread.
+         * This does not change the outcome of the simulation.
+         */
+        unsigned int unitUpdateThreadCount{0};
+
+        /** Runs the planning phase of each tick. Created on first use. */
+        std::unique_ptr<ThreadPool> unitUpdateThreadPool;
+
         std::deque<UnitId> unitCreationRequests;
 
         GameTime gameTime{0};
@@ -292,6 +434,12 @@ namespace rwe
 
         GameTime nextWindSpeedChange;
 
+        /**
+         * Timings of recent ticks, for diagnostics only.
+         * This is not part of the simulation state.
+         */
+        TickProfiler tickProfiler;
+
         explicit GameSimulation(MapTerrain&& terrain, unsigned char surfaceMetal, int minWindSpeed, int maxWindSpeed);
 
         std::optional<FeatureId> addFeature(MapFeature&& newFeature);
@@ -300,6 +448,12 @@ namespace rwe
 
         PlayerId addPlayer(const GamePlayerInfo& info);
 
+        /**
+         * Returns the map from the pieces in the unit type's COB script
+         * to the pieces of its model, building it on first use.
+         */
+        const std::vector<std::optional<int>>& getCobPieceIndices(UnitDefinitionId unitType, const CobProgram& script);
+
         std::optional<UnitId> trySpawnUnit(const std::string& unitType, PlayerId owner, const SimVector& position, std::optional<SimAngle> rotation);
 
         /**
@@ -329,18 +483,32 @@ namespace rwe
 
         bool isCollisionAt(const DiscreteRect& rect, UnitId self) const;
 
+        /**
+         * Returns true if the cell is blocked by something that does not move,
+         * i.e. a building or a blocking feature.
+         */
+        bool isStaticObstacle(const OccupiedCell& cell) const;
+
         bool isYardmapBlocked(unsigned int x, unsigned int y, const Grid<YardMapCell>& yardMap, bool open, UnitId self) const;
 
         bool isAdjacentToObstacle(const DiscreteRect& rect) const;
 
         void showObject(UnitId unitId, const std::string& name);
 
+        void showObject(UnitId unitId, int pieceIndex);
+
         void hideObject(UnitId unitId, const std::string& name);
 
+        void hideObject(UnitId unitId, int pieceIndex);
+
         void enableShading(UnitId unitId, const std::string& name);
 
+        void enableShading(UnitId unitId, int pieceIndex);
+
         void disableShading(UnitId unitId, const std::string& name);
 
+        void disableShading(UnitId unitId, int pieceIndex);
+
         UnitState& getUnitState(UnitId id);
 
         const UnitState& getUnitState(UnitId id) const;
@@ -357,6 +525,72 @@ namespace rwe
 
         bool unitExists(UnitId id) const;
 
+        /**
+         * Must be called after modifying any field of the unit
+         * that contributes to its hash (see forEachHashedField),
+         * so that computeHash picks up the change.
+         */
+        void markUnitChanged(UnitId id);
+
+        /**
+         * Must be called after changing the unit's position or life state,
+         * or anything else that decides whether it is a valid weapon target,
+         * so that plans made earlier in the tick are checked against it.
+         */
+        void markUnitTargetingChanged(UnitId id);
+
+        /**
+         * Calls f(unitId, unitState) for every unit whose position
+         * is within the given rectangle on the XZ plane.
+         * min and max are the world space corners of the rectangle,
+         * y components are ignored.
+         * Units are visited in an unspecified order.
+         */
+        template <typename Func>
+        void forEachUnitInRectangle(const SimVector& min, const SimVector& max, Func f) const
+        {
+            forEachUnitNearRectangle(min, max, [&](UnitId unitId, const UnitState& unit) {
+                if (unit.position.x < min.x || unit.position.x > max.x || unit.position.z < min.z || unit.position.z > max.z)
+                {
+                    return;
+                }
+                f(unitId, unit);
+            });
+        }
+
+        /**
+         * Calls f(unitId, unitState) for every unit whose position
+         * is within the given radius of the given position on the XZ plane.
+         * Units are visited in an unspecified order.
+         */
+        template <typename Func>
+        void forEachUnitInRadius(const SimVector& position, SimScalar radius, Func f) const
+        {
+            auto radiusSquared = radius * radius;
+            SimVector min(position.x - radius, position.y, position.z - radius);
+            SimVector max(position.x + radius, position.y, position.z + radius);
+            forEachUnitNearRectangle(min, max, [&](UnitId unitId, const UnitState& unit) {
+                auto dx = unit.position.x - position.x;
+                auto dz = unit.position.z - position.z;
+                if ((dx * dx) + (dz * dz) > radiusSquared)
+                {
+                    return;
+                }
+                f(unitId, unit);
+            });
+        }
+
+        void updateUnitSpatialIndex(UnitId unitId, const SimVector& position);
+
+        void addFlyingUnit(UnitId unitId);
+
+        void removeFlyingUnit(UnitId unitId);
+
+        void updateFlyingUnitSpatialIndex(UnitId unitId, const SimVector& position);
+
+        /** Rebuilds flyingUnitSpatialIndex from flyingUnitsSet, e.g. after restoring a snapshot. */
+        void rebuildFlyingUnitSpatialIndex();
+
         MapFeature& getFeature(FeatureId id);
 
         const MapFeature& getFeature(FeatureId id) const;
@@ -371,29 +605,49 @@ namespace rwe
 
         void moveObject(UnitId unitId, const std::string& name, SimAxis axis, SimScalar position, SimScalar speed);
 
+        void moveObject(UnitId unitId, int pieceIndex, SimAxis axis, SimScalar position, SimScalar speed);
+
         void moveObjectNow(UnitId unitId, const std::string& name, SimAxis axis, SimScalar position);
 
+        void moveObjectNow(UnitId unitId, int pieceIndex, SimAxis axis, SimScalar position);
+
         void turnObject(UnitId unitId, const std::string& name, SimAxis axis, SimAngle angle, SimScalar speed);
 
+        void turnObject(UnitId unitId, int pieceIndex, SimAxis axis, SimAngle angle, SimScalar speed);
+
         void turnObjectNow(UnitId unitId, const std::string& name, SimAxis axis, SimAngle angle);
 
+        void turnObjectNow(UnitId unitId, int pieceIndex, SimAxis axis, SimAngle angle);
+
         void spinObject(UnitId unitId, const std::string& name, SimAxis axis, SimScalar speed, SimScalar acceleration);
 
+        void spinObject(UnitId unitId, int pieceIndex, SimAxis axis, SimScalar speed, SimScalar acceleration);
+
         void stopSpinObject(UnitId unitId, const std::string& name, SimAxis axis, SimScalar deceleration);
 
+        void stopSpinObject(UnitId unitId, int pieceIndex, SimAxis axis, SimScalar deceleration);
+
         bool isPieceMoving(UnitId unitId, const std::string& name, SimAxis axis) const;
 
+        bool isPieceMoving(UnitId unitId, int pieceIndex, SimAxis axis) const;
+
         bool isPieceTurning(UnitId unitId, const std::string& name, SimAxis axis) const;
 
+        bool isPieceTurning(UnitId unitId, int pieceIndex, SimAxis axis) const;
+
         std::optional<SimVector> intersectLineWithTerrain(const Line3x<SimScalar>& line) const;
 
         void moveUnitOccupiedArea(const DiscreteRect& oldRect, const DiscreteRect& newRect, UnitId unitId);
 
-        void requestPath(UnitId unitId);
+        /**
+         * Queues a path request for the unit, replacing any it already has queued.
+         * isNewGoal is as in PathRequest.
+         */
+        void requestPath(UnitId unitId, bool isNewGoal);
 
         Projectile createProjectileFromWeapon(PlayerId owner, const UnitWeapon& weapon, const SimVector& position, const SimVector& direction, SimScalar distanceToTarget, std::optional<UnitId> targetUnit);
 
-        Projectile createProjectileFromWeapon(PlayerId owner, const std::string& weaponType, const SimVector& position, const SimVector& direction, SimScalar distanceToTarget, std::optional<UnitId> targetUnit);
+        Projectile createProjectileFromWeapon(PlayerId owner, WeaponDefinitionId weaponType, const SimVector& position, const SimVector& direction, SimScalar distanceToTarget, std::optional<UnitId> targetUnit);
 
         void spawnProjectile(PlayerId owner, const UnitWeapon& weapon, const SimVector& position, const SimVector& direction, SimScalar distanceToTarget, std::optional<UnitId> targetUnit);
 
@@ -402,13 +656,52 @@ namespace rwe
         bool addResourceDelta(const UnitId& unitId, const Energy& apparentEnergy, const Metal& apparentMetal, const Energy& actualEnergy, const Metal& actualMetal);
         bool addResourceDelta(const UnitId& unitId, const Energy& energy, const Metal& metal);
 
+        /** As addResourceDelta, but does not mark the unit as changed. */
+        bool addUnitResourceDelta(UnitState& unit, const Energy& apparentEnergy, const Metal& apparentMetal, const Energy& actualEnergy, const Metal& actualMetal);
+        bool addUnitResourceDelta(UnitState& unit, const Energy& energy, const Metal& metal);
+
         bool trySetYardOpen(const UnitId& unitId, bool open);
 
         void emitBuggerOff(const UnitId& unitId);
 
         void tellToBuggerOff(const UnitId& unitId, const DiscreteRect& rect);
 
-        GameHash computeHash() const;
+        /**
+         * Returns the hash of the simulation state.
+         * Only units changed since the last call are rehashed.
+         */
+        GameHash computeHash();
+
+        /**
+         * Returns the hash of the simulation state as computeHash does,
+         * together with the delta from which a GameHashHistory
+         * can rebuild this tick's hash tree.
+         * The delta lists the units and projectiles whose hash changed
+         * since the last call, so computeHash must not be called in between.
+         */
+        std::pair<GameHash, GameHashDelta> computeHashDelta();
+
+        /**
+         * Rehashes the units marked as changed and returns the hash of all units.
+         * If changes is not null, the field hashes of units whose hash changed,
+         * and the ids of units that were removed, are added to it.
+         */
+        GameHash updateUnitsHash(std::vector<GameHashDelta::Change>* changes);
+
+        /** As updateUnitsHash, for every projectile. */
+        GameHash updateProjectilesHash(std::vector<GameHashDelta::Change>* changes);
+
+        /**
+         * Starts the running hashes over from every unit and projectile,
+         * e.g. after they were all replaced by restoring a snapshot.
+         */
+        void restartHashes();
+
+        /**
+         * In debug builds, throws if hashCheckInterval divides the game time
+         * and the given hash does not match a full recomputation.
+         */
+        void checkIncrementalHash(GameHash hash) const;
 
         void activateUnit(UnitId unitId);
 
@@ -418,10 +711,16 @@ namespace rwe
 
         Matrix4x<SimScalar> getUnitPieceLocalTransform(UnitId unitId, const std::string& pieceName) const;
 
+        Matrix4x<SimScalar> getUnitPieceLocalTransform(UnitId unitId, int pieceIndex) const;
+
         Matrix4x<SimScalar> getUnitPieceTransform(UnitId unitId, const std::string& pieceName) const;
 
+        Matrix4x<SimScalar> getUnitPieceTransform(UnitId unitId, int pieceIndex) const;
+
         SimVector getUnitPiecePosition(UnitId unitId, const std::string& pieceName) const;
 
+        SimVector getUnitPiecePosition(UnitId unitId, int pieceIndex) const;
+
         void setBuildStance(UnitId unitId, bool value);
 
         void setYardOpen(UnitId unitId, bool value);
@@ -460,10 +759,102 @@ namespace rwe
 
         void spawnNewUnits();
 
+        /** Fills unitUpdatePlans for every unit, in parallel. */
+        void planUnitUpdates();
+
+        /** Returns the plan made for the unit this tick, or null if it was not planned for. */
+        const UnitUpdatePlan* tryGetUnitUpdatePlan(UnitId unitId) const;
+
+        /** Returns true if markUnitTargetingChanged has been called for the unit since the plans were made this tick. */
+        bool hasUnitTargetingChangedSincePlanning(UnitId unitId) const;
+
+        /**
+         * Calls f(unitId, unitState) for every unit marked by markUnitTargetingChanged
+         * since the plans were made this tick whose position might be
+         * within the given radius of the given position on the XZ plane.
+         * This is a superset of the units inside the radius.
+         * Units are visited in an unspecified order.
+         */
+        template <typename Func>
+        void forEachUnitTargetingChangedNear(const SimVector& position, SimScalar radius, Func f) const
+        {
+            SimVector min(position.x - radius, position.y, position.z - radius);
+            SimVector max(position.x + radius, position.y, position.z + radius);
+            forEachIndexedUnitNearRectangle(unitsTargetingChangedSincePlanning, min, max, f);
+        }
+
         void tick();
 
         std::optional<FeatureDefinitionId> tryGetFeatureDefinitionId(const std::string& featureName) const;
 
         const FeatureDefinition& getFeatureDefinition(FeatureDefinitionId featureDefinitionId) const;
+
+        std::optional<UnitDefinitionId> tryGetUnitDefinitionId(const std::string& unitType) const;
+
+        /** Returns the id of the given unit type, or throws if there is no such type. */
+        UnitDefinitionId getUnitDefinitionId(const std::string& unitType) const;
+
+        const UnitDefinition& getUnitDefinition(UnitDefinitionId unitDefinitionId) const;
+
+        /**
+         * Fills in the parts of an order that the simulation looks up by name,
+         * such as the unit type of a build order.
+         * Called when an order is given to a unit.
+         */
+        void resolveOrder(UnitOrder& order) const;
+
+        std::optional<WeaponDefinitionId> tryGetWeaponDefinitionId(const std::string& weaponType) const;
+
+        /** Returns the id of the given weapon type, or throws if there is no such type. */
+        WeaponDefinitionId getWeaponDefinitionId(const std::string& weaponType) const;
+
+        const WeaponDefinition& getWeaponDefinition(WeaponDefinitionId weaponDefinitionId) const;
+
+        /**
+         * Resolves every weapon's damage table against the unit definitions,
+         * so that damage can be looked up by UnitDefinitionId.
+         * Must be called again whenever unit or weapon definitions are added.
+         */
+        void resolveWeaponDamage();
+
+        /**
+         * Calls f for every unit in the spatial index buckets
+         * overlapping the given rectangle on the XZ plane.
+         * This is a superset of the units inside the rectangle.
+         */
+        template <typename Func>
+        void forEachUnitNearRectangle(const SimVector& min, const SimVector& max, Func f) const
+        {
+            forEachIndexedUnitNearRectangle(unitSpatialIndex, min, max, f);
+        }
+
+        /**
+         * Calls f for every unit in the given index's buckets
+         * overlapping the given rectangle on the XZ plane.
+         */
+        template <typename Func>
+        void forEachIndexedUnitNearRectangle(const UnitSpatialIndex& index, const SimVector& min, const SimVector& max, Func f) const
+        {
+            // pad by a cell so that rounding at bucket boundaries never loses a unit
+            auto minPoint = terrain.worldToHeightmapCoordinate(min) - Point(1, 1);
+            auto maxPoint = terrain.worldToHeightmapCoordinate(max) + Point(1, 1);
+            index.forEachInRegion(minPoint, maxPoint, [&](UnitId unitId) {
+                f(unitId, getUnitState(unitId));
+            });
+        }
+
+        /**
+         * Calls f(unitId) for every flying unit whose footprint
+         * might overlap the given heightmap cell rectangle (inclusive).
+         * Units are visited in an unspecified order.
+         */
+        template <typename Func>
+        void forEachFlyingUnitNearCells(const Point& min, const Point& max, Func f) const
+        {
+            // half a footprint either side of the unit's position,
+            // plus a cell for rounding in each of the footprint and the index
+            auto padding = maxFlyingUnitFootprint / 2 + 2;
+            flyingUnitSpatialIndex.forEachInRegion(min - Point(padding, padding), max + Point(padding, padding), f);
+        }
     };
 }
@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/sim/GameHashHistory.h>
+#include <rwe/sim/GameHashTree.h>
+#include <rwe/sim/GameHash_util.h>
+#include <rwe/sim/GameSimulation.h>
+
+namespace rwe
+{
+    GameSimulation createBattleTestSimulation(unsigned int unitUpdateThreadCount)
+    {
+        GameSimulation simulation(MapTerrain(Grid<unsigned char>(64, 64, 10), 0_ss), 0, 1000, 3000);
+        simulation.unitUpdateThreadCount = unitUpdateThreadCount;
+
+        WeaponDefinition weaponDefinition{};
+        weaponDefinition.weaponType = "TESTGUN";
+        weaponDefinition.physicsType = ProjectilePhysicsTypeLineOfSight();
+        weaponDefinition.maxRange = 150_ss;
+        weaponDefinition.reloadTime = 1_ss;
+        weaponDefinition.burst = 1;
+        weaponDefinition.velocity = 10_ss;
+        weaponDefinition.damage = {{"DEFAULT", 20}};
+        weaponDefinition.damageRadius = 16_ss;
+        auto weaponDefinitionId = simulation.weaponDefinitions.insert(weaponDefinition);
+        simulation.weaponNameIndex.insert({"TESTGUN", weaponDefinitionId});
+
+        UnitDefinition unitDefinition{};
+        unitDefinition.unitType = "TESTUNIT";
+        unitDefinition.objectName = "TESTMODEL";
+        unitDefinition.movementCollisionInfo = UnitDefinition::AdHocMovementClass{2, 2, 255, 255, 0, 255};
+        unitDefinition.maxHitPoints = 100;
+        unitDefinition.isMobile = true;
+        unitDefinition.maxVelocity = 1_ss;
+        unitDefinition.acceleration = 1_ss;
+        unitDefinition.brakeRate = 1_ss;
+        unitDefinition.turnRate = SimScalar(1000);
+        unitDefinition.weapon1 = "TESTGUN";
+        unitDefinition.explodeAs = "TESTGUN";
+        auto unitDefinitionId = simulation.unitDefinitions.insert(unitDefinition);
+        simulation.unitNameIndex.insert({"TESTUNIT", unitDefinitionId});
+        simulation.resolveWeaponDamage();
+
+        std::vector<UnitPieceDefinition> pieces{UnitPieceDefinition{"base", SimVector(0_ss, 0_ss, 0_ss), std::nullopt}};
+        simulation.unitModelDefinitions.insert({"TESTMODEL", createUnitModelDefinition(10_ss, std::move(pieces))});
+
+        CobScript script;
+        script.pieces = {"base"};
+        script.staticVariableCount = 0;
+        simulation.unitScriptDefinitions.insert({"TESTUNIT", compileCobScript(std::move(script))});
+
+        for (int p = 0; p < 2; ++p)
+        {
+            auto player = simulation.addPlayer(GamePlayerInfo{
+                .name = std::string("Player"),
+                .type = GamePlayerType::Computer,
+                .color = PlayerColorIndex(p),
+                .status = GamePlayerStatus::Alive,
+                .side = "ARM",
+                .metal = Metal(500),
+                .energy = Energy(500),
+                .maxMetal = Metal(1000),
+                .maxEnergy = Energy(1000),
+                .startingMetal = Metal(500),
+                .startingEnergy = Energy(500),
+            });
+
+            // two lines of units marching through each other
+            auto startZ = p == 0 ? -200_ss : 200_ss;
+            for (int i = 0; i < 20; ++i)
+            {
+                auto x = SimScalar(-380 + (i * 40));
+                auto unit = simulation.trySpawnUnit("TESTUNIT", player, SimVector(x, 10_ss, startZ), std::nullopt);
+                REQUIRE(unit);
+                simulation.getUnitState(*unit).addOrder(createMoveOrder(SimVector(x, 10_ss, -startZ)));
+            }
+        }
+
+        return simulation;
+    }
+
+    /** Returns the unit each weapon of each unit is attacking, if any, in id order. */
+    std::vector<std::optional<UnitId>> getWeaponTargets(const GameSimulation& simulation)
+    {
+        std::vector<std::optional<UnitId>> targets;
+        for (const auto& [unitId, unit] : simulation.units)
+        {
+            for (const auto& weapon : unit.weapons)
+            {
+                auto attacking = weapon ? std::get_if<UnitWeaponStateAttacking>(&weapon->state) : nullptr;
+                auto target = attacking ? std::get_if<UnitId>(&attacking->target) : nullptr;
+                targets.push_back(target ? std::make_optional(*target) : std::nullopt);
+            }
+        }
+        return targets;
+    }
+
+    TEST_CASE("GameSimulation")
+    {
+        SECTION("gives the same result whether units are planned in serial or in parallel")
+        {
+            auto serial = createBattleTestSimulation(1);
+            auto parallel = createBattleTestSimulation(4);
+
+            auto anyShotsFired = false;
+            for (int i = 0; i < 300; ++i)
+            {
+                serial.tick();
+                parallel.tick();
+
+                for (const auto& e : serial.events)
+                {
+                    anyShotsFired = anyShotsFired || std::holds_alternative<FireWeaponEvent>(e);
+                }
+                serial.events.clear();
+                parallel.events.clear();
+
+                REQUIRE(serial.computeHash() == parallel.computeHash());
+            }
+
+            REQUIRE(anyShotsFired);
+            REQUIRE(parallel.unitUpdateThreadPool->getThreadCount() == 4);
+        }
+
+        SECTION("picks the same targets as scanning for them in the serial loop")
+        {
+            auto planned = createBattleTestSimulation(4);
+            auto scanning = createBattleTestSimulation(1);
+            scanning.unitUpdatePlanningEnabled = false;
+
+            auto anyTargets = false;
+            for (int i = 0; i < 300; ++i)
+            {
+                planned.tick();
+                scanning.tick();
+                planned.events.clear();
+                scanning.events.clear();
+
+                auto targets = getWeaponTargets(planned);
+                REQUIRE(targets == getWeaponTargets(scanning));
+                REQUIRE(computeHashOf(planned) == computeHashOf(scanning));
+                anyTargets = anyTargets || std::any_of(targets.begin(), targets.end(), [](const auto& t) { return t.has_value(); });
+            }
+
+            REQUIRE(anyTargets);
+            REQUIRE(scanning.unitUpdateThreadPool == nullptr);
+
+            // units moving around each other
+            // should not make every plan fall back to a scan
+            if constexpr (TickProfiler::Enabled)
+            {
+                auto rechecks = planned.tickProfiler.getCounterTotal(TickCounter::WeaponTargetRechecks);
+                auto rescans = planned.tickProfiler.getCounterTotal(TickCounter::WeaponTargetRescans);
+                REQUIRE(rechecks > rescans);
+                REQUIRE(scanning.tickProfiler.getCounterTotal(TickCounter::WeaponTargetRechecks) == 0);
+            }
+        }
+
+        SECTION("keeps a queued request for a new goal new when the unit asks again")
+        {
+            auto simulation = createBattleTestSimulation(1);
+            simulation.pathRequests.clear();
+            auto first = simulation.units.begin()->first;
+            auto second = std::next(simulation.units.begin())->first;
+
+            simulation.requestPath(first, true);
+            simulation.requestPath(second, false);
+            simulation.requestPath(first, false);
+
+            REQUIRE(simulation.pathRequests.size() == 2);
+            REQUIRE(simulation.pathRequests[0].unitId == second);
+            REQUIRE(!simulation.pathRequests[0].isNewGoal);
+            REQUIRE(simulation.pathRequests[1].unitId == first);
+            REQUIRE(simulation.pathRequests[1].isNewGoal);
+        }
+
+        SECTION("keeps the incremental hash in step with the full hash")
+        {
+            auto simulation = createBattleTestSimulation(1);
+            for (int i = 0; i < 300; ++i)
+            {
+                simulation.tick();
+                simulation.events.clear();
+                REQUIRE(simulation.computeHash() == computeHashOf(simulation));
+            }
+        }
+
+        SECTION("rebuilds past hash trees from the deltas as from scratch")
+        {
+            auto simulation = createBattleTestSimulation(1);
+            GameHashHistory history;
+            std::vector<std::pair<GameTime, GameHashTree>> fullTrees;
+            auto anyProjectiles = false;
+            for (int i = 0; i < 300; ++i)
+            {
+                simulation.tick();
+                simulation.events.clear();
+
+                auto [hash, delta] = simulation.computeHashDelta();
+                REQUIRE(hash == computeHashOf(simulation));
+                history.push(simulation.gameTime, std::move(delta));
+                fullTrees.emplace_back(simulation.gameTime, buildHashTree(simulation));
+                anyProjectiles = anyProjectiles || simulation.projectiles.begin() != simulation.projectiles.end();
+
+                // checked ticks are folded into the base as the game goes on
+                if (i % 10 == 9)
+                {
+                    history.forgetUntil(GameTime(simulation.gameTime.value - 5));
+                }
+            }
+
+            REQUIRE(anyProjectiles);
+            REQUIRE(history.size() == 5);
+
+            // compare every node of the trees of the ticks still held
+            for (auto it = fullTrees.end() - history.size(); it != fullTrees.end(); ++it)
+            {
+                const auto& [gameTime, fullTree] = *it;
+                std::vector<GameHashTree::Path> paths{{}};
+                while (!paths.empty())
+                {
+                    auto path = std::move(paths.back());
+                    paths.pop_back();
+
+                    auto children = history.getChildren(gameTime, path);
+                    REQUIRE(children == fullTree.getChildren(path));
+                    for (const auto& child : *children)
+                    {
+                        auto childPath = path;
+                        childPath.push_back(child.first);
+                        paths.push_back(std::move(childPath));
+                    }
+                }
+            }
+        }
+
+        SECTION("resolves weapon damage by unit type, falling back to the default")
+        {
+            auto simulation = createBattleTestSimulation(1);
+            auto weaponId = simulation.getWeaponDefinitionId("TESTGUN");
+            auto unitId = simulation.getUnitDefinitionId("TESTUNIT");
+            REQUIRE(simulation.getWeaponDefinition(weaponId).getDamage(unitId) == 20);
+
+            simulation.weaponDefinitions.get(weaponId).damage.insert({"TESTUNIT", 35});
+            simulation.resolveWeaponDamage();
+            REQUIRE(simulation.getWeaponDefinition(weaponId).getDamage(unitId) == 35);
+        }
+
+        SECTION("resolves the unit type of a build order")
+        {
+            auto simulation = createBattleTestSimulation(1);
+
+            UnitOrder order = BuildOrder("testunit", SimVector(0_ss, 0_ss, 0_ss));
+            simulation.resolveOrder(order);
+            REQUIRE(std::get<BuildOrder>(order).unitDefinitionId == simulation.getUnitDefinitionId("TESTUNIT"));
+
+            UnitOrder unknownOrder = BuildOrder("NOSUCHUNIT", SimVector(0_ss, 0_ss, 0_ss));
+            simulation.resolveOrder(unknownOrder);
+            REQUIRE(!std::get<BuildOrder>(unknownOrder).unitDefinitionId);
+        }
+
+        SECTION("hashes changes made to units that are standing still")
+        {
+            auto simulation = createBattleTestSimulation(1);
+            for (auto& [id, unit] : simulation.units)
+            {
+                unit.clearOrders();
+            }
+            for (int i = 0; i < 10; ++i)
+            {
+                simulation.tick();
+            }
+            REQUIRE(simulation.computeHash() == computeHashOf(simulation));
+
+            auto unitId = simulation.units.begin()->first;
+            auto& unit = simulation.getUnitState(unitId);
+            unit.finishBuilding(simulation.unitDefinitions.get(unit.unitType));
+            simulation.markUnitChanged(unitId);
+            REQUIRE(simulation.computeHash() == computeHashOf(simulation));
+
+            simulation.applyDamage(unitId, 10);
+            REQUIRE(simulation.computeHash() == computeHashOf(simulation));
+            simulation.setBuildStance(unitId, true);
+            REQUIRE(simulation.computeHash() == computeHashOf(simulation));
+            simulation.activateUnit(unitId);
+            REQUIRE(simulation.computeHash() == computeHashOf(simulation));
+
+            simulation.tick();
+            REQUIRE(simulation.computeHash() == computeHashOf(simulation));
+        }
+    }
+}
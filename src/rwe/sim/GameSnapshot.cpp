@@ -0,0 +1,1177 @@
+#include "GameSnapshot.h"
+#include <algorithm>
+#include <limits>
+#include <rwe/sim/GameSimulation.h>
+#include <rwe/sim/SnapshotIo.h>
+#include <sstream>
+
+namespace rwe
+{
+    const char SnapshotMagic[4] = {'R', 'W', 'E', 'S'};
+
+    /** Written in place of a thread index when a weapon's aim thread no longer exists. */
+    constexpr uint32_t NoThreadIndex = std::numeric_limits<uint32_t>::max();
+
+    void writeSnapshot(SnapshotWriter& w, const UnitMesh::MoveOperation& op)
+    {
+        writeSnapshot(w, op.targetPosition);
+        writeSnapshot(w, op.speed);
+    }
+
+    UnitMesh::MoveOperation readSnapshot(SnapshotReader& r, SnapshotTag<UnitMesh::MoveOperation>)
+    {
+        auto targetPosition = readSnapshotValue<SimScalar>(r);
+        auto speed = readSnapshotValue<SimScalar>(r);
+        return UnitMesh::MoveOperation(targetPosition, speed);
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const UnitMesh::TurnOperation& op)
+    {
+        writeSnapshot(w, op.targetAngle);
+        writeSnapshot(w, op.speed);
+    }
+
+    UnitMesh::TurnOperation readSnapshot(SnapshotReader& r, SnapshotTag<UnitMesh::TurnOperation>)
+    {
+        auto targetAngle = readSnapshotValue<SimAngle>(r);
+        auto speed = readSnapshotValue<SimScalar>(r);
+        return UnitMesh::TurnOperation(targetAngle, speed);
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const UnitMesh::SpinOperation& op)
+    {
+        writeSnapshot(w, op.currentSpeed);
+        writeSnapshot(w, op.targetSpeed);
+        writeSnapshot(w, op.acceleration);
+    }
+
+    UnitMesh::SpinOperation readSnapshot(SnapshotReader& r, SnapshotTag<UnitMesh::SpinOperation>)
+    {
+        auto currentSpeed = readSnapshotValue<SimScalar>(r);
+        auto targetSpeed = readSnapshotValue<SimScalar>(r);
+        auto acceleration = readSnapshotValue<SimScalar>(r);
+        return UnitMesh::SpinOperation(currentSpeed, targetSpeed, acceleration);
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const UnitMesh::StopSpinOperation& op)
+    {
+        writeSnapshot(w, op.currentSpeed);
+        writeSnapshot(w, op.deceleration);
+    }
+
+    UnitMesh::StopSpinOperation readSnapshot(SnapshotReader& r, SnapshotTag<UnitMesh::StopSpinOperation>)
+    {
+        auto currentSpeed = readSnapshotValue<SimScalar>(r);
+        auto deceleration = readSnapshotValue<SimScalar>(r);
+        return UnitMesh::StopSpinOperation(currentSpeed, deceleration);
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const UnitMesh& piece)
+    {
+        writeSnapshot(w, piece.visible);
+        writeSnapshot(w, piece.shaded);
+        writeSnapshot(w, piece.offset);
+        writeSnapshot(w, piece.previousOffset);
+        writeSnapshot(w, piece.previousRotationX);
+        writeSnapshot(w, piece.previousRotationY);
+        writeSnapshot(w, piece.previousRotationZ);
+        writeSnapshot(w, piece.rotationX);
+        writeSnapshot(w, piece.rotationY);
+        writeSnapshot(w, piece.rotationZ);
+        writeSnapshot(w, piece.xMoveOperation);
+        writeSnapshot(w, piece.yMoveOperation);
+        writeSnapshot(w, piece.zMoveOperation);
+        writeSnapshot(w, piece.xTurnOperation);
+        writeSnapshot(w, piece.yTurnOperation);
+        writeSnapshot(w, piece.zTurnOperation);
+        writeSnapshot(w, piece.inAnimatingList);
+    }
+
+    UnitMesh readSnapshot(SnapshotReader& r, SnapshotTag<UnitMesh>)
+    {
+        UnitMesh piece;
+        piece.visible = readSnapshotValue<bool>(r);
+        piece.shaded = readSnapshotValue<bool>(r);
+        piece.offset = readSnapshotValue<SimVector>(r);
+        piece.previousOffset = readSnapshotValue<SimVector>(r);
+        piece.previousRotationX = readSnapshotValue<SimAngle>(r);
+        piece.previousRotationY = readSnapshotValue<SimAngle>(r);
+        piece.previousRotationZ = readSnapshotValue<SimAngle>(r);
+        piece.rotationX = readSnapshotValue<SimAngle>(r);
+        piece.rotationY = readSnapshotValue<SimAngle>(r);
+        piece.rotationZ = readSnapshotValue<SimAngle>(r);
+        piece.xMoveOperation = readSnapshotValue<std::optional<UnitMesh::MoveOperation>>(r);
+        piece.yMoveOperation = readSnapshotValue<std::optional<UnitMesh::MoveOperation>>(r);
+        piece.zMoveOperation = readSnapshotValue<std::optional<UnitMesh::MoveOperation>>(r);
+        piece.xTurnOperation = readSnapshotValue<std::optional<UnitMesh::TurnOperationUnion>>(r);
+        piece.yTurnOperation = readSnapshotValue<std::optional<UnitMesh::TurnOperationUnion>>(r);
+        piece.zTurnOperation = readSnapshotValue<std::optional<UnitMesh::TurnOperationUnion>>(r);
+        piece.inAnimatingList = readSnapshotValue<bool>(r);
+        return piece;
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const MoveOrder& order)
+    {
+        writeSnapshot(w, order.destination);
+    }
+
+    MoveOrder readSnapshot(SnapshotReader& r, SnapshotTag<MoveOrder>)
+    {
+        return MoveOrder(readSnapshotValue<SimVector>(r));
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const AttackOrder& order)
+    {
+        writeSnapshot(w, order.target);
+    }
+
+    AttackOrder readSnapshot(SnapshotReader& r, SnapshotTag<AttackOrder>)
+    {
+        auto target = readSnapshotValue<AttackTarget>(r);
+        return std::visit([](const auto& t) { return AttackOrder(t); }, target);
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const BuildOrder& order)
+    {
+        writeSnapshot(w, order.unitType);
+        writeSnapshot(w, order.position);
+    }
+
+    BuildOrder readSnapshot(SnapshotReader& r, SnapshotTag<BuildOrder>)
+    {
+        auto unitType = readSnapshotValue<std::string>(r);
+        auto position = readSnapshotValue<SimVector>(r);
+        return BuildOrder(unitType, position);
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const BuggerOffOrder& order)
+    {
+        writeSnapshot(w, order.rect);
+    }
+
+    BuggerOffOrder readSnapshot(SnapshotReader& r, SnapshotTag<BuggerOffOrder>)
+    {
+        return BuggerOffOrder(readSnapshotValue<DiscreteRect>(r));
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const CompleteBuildOrder& order)
+    {
+        writeSnapshot(w, order.target);
+    }
+
+    CompleteBuildOrder readSnapshot(SnapshotReader& r, SnapshotTag<CompleteBuildOrder>)
+    {
+        return CompleteBuildOrder(readSnapshotValue<UnitId>(r));
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const GuardOrder& order)
+    {
+        writeSnapshot(w, order.target);
+    }
+
+    GuardOrder readSnapshot(SnapshotReader& r, SnapshotTag<GuardOrder>)
+    {
+        return GuardOrder(readSnapshotValue<UnitId>(r));
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const UnitCreationStatusDone& status)
+    {
+        writeSnapshot(w, status.unitId);
+    }
+
+    UnitCreationStatusDone readSnapshot(SnapshotReader& r, SnapshotTag<UnitCreationStatusDone>)
+    {
+        return UnitCreationStatusDone{readSnapshotValue<UnitId>(r)};
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const UnitBehaviorStateCreatingUnit& state)
+    {
+        writeSnapshot(w, state.unitType);
+        writeSnapshot(w, state.owner);
+        writeSnapshot(w, state.position);
+        writeSnapshot(w, state.status);
+    }
+
+    UnitBehaviorStateCreatingUnit readSnapshot(SnapshotReader& r, SnapshotTag<UnitBehaviorStateCreatingUnit>)
+    {
+        return UnitBehaviorStateCreatingUnit{
+            .unitType = readSnapshotValue<UnitDefinitionId>(r),
+            .owner = readSnapshotValue<PlayerId>(r),
+            .position = readSnapshotValue<SimVector>(r),
+            .status = readSnapshotValue<UnitCreationStatus>(r),
+        };
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const UnitBehaviorStateBuilding& state)
+    {
+        writeSnapshot(w, state.targetUnit);
+        writeSnapshot(w, state.nanoParticleOrigin);
+    }
+
+    UnitBehaviorStateBuilding readSnapshot(SnapshotReader& r, SnapshotTag<UnitBehaviorStateBuilding>)
+    {
+        return UnitBehaviorStateBuilding{
+            .targetUnit = readSnapshotValue<UnitId>(r),
+            .nanoParticleOrigin = readSnapshotValue<std::optional<SimVector>>(r),
+        };
+    }
+
+    /** The current waypoint is written as an index into the path. */
+    void writeSnapshot(SnapshotWriter& w, const PathFollowingInfo& info)
+    {
+        writeSnapshot(w, info.path.waypoints);
+        writeSnapshot(w, info.pathCreationTime);
+        writeSnapshotSize(w, info.currentWaypoint - info.path.waypoints.begin());
+    }
+
+    PathFollowingInfo readSnapshot(SnapshotReader& r, SnapshotTag<PathFollowingInfo>)
+    {
+        auto waypoints = readSnapshotValue<std::vector<SimVector>>(r);
+        auto creationTime = readSnapshotValue<GameTime>(r);
+        auto currentWaypoint = readSnapshotSize(r);
+        if (currentWaypoint > waypoints.size())
+        {
+            throw std::runtime_error("Path waypoint index out of range");
+        }
+
+        PathFollowingInfo info(UnitPath{std::move(waypoints)}, creationTime);
+        info.currentWaypoint = info.path.waypoints.begin() + currentWaypoint;
+        return info;
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const NavigationStateMoving& state)
+    {
+        writeSnapshot(w, state.movementGoal);
+        writeSnapshot(w, state.pathDestination);
+        writeSnapshot(w, state.path);
+        writeSnapshot(w, state.pathRequested);
+    }
+
+    NavigationStateMoving readSnapshot(SnapshotReader& r, SnapshotTag<NavigationStateMoving>)
+    {
+        return NavigationStateMoving{
+            .movementGoal = readSnapshotValue<MovingStateGoal>(r),
+            .pathDestination = readSnapshotValue<PathDestination>(r),
+            .path = readSnapshotValue<std::optional<PathFollowingInfo>>(r),
+            .pathRequested = readSnapshotValue<bool>(r),
+        };
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const NavigationStateMovingToLandingSpot& state)
+    {
+        writeSnapshot(w, state.landingLocation);
+    }
+
+    NavigationStateMovingToLandingSpot readSnapshot(SnapshotReader& r, SnapshotTag<NavigationStateMovingToLandingSpot>)
+    {
+        return NavigationStateMovingToLandingSpot{readSnapshotValue<SimVector>(r)};
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const UnitPositionCache& cache)
+    {
+        writeSnapshot(w, cache.unitId);
+        writeSnapshot(w, cache.position);
+        writeSnapshot(w, cache.cachedAtTime);
+    }
+
+    UnitPositionCache readSnapshot(SnapshotReader& r, SnapshotTag<UnitPositionCache>)
+    {
+        return UnitPositionCache{
+            .unitId = readSnapshotValue<UnitId>(r),
+            .position = readSnapshotValue<SimVector>(r),
+            .cachedAtTime = readSnapshotValue<GameTime>(r),
+        };
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const NavigationStateInfo& info)
+    {
+        writeSnapshot(w, info.desiredDestination);
+        writeSnapshot(w, info.unitPositionCache);
+        writeSnapshot(w, info.state);
+    }
+
+    NavigationStateInfo readSnapshot(SnapshotReader& r, SnapshotTag<NavigationStateInfo>)
+    {
+        return NavigationStateInfo{
+            .desiredDestination = readSnapshotValue<std::optional<NavigationGoal>>(r),
+            .unitPositionCache = readSnapshotValue<std::optional<UnitPositionCache>>(r),
+            .state = readSnapshotValue<NavigationState>(r),
+        };
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const UnitPhysicsInfoGround& physics)
+    {
+        writeSnapshot(w, physics.steeringInfo.targetAngle);
+        writeSnapshot(w, physics.steeringInfo.targetSpeed);
+        writeSnapshot(w, physics.steeringInfo.shouldTakeOff);
+        writeSnapshot(w, physics.currentSpeed);
+    }
+
+    UnitPhysicsInfoGround readSnapshot(SnapshotReader& r, SnapshotTag<UnitPhysicsInfoGround>)
+    {
+        UnitPhysicsInfoGround physics;
+        physics.steeringInfo.targetAngle = readSnapshotValue<SimAngle>(r);
+        physics.steeringInfo.targetSpeed = readSnapshotValue<SimScalar>(r);
+        physics.steeringInfo.shouldTakeOff = readSnapshotValue<bool>(r);
+        physics.currentSpeed = readSnapshotValue<SimScalar>(r);
+        return physics;
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const AirMovementStateFlying& state)
+    {
+        writeSnapshot(w, state.targetPosition);
+        writeSnapshot(w, state.shouldLand);
+        writeSnapshot(w, state.currentVelocity);
+    }
+
+    AirMovementStateFlying readSnapshot(SnapshotReader& r, SnapshotTag<AirMovementStateFlying>)
+    {
+        AirMovementStateFlying state;
+        state.targetPosition = readSnapshotValue<std::optional<SimVector>>(r);
+        state.shouldLand = readSnapshotValue<bool>(r);
+        state.currentVelocity = readSnapshotValue<SimVector>(r);
+        return state;
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const AirMovementStateLanding& state)
+    {
+        writeSnapshot(w, state.landingFailed);
+        writeSnapshot(w, state.shouldAbort);
+    }
+
+    AirMovementStateLanding readSnapshot(SnapshotReader& r, SnapshotTag<AirMovementStateLanding>)
+    {
+        AirMovementStateLanding state;
+        state.landingFailed = readSnapshotValue<bool>(r);
+        state.shouldAbort = readSnapshotValue<bool>(r);
+        return state;
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const UnitPhysicsInfoAir& physics)
+    {
+        writeSnapshot(w, physics.movementState);
+    }
+
+    UnitPhysicsInfoAir readSnapshot(SnapshotReader& r, SnapshotTag<UnitPhysicsInfoAir>)
+    {
+        UnitPhysicsInfoAir physics;
+        physics.movementState = readSnapshotValue<AirMovementState>(r);
+        return physics;
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const UnitState::LifeStateDead& state)
+    {
+        writeSnapshot(w, state.leaveCorpse);
+    }
+
+    UnitState::LifeStateDead readSnapshot(SnapshotReader& r, SnapshotTag<UnitState::LifeStateDead>)
+    {
+        return UnitState::LifeStateDead{readSnapshotValue<bool>(r)};
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const UnitWeaponStateAttacking::FireInfo& info)
+    {
+        writeSnapshot(w, info.heading);
+        writeSnapshot(w, info.pitch);
+        writeSnapshot(w, info.targetPosition);
+        writeSnapshot(w, info.firingPiece);
+        writeSnapshot(w, info.burstsFired);
+        writeSnapshot(w, info.readyTime);
+    }
+
+    UnitWeaponStateAttacking::FireInfo readSnapshot(SnapshotReader& r, SnapshotTag<UnitWeaponStateAttacking::FireInfo>)
+    {
+        return UnitWeaponStateAttacking::FireInfo{
+            .heading = readSnapshotValue<SimAngle>(r),
+            .pitch = readSnapshotValue<SimAngle>(r),
+            .targetPosition = readSnapshotValue<SimVector>(r),
+            .firingPiece = readSnapshotValue<std::optional<int>>(r),
+            .burstsFired = readSnapshotValue<int>(r),
+            .readyTime = readSnapshotValue<GameTime>(r),
+        };
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const FactoryBehaviorStateCreatingUnit& state)
+    {
+        writeSnapshot(w, state.unitType);
+        writeSnapshot(w, state.owner);
+        writeSnapshot(w, state.position);
+        writeSnapshot(w, state.rotation);
+        writeSnapshot(w, state.status);
+    }
+
+    FactoryBehaviorStateCreatingUnit readSnapshot(SnapshotReader& r, SnapshotTag<FactoryBehaviorStateCreatingUnit>)
+    {
+        return FactoryBehaviorStateCreatingUnit{
+            .unitType = readSnapshotValue<std::string>(r),
+            .owner = readSnapshotValue<PlayerId>(r),
+            .position = readSnapshotValue<SimVector>(r),
+            .rotation = readSnapshotValue<SimAngle>(r),
+            .status = readSnapshotValue<UnitCreationStatus>(r),
+        };
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const FactoryBehaviorStateBuilding& state)
+    {
+        writeSnapshot(w, state.targetUnit);
+    }
+
+    FactoryBehaviorStateBuilding readSnapshot(SnapshotReader& r, SnapshotTag<FactoryBehaviorStateBuilding>)
+    {
+        return FactoryBehaviorStateBuilding{readSnapshotValue<std::optional<std::pair<UnitId, std::optional<SimVector>>>>(r)};
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const CobFunction& function)
+    {
+        writeSnapshot(w, function.instructionIndex);
+        writeSnapshot(w, function.locals);
+        writeSnapshot(w, function.localCount);
+    }
+
+    CobFunction readSnapshot(SnapshotReader& r, SnapshotTag<CobFunction>)
+    {
+        auto instructionIndex = readSnapshotValue<unsigned int>(r);
+        auto locals = readSnapshotValue<std::vector<int>>(r);
+        CobFunction function(instructionIndex, locals);
+        function.localCount = readSnapshotValue<unsigned int>(r);
+        return function;
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const CobEnvironment::BlockedStatus::Move& condition)
+    {
+        writeSnapshot(w, condition.object);
+        writeSnapshot(w, condition.axis);
+    }
+
+    CobEnvironment::BlockedStatus::Move readSnapshot(SnapshotReader& r, SnapshotTag<CobEnvironment::BlockedStatus::Move>)
+    {
+        auto object = readSnapshotValue<unsigned int>(r);
+        auto axis = readSnapshotValue<CobAxis>(r);
+        return CobEnvironment::BlockedStatus::Move(object, axis);
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const CobEnvironment::BlockedStatus::Turn& condition)
+    {
+        writeSnapshot(w, condition.object);
+        writeSnapshot(w, condition.axis);
+    }
+
+    CobEnvironment::BlockedStatus::Turn readSnapshot(SnapshotReader& r, SnapshotTag<CobEnvironment::BlockedStatus::Turn>)
+    {
+        auto object = readSnapshotValue<unsigned int>(r);
+        auto axis = readSnapshotValue<CobAxis>(r);
+        return CobEnvironment::BlockedStatus::Turn(object, axis);
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const MapFeature& feature)
+    {
+        writeSnapshot(w, feature.featureName);
+        writeSnapshot(w, feature.position);
+        writeSnapshot(w, feature.rotation);
+    }
+
+    MapFeature readSnapshot(SnapshotReader& r, SnapshotTag<MapFeature>)
+    {
+        return MapFeature{
+            .featureName = readSnapshotValue<FeatureDefinitionId>(r),
+            .position = readSnapshotValue<SimVector>(r),
+            .rotation = readSnapshotValue<SimAngle>(r),
+        };
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const Projectile& projectile)
+    {
+        writeSnapshot(w, projectile.weaponType);
+        writeSnapshot(w, projectile.owner);
+        writeSnapshot(w, projectile.position);
+        writeSnapshot(w, projectile.previousPosition);
+        writeSnapshot(w, projectile.origin);
+        writeSnapshot(w, projectile.velocity);
+        writeSnapshot(w, projectile.lastSmoke);
+        writeSnapshot(w, projectile.dieOnFrame);
+        writeSnapshot(w, projectile.damageRadius);
+        writeSnapshot(w, projectile.groundBounce);
+        writeSnapshot(w, projectile.isDead);
+        writeSnapshot(w, projectile.createdAt);
+        writeSnapshot(w, projectile.targetUnit);
+    }
+
+    Projectile readSnapshot(SnapshotReader& r, SnapshotTag<Projectile>)
+    {
+        return Projectile{
+            .weaponType = readSnapshotValue<WeaponDefinitionId>(r),
+            .owner = readSnapshotValue<PlayerId>(r),
+            .position = readSnapshotValue<SimVector>(r),
+            .previousPosition = readSnapshotValue<SimVector>(r),
+            .origin = readSnapshotValue<SimVector>(r),
+            .velocity = readSnapshotValue<SimVector>(r),
+            .lastSmoke = readSnapshotValue<GameTime>(r),
+            .dieOnFrame = readSnapshotValue<std::optional<GameTime>>(r),
+            .damageRadius = readSnapshotValue<SimScalar>(r),
+            .groundBounce = readSnapshotValue<bool>(r),
+            .isDead = readSnapshotValue<bool>(r),
+            .createdAt = readSnapshotValue<GameTime>(r),
+            .targetUnit = readSnapshotValue<std::optional<UnitId>>(r),
+        };
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const OccupiedCellBuildingInfo& info)
+    {
+        writeSnapshot(w, info.unit);
+        writeSnapshot(w, info.passable);
+    }
+
+    OccupiedCellBuildingInfo readSnapshot(SnapshotReader& r, SnapshotTag<OccupiedCellBuildingInfo>)
+    {
+        return OccupiedCellBuildingInfo{
+            .unit = readSnapshotValue<UnitId>(r),
+            .passable = readSnapshotValue<bool>(r),
+        };
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const OccupiedCell& cell)
+    {
+        writeSnapshot(w, cell.mobileUnitId);
+        writeSnapshot(w, cell.buildingInfo);
+        writeSnapshot(w, cell.featureId);
+    }
+
+    OccupiedCell readSnapshot(SnapshotReader& r, SnapshotTag<OccupiedCell>)
+    {
+        return OccupiedCell{
+            .mobileUnitId = readSnapshotValue<std::optional<UnitId>>(r),
+            .buildingInfo = readSnapshotValue<std::optional<OccupiedCellBuildingInfo>>(r),
+            .featureId = readSnapshotValue<std::optional<FeatureId>>(r),
+        };
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const PathRequest& request)
+    {
+        writeSnapshot(w, request.unitId);
+        writeSnapshot(w, request.isNewGoal);
+    }
+
+    PathRequest readSnapshot(SnapshotReader& r, SnapshotTag<PathRequest>)
+    {
+        auto unitId = readSnapshotValue<UnitId>(r);
+        auto isNewGoal = readSnapshotValue<bool>(r);
+        return PathRequest{unitId, isNewGoal};
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const WinStatusWon& status)
+    {
+        writeSnapshot(w, status.winner);
+    }
+
+    WinStatusWon readSnapshot(SnapshotReader& r, SnapshotTag<WinStatusWon>)
+    {
+        return WinStatusWon{readSnapshotValue<PlayerId>(r)};
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const GamePlayerInfo& player)
+    {
+        writeSnapshot(w, player.name);
+        writeSnapshot(w, player.type);
+        writeSnapshot(w, player.color);
+        writeSnapshot(w, player.status);
+        writeSnapshot(w, player.side);
+        writeSnapshot(w, player.metal);
+        writeSnapshot(w, player.energy);
+        writeSnapshot(w, player.maxMetal);
+        writeSnapshot(w, player.maxEnergy);
+        writeSnapshot(w, player.startingMetal);
+        writeSnapshot(w, player.startingEnergy);
+        writeSnapshot(w, player.metalStalled);
+        writeSnapshot(w, player.energyStalled);
+        writeSnapshot(w, player.desiredMetalConsumptionBuffer);
+        writeSnapshot(w, player.desiredEnergyConsumptionBuffer);
+        writeSnapshot(w, player.previousDesiredMetalConsumptionBuffer);
+        writeSnapshot(w, player.previousDesiredEnergyConsumptionBuffer);
+        writeSnapshot(w, player.actualMetalConsumptionBuffer);
+        writeSnapshot(w, player.actualEnergyConsumptionBuffer);
+        writeSnapshot(w, player.metalProductionBuffer);
+        writeSnapshot(w, player.energyProductionBuffer);
+    }
+
+    GamePlayerInfo readSnapshot(SnapshotReader& r, SnapshotTag<GamePlayerInfo>)
+    {
+        return GamePlayerInfo{
+            .name = readSnapshotValue<std::optional<std::string>>(r),
+            .type = readSnapshotValue<GamePlayerType>(r),
+            .color = readSnapshotValue<PlayerColorIndex>(r),
+            .status = readSnapshotValue<GamePlayerStatus>(r),
+            .side = readSnapshotValue<std::string>(r),
+            .metal = readSnapshotValue<Metal>(r),
+            .energy = readSnapshotValue<Energy>(r),
+            .maxMetal = readSnapshotValue<Metal>(r),
+            .maxEnergy = readSnapshotValue<Energy>(r),
+            .startingMetal = readSnapshotValue<Metal>(r),
+            .startingEnergy = readSnapshotValue<Energy>(r),
+            .metalStalled = readSnapshotValue<bool>(r),
+            .energyStalled = readSnapshotValue<bool>(r),
+            .desiredMetalConsumptionBuffer = readSnapshotValue<Metal>(r),
+            .desiredEnergyConsumptionBuffer = readSnapshotValue<Energy>(r),
+            .previousDesiredMetalConsumptionBuffer = readSnapshotValue<Metal>(r),
+            .previousDesiredEnergyConsumptionBuffer = readSnapshotValue<Energy>(r),
+            .actualMetalConsumptionBuffer = readSnapshotValue<Metal>(r),
+            .actualEnergyConsumptionBuffer = readSnapshotValue<Energy>(r),
+            .metalProductionBuffer = readSnapshotValue<Metal>(r),
+            .energyProductionBuffer = readSnapshotValue<Energy>(r),
+        };
+    }
+
+    /** Threads are referred to by their index in the environment's thread list. */
+    uint32_t getCobThreadIndex(const CobEnvironment& env, const CobThread* thread)
+    {
+        for (std::size_t i = 0; i < env.threads.size(); ++i)
+        {
+            if (env.threads[i].get() == thread)
+            {
+                return static_cast<uint32_t>(i);
+            }
+        }
+
+        return NoThreadIndex;
+    }
+
+    void writeCobThreadRef(SnapshotWriter& w, const CobEnvironment& env, const CobThread* thread)
+    {
+        auto index = getCobThreadIndex(env, thread);
+        if (index == NoThreadIndex)
+        {
+            throw std::logic_error("Queued COB thread does not belong to its environment");
+        }
+        writeSnapshot(w, index);
+    }
+
+    CobThread* readCobThreadRef(SnapshotReader& r, const CobEnvironment& env)
+    {
+        auto index = readSnapshotValue<uint32_t>(r);
+        if (index >= env.threads.size())
+        {
+            throw std::runtime_error("COB thread index out of range: " + std::to_string(index));
+        }
+        return env.threads[index].get();
+    }
+
+    void writeCobEnvironment(SnapshotWriter& w, const CobEnvironment& env)
+    {
+        writeSnapshot(w, env._statics);
+
+        writeSnapshotSize(w, env.threads.size());
+        for (const auto& thread : env.threads)
+        {
+            writeSnapshot(w, thread->name);
+            writeSnapshot(w, thread->stack);
+            writeSnapshot(w, thread->signalMask);
+            writeSnapshot(w, thread->callStack);
+            writeSnapshot(w, thread->returnValue);
+            writeSnapshot(w, thread->returnLocals);
+        }
+
+        writeSnapshotSize(w, env.readyQueue.size());
+        for (const auto& thread : env.readyQueue)
+        {
+            writeCobThreadRef(w, env, thread);
+        }
+
+        writeSnapshotSize(w, env.blockedQueue.size());
+        for (const auto& [status, thread] : env.blockedQueue)
+        {
+            writeSnapshot(w, status.condition);
+            writeCobThreadRef(w, env, thread);
+        }
+
+        writeSnapshotSize(w, env.sleepingQueue.size());
+        for (const auto& [wakeTime, thread] : env.sleepingQueue)
+        {
+            writeSnapshot(w, wakeTime);
+            writeCobThreadRef(w, env, thread);
+        }
+
+        writeSnapshotSize(w, env.finishedQueue.size());
+        for (const auto& thread : env.finishedQueue)
+        {
+            writeCobThreadRef(w, env, thread);
+        }
+    }
+
+    std::unique_ptr<CobEnvironment> readCobEnvironment(SnapshotReader& r, const CobProgram& program)
+    {
+        auto env = std::make_unique<CobEnvironment>(&program);
+
+        auto statics = readSnapshotValue<std::vector<int>>(r);
+        if (statics.size() != env->_statics.size())
+        {
+            throw std::runtime_error("COB static variable count does not match the script");
+        }
+        env->_statics = std::move(statics);
+
+        auto threadCount = readSnapshotSize(r);
+        for (std::size_t i = 0; i < threadCount; ++i)
+        {
+            auto name = readSnapshotValue<std::string>(r);
+            auto thread = std::make_unique<CobThread>(name);
+            thread->stack = readSnapshotValue<std::stack<int>>(r);
+            thread->signalMask = readSnapshotValue<unsigned int>(r);
+            thread->callStack = readSnapshotValue<std::stack<CobFunction>>(r);
+            thread->returnValue = readSnapshotValue<int>(r);
+            thread->returnLocals = readSnapshotValue<std::vector<int>>(r);
+            env->threads.push_back(std::move(thread));
+        }
+
+        auto readyCount = readSnapshotSize(r);
+        for (std::size_t i = 0; i < readyCount; ++i)
+        {
+            env->readyQueue.push_back(readCobThreadRef(r, *env));
+        }
+
+        auto blockedCount = readSnapshotSize(r);
+        for (std::size_t i = 0; i < blockedCount; ++i)
+        {
+            auto condition = readSnapshotValue<CobEnvironment::BlockedStatus::Condition>(r);
+            env->blockedQueue.emplace_back(CobEnvironment::BlockedStatus(condition), readCobThreadRef(r, *env));
+        }
+
+        auto sleepingCount = readSnapshotSize(r);
+        for (std::size_t i = 0; i < sleepingCount; ++i)
+        {
+            auto wakeTime = readSnapshotValue<CobTime>(r);
+            env->sleepingQueue.emplace_back(wakeTime, readCobThreadRef(r, *env));
+        }
+
+        auto finishedCount = readSnapshotSize(r);
+        for (std::size_t i = 0; i < finishedCount; ++i)
+        {
+            env->finishedQueue.push_back(readCobThreadRef(r, *env));
+        }
+
+        return env;
+    }
+
+    /**
+     * The aiming thread is written as an index into the unit's COB threads.
+     * It may already have been reaped, in which case it is restored as null,
+     * which the weapon treats the same way as a thread that no longer exists.
+     */
+    void writeUnitWeapon(SnapshotWriter& w, const UnitWeapon& weapon, const CobEnvironment& env)
+    {
+        writeSnapshot(w, weapon.weaponType);
+        writeSnapshot(w, weapon.readyTime);
+        writeSnapshot(w, weapon.ballisticZOffset);
+
+        writeSnapshotSize(w, weapon.state.index());
+        match(
+            weapon.state,
+            [&](const UnitWeaponStateIdle&) {},
+            [&](const UnitWeaponStateAttacking& state) {
+                writeSnapshot(w, state.target);
+                writeSnapshotSize(w, state.attackInfo.index());
+                match(
+                    state.attackInfo,
+                    [&](const UnitWeaponStateAttacking::IdleInfo&) {},
+                    [&](const UnitWeaponStateAttacking::AimInfo& info) {
+                        writeSnapshot(w, getCobThreadIndex(env, info.thread));
+                        writeSnapshot(w, info.lastHeading);
+                        writeSnapshot(w, info.lastPitch);
+                    },
+                    [&](const UnitWeaponStateAttacking::FireInfo& info) {
+                        writeSnapshot(w, info);
+                    });
+            });
+    }
+
+    UnitWeaponStateAttacking::AttackInfo readAttackInfo(SnapshotReader& r, const CobEnvironment& env)
+    {
+        auto index = readSnapshotSize(r);
+        switch (index)
+        {
+            case 0:
+                return UnitWeaponStateAttacking::IdleInfo();
+            case 1:
+            {
+                auto threadIndex = readSnapshotValue<uint32_t>(r);
+                if (threadIndex != NoThreadIndex && threadIndex >= env.threads.size())
+                {
+                    throw std::runtime_error("COB thread index out of range: " + std::to_string(threadIndex));
+                }
+                auto lastHeading = readSnapshotValue<SimAngle>(r);
+                auto lastPitch = readSnapshotValue<SimAngle>(r);
+                return UnitWeaponStateAttacking::AimInfo{
+                    threadIndex == NoThreadIndex ? nullptr : env.threads[threadIndex].get(),
+                    lastHeading,
+                    lastPitch};
+            }
+            case 2:
+                return readSnapshotValue<UnitWeaponStateAttacking::FireInfo>(r);
+            default:
+                throw std::runtime_error("Invalid weapon attack state in snapshot: " + std::to_string(index));
+        }
+    }
+
+    UnitWeapon readUnitWeapon(SnapshotReader& r, const CobEnvironment& env)
+    {
+        UnitWeapon weapon;
+        weapon.weaponType = readSnapshotValue<WeaponDefinitionId>(r);
+        weapon.readyTime = readSnapshotValue<GameTime>(r);
+        weapon.ballisticZOffset = readSnapshotValue<SimScalar>(r);
+
+        auto stateIndex = readSnapshotSize(r);
+        switch (stateIndex)
+        {
+            case 0:
+                weapon.state = UnitWeaponStateIdle();
+                break;
+            case 1:
+            {
+                UnitWeaponStateAttacking state(readSnapshotValue<UnitWeaponAttackTarget>(r));
+                state.attackInfo = readAttackInfo(r, env);
+                weapon.state = std::move(state);
+                break;
+            }
+            default:
+                throw std::runtime_error("Invalid weapon state in snapshot: " + std::to_string(stateIndex));
+        }
+
+        return weapon;
+    }
+
+    /**
+     * The unit's model and COB script are not written.
+     * The model comes from the unit's definition,
+     * and the script is written by name so that it can be found again on restore.
+     */
+    void writeUnit(SnapshotWriter& w, const UnitState& unit, const std::unordered_map<const CobProgram*, std::string>& scriptNames)
+    {
+        writeSnapshot(w, unit.unitType);
+        writeSnapshot(w, scriptNames.at(unit.cobEnvironment->_program));
+
+        writeSnapshot(w, unit.pieces);
+        writeSnapshot(w, unit.animatingPieces);
+        writeSnapshot(w, unit.position);
+        writeSnapshot(w, unit.previousPosition);
+        writeCobEnvironment(w, *unit.cobEnvironment);
+        writeSnapshot(w, unit.owner);
+        writeSnapshot(w, unit.rotation);
+        writeSnapshot(w, unit.previousRotation);
+        writeSnapshot(w, unit.physics);
+        writeSnapshot(w, unit.hitPoints);
+        writeSnapshot(w, unit.lifeState);
+        writeSnapshot(w, unit.orders);
+        writeSnapshot(w, unit.behaviourState);
+        writeSnapshot(w, unit.navigationState);
+        writeSnapshot(w, unit.buildOrderUnitId);
+        writeSnapshot(w, unit.inBuildStance);
+        writeSnapshot(w, unit.yardOpen);
+        writeSnapshot(w, unit.inCollision);
+
+        for (const auto& weapon : unit.weapons)
+        {
+            writeSnapshot(w, weapon.has_value());
+            if (weapon)
+            {
+                writeUnitWeapon(w, *weapon, *unit.cobEnvironment);
+            }
+        }
+
+        writeSnapshot(w, unit.fireOrders);
+        writeSnapshot(w, unit.buildTimeCompleted);
+        writeSnapshot(w, unit.activated);
+        writeSnapshot(w, unit.isSufficientlyPowered);
+        writeSnapshot(w, unit.energyProductionBuffer);
+        writeSnapshot(w, unit.metalProductionBuffer);
+        writeSnapshot(w, unit.previousEnergyConsumptionBuffer);
+        writeSnapshot(w, unit.previousMetalConsumptionBuffer);
+        writeSnapshot(w, unit.energyConsumptionBuffer);
+        writeSnapshot(w, unit.metalConsumptionBuffer);
+        writeSnapshot(w, unit.buildQueue);
+        writeSnapshot(w, unit.factoryState);
+    }
+
+    UnitState readUnit(SnapshotReader& r, GameSimulation& simulation)
+    {
+        auto unitType = readSnapshotValue<UnitDefinitionId>(r);
+        auto unitDefinition = simulation.unitDefinitions.tryGet(unitType);
+        if (!unitDefinition)
+        {
+            throw std::runtime_error("Unknown unit type in snapshot: " + std::to_string(unitType.value));
+        }
+        const auto& modelDefinition = simulation.unitModelDefinitions.at(unitDefinition->get().objectName);
+
+        auto scriptName = readSnapshotValue<std::string>(r);
+        auto scriptIt = simulation.unitScriptDefinitions.find(scriptName);
+        if (scriptIt == simulation.unitScriptDefinitions.end())
+        {
+            throw std::runtime_error("Unknown unit script in snapshot: " + scriptName);
+        }
+        const auto& cobPieceIndices = simulation.getCobPieceIndices(unitType, scriptIt->second);
+
+        auto pieces = readSnapshotValue<std::vector<UnitMesh>>(r);
+        if (pieces.size() != modelDefinition.pieces.size())
+        {
+            throw std::runtime_error("Unit piece count does not match its model");
+        }
+
+        auto animatingPieces = readSnapshotValue<std::vector<int>>(r);
+        for (auto pieceIndex : animatingPieces)
+        {
+            if (pieceIndex < 0 || static_cast<std::size_t>(pieceIndex) >= pieces.size())
+            {
+                throw std::runtime_error("Animating piece index out of range");
+            }
+        }
+
+        auto position = readSnapshotValue<SimVector>(r);
+        auto previousPosition = readSnapshotValue<SimVector>(r);
+        auto cobEnvironment = readCobEnvironment(r, scriptIt->second);
+
+        UnitState unit(&modelDefinition, std::move(cobEnvironment), &cobPieceIndices);
+        unit.unitType = unitType;
+        unit.pieces = std::move(pieces);
+        unit.animatingPieces = std::move(animatingPieces);
+        unit.position = position;
+        unit.previousPosition = previousPosition;
+        unit.owner = readSnapshotValue<PlayerId>(r);
+        unit.rotation = readSnapshotValue<SimAngle>(r);
+        unit.previousRotation = readSnapshotValue<SimAngle>(r);
+        unit.physics = readSnapshotValue<UnitPhysicsInfo>(r);
+        unit.hitPoints = readSnapshotValue<unsigned int>(r);
+        unit.lifeState = readSnapshotValue<UnitState::LifeState>(r);
+        unit.orders = readSnapshotValue<std::deque<UnitOrder>>(r);
+        for (auto& order : unit.orders)
+        {
+            simulation.resolveOrder(order);
+        }
+        unit.behaviourState = readSnapshotValue<UnitBehaviorState>(r);
+        if (auto s = std::get_if<UnitBehaviorStateCreatingUnit>(&unit.behaviourState); s != nullptr && !simulation.unitDefinitions.tryGet(s->unitType))
+        {
+            throw std::runtime_error("Unknown unit type being created in snapshot: " + std::to_string(s->unitType.value));
+        }
+        unit.navigationState = readSnapshotValue<NavigationStateInfo>(r);
+        unit.buildOrderUnitId = readSnapshotValue<std::optional<UnitId>>(r);
+        unit.inBuildStance = readSnapshotValue<bool>(r);
+        unit.yardOpen = readSnapshotValue<bool>(r);
+        unit.inCollision = readSnapshotValue<bool>(r);
+
+        for (auto& weapon : unit.weapons)
+        {
+            if (readSnapshotValue<bool>(r))
+            {
+                weapon = readUnitWeapon(r, *unit.cobEnvironment);
+            }
+            else
+            {
+                weapon = std::nullopt;
+            }
+        }
+
+        unit.fireOrders = readSnapshotValue<UnitFireOrders>(r);
+        unit.buildTimeCompleted = readSnapshotValue<unsigned int>(r);
+        unit.activated = readSnapshotValue<bool>(r);
+        unit.isSufficientlyPowered = readSnapshotValue<bool>(r);
+        unit.energyProductionBuffer = readSnapshotValue<Energy>(r);
+        unit.metalProductionBuffer = readSnapshotValue<Metal>(r);
+        unit.previousEnergyConsumptionBuffer = readSnapshotValue<Energy>(r);
+        unit.previousMetalConsumptionBuffer = readSnapshotValue<Metal>(r);
+        unit.energyConsumptionBuffer = readSnapshotValue<Energy>(r);
+        unit.metalConsumptionBuffer = readSnapshotValue<Metal>(r);
+        unit.buildQueue = readSnapshotValue<std::deque<std::pair<std::string, int>>>(r);
+        unit.factoryState = readSnapshotValue<FactoryBehaviorState>(r);
+
+        return unit;
+    }
+
+    /**
+     * Free slots are written along with occupied ones
+     * so that the restored map hands out the same ids as the original.
+     */
+    template <typename T, typename Tag, typename WriteFunc>
+    void writeVectorMapSlots(SnapshotWriter& w, const VectorMap<T, Tag>& map, WriteFunc writeValue)
+    {
+        writeSnapshotSize(w, map.getSlotCount());
+        writeSnapshot(w, map.getFirstFreeSlotIndex());
+        map.forEachSlot(
+            [&](OpaqueId<unsigned int, Tag> id, std::optional<unsigned int> nextFreeSlotIndex) {
+                writeSnapshot(w, false);
+                writeSnapshot(w, id);
+                writeSnapshot(w, nextFreeSlotIndex);
+            },
+            [&](OpaqueId<unsigned int, Tag> id, const T& value) {
+                writeSnapshot(w, true);
+                writeSnapshot(w, id);
+                writeValue(value);
+            });
+    }
+
+    template <typename T, typename Tag, typename ReadFunc>
+    void readVectorMapSlots(SnapshotReader& r, VectorMap<T, Tag>& map, ReadFunc readValue)
+    {
+        auto slotCount = readSnapshotSize(r);
+        auto firstFreeSlotIndex = readSnapshotValue<std::optional<unsigned int>>(r);
+
+        map.clearSlots();
+        for (std::size_t i = 0; i < slotCount; ++i)
+        {
+            auto occupied = readSnapshotValue<bool>(r);
+            auto id = readSnapshotValue<OpaqueId<unsigned int, Tag>>(r);
+            if (occupied)
+            {
+                map.restoreOccupiedSlot(id, readValue());
+            }
+            else
+            {
+                auto nextFreeSlotIndex = readSnapshotValue<std::optional<unsigned int>>(r);
+                if (nextFreeSlotIndex && *nextFreeSlotIndex >= slotCount)
+                {
+                    throw std::runtime_error("Next free slot index out of range");
+                }
+                map.restoreFreeSlot(id, nextFreeSlotIndex);
+            }
+        }
+        map.restoreFirstFreeSlotIndex(firstFreeSlotIndex);
+    }
+
+    /** Checks that the snapshot was taken from a simulation loaded with the same map and data. */
+    void writeSnapshotHeader(SnapshotWriter& w, const GameSimulation& simulation)
+    {
+        w.writeBytes(SnapshotMagic, sizeof(SnapshotMagic));
+        writeSnapshot(w, GameSnapshotVersion);
+        writeSnapshotSize(w, simulation.terrain.getHeightMap().getWidth());
+        writeSnapshotSize(w, simulation.terrain.getHeightMap().getHeight());
+        writeSnapshot(w, simulation.unitDefinitions.getNextId());
+        writeSnapshot(w, simulation.featureDefinitions.getNextId());
+        writeSnapshot(w, simulation.weaponDefinitions.getNextId());
+        writeSnapshot(w, simulation.minWindSpeed);
+        writeSnapshot(w, simulation.maxWindSpeed);
+    }
+
+    void checkSnapshotHeader(SnapshotReader& r, const GameSimulation& simulation)
+    {
+        char magic[sizeof(SnapshotMagic)];
+        r.readBytes(magic, sizeof(magic));
+        if (!std::equal(std::begin(magic), std::end(magic), std::begin(SnapshotMagic)))
+        {
+            throw std::runtime_error("Not a game snapshot");
+        }
+
+        auto version = readSnapshotValue<uint32_t>(r);
+        if (version != GameSnapshotVersion)
+        {
+            throw std::runtime_error("Unsupported snapshot version: " + std::to_string(version));
+        }
+
+        auto width = readSnapshotSize(r);
+        auto height = readSnapshotSize(r);
+        if (width != static_cast<std::size_t>(simulation.terrain.getHeightMap().getWidth()) || height != static_cast<std::size_t>(simulation.terrain.getHeightMap().getHeight()))
+        {
+            throw std::runtime_error("Snapshot was taken on a different map");
+        }
+
+        auto unitDefinitionCount = readSnapshotValue<UnitDefinitionId>(r);
+        auto featureDefinitionCount = readSnapshotValue<FeatureDefinitionId>(r);
+        auto weaponDefinitionCount = readSnapshotValue<WeaponDefinitionId>(r);
+        if (unitDefinitionCount != simulation.unitDefinitions.getNextId()
+            || featureDefinitionCount != simulation.featureDefinitions.getNextId()
+            || weaponDefinitionCount != simulation.weaponDefinitions.getNextId())
+        {
+            throw std::runtime_error("Snapshot was taken with different game data");
+        }
+
+        auto minWindSpeed = readSnapshotValue<int>(r);
+        auto maxWindSpeed = readSnapshotValue<int>(r);
+        if (minWindSpeed != simulation.minWindSpeed || maxWindSpeed != simulation.maxWindSpeed)
+        {
+            throw std::runtime_error("Snapshot was taken on a map with different wind");
+        }
+    }
+
+    void saveSnapshot(const GameSimulation& simulation, std::ostream& stream)
+    {
+        SnapshotWriter w(stream);
+        writeSnapshotHeader(w, simulation);
+
+        std::ostringstream rngState;
+        rngState << simulation.rng;
+        writeSnapshot(w, rngState.str());
+
+        writeSnapshot(w, simulation.gameStatus);
+        writeSnapshot(w, simulation.gameTime);
+        writeSnapshot(w, simulation.players);
+
+        writeSnapshot(w, simulation.metalGrid);
+        writeSnapshot(w, simulation.geoGrid);
+        writeSnapshot(w, simulation.occupiedGrid);
+
+        writeVectorMapSlots(w, simulation.features, [&](const MapFeature& feature) { writeSnapshot(w, feature); });
+
+        std::unordered_map<const CobProgram*, std::string> scriptNames;
+        for (const auto& [name, program] : simulation.unitScriptDefinitions)
+        {
+            scriptNames.emplace(&program, name);
+        }
+        writeVectorMapSlots(w, simulation.units, [&](const UnitState& unit) { writeUnit(w, unit, scriptNames); });
+
+        writeSnapshot(w, simulation.flyingUnitsSet);
+        simulation.unitSpatialIndex.saveSnapshot(w);
+
+        writeVectorMapSlots(w, simulation.projectiles, [&](const Projectile& projectile) { writeSnapshot(w, projectile); });
+
+        writeSnapshot(w, simulation.pathRequests);
+        writeSnapshot(w, simulation.unitCreationRequests);
+        simulation.pathFindingService.saveSnapshot(w);
+
+        writeSnapshot(w, simulation.currentWindGenerationFactor);
+        writeSnapshot(w, simulation.nextWindSpeedChange);
+    }
+
+    void restoreSnapshot(GameSimulation& simulation, std::istream& stream)
+    {
+        SnapshotReader r(stream);
+        checkSnapshotHeader(r, simulation);
+
+        std::istringstream rngState(readSnapshotValue<std::string>(r));
+        rngState >> simulation.rng;
+        if (rngState.fail())
+        {
+            throw std::runtime_error("Invalid RNG state in snapshot");
+        }
+
+        simulation.gameStatus = readSnapshotValue<WinStatus>(r);
+        simulation.gameTime = readSnapshotValue<GameTime>(r);
+        simulation.players = readSnapshotValue<std::vector<GamePlayerInfo>>(r);
+
+        auto metalGrid = readSnapshotValue<Grid<unsigned char>>(r);
+        auto geoGrid = readSnapshotValue<Grid<bool>>(r);
+        auto occupiedGrid = readSnapshotValue<OccupiedGrid>(r);
+        if (metalGrid.getWidth() != simulation.metalGrid.getWidth() || metalGrid.getHeight() != simulation.metalGrid.getHeight()
+            || geoGrid.getWidth() != simulation.geoGrid.getWidth() || geoGrid.getHeight() != simulation.geoGrid.getHeight()
+            || occupiedGrid.getWidth() != simulation.occupiedGrid.getWidth() || occupiedGrid.getHeight() != simulation.occupiedGrid.getHeight())
+        {
+            throw std::runtime_error("Snapshot grid size does not match the map");
+        }
+        simulation.metalGrid = std::move(metalGrid);
+        simulation.geoGrid = std::move(geoGrid);
+        simulation.occupiedGrid = std::move(occupiedGrid);
+
+        readVectorMapSlots(r, simulation.features, [&]() { return readSnapshotValue<MapFeature>(r); });
+        readVectorMapSlots(r, simulation.units, [&]() { return readUnit(r, simulation); });
+
+        simulation.flyingUnitsSet = readSnapshotValue<std::set<UnitId>>(r);
+        simulation.rebuildFlyingUnitSpatialIndex();
+        simulation.unitSpatialIndex.restoreSnapshot(r);
+
+        readVectorMapSlots(r, simulation.projectiles, [&]() { return readSnapshotValue<Projectile>(r); });
+
+        simulation.pathRequests = readSnapshotValue<std::deque<PathRequest>>(r);
+        simulation.unitCreationRequests = readSnapshotValue<std::deque<UnitId>>(r);
+        simulation.pathFindingService.restoreSnapshot(r);
+
+        simulation.currentWindGenerationFactor = readSnapshotValue<SimScalar>(r);
+        simulation.nextWindSpeedChange = readSnapshotValue<GameTime>(r);
+
+        simulation.events.clear();
+
+        // every unit and projectile was replaced, so the running hashes start over
+        simulation.restartHashes();
+    }
+}
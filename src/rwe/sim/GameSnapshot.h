@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <rwe/sim/SnapshotIo.h>
+#include <rwe/sim/UnitOrder.h>
+#include <rwe/sim/UnitState.h>
+
+namespace rwe
+{
+    struct GameSimulation;
+
+    /** Bump whenever the layout of a snapshot changes. */
+    constexpr uint32_t GameSnapshotVersion = 1;
+
+    /**
+     * Writes the state of the simulation that changes while the game is played:
+     * players, units (including their pieces and COB threads), features,
+     * projectiles, the occupied, metal and geo grids, the RNG, pending requests
+     * and the pathfinding caches that affect which path a unit gets.
+     *
+     * Data loaded at the start of the game (the terrain and the unit, weapon,
+     * feature, model and script definitions) is not written.
+     * A snapshot must be restored into a simulation loaded from the same map and data.
+     */
+    void saveSnapshot(const GameSimulation& simulation, std::ostream& stream);
+
+    /**
+     * Replaces the state of the simulation with the state in the snapshot.
+     * The simulation must have been loaded from the same map and data
+     * as the one the snapshot was taken from.
+     * Pending events are discarded, since they are not part of the snapshot.
+     *
+     * Throws std::runtime_error if the snapshot is invalid
+     * or does not match the simulation's data,
+     * in which case the simulation is left in an unspecified state.
+     */
+    void restoreSnapshot(GameSimulation& simulation, std::istream& stream);
+
+    // Unit orders are also written outside of snapshots, as part of player commands.
+
+    void writeSnapshot(SnapshotWriter& w, const MoveOrder& order);
+    MoveOrder readSnapshot(SnapshotReader& r, SnapshotTag<MoveOrder>);
+
+    void writeSnapshot(SnapshotWriter& w, const AttackOrder& order);
+    AttackOrder readSnapshot(SnapshotReader& r, SnapshotTag<AttackOrder>);
+
+    void writeSnapshot(SnapshotWriter& w, const BuildOrder& order);
+    BuildOrder readSnapshot(SnapshotReader& r, SnapshotTag<BuildOrder>);
+
+    void writeSnapshot(SnapshotWriter& w, const BuggerOffOrder& order);
+    BuggerOffOrder readSnapshot(SnapshotReader& r, SnapshotTag<BuggerOffOrder>);
+
+    void writeSnapshot(SnapshotWriter& w, const CompleteBuildOrder& order);
+    CompleteBuildOrder readSnapshot(SnapshotReader& r, SnapshotTag<CompleteBuildOrder>);
+
+    void writeSnapshot(SnapshotWriter& w, const GuardOrder& order);
+    GuardOrder readSnapshot(SnapshotReader& r, SnapshotTag<GuardOrder>);
+
+    // Parts of the unit state are also written by the state log.
+
+    void writeSnapshot(SnapshotWriter& w, const UnitBehaviorStateCreatingUnit& state);
+    UnitBehaviorStateCreatingUnit readSnapshot(SnapshotReader& r, SnapshotTag<UnitBehaviorStateCreatingUnit>);
+
+    void writeSnapshot(SnapshotWriter& w, const UnitBehaviorStateBuilding& state);
+    UnitBehaviorStateBuilding readSnapshot(SnapshotReader& r, SnapshotTag<UnitBehaviorStateBuilding>);
+
+    void writeSnapshot(SnapshotWriter& w, const NavigationStateInfo& info);
+    NavigationStateInfo readSnapshot(SnapshotReader& r, SnapshotTag<NavigationStateInfo>);
+
+    void writeSnapshot(SnapshotWriter& w, const UnitPhysicsInfoGround& physics);
+    UnitPhysicsInfoGround readSnapshot(SnapshotReader& r, SnapshotTag<UnitPhysicsInfoGround>);
+
+    void writeSnapshot(SnapshotWriter& w, const UnitPhysicsInfoAir& physics);
+    UnitPhysicsInfoAir readSnapshot(SnapshotReader& r, SnapshotTag<UnitPhysicsInfoAir>);
+
+    void writeSnapshot(SnapshotWriter& w, const UnitState::LifeStateDead& state);
+    UnitState::LifeStateDead readSnapshot(SnapshotReader& r, SnapshotTag<UnitState::LifeStateDead>);
+}
@@ -0,0 +1,145 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/sim/GameSimulation.h>
+#include <rwe/sim/GameSnapshot.h>
+#include <sstream>
+
+namespace rwe
+{
+    GameSimulation createSnapshotTestSimulation(int width = 32, int height = 32)
+    {
+        GameSimulation simulation(MapTerrain(Grid<unsigned char>(width, height, 10), 0_ss), 0, 1000, 3000);
+
+        UnitDefinition unitDefinition{};
+        unitDefinition.unitType = "TESTUNIT";
+        unitDefinition.objectName = "TESTMODEL";
+        unitDefinition.movementCollisionInfo = UnitDefinition::AdHocMovementClass{2, 2, 255, 255, 0, 255};
+        unitDefinition.maxHitPoints = 100;
+        unitDefinition.buildTime = 10;
+        unitDefinition.isMobile = true;
+        auto unitDefinitionId = simulation.unitDefinitions.insert(unitDefinition);
+        simulation.unitNameIndex.insert({"TESTUNIT", unitDefinitionId});
+
+        std::vector<UnitPieceDefinition> pieces{
+            UnitPieceDefinition{"base", SimVector(0_ss, 0_ss, 0_ss), std::nullopt},
+            UnitPieceDefinition{"turret", SimVector(0_ss, 5_ss, 0_ss), std::string("base")}};
+        simulation.unitModelDefinitions.insert({"TESTMODEL", createUnitModelDefinition(10_ss, std::move(pieces))});
+
+        CobScript script;
+        script.pieces = {"base", "turret"};
+        script.functions = {CobFunctionInfo{"AimPrimary", 0}, CobFunctionInfo{"Idle", 0}};
+        script.staticVariableCount = 2;
+        simulation.unitScriptDefinitions.insert({"TESTUNIT", compileCobScript(std::move(script))});
+
+        simulation.addPlayer(GamePlayerInfo{
+            .name = std::string("Alice"),
+            .type = GamePlayerType::Human,
+            .color = PlayerColorIndex(0),
+            .status = GamePlayerStatus::Alive,
+            .side = "ARM",
+            .metal = Metal(500),
+            .energy = Energy(700),
+            .maxMetal = Metal(1000),
+            .maxEnergy = Energy(1000),
+            .startingMetal = Metal(500),
+            .startingEnergy = Energy(700),
+        });
+
+        return simulation;
+    }
+
+    TEST_CASE("GameSnapshot")
+    {
+        SECTION("restores a simulation with an identical hash")
+        {
+            auto original = createSnapshotTestSimulation();
+            auto unit1 = original.trySpawnUnit("TESTUNIT", PlayerId(0), SimVector(-100_ss, 10_ss, -100_ss), std::nullopt);
+            auto unit2 = original.trySpawnUnit("TESTUNIT", PlayerId(0), SimVector(0_ss, 10_ss, 0_ss), SimAngle(1000));
+            auto unit3 = original.trySpawnUnit("TESTUNIT", PlayerId(0), SimVector(100_ss, 10_ss, 50_ss), std::nullopt);
+            REQUIRE(unit1);
+            REQUIRE(unit2);
+            REQUIRE(unit3);
+
+            // leave a free slot behind so that id reuse is covered
+            original.quietlyKillUnit(*unit2);
+            original.deleteDeadUnits();
+
+            original.turnObject(*unit1, "turret", SimAxis::Y, SimAngle(4000), 2_ss);
+            original.moveObject(*unit3, "base", SimAxis::X, 3_ss, 1_ss);
+
+            auto& unit = original.getUnitState(*unit1);
+            unit.hitPoints = 42;
+            unit.addOrder(createMoveOrder(SimVector(200_ss, 10_ss, 200_ss)));
+            unit.cobEnvironment->setStatic(1, 1234);
+            auto aimThread = unit.cobEnvironment->createThread(0, {5, 6});
+            unit.cobEnvironment->createThread(1, {});
+            UnitWeapon weapon;
+            weapon.weaponType = WeaponDefinitionId(0);
+            UnitWeaponStateAttacking attacking(SimVector(50_ss, 10_ss, 60_ss));
+            attacking.attackInfo = UnitWeaponStateAttacking::AimInfo{aimThread, SimAngle(10), SimAngle(20)};
+            weapon.state = attacking;
+            unit.weapons[0] = weapon;
+
+            original.projectiles.emplace(Projectile{
+                .weaponType = WeaponDefinitionId(0),
+                .owner = PlayerId(0),
+                .position = SimVector(10_ss, 20_ss, 30_ss),
+                .previousPosition = SimVector(9_ss, 20_ss, 30_ss),
+                .origin = SimVector(0_ss, 20_ss, 30_ss),
+                .velocity = SimVector(1_ss, 0_ss, 0_ss),
+                .lastSmoke = GameTime(3),
+                .dieOnFrame = GameTime(90),
+                .damageRadius = 8_ss,
+                .groundBounce = false,
+                .createdAt = GameTime(3),
+                .targetUnit = *unit3,
+            });
+
+            original.rng.discard(17);
+            original.gameTime = GameTime(50);
+            original.getPlayer(PlayerId(0)).metal = Metal(123);
+
+            std::stringstream snapshot;
+            saveSnapshot(original, snapshot);
+
+            auto restored = createSnapshotTestSimulation();
+            restoreSnapshot(restored, snapshot);
+
+            REQUIRE(restored.computeHash() == original.computeHash());
+
+            std::stringstream resaved;
+            saveSnapshot(restored, resaved);
+            REQUIRE(resaved.str() == snapshot.str());
+            REQUIRE(restored.rng() == original.rng());
+
+            const auto& restoredUnit = restored.getUnitState(*unit1);
+            REQUIRE(restoredUnit.cobEnvironment->threads.size() == 2);
+            auto restoredAimThread = restoredUnit.cobEnvironment->threads[0].get();
+            const auto& restoredAttacking = std::get<UnitWeaponStateAttacking>(restoredUnit.weapons[0]->state);
+            REQUIRE(std::get<UnitWeaponStateAttacking::AimInfo>(restoredAttacking.attackInfo).thread == restoredAimThread);
+
+            // the free slot is reused in the same way
+            auto nextOriginal = original.trySpawnUnit("TESTUNIT", PlayerId(0), SimVector(150_ss, 10_ss, 150_ss), std::nullopt);
+            auto nextRestored = restored.trySpawnUnit("TESTUNIT", PlayerId(0), SimVector(150_ss, 10_ss, 150_ss), std::nullopt);
+            REQUIRE(nextOriginal);
+            REQUIRE(nextRestored == nextOriginal);
+            REQUIRE(restored.computeHash() == original.computeHash());
+        }
+
+        SECTION("rejects a snapshot from a different map")
+        {
+            auto original = createSnapshotTestSimulation();
+            std::stringstream snapshot;
+            saveSnapshot(original, snapshot);
+
+            auto other = createSnapshotTestSimulation(16, 16);
+            REQUIRE_THROWS_AS(restoreSnapshot(other, snapshot), std::runtime_error);
+        }
+
+        SECTION("rejects data that is not a snapshot")
+        {
+            auto simulation = createSnapshotTestSimulation();
+            std::stringstream snapshot("not a snapshot at all");
+            REQUIRE_THROWS_AS(restoreSnapshot(simulation, snapshot), std::runtime_error);
+        }
+    }
+}
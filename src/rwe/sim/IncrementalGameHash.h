@@ -0,0 +1,88 @@
+#pragma once
+
+#include <optional>
+#include <rwe/sim/GameHash.h>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace rwe
+{
+    /**
+     * A running GameHash over a collection of entities.
+     *
+     * The hash of a collection is the sum of the hashes of its elements,
+     * so when an entity changes only its own contribution needs recomputing.
+     * Callers mark each entity they add, remove or modify,
+     * and update() rehashes just the marked ones.
+     */
+    template <typename Id>
+    class IncrementalGameHash
+    {
+    private:
+        std::unordered_map<Id, GameHash> contributions;
+        std::unordered_set<Id> changed;
+        GameHash total{0};
+
+    public:
+        void markChanged(const Id& id)
+        {
+            changed.insert(id);
+        }
+
+        /**
+         * Returns the contribution of the entity as of the last update,
+         * or nothing if it was not present then.
+         */
+        std::optional<GameHash> tryGetContribution(const Id& id) const
+        {
+            auto it = contributions.find(id);
+            if (it == contributions.end())
+            {
+                return std::nullopt;
+            }
+            return it->second;
+        }
+
+        /** Forgets every contribution, e.g. after the collection was replaced wholesale. */
+        void clear()
+        {
+            contributions.clear();
+            changed.clear();
+            total = GameHash(0);
+        }
+
+        /**
+         * Recomputes the contribution of each entity marked since the last update
+         * and returns the new total.
+         * computeContribution(id) returns the hash of the entity with that id,
+         * or nothing if it no longer exists.
+         * It may call tryGetContribution to see the entity's previous contribution.
+         */
+        template <typename F>
+        GameHash update(F&& computeContribution)
+        {
+            for (const auto& id : changed)
+            {
+                auto it = contributions.find(id);
+                if (it != contributions.end())
+                {
+                    total = GameHash(total.value - it->second.value);
+                }
+
+                std::optional<GameHash> contribution = computeContribution(id);
+                if (contribution)
+                {
+                    contributions.insert_or_assign(id, *contribution);
+                    total += *contribution;
+                }
+                else if (it != contributions.end())
+                {
+                    contributions.erase(it);
+                }
+            }
+            changed.clear();
+
+            return total;
+        }
+    };
+}
@@ -0,0 +1,80 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/sim/IncrementalGameHash.h>
+
+namespace rwe
+{
+    TEST_CASE("IncrementalGameHash")
+    {
+        std::unordered_map<int, uint32_t> entities{{1, 10}, {2, 20}, {3, 30}};
+        auto computeContribution = [&](int id) -> std::optional<GameHash> {
+            auto it = entities.find(id);
+            if (it == entities.end())
+            {
+                return std::nullopt;
+            }
+            return GameHash(it->second);
+        };
+
+        IncrementalGameHash<int> hash;
+        for (const auto& e : entities)
+        {
+            hash.markChanged(e.first);
+        }
+        REQUIRE(hash.update(computeContribution) == GameHash(60));
+
+        SECTION("rehashes only marked entities")
+        {
+            entities[1] = 11;
+            entities[2] = 25;
+            hash.markChanged(2);
+            REQUIRE(hash.update(computeContribution) == GameHash(65));
+
+            hash.markChanged(1);
+            REQUIRE(hash.update(computeContribution) == GameHash(66));
+        }
+
+        SECTION("drops removed entities")
+        {
+            entities.erase(3);
+            hash.markChanged(3);
+            REQUIRE(hash.update(computeContribution) == GameHash(30));
+
+            // marking a missing entity again is harmless
+            hash.markChanged(3);
+            REQUIRE(hash.update(computeContribution) == GameHash(30));
+        }
+
+        SECTION("wraps around like a full recomputation")
+        {
+            entities[4] = 0xFFFFFFFFu;
+            hash.markChanged(4);
+            REQUIRE(hash.update(computeContribution) == GameHash(59));
+
+            entities.erase(4);
+            hash.markChanged(4);
+            REQUIRE(hash.update(computeContribution) == GameHash(60));
+        }
+
+        SECTION("shows the previous contribution while rehashing")
+        {
+            entities[2] = 25;
+            hash.markChanged(2);
+            std::optional<GameHash> previous;
+            hash.update([&](int id) {
+                previous = hash.tryGetContribution(id);
+                return computeContribution(id);
+            });
+
+            REQUIRE(previous == GameHash(20));
+            REQUIRE(hash.tryGetContribution(2) == GameHash(25));
+            REQUIRE(!hash.tryGetContribution(4));
+        }
+
+        SECTION("clear forgets everything")
+        {
+            hash.clear();
+            REQUIRE(hash.update(computeContribution) == GameHash(0));
+            REQUIRE(!hash.tryGetContribution(1));
+        }
+    }
+}
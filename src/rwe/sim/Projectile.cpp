@@ -27,21 +27,4 @@ namespace rwe
             return origin;
         }
     }
-
-    unsigned int Projectile::getDamage(const std::string& unitType) const
-    {
-        auto it = damage.find(unitType);
-        if (it != damage.end())
-        {
-            return it->second;
-        }
-
-        it = damage.find("DEFAULT");
-        if (it != damage.end())
-        {
-            return it->second;
-        }
-
-        throw std::runtime_error("Failed to find damage entry for projectile");
-    }
 }
@@ -5,13 +5,14 @@
 #include <rwe/sim/ProjectilePhysicsType.h>
 #include <rwe/sim/SimVector.h>
 #include <rwe/sim/UnitId.h>
+#include <rwe/sim/WeaponDefinitionId.h>
 #include <variant>
 
 namespace rwe
 {
     struct Projectile
     {
-        std::string weaponType;
+        WeaponDefinitionId weaponType;
 
         PlayerId owner;
 
@@ -26,8 +27,6 @@ namespace rwe
         /** The last time the projectile emitted smoke. */
         GameTime lastSmoke;
 
-        std::unordered_map<std::string, unsigned int> damage;
-
         std::optional<GameTime> dieOnFrame;
 
         SimScalar damageRadius;
@@ -45,7 +44,5 @@ namespace rwe
         SimVector getBackPosition(SimScalar duration) const;
 
         SimVector getPreviousBackPosition(SimScalar duration) const;
-
-        unsigned int getDamage(const std::string& unitType) const;
     };
 }
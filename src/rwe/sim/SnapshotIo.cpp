@@ -0,0 +1,103 @@
+#include "SnapshotIo.h"
+#include <limits>
+
+namespace rwe
+{
+    SnapshotWriter::SnapshotWriter(std::ostream& stream) : stream(&stream)
+    {
+    }
+
+    void SnapshotWriter::writeBytes(const char* data, std::size_t size)
+    {
+        stream->write(data, size);
+        if (stream->fail())
+        {
+            throw std::runtime_error("Failed to write snapshot");
+        }
+    }
+
+    SnapshotReader::SnapshotReader(std::istream& stream) : stream(&stream)
+    {
+    }
+
+    void SnapshotReader::readBytes(char* data, std::size_t size)
+    {
+        stream->read(data, size);
+        if (stream->fail())
+        {
+            throw std::runtime_error("Snapshot ended unexpectedly");
+        }
+    }
+
+    void writeSnapshot(SnapshotWriter& w, bool value)
+    {
+        writeSnapshot(w, static_cast<uint8_t>(value ? 1 : 0));
+    }
+
+    bool readSnapshot(SnapshotReader& r, SnapshotTag<bool>)
+    {
+        auto value = readSnapshotValue<uint8_t>(r);
+        if (value > 1)
+        {
+            throw std::runtime_error("Invalid boolean in snapshot");
+        }
+        return value != 0;
+    }
+
+    void writeSnapshotSize(SnapshotWriter& w, std::size_t size)
+    {
+        if (size > std::numeric_limits<uint32_t>::max())
+        {
+            throw std::logic_error("Size too large for snapshot");
+        }
+        writeSnapshot(w, static_cast<uint32_t>(size));
+    }
+
+    std::size_t readSnapshotSize(SnapshotReader& r)
+    {
+        return readSnapshotValue<uint32_t>(r);
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const std::string& s)
+    {
+        writeSnapshotSize(w, s.size());
+        w.writeBytes(s.data(), s.size());
+    }
+
+    std::string readSnapshot(SnapshotReader& r, SnapshotTag<std::string>)
+    {
+        std::string s(readSnapshotSize(r), '\0');
+        r.readBytes(s.data(), s.size());
+        return s;
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const Point& p)
+    {
+        writeSnapshot(w, p.x);
+        writeSnapshot(w, p.y);
+    }
+
+    Point readSnapshot(SnapshotReader& r, SnapshotTag<Point>)
+    {
+        auto x = readSnapshotValue<int>(r);
+        auto y = readSnapshotValue<int>(r);
+        return Point(x, y);
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const DiscreteRect& rect)
+    {
+        writeSnapshot(w, rect.x);
+        writeSnapshot(w, rect.y);
+        writeSnapshot(w, rect.width);
+        writeSnapshot(w, rect.height);
+    }
+
+    DiscreteRect readSnapshot(SnapshotReader& r, SnapshotTag<DiscreteRect>)
+    {
+        auto x = readSnapshotValue<int>(r);
+        auto y = readSnapshotValue<int>(r);
+        auto width = readSnapshotValue<int>(r);
+        auto height = readSnapshotValue<int>(r);
+        return DiscreteRect(x, y, width, height);
+    }
+}
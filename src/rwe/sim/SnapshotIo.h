@@ -0,0 +1,379 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <optional>
+#include <ostream>
+#include <rwe/grid/DiscreteRect.h>
+#include <rwe/grid/Grid.h>
+#include <rwe/grid/Point.h>
+#include <rwe/math/Vector3x.h>
+#include <set>
+#include <stack>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * Writes values in the binary format used by game snapshots.
+     * Numbers are written in the native byte order,
+     * container sizes and variant indices as 32-bit unsigned integers.
+     */
+    class SnapshotWriter
+    {
+    private:
+        std::ostream* stream;
+
+    public:
+        explicit SnapshotWriter(std::ostream& stream);
+
+        void writeBytes(const char* data, std::size_t size);
+    };
+
+    /** Reads values written by SnapshotWriter. */
+    class SnapshotReader
+    {
+    private:
+        std::istream* stream;
+
+    public:
+        explicit SnapshotReader(std::istream& stream);
+
+        /** Throws std::runtime_error if the stream ends first. */
+        void readBytes(char* data, std::size_t size);
+    };
+
+    /**
+     * Selects the readSnapshot overload for a type,
+     * since overloads cannot differ only in their return type.
+     */
+    template <typename T>
+    struct SnapshotTag
+    {
+    };
+
+    template <typename T>
+    T readSnapshotValue(SnapshotReader& r)
+    {
+        return readSnapshot(r, SnapshotTag<T>());
+    }
+
+    void writeSnapshot(SnapshotWriter& w, bool value);
+    bool readSnapshot(SnapshotReader& r, SnapshotTag<bool>);
+
+    template <typename T>
+        requires(std::is_arithmetic_v<T> || std::is_enum_v<T>) && (!std::is_same_v<T, bool>)
+    void writeSnapshot(SnapshotWriter& w, T value)
+    {
+        w.writeBytes(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+        requires(std::is_arithmetic_v<T> || std::is_enum_v<T>) && (!std::is_same_v<T, bool>)
+    T readSnapshot(SnapshotReader& r, SnapshotTag<T>)
+    {
+        T value;
+        r.readBytes(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+    }
+
+    void writeSnapshotSize(SnapshotWriter& w, std::size_t size);
+    std::size_t readSnapshotSize(SnapshotReader& r);
+
+    /** Empty structs, such as idle states, carry no data. */
+    template <typename T>
+        requires std::is_class_v<T> && std::is_empty_v<T> && std::is_default_constructible_v<T>
+    void writeSnapshot(SnapshotWriter&, const T&)
+    {
+    }
+
+    template <typename T>
+        requires std::is_class_v<T> && std::is_empty_v<T> && std::is_default_constructible_v<T>
+    T readSnapshot(SnapshotReader&, SnapshotTag<T>)
+    {
+        return T();
+    }
+
+    /** Matches OpaqueId, OpaqueUnit, OpaqueField and types derived from them. */
+    template <typename T>
+    concept SnapshotOpaqueValue = requires(const T& t) {
+        typename T::ValueType;
+        t.value;
+    } && std::is_constructible_v<T, typename T::ValueType>;
+
+    template <SnapshotOpaqueValue T>
+    void writeSnapshot(SnapshotWriter& w, const T& value)
+    {
+        writeSnapshot(w, value.value);
+    }
+
+    template <SnapshotOpaqueValue T>
+    T readSnapshot(SnapshotReader& r, SnapshotTag<T>)
+    {
+        return T(readSnapshotValue<typename T::ValueType>(r));
+    }
+
+    void writeSnapshot(SnapshotWriter& w, const std::string& s);
+    std::string readSnapshot(SnapshotReader& r, SnapshotTag<std::string>);
+
+    void writeSnapshot(SnapshotWriter& w, const Point& p);
+    Point readSnapshot(SnapshotReader& r, SnapshotTag<Point>);
+
+    void writeSnapshot(SnapshotWriter& w, const DiscreteRect& rect);
+    DiscreteRect readSnapshot(SnapshotReader& r, SnapshotTag<DiscreteRect>);
+
+    template <typename Val>
+    void writeSnapshot(SnapshotWriter& w, const Vector3x<Val>& v)
+    {
+        writeSnapshot(w, v.x);
+        writeSnapshot(w, v.y);
+        writeSnapshot(w, v.z);
+    }
+
+    template <typename Val>
+    Vector3x<Val> readSnapshot(SnapshotReader& r, SnapshotTag<Vector3x<Val>>)
+    {
+        auto x = readSnapshotValue<Val>(r);
+        auto y = readSnapshotValue<Val>(r);
+        auto z = readSnapshotValue<Val>(r);
+        return Vector3x<Val>(x, y, z);
+    }
+
+    template <typename T>
+    void writeSnapshot(SnapshotWriter& w, const std::optional<T>& o)
+    {
+        writeSnapshot(w, o.has_value());
+        if (o)
+        {
+            writeSnapshot(w, *o);
+        }
+    }
+
+    template <typename T>
+    std::optional<T> readSnapshot(SnapshotReader& r, SnapshotTag<std::optional<T>>)
+    {
+        if (!readSnapshotValue<bool>(r))
+        {
+            return std::nullopt;
+        }
+        return readSnapshotValue<T>(r);
+    }
+
+    template <typename A, typename B>
+    void writeSnapshot(SnapshotWriter& w, const std::pair<A, B>& p)
+    {
+        writeSnapshot(w, p.first);
+        writeSnapshot(w, p.second);
+    }
+
+    template <typename A, typename B>
+    std::pair<A, B> readSnapshot(SnapshotReader& r, SnapshotTag<std::pair<A, B>>)
+    {
+        auto first = readSnapshotValue<A>(r);
+        auto second = readSnapshotValue<B>(r);
+        return std::pair<A, B>(std::move(first), std::move(second));
+    }
+
+    template <typename Container>
+    void writeSnapshotRange(SnapshotWriter& w, const Container& c)
+    {
+        writeSnapshotSize(w, c.size());
+        for (const auto& item : c)
+        {
+            writeSnapshot(w, static_cast<const typename Container::value_type&>(item));
+        }
+    }
+
+    template <typename T>
+    void writeSnapshot(SnapshotWriter& w, const std::vector<T>& v)
+    {
+        writeSnapshotRange(w, v);
+    }
+
+    template <typename T>
+    std::vector<T> readSnapshot(SnapshotReader& r, SnapshotTag<std::vector<T>>)
+    {
+        auto size = readSnapshotSize(r);
+        std::vector<T> v;
+        v.reserve(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            v.push_back(readSnapshotValue<T>(r));
+        }
+        return v;
+    }
+
+    template <typename T>
+    void writeSnapshot(SnapshotWriter& w, const std::deque<T>& d)
+    {
+        writeSnapshotRange(w, d);
+    }
+
+    template <typename T>
+    std::deque<T> readSnapshot(SnapshotReader& r, SnapshotTag<std::deque<T>>)
+    {
+        auto size = readSnapshotSize(r);
+        std::deque<T> d;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            d.push_back(readSnapshotValue<T>(r));
+        }
+        return d;
+    }
+
+    template <typename T>
+    void writeSnapshot(SnapshotWriter& w, const std::set<T>& s)
+    {
+        writeSnapshotRange(w, s);
+    }
+
+    template <typename T>
+    std::set<T> readSnapshot(SnapshotReader& r, SnapshotTag<std::set<T>>)
+    {
+        auto size = readSnapshotSize(r);
+        std::set<T> s;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            s.insert(s.end(), readSnapshotValue<T>(r));
+        }
+        return s;
+    }
+
+    /** Entries are written in iteration order, so two equal maps may not produce identical bytes. */
+    template <typename K, typename V>
+    void writeSnapshot(SnapshotWriter& w, const std::unordered_map<K, V>& m)
+    {
+        writeSnapshotSize(w, m.size());
+        for (const auto& [key, value] : m)
+        {
+            writeSnapshot(w, key);
+            writeSnapshot(w, value);
+        }
+    }
+
+    template <typename K, typename V>
+    std::unordered_map<K, V> readSnapshot(SnapshotReader& r, SnapshotTag<std::unordered_map<K, V>>)
+    {
+        auto size = readSnapshotSize(r);
+        std::unordered_map<K, V> m;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            auto key = readSnapshotValue<K>(r);
+            m.insert_or_assign(std::move(key), readSnapshotValue<V>(r));
+        }
+        return m;
+    }
+
+    template <typename T, std::size_t N>
+    void writeSnapshot(SnapshotWriter& w, const std::array<T, N>& a)
+    {
+        for (const auto& item : a)
+        {
+            writeSnapshot(w, item);
+        }
+    }
+
+    template <typename T, std::size_t N, std::size_t... Is>
+    std::array<T, N> readSnapshotArray(SnapshotReader& r, std::index_sequence<Is...>)
+    {
+        // elements of a braced initializer are evaluated in order
+        return std::array<T, N>{((void)Is, readSnapshotValue<T>(r))...};
+    }
+
+    template <typename T, std::size_t N>
+    std::array<T, N> readSnapshot(SnapshotReader& r, SnapshotTag<std::array<T, N>>)
+    {
+        return readSnapshotArray<T, N>(r, std::make_index_sequence<N>());
+    }
+
+    /** Elements are written from the bottom of the stack to the top. */
+    template <typename T>
+    void writeSnapshot(SnapshotWriter& w, const std::stack<T>& s)
+    {
+        auto copy = s;
+        std::vector<T> items;
+        items.reserve(copy.size());
+        while (!copy.empty())
+        {
+            items.push_back(std::move(copy.top()));
+            copy.pop();
+        }
+
+        writeSnapshotSize(w, items.size());
+        for (auto it = items.rbegin(); it != items.rend(); ++it)
+        {
+            writeSnapshot(w, *it);
+        }
+    }
+
+    template <typename T>
+    std::stack<T> readSnapshot(SnapshotReader& r, SnapshotTag<std::stack<T>>)
+    {
+        auto size = readSnapshotSize(r);
+        std::stack<T> s;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            s.push(readSnapshotValue<T>(r));
+        }
+        return s;
+    }
+
+    template <typename... Ts>
+    void writeSnapshot(SnapshotWriter& w, const std::variant<Ts...>& v)
+    {
+        writeSnapshotSize(w, v.index());
+        std::visit([&](const auto& x) { writeSnapshot(w, x); }, v);
+    }
+
+    template <typename... Ts, std::size_t... Is>
+    std::variant<Ts...> readSnapshotVariant(SnapshotReader& r, std::size_t index, std::index_sequence<Is...>)
+    {
+        std::optional<std::variant<Ts...>> result;
+        ((index == Is ? (void)result.emplace(std::in_place_index<Is>, readSnapshotValue<Ts>(r)) : (void)0), ...);
+        if (!result)
+        {
+            throw std::runtime_error("Invalid variant index in snapshot: " + std::to_string(index));
+        }
+        return std::move(*result);
+    }
+
+    template <typename... Ts>
+    std::variant<Ts...> readSnapshot(SnapshotReader& r, SnapshotTag<std::variant<Ts...>>)
+    {
+        auto index = readSnapshotSize(r);
+        return readSnapshotVariant<Ts...>(r, index, std::index_sequence_for<Ts...>());
+    }
+
+    template <typename T>
+    void writeSnapshot(SnapshotWriter& w, const Grid<T>& grid)
+    {
+        writeSnapshotSize(w, grid.getWidth());
+        writeSnapshotSize(w, grid.getHeight());
+        for (const auto& cell : grid.getVector())
+        {
+            writeSnapshot(w, static_cast<const T&>(cell));
+        }
+    }
+
+    template <typename T>
+    Grid<T> readSnapshot(SnapshotReader& r, SnapshotTag<Grid<T>>)
+    {
+        auto width = static_cast<int>(readSnapshotSize(r));
+        auto height = static_cast<int>(readSnapshotSize(r));
+        std::vector<T> data;
+        data.reserve(static_cast<std::size_t>(width) * static_cast<std::size_t>(height));
+        for (int i = 0; i < width * height; ++i)
+        {
+            data.push_back(readSnapshotValue<T>(r));
+        }
+        return Grid<T>(width, height, std::move(data));
+    }
+}
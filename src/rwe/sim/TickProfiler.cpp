@@ -0,0 +1,252 @@
+#include "TickProfiler.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace rwe
+{
+    const char* getTickPhaseName(TickPhase phase)
+    {
+        switch (phase)
+        {
+            case TickPhase::Wind:
+                return "Wind";
+            case TickPhase::Resources:
+                return "Resources";
+            case TickPhase::PathFinding:
+                return "PathFinding";
+            case TickPhase::UnitPlanning:
+                return "UnitPlanning";
+            case TickPhase::UnitBehavior:
+                return "UnitBehavior";
+            case TickPhase::Pieces:
+                return "Pieces";
+            case TickPhase::Cob:
+                return "Cob";
+            case TickPhase::Projectiles:
+                return "Projectiles";
+            case TickPhase::VictoryCondition:
+                return "VictoryCondition";
+            case TickPhase::DeleteDeadUnits:
+                return "DeleteDeadUnits";
+            case TickPhase::DeleteDeadProjectiles:
+                return "DeleteDeadProjectiles";
+            case TickPhase::SpawnNewUnits:
+                return "SpawnNewUnits";
+        }
+
+        throw std::logic_error("Invalid tick phase");
+    }
+
+    const char* getTickCounterName(TickCounter counter)
+    {
+        switch (counter)
+        {
+            case TickCounter::WeaponTargetRechecks:
+                return "WeaponTargetRechecks";
+            case TickCounter::WeaponTargetRescans:
+                return "WeaponTargetRescans";
+            case TickCounter::WeaponTargetScans:
+                return "WeaponTargetScans";
+        }
+
+        throw std::logic_error("Invalid tick counter");
+    }
+
+    float tickProfilerMilliseconds(TickProfiler::Clock::duration d)
+    {
+        return std::chrono::duration<float, std::milli>(d).count();
+    }
+
+    void TickProfiler::beginTick(GameTime time)
+    {
+        currentTime = time;
+        currentPhaseMs.fill(0.0f);
+        tickStart = Clock::now();
+    }
+
+    void TickProfiler::endTick()
+    {
+        auto totalMs = tickProfilerMilliseconds(Clock::now() - tickStart);
+
+        for (int i = 0; i < TickPhaseCount; ++i)
+        {
+            phaseHistory[i][historyOffset] = currentPhaseMs[i];
+        }
+        totalHistory[historyOffset] = totalMs;
+        timeHistory[historyOffset] = currentTime;
+        historyOffset = (historyOffset + 1) % HistorySize;
+        historyCount = std::min(historyCount + 1, HistorySize);
+
+        for (auto& stats : unitTypeStats)
+        {
+            if (!stats.updatedThisTick)
+            {
+                stats.lastTickMs = 0.0f;
+                continue;
+            }
+
+            stats.lastTickMs = stats.currentTickMs;
+            stats.maxTickMs = std::max(stats.maxTickMs, stats.currentTickMs);
+            stats.totalMs += stats.currentTickMs;
+            stats.ticks += 1;
+            stats.currentTickMs = 0.0f;
+            stats.updatedThisTick = false;
+        }
+    }
+
+    void TickProfiler::addPhaseTime(TickPhase phase, Clock::duration duration)
+    {
+        currentPhaseMs[static_cast<int>(phase)] += tickProfilerMilliseconds(duration);
+    }
+
+    TickProfiler::UnitTypeStats& TickProfiler::getUnitTypeStats(UnitDefinitionId unitType)
+    {
+        if (unitType.value >= unitTypeStats.size())
+        {
+            unitTypeStats.resize(unitType.value + 1);
+        }
+        return unitTypeStats[unitType.value];
+    }
+
+    void TickProfiler::addCount(TickCounter counter)
+    {
+        counterTotals[static_cast<int>(counter)] += 1;
+    }
+
+    unsigned long long TickProfiler::getCounterTotal(TickCounter counter) const
+    {
+        return counterTotals[static_cast<int>(counter)];
+    }
+
+    void TickProfiler::clear()
+    {
+        for (auto& h : phaseHistory)
+        {
+            h.fill(0.0f);
+        }
+        totalHistory.fill(0.0f);
+        timeHistory.fill(GameTime(0));
+        historyOffset = 0;
+        historyCount = 0;
+        unitTypeStats.clear();
+        counterTotals.fill(0);
+    }
+
+    int TickProfiler::getHistoryCount() const
+    {
+        return historyCount;
+    }
+
+    int TickProfiler::getHistoryOffset() const
+    {
+        return historyOffset;
+    }
+
+    const std::array<float, TickProfiler::HistorySize>& TickProfiler::getPhaseHistory(TickPhase phase) const
+    {
+        return phaseHistory[static_cast<int>(phase)];
+    }
+
+    const std::array<float, TickProfiler::HistorySize>& TickProfiler::getTotalHistory() const
+    {
+        return totalHistory;
+    }
+
+    float TickProfiler::getRecentPhaseMs(TickPhase phase, int n) const
+    {
+        return phaseHistory[static_cast<int>(phase)][recentIndex(n)];
+    }
+
+    float TickProfiler::getRecentTotalMs(int n) const
+    {
+        return totalHistory[recentIndex(n)];
+    }
+
+    std::vector<std::pair<UnitDefinitionId, TickProfiler::UnitTypeStats>> TickProfiler::getUnitTypeStats() const
+    {
+        std::vector<std::pair<UnitDefinitionId, UnitTypeStats>> result;
+        for (unsigned int i = 0; i < unitTypeStats.size(); ++i)
+        {
+            if (unitTypeStats[i].ticks != 0)
+            {
+                result.emplace_back(UnitDefinitionId(i), unitTypeStats[i]);
+            }
+        }
+        return result;
+    }
+
+    void TickProfiler::writePhaseCsv(std::ostream& out) const
+    {
+        out << "tick";
+        for (int i = 0; i < TickPhaseCount; ++i)
+        {
+            out << "," << getTickPhaseName(static_cast<TickPhase>(i));
+        }
+        out << ",Total\n";
+
+        for (int n = historyCount - 1; n >= 0; --n)
+        {
+            auto index = recentIndex(n);
+            out << timeHistory[index].value;
+            for (int i = 0; i < TickPhaseCount; ++i)
+            {
+                out << "," << phaseHistory[i][index];
+            }
+            out << "," << totalHistory[index] << "\n";
+        }
+    }
+
+    void TickProfiler::writeUnitTypeCsv(std::ostream& out, const std::function<std::string(UnitDefinitionId)>& getUnitTypeName) const
+    {
+        std::vector<std::pair<std::string, UnitTypeStats>> sorted;
+        for (const auto& [unitType, stats] : getUnitTypeStats())
+        {
+            sorted.emplace_back(getUnitTypeName(unitType), stats);
+        }
+        std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+            if (a.second.totalMs != b.second.totalMs)
+            {
+                return a.second.totalMs > b.second.totalMs;
+            }
+            return a.first < b.first;
+        });
+
+        out << "unitType,totalMs,ticks,meanMsPerTick,maxMsPerTick\n";
+        for (const auto& [unitType, stats] : sorted)
+        {
+            auto mean = stats.ticks == 0 ? 0.0 : stats.totalMs / stats.ticks;
+            out << unitType << "," << stats.totalMs << "," << stats.ticks << "," << mean << "," << stats.maxTickMs << "\n";
+        }
+    }
+
+    int TickProfiler::recentIndex(int n) const
+    {
+        if (n < 0 || n >= historyCount)
+        {
+            throw std::out_of_range("Tick history index out of range");
+        }
+
+        return (historyOffset + HistorySize - 1 - n) % HistorySize;
+    }
+
+    TickPhaseTimer::TickPhaseTimer(TickProfiler& profiler, TickPhase phase)
+        : profiler(&profiler), phase(phase), start(TickProfiler::Clock::now())
+    {
+    }
+
+    TickPhaseTimer::~TickPhaseTimer()
+    {
+        profiler->addPhaseTime(phase, TickProfiler::Clock::now() - start);
+    }
+
+    UnitTypeTimer::UnitTypeTimer(TickProfiler& profiler, UnitDefinitionId unitType)
+        : stats(&profiler.getUnitTypeStats(unitType)), start(TickProfiler::Clock::now())
+    {
+        stats->updatedThisTick = true;
+    }
+
+    UnitTypeTimer::~UnitTypeTimer()
+    {
+        stats->currentTickMs += tickProfilerMilliseconds(TickProfiler::Clock::now() - start);
+    }
+}
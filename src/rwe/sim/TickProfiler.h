@@ -0,0 +1,217 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <ostream>
+#include <rwe/sim/GameTime.h>
+#include <rwe/sim/UnitDefinitionId.h>
+#include <string>
+#include <vector>
+
+// The tick profiler is controlled at compile time via RWE_TICK_PROFILER,
+// which is set by the CMake option of the same name.
+// When it is 0 the timers are stripped out of GameSimulation::tick entirely.
+// Without the option, it is enabled only in builds without NDEBUG.
+#ifndef RWE_TICK_PROFILER
+#ifdef NDEBUG
+#define RWE_TICK_PROFILER 0
+#else
+#define RWE_TICK_PROFILER 1
+#endif
+#endif
+
+namespace rwe
+{
+    enum class TickPhase
+    {
+        Wind,
+        Resources,
+        PathFinding,
+        UnitPlanning,
+        UnitBehavior,
+        Pieces,
+        Cob,
+        Projectiles,
+        VictoryCondition,
+        DeleteDeadUnits,
+        DeleteDeadProjectiles,
+        SpawnNewUnits,
+    };
+
+    constexpr int TickPhaseCount = static_cast<int>(TickPhase::SpawnNewUnits) + 1;
+
+    const char* getTickPhaseName(TickPhase phase);
+
+    /** Things counted during GameSimulation::tick, alongside the timings. */
+    enum class TickCounter
+    {
+        /** Planned weapon targets checked only against the units changed since planning. */
+        WeaponTargetRechecks,
+        /** Planned weapon targets that had to be scanned for again in the serial loop. */
+        WeaponTargetRescans,
+        /** Weapon targets scanned for in the serial loop without a plan. */
+        WeaponTargetScans,
+    };
+
+    constexpr int TickCounterCount = static_cast<int>(TickCounter::WeaponTargetScans) + 1;
+
+    const char* getTickCounterName(TickCounter counter);
+
+    /**
+     * Records how long each phase of GameSimulation::tick takes,
+     * and how much time is spent updating each unit type.
+     * The most recent ticks are kept in a fixed size ring buffer.
+     */
+    class TickProfiler
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr bool Enabled = RWE_TICK_PROFILER != 0;
+
+        static constexpr int HistorySize = 500;
+
+        struct UnitTypeStats
+        {
+            /** Time spent on this unit type in the tick currently being recorded. */
+            float currentTickMs{0.0f};
+            bool updatedThisTick{false};
+
+            float lastTickMs{0.0f};
+            float maxTickMs{0.0f};
+            double totalMs{0.0};
+
+            /** The number of ticks in which at least one unit of this type was updated. */
+            unsigned int ticks{0};
+        };
+
+    private:
+        std::array<std::array<float, HistorySize>, TickPhaseCount> phaseHistory{};
+        std::array<float, HistorySize> totalHistory{};
+        std::array<GameTime, HistorySize> timeHistory{};
+        int historyOffset{0};
+        int historyCount{0};
+
+        std::array<float, TickPhaseCount> currentPhaseMs{};
+        GameTime currentTime{0};
+        Clock::time_point tickStart;
+
+        /**
+         * Indexed by UnitDefinitionId, so that timing a unit does not look up its name.
+         * Unit types that have not been timed have a default record.
+         * A deque so that growing it does not move the records
+         * that running UnitTypeTimers point to.
+         */
+        std::deque<UnitTypeStats> unitTypeStats;
+
+        std::array<unsigned long long, TickCounterCount> counterTotals{};
+
+    public:
+        void beginTick(GameTime time);
+
+        void endTick();
+
+        void addPhaseTime(TickPhase phase, Clock::duration duration);
+
+        /**
+         * Returns the stats record for the given unit type.
+         * The reference remains valid until clear() is called,
+         * even if records for other unit types are added meanwhile.
+         */
+        UnitTypeStats& getUnitTypeStats(UnitDefinitionId unitType);
+
+        void addCount(TickCounter counter);
+
+        /** Returns how many times the counter has been added to since the last clear(). */
+        unsigned long long getCounterTotal(TickCounter counter) const;
+
+        void clear();
+
+        /** The number of ticks currently held in the history. */
+        int getHistoryCount() const;
+
+        /**
+         * Returns the offset of the oldest entry in the history arrays,
+         * suitable for passing to ImGui::PlotLines.
+         */
+        int getHistoryOffset() const;
+
+        const std::array<float, HistorySize>& getPhaseHistory(TickPhase phase) const;
+
+        const std::array<float, HistorySize>& getTotalHistory() const;
+
+        /** Returns the time taken by the given phase in the n-th most recent tick (0 is the latest). */
+        float getRecentPhaseMs(TickPhase phase, int n) const;
+
+        float getRecentTotalMs(int n) const;
+
+        /**
+         * Returns the stats of each unit type that has been timed
+         * in at least one completed tick, paired with its id.
+         */
+        std::vector<std::pair<UnitDefinitionId, UnitTypeStats>> getUnitTypeStats() const;
+
+        /** Writes the tick history as CSV, oldest tick first. */
+        void writePhaseCsv(std::ostream& out) const;
+
+        /**
+         * Writes the per unit type totals as CSV, most expensive first.
+         * getUnitTypeName gives the name written for each unit type.
+         */
+        void writeUnitTypeCsv(std::ostream& out, const std::function<std::string(UnitDefinitionId)>& getUnitTypeName) const;
+
+    private:
+        int recentIndex(int n) const;
+    };
+
+    /** Adds the time between construction and destruction to a tick phase. */
+    class TickPhaseTimer
+    {
+    private:
+        TickProfiler* profiler;
+        TickPhase phase;
+        TickProfiler::Clock::time_point start;
+
+    public:
+        TickPhaseTimer(TickProfiler& profiler, TickPhase phase);
+        ~TickPhaseTimer();
+        TickPhaseTimer(const TickPhaseTimer&) = delete;
+        TickPhaseTimer& operator=(const TickPhaseTimer&) = delete;
+    };
+
+    /** Adds the time between construction and destruction to a unit type. */
+    class UnitTypeTimer
+    {
+    private:
+        TickProfiler::UnitTypeStats* stats;
+        TickProfiler::Clock::time_point start;
+
+    public:
+        UnitTypeTimer(TickProfiler& profiler, UnitDefinitionId unitType);
+        ~UnitTypeTimer();
+        UnitTypeTimer(const UnitTypeTimer&) = delete;
+        UnitTypeTimer& operator=(const UnitTypeTimer&) = delete;
+    };
+}
+
+#define RWE_PROFILE_CONCAT_INNER(a, b) a##b
+#define RWE_PROFILE_CONCAT(a, b) RWE_PROFILE_CONCAT_INNER(a, b)
+
+// Profiling macros. Each one times the rest of the enclosing scope.
+// When the profiler is disabled they expand to nothing,
+// so the arguments are not evaluated.
+#if RWE_TICK_PROFILER
+#define RWE_PROFILE_PHASE(profiler, phase) rwe::TickPhaseTimer RWE_PROFILE_CONCAT(rweTickPhaseTimer, __LINE__)(profiler, phase)
+#define RWE_PROFILE_UNIT_TYPE(profiler, unitType) rwe::UnitTypeTimer RWE_PROFILE_CONCAT(rweUnitTypeTimer, __LINE__)(profiler, unitType)
+#define RWE_PROFILE_BEGIN_TICK(profiler, time) (profiler).beginTick(time)
+#define RWE_PROFILE_END_TICK(profiler) (profiler).endTick()
+#define RWE_PROFILE_COUNT(profiler, counter) (profiler).addCount(counter)
+#else
+#define RWE_PROFILE_PHASE(profiler, phase) static_cast<void>(0)
+#define RWE_PROFILE_UNIT_TYPE(profiler, unitType) static_cast<void>(0)
+#define RWE_PROFILE_BEGIN_TICK(profiler, time) static_cast<void>(0)
+#define RWE_PROFILE_END_TICK(profiler) static_cast<void>(0)
+#define RWE_PROFILE_COUNT(profiler, counter) static_cast<void>(0)
+#endif
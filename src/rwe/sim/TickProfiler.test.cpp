@@ -0,0 +1,171 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/sim/TickProfiler.h>
+#include <sstream>
+
+namespace rwe
+{
+    TEST_CASE("TickProfiler")
+    {
+        using namespace std::chrono_literals;
+
+        TickProfiler profiler;
+
+        SECTION("records phase times for each tick")
+        {
+            profiler.beginTick(GameTime(1));
+            profiler.addPhaseTime(TickPhase::Cob, 2ms);
+            profiler.addPhaseTime(TickPhase::Cob, 1ms);
+            profiler.addPhaseTime(TickPhase::PathFinding, 4ms);
+            profiler.endTick();
+
+            profiler.beginTick(GameTime(2));
+            profiler.addPhaseTime(TickPhase::Cob, 5ms);
+            profiler.endTick();
+
+            REQUIRE(profiler.getHistoryCount() == 2);
+            REQUIRE(profiler.getRecentPhaseMs(TickPhase::Cob, 0) == 5.0f);
+            REQUIRE(profiler.getRecentPhaseMs(TickPhase::PathFinding, 0) == 0.0f);
+            REQUIRE(profiler.getRecentPhaseMs(TickPhase::Cob, 1) == 3.0f);
+            REQUIRE(profiler.getRecentPhaseMs(TickPhase::PathFinding, 1) == 4.0f);
+            REQUIRE_THROWS(profiler.getRecentPhaseMs(TickPhase::Cob, 2));
+        }
+
+        SECTION("keeps only the most recent ticks")
+        {
+            for (int i = 0; i < TickProfiler::HistorySize + 10; ++i)
+            {
+                profiler.beginTick(GameTime(i));
+                profiler.addPhaseTime(TickPhase::Wind, std::chrono::milliseconds(i));
+                profiler.endTick();
+            }
+
+            REQUIRE(profiler.getHistoryCount() == TickProfiler::HistorySize);
+            REQUIRE(profiler.getRecentPhaseMs(TickPhase::Wind, 0) == static_cast<float>(TickProfiler::HistorySize + 9));
+            REQUIRE(profiler.getRecentPhaseMs(TickPhase::Wind, TickProfiler::HistorySize - 1) == 10.0f);
+
+            // the oldest entry sits at the offset, as ImGui::PlotLines expects
+            REQUIRE(profiler.getPhaseHistory(TickPhase::Wind)[profiler.getHistoryOffset()] == 10.0f);
+        }
+
+        SECTION("accumulates unit type stats only for ticks where the type was updated")
+        {
+            UnitDefinitionId armpw(0);
+            UnitDefinitionId corak(2);
+
+            profiler.beginTick(GameTime(1));
+            {
+                UnitTypeTimer t(profiler, armpw);
+            }
+            {
+                UnitTypeTimer t(profiler, armpw);
+            }
+            profiler.endTick();
+
+            profiler.beginTick(GameTime(2));
+            {
+                UnitTypeTimer t(profiler, corak);
+            }
+            profiler.endTick();
+
+            auto stats = profiler.getUnitTypeStats();
+            REQUIRE(stats.size() == 2);
+            REQUIRE(stats[0].first == armpw);
+            REQUIRE(stats[0].second.ticks == 1);
+            REQUIRE(stats[0].second.lastTickMs == 0.0f);
+            REQUIRE(stats[1].first == corak);
+            REQUIRE(stats[1].second.ticks == 1);
+            REQUIRE(!stats[1].second.updatedThisTick);
+        }
+
+        SECTION("keeps a unit type timer's record in place when other types are added")
+        {
+            profiler.beginTick(GameTime(1));
+            {
+                UnitTypeTimer outer(profiler, UnitDefinitionId(0));
+                for (unsigned int i = 1; i < 100; ++i)
+                {
+                    UnitTypeTimer inner(profiler, UnitDefinitionId(i));
+                }
+            }
+            profiler.endTick();
+
+            auto stats = profiler.getUnitTypeStats();
+            REQUIRE(stats.size() == 100);
+            REQUIRE(stats[0].first == UnitDefinitionId(0));
+            REQUIRE(stats[0].second.ticks == 1);
+        }
+
+        SECTION("names unit types only when writing CSV")
+        {
+            profiler.beginTick(GameTime(1));
+            profiler.getUnitTypeStats(UnitDefinitionId(1)).updatedThisTick = true;
+            profiler.endTick();
+
+            std::ostringstream out;
+            profiler.writeUnitTypeCsv(out, [](UnitDefinitionId id) { return "TYPE" + std::to_string(id.value); });
+
+            std::istringstream in(out.str());
+            std::string header;
+            std::string row;
+            std::getline(in, header);
+            std::getline(in, row);
+
+            REQUIRE(header == "unitType,totalMs,ticks,meanMsPerTick,maxMsPerTick");
+            REQUIRE(row.rfind("TYPE1,", 0) == 0);
+            REQUIRE(!std::getline(in, row));
+        }
+
+        SECTION("writes phase history as CSV, oldest first")
+        {
+            profiler.beginTick(GameTime(7));
+            profiler.addPhaseTime(TickPhase::Wind, 1ms);
+            profiler.endTick();
+            profiler.beginTick(GameTime(8));
+            profiler.endTick();
+
+            std::ostringstream out;
+            profiler.writePhaseCsv(out);
+
+            std::istringstream in(out.str());
+            std::string header;
+            std::string first;
+            std::string second;
+            std::getline(in, header);
+            std::getline(in, first);
+            std::getline(in, second);
+
+            REQUIRE(header.rfind("tick,Wind,Resources,", 0) == 0);
+            REQUIRE(first.rfind("7,1,", 0) == 0);
+            REQUIRE(second.rfind("8,0,", 0) == 0);
+        }
+
+        SECTION("totals counters across ticks")
+        {
+            profiler.beginTick(GameTime(1));
+            profiler.addCount(TickCounter::WeaponTargetRechecks);
+            profiler.addCount(TickCounter::WeaponTargetRechecks);
+            profiler.endTick();
+            profiler.beginTick(GameTime(2));
+            profiler.addCount(TickCounter::WeaponTargetRechecks);
+            profiler.addCount(TickCounter::WeaponTargetRescans);
+            profiler.endTick();
+
+            REQUIRE(profiler.getCounterTotal(TickCounter::WeaponTargetRechecks) == 3);
+            REQUIRE(profiler.getCounterTotal(TickCounter::WeaponTargetRescans) == 1);
+            REQUIRE(profiler.getCounterTotal(TickCounter::WeaponTargetScans) == 0);
+        }
+
+        SECTION("clear forgets everything")
+        {
+            profiler.beginTick(GameTime(1));
+            profiler.getUnitTypeStats(UnitDefinitionId(0)).updatedThisTick = true;
+            profiler.addCount(TickCounter::WeaponTargetScans);
+            profiler.endTick();
+            profiler.clear();
+
+            REQUIRE(profiler.getHistoryCount() == 0);
+            REQUIRE(profiler.getUnitTypeStats().empty());
+            REQUIRE(profiler.getCounterTotal(TickCounter::WeaponTargetScans) == 0);
+        }
+    }
+}
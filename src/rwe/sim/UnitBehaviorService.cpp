@@ -22,7 +22,7 @@ namespace rwe
     void UnitBehaviorService::onCreate(UnitId unitId)
     {
         auto& unit = sim->getUnitState(unitId);
-        const auto& unitDefinition = sim->unitDefinitions.at(unit.unitType);
+        const auto& unitDefinition = sim->unitDefinitions.get(unit.unitType);
 
         unit.cobEnvironment->createThread("Create", std::vector<int>());
 
@@ -57,7 +57,7 @@ namespace rwe
 
         for (auto& [id, unit] : sim->units)
         {
-            const auto& unitDefinition = sim->unitDefinitions.at(unit.unitType);
+            const auto& unitDefinition = sim->unitDefinitions.get(unit.unitType);
             if (unitDefinition.windGenerator != Energy(0))
             {
                 unit.cobEnvironment->createThread("SetSpeed", {cobWindSpeed});
@@ -66,7 +66,7 @@ namespace rwe
         }
     }
 
-    void UnitBehaviorService::update(UnitId unitId)
+    void UnitBehaviorService::update(UnitId unitId, const UnitUpdatePlan& plan)
     {
         auto unitInfo = sim->getUnitInfo(unitId);
 
@@ -74,6 +74,10 @@ namespace rwe
         match(
             unitInfo.state->physics,
             [&](UnitPhysicsInfoGround& p) {
+                if (p.steeringInfo.targetAngle != unitInfo.state->rotation || p.steeringInfo.targetSpeed != 0_ss)
+                {
+                    sim->markUnitChanged(unitId);
+                }
                 p.steeringInfo = SteeringInfo{
                     unitInfo.state->rotation,
                     0_ss,
@@ -93,7 +97,10 @@ namespace rwe
                     });
             });
 
-        // clear navigation targets
+        // Clear navigation targets.
+        // Orders set them again every tick they are in effect,
+        // so the unit is only marked changed below if the target is different at the end.
+        auto previousDestination = std::move(unitInfo.state->navigationState.desiredDestination);
         unitInfo.state->navigationState.desiredDestination = std::nullopt;
 
         // Run unit and weapon AI
@@ -151,15 +158,20 @@ namespace rwe
             }
             else
             {
-                changeState(*unitInfo.state, UnitBehaviorStateIdle());
+                changeState(unitInfo, UnitBehaviorStateIdle());
             }
 
             for (Index i = 0; i < getSize(unitInfo.state->weapons); ++i)
             {
-                updateWeapon(unitId, i);
+                updateWeapon(unitId, i, plan);
             }
         }
 
+        if (unitInfo.state->navigationState.desiredDestination != previousDestination)
+        {
+            sim->markUnitChanged(unitId);
+        }
+
         if (unitInfo.definition->isMobile)
         {
             updateNavigation(unitInfo);
@@ -198,6 +210,7 @@ namespace rwe
                             if (unitInfo.state->position.y == targetHeight)
                             {
                                 p.movementState = AirMovementStateFlying();
+                                sim->markUnitChanged(unitId);
                             }
                         },
                         [&](AirMovementStateLanding& m) {
@@ -205,6 +218,7 @@ namespace rwe
                             {
                                 unitInfo.state->activate();
                                 p.movementState = AirMovementStateFlying();
+                                sim->markUnitChanged(unitId);
                             }
                             else
                             {
@@ -223,6 +237,7 @@ namespace rwe
                             {
                                 p.movementState = AirMovementStateLanding();
                                 unitInfo.state->deactivate();
+                                sim->markUnitChanged(unitId);
                             }
                         });
                 });
@@ -258,7 +273,7 @@ namespace rwe
 
         if (!goal)
         {
-            unitInfo.state->navigationState.state = NavigationStateIdle();
+            setNavigationStateIdle(unitInfo);
             return;
         }
 
@@ -278,6 +293,7 @@ namespace rwe
                         return std::optional<MovingStateGoal>();
                     }
                     unitInfo.state->navigationState.state = NavigationStateMovingToLandingSpot{*landingLocation};
+                    sim->markUnitChanged(unitInfo.id);
                     return std::make_optional<MovingStateGoal>(*landingLocation);
                 }
             },
@@ -293,13 +309,22 @@ namespace rwe
 
         if (!resolvedGoal)
         {
-            unitInfo.state->navigationState.state = NavigationStateIdle();
+            setNavigationStateIdle(unitInfo);
             return;
         }
 
         moveTo(unitInfo, *resolvedGoal);
     }
 
+    void UnitBehaviorService::setNavigationStateIdle(UnitInfo unitInfo)
+    {
+        if (!std::holds_alternative<NavigationStateIdle>(unitInfo.state->navigationState.state))
+        {
+            unitInfo.state->navigationState.state = NavigationStateIdle();
+            sim->markUnitChanged(unitInfo.id);
+        }
+    }
+
     bool followPath(UnitInfo unitInfo, UnitPhysicsInfoGround& physics, PathFollowingInfo& path)
     {
         const auto& destination = *path.currentWaypoint;
@@ -330,7 +355,7 @@ namespace rwe
         return false;
     }
 
-    void UnitBehaviorService::updateWeapon(UnitId id, unsigned int weaponIndex)
+    void UnitBehaviorService::updateWeapon(UnitId id, unsigned int weaponIndex, const UnitUpdatePlan& plan)
     {
         auto& unit = sim->getUnitState(id);
         auto& weapon = unit.weapons[weaponIndex];
@@ -339,35 +364,30 @@ namespace rwe
             return;
         }
 
-        const auto& weaponDefinition = sim->weaponDefinitions.at(weapon->weaponType);
+        const auto& weaponDefinition = sim->weaponDefinitions.get(weapon->weaponType);
 
         if (auto idleState = std::get_if<UnitWeaponStateIdle>(&weapon->state); idleState != nullptr)
         {
             // attempt to acquire a target
             if (!weaponDefinition.commandFire && unit.fireOrders == UnitFireOrders::FireAtWill)
             {
-                for (const auto& entry : sim->units)
+                // A planned target was found at the start of the tick,
+                // so is checked against what has changed since.
+                std::optional<UnitId> target;
+                if (plan.weaponTargetPlanned[weaponIndex] && canRecheckPlannedWeaponTarget(*sim, id, unit, weaponDefinition, plan.weaponTargets[weaponIndex]))
                 {
-                    auto otherUnitId = entry.first;
-                    const auto& otherUnit = entry.second;
-
-                    if (otherUnit.isDead())
-                    {
-                        continue;
-                    }
-
-                    if (otherUnit.isOwnedBy(unit.owner))
-                    {
-                        continue;
-                    }
-
-                    if (unit.position.distanceSquared(otherUnit.position) > weaponDefinition.maxRange * weaponDefinition.maxRange)
-                    {
-                        continue;
-                    }
+                    RWE_PROFILE_COUNT(sim->tickProfiler, TickCounter::WeaponTargetRechecks);
+                    target = recheckPlannedWeaponTarget(*sim, unit, weaponDefinition, plan.weaponTargets[weaponIndex]);
+                }
+                else
+                {
+                    RWE_PROFILE_COUNT(sim->tickProfiler, plan.weaponTargetPlanned[weaponIndex] ? TickCounter::WeaponTargetRescans : TickCounter::WeaponTargetScans);
+                    target = findWeaponTarget(*sim, unit, weaponDefinition);
+                }
 
-                    weapon->state = UnitWeaponStateAttacking(otherUnitId);
-                    break;
+                if (target)
+                {
+                    weapon->state = UnitWeaponStateAttacking(*target);
                 }
             }
         }
@@ -492,7 +512,7 @@ namespace rwe
             return;
         }
 
-        const auto& weaponDefinition = sim->weaponDefinitions.at(weapon->weaponType);
+        const auto& weaponDefinition = sim->weaponDefinitions.get(weapon->weaponType);
 
         auto attackInfo = std::get_if<UnitWeaponStateAttacking>(&weapon->state);
         if (!attackInfo)
@@ -598,6 +618,11 @@ namespace rwe
                         unitInfo.state->rotation = turnTowards(unitInfo.state->rotation, targetAngle, turnRateThisFrame);
                     });
             });
+
+        if (unitInfo.state->rotation != unitInfo.state->previousRotation)
+        {
+            sim->markUnitChanged(unitInfo.id);
+        }
     }
 
     void UnitBehaviorService::updateUnitSpeed(UnitInfo unitInfo)
@@ -605,7 +630,12 @@ namespace rwe
         match(
             unitInfo.state->physics,
             [&](UnitPhysicsInfoGround& p) {
-                p.currentSpeed = computeNewGroundUnitSpeed(sim->terrain, *unitInfo.state, *unitInfo.definition, p);
+                auto newSpeed = computeNewGroundUnitSpeed(sim->terrain, *unitInfo.state, *unitInfo.definition, p);
+                if (newSpeed != p.currentSpeed)
+                {
+                    p.currentSpeed = newSpeed;
+                    sim->markUnitChanged(unitInfo.id);
+                }
             },
             [&](UnitPhysicsInfoAir& p) {
                 match(
@@ -638,6 +668,7 @@ namespace rwe
             if (!tryApplyMovementToPosition(unitInfo, newPosition))
             {
                 unitInfo.state->inCollision = true;
+                sim->markUnitChanged(unitInfo.id);
 
                 // if we failed to move, try in each axis separately
                 // to see if we can complete a "partial" movement
@@ -676,7 +707,11 @@ namespace rwe
     void UnitBehaviorService::updateUnitPosition(UnitInfo unitInfo)
     {
         unitInfo.state->previousPosition = unitInfo.state->position;
-        unitInfo.state->inCollision = false;
+        if (unitInfo.state->inCollision)
+        {
+            unitInfo.state->inCollision = false;
+            sim->markUnitChanged(unitInfo.id);
+        }
 
         match(
             unitInfo.state->physics,
@@ -705,6 +740,9 @@ namespace rwe
         if (isFlying(unitInfo.state->physics))
         {
             unitInfo.state->position = newPosition;
+            sim->markUnitChanged(unitInfo.id);
+            sim->updateUnitSpatialIndex(unitInfo.id, newPosition);
+            sim->updateFlyingUnitSpatialIndex(unitInfo.id, newPosition);
             return true;
         }
 
@@ -733,6 +771,8 @@ namespace rwe
         auto oldPosBelowSea = oldTerrainHeight < seaLevel;
 
         unitInfo.state->position = newPosition;
+        sim->markUnitChanged(unitInfo.id);
+        sim->updateUnitSpatialIndex(unitInfo.id, newPosition);
 
         auto newTerrainHeight = sim->terrain.getHeightAt(unitInfo.state->position.x, unitInfo.state->position.z);
         auto newPosBelowSea = newTerrainHeight < seaLevel;
@@ -884,7 +924,7 @@ namespace rwe
             return true;
         }
 
-        const auto& weaponDefinition = sim->weaponDefinitions.at(unitInfo.state->weapons[0]->weaponType);
+        const auto& weaponDefinition = sim->weaponDefinitions.get(unitInfo.state->weapons[0]->weaponType);
 
         auto targetPosition = getTargetPosition(target);
         if (!targetPosition)
@@ -915,7 +955,8 @@ namespace rwe
 
     bool UnitBehaviorService::handleBuildOrder(UnitInfo unitInfo, const BuildOrder& buildOrder)
     {
-        return buildUnit(unitInfo, buildOrder.unitType, buildOrder.position);
+        auto unitType = buildOrder.unitDefinitionId ? *buildOrder.unitDefinitionId : sim->getUnitDefinitionId(buildOrder.unitType);
+        return buildUnit(unitInfo, unitType, buildOrder.position);
     }
 
     bool UnitBehaviorService::handleBuggerOffOrder(UnitInfo unitInfo, const BuggerOffOrder& buggerOffOrder)
@@ -1017,9 +1058,9 @@ namespace rwe
                 }
 
                 auto& targetUnit = targetUnitOption->get();
-                const auto& targetUnitDefinition = sim->unitDefinitions.at(targetUnit.unitType);
+                const auto& targetUnitDefinition = sim->unitDefinitions.get(targetUnit.unitType);
 
-                if (targetUnit.unitType != unitType)
+                if (targetUnitDefinition.unitType != unitType)
                 {
                     if (targetUnit.isBeingBuilt(targetUnitDefinition) && !targetUnit.isDead())
                     {
@@ -1061,6 +1102,7 @@ namespace rwe
 
                 tryApplyMovementToPosition(sim->getUnitInfo(state.targetUnit->first), buildPieceInfo.position);
                 targetUnit.rotation = buildPieceInfo.rotation;
+                sim->markUnitChanged(state.targetUnit->first);
 
                 auto costs = targetUnit.getBuildCostInfo(targetUnitDefinition, unitInfo.definition->workerTimePerTick);
                 auto gotResources = sim->addResourceDelta(
@@ -1078,7 +1120,9 @@ namespace rwe
                 }
                 state.targetUnit->second = getNanoPoint(unitInfo.id);
 
-                if (targetUnit.addBuildProgress(targetUnitDefinition, unitInfo.definition->workerTimePerTick))
+                auto finishedBuilding = targetUnit.addBuildProgress(targetUnitDefinition, unitInfo.definition->workerTimePerTick);
+                sim->markUnitChanged(state.targetUnit->first);
+                if (finishedBuilding)
                 {
                     sim->events.push_back(UnitCompleteEvent{state.targetUnit->first});
 
@@ -1137,8 +1181,7 @@ namespace rwe
     {
         auto& unit = sim->getUnitState(id);
 
-        const auto& pieceName = unit.cobEnvironment->_script->pieces.at(pieceId);
-        auto pieceTransform = sim->getUnitPieceLocalTransform(id, pieceName);
+        auto pieceTransform = sim->getUnitPieceLocalTransform(id, unit.getCobPiece(pieceId));
 
         return pieceTransform * SimVector(0_ss, 0_ss, 0_ss);
     }
@@ -1154,8 +1197,7 @@ namespace rwe
     {
         auto& unit = sim->getUnitState(id);
 
-        const auto& pieceName = unit.cobEnvironment->_script->pieces.at(pieceId);
-        auto pieceTransform = sim->getUnitPieceLocalTransform(id, pieceName);
+        auto pieceTransform = sim->getUnitPieceLocalTransform(id, unit.getCobPiece(pieceId));
 
         auto mat = unit.getTransform() * pieceTransform;
 
@@ -1215,7 +1257,8 @@ namespace rwe
         {
             // request a path to follow
             unitInfo.state->navigationState.state = NavigationStateMoving{goal, resolvePathDestination(*unitInfo.state, goal), std::nullopt, true};
-            sim->requestPath(unitInfo.id);
+            sim->markUnitChanged(unitInfo.id);
+            sim->requestPath(unitInfo.id, true);
             return;
         }
 
@@ -1229,8 +1272,9 @@ namespace rwe
             // we can still continue following it
             // while we wait for a new path to be computed.
             movingState->pathDestination = resolvedDestination;
-            sim->requestPath(unitInfo.id);
+            sim->requestPath(unitInfo.id, false);
             movingState->pathRequested = true;
+            sim->markUnitChanged(unitInfo.id);
         }
 
         // if we are colliding, request a new path
@@ -1240,8 +1284,9 @@ namespace rwe
             // or we've already had our current one for a bit
             if (!movingState->path || (sim->gameTime - movingState->path->pathCreationTime) >= GameTime(30))
             {
-                sim->requestPath(unitInfo.id);
+                sim->requestPath(unitInfo.id, false);
                 movingState->pathRequested = true;
+                sim->markUnitChanged(unitInfo.id);
             }
         }
 
@@ -1253,7 +1298,9 @@ namespace rwe
             {
                 throw std::logic_error("ground unit does not have ground physics");
             }
-            if (followPath(unitInfo, *groundPhysics, *movingState->path))
+            auto finishedPath = followPath(unitInfo, *groundPhysics, *movingState->path);
+            sim->markUnitChanged(unitInfo.id);
+            if (finishedPath)
             {
                 // We finished following the path.
                 // This doesn't necessarily mean we are at the goal.
@@ -1261,7 +1308,7 @@ namespace rwe
                 // Request a new path to get us the rest of the way there.
                 if (!movingState->path || (sim->gameTime - movingState->path->pathCreationTime) >= GameTime(30))
                 {
-                    sim->requestPath(unitInfo.id);
+                    sim->requestPath(unitInfo.id, false);
                     movingState->pathRequested = true;
                 }
             }
@@ -1300,7 +1347,7 @@ namespace rwe
         }
     }
 
-    UnitCreationStatus UnitBehaviorService::createNewUnit(UnitInfo unitInfo, const std::string& unitType, const SimVector& position)
+    UnitCreationStatus UnitBehaviorService::createNewUnit(UnitInfo unitInfo, UnitDefinitionId unitType, const SimVector& position)
     {
         if (auto s = std::get_if<UnitBehaviorStateCreatingUnit>(&unitInfo.state->behaviourState))
         {
@@ -1310,20 +1357,20 @@ namespace rwe
             }
         }
 
-        const auto& targetUnitDefinition = sim->unitDefinitions.at(unitType);
+        const auto& targetUnitDefinition = sim->unitDefinitions.get(unitType);
         auto footprintRect = sim->computeFootprintRegion(position, targetUnitDefinition.movementCollisionInfo);
         if (navigateTo(unitInfo, footprintRect))
         {
             // TODO: add an additional distance check here -- we may have done the best
             // we can to move but been prevented by some obstacle, so we are too far away still.
-            changeState(*unitInfo.state, UnitBehaviorStateCreatingUnit{unitType, unitInfo.state->owner, position});
+            changeState(unitInfo, UnitBehaviorStateCreatingUnit{unitType, unitInfo.state->owner, position});
             sim->unitCreationRequests.push_back(unitInfo.id);
         }
 
         return UnitCreationStatusPending();
     }
 
-    bool UnitBehaviorService::buildUnit(UnitInfo unitInfo, const std::string& unitType, const SimVector& position)
+    bool UnitBehaviorService::buildUnit(UnitInfo unitInfo, UnitDefinitionId unitType, const SimVector& position)
     {
         auto& unit = sim->getUnitState(unitInfo.id);
         if (!unit.buildOrderUnitId)
@@ -1348,7 +1395,7 @@ namespace rwe
 
         if (!targetUnitRef || targetUnitRef->get().isDead() || !targetUnitRef->get().isBeingBuilt(*unitInfo.definition))
         {
-            changeState(*unitInfo.state, UnitBehaviorStateIdle());
+            changeState(unitInfo, UnitBehaviorStateIdle());
             return true;
         }
         auto& targetUnit = targetUnitRef->get();
@@ -1367,31 +1414,38 @@ namespace rwe
         return deployBuildArm(unitInfo, targetUnitId);
     }
 
-    void UnitBehaviorService::changeState(UnitState& unit, const UnitBehaviorState& newState)
+    void UnitBehaviorService::changeState(UnitInfo unitInfo, const UnitBehaviorState& newState)
     {
+        auto& unit = *unitInfo.state;
         if (std::holds_alternative<UnitBehaviorStateBuilding>(unit.behaviourState))
         {
             unit.cobEnvironment->createThread("StopBuilding");
         }
+
+        // idle units are returned to idle every tick
+        if (!std::holds_alternative<UnitBehaviorStateIdle>(unit.behaviourState) || !std::holds_alternative<UnitBehaviorStateIdle>(newState))
+        {
+            sim->markUnitChanged(unitInfo.id);
+        }
         unit.behaviourState = newState;
     }
     bool UnitBehaviorService::deployBuildArm(UnitInfo unitInfo, UnitId targetUnitId)
     {
         auto targetUnitRef = sim->tryGetUnitState(targetUnitId);
-        if (!targetUnitRef || targetUnitRef->get().isDead() || !targetUnitRef->get().isBeingBuilt(sim->unitDefinitions.at(targetUnitRef->get().unitType)))
+        if (!targetUnitRef || targetUnitRef->get().isDead() || !targetUnitRef->get().isBeingBuilt(sim->unitDefinitions.get(targetUnitRef->get().unitType)))
         {
-            changeState(*unitInfo.state, UnitBehaviorStateIdle());
+            changeState(unitInfo, UnitBehaviorStateIdle());
             return true;
         }
         auto& targetUnit = targetUnitRef->get();
-        const auto& targetUnitDefinition = sim->unitDefinitions.at(targetUnit.unitType);
+        const auto& targetUnitDefinition = sim->unitDefinitions.get(targetUnit.unitType);
 
         return match(
             unitInfo.state->behaviourState,
             [&](UnitBehaviorStateBuilding& buildingState) {
                 if (targetUnitId != buildingState.targetUnit)
                 {
-                    changeState(*unitInfo.state, UnitBehaviorStateIdle());
+                    changeState(unitInfo, UnitBehaviorStateIdle());
                     return buildExistingUnit(unitInfo, targetUnitId);
                 }
 
@@ -1417,7 +1471,9 @@ namespace rwe
                 }
                 buildingState.nanoParticleOrigin = getNanoPoint(unitInfo.id);
 
-                if (targetUnit.addBuildProgress(targetUnitDefinition, unitInfo.definition->workerTimePerTick))
+                auto finishedBuilding = targetUnit.addBuildProgress(targetUnitDefinition, unitInfo.definition->workerTimePerTick);
+                sim->markUnitChanged(targetUnitId);
+                if (finishedBuilding)
                 {
                     sim->events.push_back(UnitCompleteEvent{buildingState.targetUnit});
 
@@ -1426,7 +1482,7 @@ namespace rwe
                         sim->activateUnit(buildingState.targetUnit);
                     }
 
-                    changeState(*unitInfo.state, UnitBehaviorStateIdle());
+                    changeState(unitInfo, UnitBehaviorStateIdle());
                     return true;
                 }
                 return false;
@@ -1437,7 +1493,7 @@ namespace rwe
                 auto heading = headingAndPitch.first;
                 auto pitch = headingAndPitch.second;
 
-                changeState(*unitInfo.state, UnitBehaviorStateBuilding{targetUnitId, std::nullopt});
+                changeState(unitInfo, UnitBehaviorStateBuilding{targetUnitId, std::nullopt});
                 unitInfo.state->cobEnvironment->createThread("StartBuilding", {toCobAngle(heading).value, toCobAngle(pitch).value});
                 return false;
             });
@@ -1448,6 +1504,8 @@ namespace rwe
         auto targetHeight = getTargetAltitude(sim->terrain, unitInfo.state->position.x, unitInfo.state->position.z, *unitInfo.definition);
 
         unitInfo.state->position.y = rweMin(unitInfo.state->position.y + 1_ss, targetHeight);
+        sim->markUnitChanged(unitInfo.id);
+        sim->markUnitTargetingChanged(unitInfo.id);
 
         return unitInfo.state->position.y == targetHeight;
     }
@@ -1457,6 +1515,8 @@ namespace rwe
         auto terrainHeight = sim->terrain.getHeightAt(unitInfo.state->position.x, unitInfo.state->position.z);
 
         unitInfo.state->position.y = rweMax(unitInfo.state->position.y - 1_ss, terrainHeight);
+        sim->markUnitChanged(unitInfo.id);
+        sim->markUnitTargetingChanged(unitInfo.id);
 
         return unitInfo.state->position.y == terrainHeight;
     }
@@ -1466,13 +1526,14 @@ namespace rwe
         unitInfo.state->activate();
 
         unitInfo.state->physics = UnitPhysicsInfoAir();
+        sim->markUnitChanged(unitInfo.id);
         auto footprintRect = sim->computeFootprintRegion(unitInfo.state->position, unitInfo.definition->movementCollisionInfo);
         auto footprintRegion = sim->occupiedGrid.tryToRegion(footprintRect);
         assert(!!footprintRegion);
         sim->occupiedGrid.forEach(*footprintRegion, [](auto& cell) {
             cell.mobileUnitId = std::nullopt;
         });
-        sim->flyingUnitsSet.insert(unitInfo.id);
+        sim->addFlyingUnit(unitInfo.id);
     }
 
     bool UnitBehaviorService::tryTransitionFromAirToGround(UnitInfo unitInfo)
@@ -1489,9 +1550,10 @@ namespace rwe
         sim->occupiedGrid.forEach(*footprintRegion, [&](auto& cell) {
             cell.mobileUnitId = unitInfo.id;
         });
-        sim->flyingUnitsSet.erase(unitInfo.id);
+        sim->removeFlyingUnit(unitInfo.id);
 
         unitInfo.state->physics = UnitPhysicsInfoGround();
+        sim->markUnitChanged(unitInfo.id);
 
         return true;
     }
@@ -30,7 +30,8 @@ namespace rwe
 
         void updateWind(SimScalar windSpeed, SimAngle windDirection);
 
-        void update(UnitId unitId);
+        /** Updates the unit, acting on the plan made for it at the start of the tick. */
+        void update(UnitId unitId, const UnitUpdatePlan& plan);
 
         // FIXME: shouldn't really be public
         SimVector getSweetSpot(UnitId id);
@@ -61,7 +62,7 @@ namespace rwe
 
         void clearBuild(UnitInfo unitInfo);
 
-        void updateWeapon(UnitId id, unsigned int weaponIndex);
+        void updateWeapon(UnitId id, unsigned int weaponIndex, const UnitUpdatePlan& plan);
 
         SimVector changeDirectionByRandomAngle(const SimVector& direction, SimAngle maxAngle);
 
@@ -71,6 +72,8 @@ namespace rwe
 
         void updateNavigation(UnitInfo unitInfo);
 
+        void setNavigationStateIdle(UnitInfo unitInfo);
+
         void applyUnitSteering(UnitInfo unitInfo);
         void updateUnitRotation(UnitInfo unitInfo);
         void updateUnitSpeed(UnitInfo unitInfo);
@@ -116,13 +119,13 @@ namespace rwe
 
         bool attackTarget(UnitInfo unitInfo, const AttackTarget& target);
 
-        bool buildUnit(UnitInfo unitInfo, const std::string& unitType, const SimVector& position);
+        bool buildUnit(UnitInfo unitInfo, UnitDefinitionId unitType, const SimVector& position);
 
-        UnitCreationStatus createNewUnit(UnitInfo unitInfo, const std::string& unitType, const SimVector& position);
+        UnitCreationStatus createNewUnit(UnitInfo unitInfo, UnitDefinitionId unitType, const SimVector& position);
 
         bool buildExistingUnit(UnitInfo unitInfo, UnitId targetUnitId);
 
-        void changeState(UnitState& unit, const UnitBehaviorState& newState);
+        void changeState(UnitInfo unitInfo, const UnitBehaviorState& newState);
 
         bool deployBuildArm(UnitInfo unitInfo, UnitId targetUnitId);
 
@@ -1,5 +1,6 @@
 #include "UnitBehaviorService_util.h"
 #include <algorithm>
+#include <rwe/util/Index.h>
 
 #include <stdexcept>
 
@@ -382,6 +383,112 @@ namespace rwe
         return false;
     }
 
+    bool isValidWeaponTarget(const UnitState& unit, const WeaponDefinition& weaponDefinition, const UnitState& otherUnit)
+    {
+        if (otherUnit.isDead())
+        {
+            return false;
+        }
+
+        if (otherUnit.isOwnedBy(unit.owner))
+        {
+            return false;
+        }
+
+        return unit.position.distanceSquared(otherUnit.position) <= weaponDefinition.maxRange * weaponDefinition.maxRange;
+    }
+
+    std::optional<UnitId> findWeaponTarget(const GameSimulation& sim, const UnitState& unit, const WeaponDefinition& weaponDefinition)
+    {
+        // Take the lowest ID in range.
+        // This matches the unit that a scan over all units
+        // in iteration order would have found first.
+        std::optional<UnitId> target;
+        sim.forEachUnitInRadius(unit.position, weaponDefinition.maxRange, [&](UnitId otherUnitId, const UnitState& otherUnit) {
+            if (target && *target < otherUnitId)
+            {
+                return;
+            }
+
+            if (!isValidWeaponTarget(unit, weaponDefinition, otherUnit))
+            {
+                return;
+            }
+
+            target = otherUnitId;
+        });
+
+        return target;
+    }
+
+    bool canRecheckPlannedWeaponTarget(const GameSimulation& sim, UnitId unitId, const UnitState& unit, const WeaponDefinition& weaponDefinition, std::optional<UnitId> plannedTarget)
+    {
+        if (sim.hasUnitTargetingChangedSincePlanning(unitId))
+        {
+            return false;
+        }
+
+        if (plannedTarget)
+        {
+            auto target = sim.tryGetUnitState(*plannedTarget);
+            if (!target || !isValidWeaponTarget(unit, weaponDefinition, target->get()))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::optional<UnitId> recheckPlannedWeaponTarget(const GameSimulation& sim, const UnitState& unit, const WeaponDefinition& weaponDefinition, std::optional<UnitId> plannedTarget)
+    {
+        // The planned target was the lowest valid id at the start of the tick,
+        // so any lower id that is valid now must have moved, died or been created since.
+        auto target = plannedTarget;
+        sim.forEachUnitTargetingChangedNear(unit.position, weaponDefinition.maxRange, [&](UnitId otherUnitId, const UnitState& otherUnit) {
+            if (target && *target < otherUnitId)
+            {
+                return;
+            }
+
+            if (!isValidWeaponTarget(unit, weaponDefinition, otherUnit))
+            {
+                return;
+            }
+
+            target = otherUnitId;
+        });
+
+        return target;
+    }
+
+    void planUnitUpdate(const GameSimulation& sim, UnitId unitId, UnitUpdatePlan& plan)
+    {
+        const auto& unit = sim.getUnitState(unitId);
+
+        plan.unitId = unitId;
+        for (Index i = 0; i < getSize(unit.weapons); ++i)
+        {
+            plan.weaponTargetPlanned[i] = false;
+            plan.weaponTargets[i] = std::nullopt;
+
+            const auto& weapon = unit.weapons[i];
+            if (!weapon || !std::holds_alternative<UnitWeaponStateIdle>(weapon->state))
+            {
+                continue;
+            }
+
+            const auto& weaponDefinition = sim.weaponDefinitions.get(weapon->weaponType);
+            if (weaponDefinition.commandFire || unit.fireOrders != UnitFireOrders::FireAtWill)
+            {
+                continue;
+            }
+
+            plan.weaponTargetPlanned[i] = true;
+            plan.weaponTargets[i] = findWeaponTarget(sim, unit, weaponDefinition);
+        }
+    }
+
     std::string getAimScriptName(unsigned int weaponIndex)
     {
         switch (weaponIndex)
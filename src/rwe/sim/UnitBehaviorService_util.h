@@ -46,6 +46,39 @@ namespace rwe
 
     bool hasReachedGoal(const GameSimulation& sim, const MapTerrain& terrain, const UnitState& unit, const UnitDefinition& unitDefinition, const NavigationGoal& goal);
 
+    /** Returns true if the other unit is alive, owned by an enemy and within range of the unit's weapon. */
+    bool isValidWeaponTarget(const UnitState& unit, const WeaponDefinition& weaponDefinition, const UnitState& otherUnit);
+
+    /**
+     * Returns the enemy the unit's weapon should pick as its target:
+     * the living, enemy-owned unit in range with the lowest ID.
+     */
+    std::optional<UnitId> findWeaponTarget(const GameSimulation& sim, const UnitState& unit, const WeaponDefinition& weaponDefinition);
+
+    /**
+     * Returns true if recheckPlannedWeaponTarget can be used
+     * to update the target findWeaponTarget returned when the plans were made this tick.
+     * This is not the case when the unit itself has moved or died since,
+     * or when the planned target has died or moved out of range,
+     * and findWeaponTarget must be called again instead.
+     */
+    bool canRecheckPlannedWeaponTarget(const GameSimulation& sim, UnitId unitId, const UnitState& unit, const WeaponDefinition& weaponDefinition, std::optional<UnitId> plannedTarget);
+
+    /**
+     * Returns the same target as findWeaponTarget,
+     * given the target it returned when the plans were made this tick.
+     * Only units marked by markUnitTargetingChanged since planning
+     * can have become better targets, so only those in range are checked.
+     * canRecheckPlannedWeaponTarget must be true.
+     */
+    std::optional<UnitId> recheckPlannedWeaponTarget(const GameSimulation& sim, const UnitState& unit, const WeaponDefinition& weaponDefinition, std::optional<UnitId> plannedTarget);
+
+    /**
+     * Works out the plan for the unit's update this tick.
+     * Only reads the simulation, so may be called for many units at once.
+     */
+    void planUnitUpdate(const GameSimulation& sim, UnitId unitId, UnitUpdatePlan& plan);
+
     std::string getAimScriptName(unsigned int weaponIndex);
     std::string getAimFromScriptName(unsigned int weaponIndex);
     std::string getFireScriptName(unsigned int weaponIndex);
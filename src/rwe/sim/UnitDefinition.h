@@ -47,6 +47,9 @@ namespace rwe
         std::string unitName;
         std::string unitDescription;
 
+        /** The upper-case name the unit type is known by, e.g. ARMCOM. */
+        std::string unitType;
+
         std::string objectName;
 
         MovementCollisionInfo movementCollisionInfo;
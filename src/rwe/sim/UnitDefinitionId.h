@@ -0,0 +1,9 @@
+#pragma once
+
+#include <rwe/util/OpaqueId.h>
+
+namespace rwe
+{
+    struct UnitDefinitionIdTag;
+    using UnitDefinitionId = OpaqueId<unsigned int, UnitDefinitionIdTag>;
+}
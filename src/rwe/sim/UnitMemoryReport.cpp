@@ -0,0 +1,81 @@
+#include "UnitMemoryReport.h"
+#include <rwe/sim/GameSimulation.h>
+#include <rwe/sim/UnitModelDefinition.h>
+
+namespace rwe
+{
+    std::size_t UnitMemoryReport::getBytesPerUnit() const
+    {
+        return unitCount == 0 ? 0 : unitBytes / unitCount;
+    }
+
+    std::size_t UnitMemoryReport::getBytesPerUnitWithCopies() const
+    {
+        return unitCount == 0 ? 0 : (unitBytes + perUnitCopyBytes) / unitCount;
+    }
+
+    std::size_t estimateStringBytes(const std::string& s)
+    {
+        // short strings live inside the object itself
+        static const auto inlineCapacity = std::string().capacity();
+        return sizeof(std::string) + (s.capacity() > inlineCapacity ? s.capacity() + 1 : 0);
+    }
+
+    std::size_t estimatePieceIndexBytes(const std::unordered_map<std::string, int>& index)
+    {
+        // each node holds a next pointer, the entry and a cached hash
+        const auto nodeBytes = sizeof(void*) + sizeof(std::pair<const std::string, int>) + sizeof(std::size_t);
+
+        auto total = sizeof(index) + index.bucket_count() * sizeof(void*);
+        for (const auto& [name, pieceIndex] : index)
+        {
+            total += nodeBytes + estimateStringBytes(name) - sizeof(std::string);
+        }
+        return total;
+    }
+
+    std::size_t estimateModelDefinitionBytes(const UnitModelDefinition& modelDefinition)
+    {
+        auto total = sizeof(modelDefinition);
+        for (const auto& piece : modelDefinition.pieces)
+        {
+            total += sizeof(piece) + estimateStringBytes(piece.name) - sizeof(std::string);
+            if (piece.parent)
+            {
+                total += estimateStringBytes(*piece.parent) - sizeof(std::string);
+            }
+        }
+        total += estimatePieceIndexBytes(modelDefinition.pieceIndicesByName) - sizeof(modelDefinition.pieceIndicesByName);
+        total += modelDefinition.pieceParentIndices.capacity() * sizeof(std::optional<int>);
+        return total;
+    }
+
+    UnitMemoryReport createUnitMemoryReport(const GameSimulation& simulation)
+    {
+        UnitMemoryReport report;
+
+        for (const auto& [name, modelDefinition] : simulation.unitModelDefinitions)
+        {
+            report.sharedBytes += estimateModelDefinitionBytes(modelDefinition);
+        }
+        for (const auto& [unitType, cobPieceIndices] : simulation.unitCobPieceIndices)
+        {
+            report.sharedBytes += sizeof(cobPieceIndices) + cobPieceIndices.capacity() * sizeof(std::optional<int>);
+        }
+
+        for (const auto& entry : simulation.units)
+        {
+            const auto& unit = entry.second;
+            ++report.unitCount;
+            report.unitBytes += sizeof(unit) + unit.pieces.capacity() * sizeof(UnitMesh);
+
+            for (const auto& piece : unit.modelDefinition->pieces)
+            {
+                report.perUnitCopyBytes += estimateStringBytes(piece.name);
+            }
+            report.perUnitCopyBytes += estimatePieceIndexBytes(unit.modelDefinition->pieceIndicesByName);
+        }
+
+        return report;
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+namespace rwe
+{
+    class GameSimulation;
+    struct UnitModelDefinition;
+
+    /**
+     * Rough accounting of the memory used by units and their piece metadata.
+     * Sizes are estimates based on the usual layout of standard containers.
+     */
+    struct UnitMemoryReport
+    {
+        std::size_t unitCount{0};
+
+        /** Bytes held by the units themselves: the UnitState objects and their piece arrays. */
+        std::size_t unitBytes{0};
+
+        /** Bytes of piece metadata shared between units: model definitions and COB piece maps. */
+        std::size_t sharedBytes{0};
+
+        /**
+         * Bytes the units would additionally hold if each one carried
+         * its own copy of its model's piece names and piece name index.
+         */
+        std::size_t perUnitCopyBytes{0};
+
+        std::size_t getBytesPerUnit() const;
+
+        std::size_t getBytesPerUnitWithCopies() const;
+    };
+
+    std::size_t estimateStringBytes(const std::string& s);
+
+    std::size_t estimatePieceIndexBytes(const std::unordered_map<std::string, int>& index);
+
+    std::size_t estimateModelDefinitionBytes(const UnitModelDefinition& modelDefinition);
+
+    UnitMemoryReport createUnitMemoryReport(const GameSimulation& simulation);
+}
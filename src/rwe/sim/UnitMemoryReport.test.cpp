@@ -0,0 +1,45 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/sim/UnitMemoryReport.h>
+#include <rwe/sim/UnitModelDefinition.h>
+
+namespace rwe
+{
+    TEST_CASE("estimateStringBytes")
+    {
+        SECTION("counts only the object for short strings")
+        {
+            REQUIRE(estimateStringBytes("") == sizeof(std::string));
+            REQUIRE(estimateStringBytes("A") == sizeof(std::string));
+        }
+
+        SECTION("counts the heap buffer of long strings")
+        {
+            std::string s(100, 'x');
+            REQUIRE(estimateStringBytes(s) > sizeof(std::string) + 100);
+        }
+    }
+
+    TEST_CASE("estimatePieceIndexBytes")
+    {
+        SECTION("grows with the number of entries")
+        {
+            std::unordered_map<std::string, int> small{{"BASE", 0}};
+            std::unordered_map<std::string, int> large{{"BASE", 0}, {"TURRET", 1}, {"SLEEVE", 2}, {"BARREL", 3}};
+            REQUIRE(estimatePieceIndexBytes(small) > sizeof(small));
+            REQUIRE(estimatePieceIndexBytes(large) > estimatePieceIndexBytes(small));
+        }
+    }
+
+    TEST_CASE("estimateModelDefinitionBytes")
+    {
+        SECTION("includes the piece name index")
+        {
+            std::vector<UnitPieceDefinition> pieces{
+                UnitPieceDefinition{"base", SimVector(0_ss, 0_ss, 0_ss), std::nullopt},
+                UnitPieceDefinition{"turret", SimVector(0_ss, 0_ss, 0_ss), std::string("base")}};
+            auto modelDefinition = createUnitModelDefinition(10_ss, std::move(pieces));
+
+            REQUIRE(estimateModelDefinitionBytes(modelDefinition) > estimatePieceIndexBytes(modelDefinition.pieceIndicesByName));
+        }
+    }
+}
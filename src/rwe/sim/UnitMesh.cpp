@@ -104,6 +104,16 @@ namespace rwe
         applyTurnOperation(zTurnOperation, rotationZ, dt);
     }
 
+    bool UnitMesh::isAnimating() const
+    {
+        return xMoveOperation || yMoveOperation || zMoveOperation
+            || xTurnOperation || yTurnOperation || zTurnOperation
+            || previousOffset != offset
+            || previousRotationX != rotationX
+            || previousRotationY != rotationY
+            || previousRotationZ != rotationZ;
+    }
+
     UnitMesh::MoveOperation::MoveOperation(SimScalar targetPosition, SimScalar speed)
         : targetPosition(targetPosition), speed(speed)
     {
@@ -55,7 +55,6 @@ namespace rwe
 
         using TurnOperationUnion = std::variant<TurnOperation, SpinOperation, StopSpinOperation>;
 
-        std::string name;
         bool visible{true};
         bool shaded{true};
         SimVector offset{0_ss, 0_ss, 0_ss};
@@ -75,6 +74,16 @@ namespace rwe
         std::optional<TurnOperationUnion> yTurnOperation;
         std::optional<TurnOperationUnion> zTurnOperation;
 
+        /** True while the piece is in its unit's list of animating pieces. */
+        bool inAnimatingList{false};
+
         void update(SimScalar dt);
+
+        /**
+         * True if the piece has an operation in progress
+         * or moved during the last update,
+         * i.e. if calling update would change it.
+         */
+        bool isAnimating() const;
     };
 }
@@ -14,12 +14,43 @@ namespace rwe
         return m;
     }
 
+    std::vector<std::optional<int>> createPieceParentIndices(const std::vector<UnitPieceDefinition>& pieces, const std::unordered_map<std::string, int>& pieceIndicesByName)
+    {
+        std::vector<std::optional<int>> v;
+        v.reserve(pieces.size());
+        for (const auto& piece : pieces)
+        {
+            if (!piece.parent)
+            {
+                v.emplace_back();
+                continue;
+            }
+
+            auto it = pieceIndicesByName.find(toUpper(*piece.parent));
+            v.push_back(it == pieceIndicesByName.end() ? std::nullopt : std::make_optional(it->second));
+        }
+        return v;
+    }
+
+    std::vector<std::optional<int>> createCobPieceIndexMap(const std::vector<std::string>& cobPieceNames, const UnitModelDefinition& modelDefinition)
+    {
+        std::vector<std::optional<int>> v;
+        v.reserve(cobPieceNames.size());
+        for (const auto& name : cobPieceNames)
+        {
+            auto it = modelDefinition.pieceIndicesByName.find(toUpper(name));
+            v.push_back(it == modelDefinition.pieceIndicesByName.end() ? std::nullopt : std::make_optional(it->second));
+        }
+        return v;
+    }
+
     UnitModelDefinition createUnitModelDefinition(SimScalar height, std::vector<UnitPieceDefinition>&& pieces)
     {
         UnitModelDefinition d;
         d.height = height;
         d.pieces = std::move(pieces);
         d.pieceIndicesByName = createPieceNameIndex(d.pieces);
+        d.pieceParentIndices = createPieceParentIndices(d.pieces, d.pieceIndicesByName);
         return d;
     }
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <rwe/sim/SimScalar.h>
+#include <optional>
 #include <rwe/sim/UnitPieceDefinition.h>
+#include <unordered_map>
 #include <vector>
 
 namespace rwe
@@ -11,7 +13,19 @@ namespace rwe
         SimScalar height;
         std::vector<UnitPieceDefinition> pieces;
         std::unordered_map<std::string, int> pieceIndicesByName;
+
+        /**
+         * The index of each piece's parent, or nothing for root pieces
+         * and pieces whose parent is not in the model.
+         */
+        std::vector<std::optional<int>> pieceParentIndices;
     };
 
+    /**
+     * Maps each piece name in a COB script to the index of the piece
+     * with that name in the model, or to nothing if the model has no such piece.
+     */
+    std::vector<std::optional<int>> createCobPieceIndexMap(const std::vector<std::string>& cobPieceNames, const UnitModelDefinition& modelDefinition);
+
     UnitModelDefinition createUnitModelDefinition(SimScalar height, std::vector<UnitPieceDefinition>&& pieces);
 }
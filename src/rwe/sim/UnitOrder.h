@@ -1,8 +1,11 @@
 #pragma once
 
 #include <rwe/grid/DiscreteRect.h>
+#include <optional>
 #include <rwe/sim/SimVector.h>
+#include <rwe/sim/UnitDefinitionId.h>
 #include <rwe/sim/UnitId.h>
+#include <string>
 #include <variant>
 
 namespace rwe
@@ -26,6 +29,15 @@ namespace rwe
     {
         std::string unitType;
         SimVector position;
+
+        /**
+         * The definition of unitType, filled in by GameSimulation::resolveOrder
+         * when the order is given to a unit, so that it is not looked up
+         * on every tick the order is carried out.
+         * Not sent over the network or saved in snapshots.
+         */
+        std::optional<UnitDefinitionId> unitDefinitionId;
+
         BuildOrder(const std::string& unitType, const SimVector& position) : unitType(unitType), position(position) {}
     };
 
@@ -0,0 +1,137 @@
+#include "UnitSpatialIndex.h"
+#include <rwe/sim/SnapshotIo.h>
+#include <rwe/util/Index.h>
+#include <stdexcept>
+
+namespace rwe
+{
+    UnitSpatialIndex::UnitSpatialIndex(int widthInCells, int heightInCells)
+        : buckets((widthInCells + BucketSize - 1) / BucketSize, (heightInCells + BucketSize - 1) / BucketSize)
+    {
+    }
+
+    void UnitSpatialIndex::insert(UnitId unitId, const Point& position)
+    {
+        if (entries.find(unitId) != entries.end())
+        {
+            throw std::logic_error("Unit is already in the spatial index");
+        }
+
+        entries.insert({unitId, addToBucket(unitId, toBucketIndex(position))});
+    }
+
+    void UnitSpatialIndex::move(UnitId unitId, const Point& position)
+    {
+        auto it = entries.find(unitId);
+        if (it == entries.end())
+        {
+            throw std::logic_error("Unit is not in the spatial index");
+        }
+
+        auto bucketIndex = toBucketIndex(position);
+        if (it->second.bucketIndex == bucketIndex)
+        {
+            return;
+        }
+
+        removeFromBucket(it->second);
+        it->second = addToBucket(unitId, bucketIndex);
+    }
+
+    void UnitSpatialIndex::remove(UnitId unitId)
+    {
+        auto it = entries.find(unitId);
+        if (it == entries.end())
+        {
+            throw std::logic_error("Unit is not in the spatial index");
+        }
+
+        removeFromBucket(it->second);
+        entries.erase(it);
+    }
+
+    void UnitSpatialIndex::clear()
+    {
+        for (const auto& entry : entries)
+        {
+            buckets.getVector()[entry.second.bucketIndex].clear();
+        }
+
+        entries.clear();
+    }
+
+    bool UnitSpatialIndex::contains(UnitId unitId) const
+    {
+        return entries.find(unitId) != entries.end();
+    }
+
+    int UnitSpatialIndex::size() const
+    {
+        return static_cast<int>(entries.size());
+    }
+
+    void UnitSpatialIndex::saveSnapshot(SnapshotWriter& w) const
+    {
+        writeSnapshot(w, buckets);
+    }
+
+    void UnitSpatialIndex::restoreSnapshot(SnapshotReader& r)
+    {
+        auto newBuckets = readSnapshotValue<Grid<std::vector<UnitId>>>(r);
+        if (newBuckets.getWidth() != buckets.getWidth() || newBuckets.getHeight() != buckets.getHeight())
+        {
+            throw std::runtime_error("Spatial index in snapshot has the wrong size");
+        }
+
+        buckets = std::move(newBuckets);
+        entries.clear();
+        for (int i = 0; i < getSize(buckets.getVector()); ++i)
+        {
+            const auto& bucket = buckets.getVector()[i];
+            for (int slot = 0; slot < getSize(bucket); ++slot)
+            {
+                entries.insert({bucket[slot], Entry{i, slot}});
+            }
+        }
+    }
+
+    GridCoordinates UnitSpatialIndex::toBucketCoordinates(const Point& position) const
+    {
+        // Divide before clamping so that negative positions
+        // round towards the first bucket rather than towards zero.
+        auto x = position.x < 0 ? 0 : position.x / BucketSize;
+        auto y = position.y < 0 ? 0 : position.y / BucketSize;
+        return buckets.clampToCoords(Point(x, y));
+    }
+
+    int UnitSpatialIndex::toBucketIndex(const Point& position) const
+    {
+        if (buckets.getWidth() == 0 || buckets.getHeight() == 0)
+        {
+            throw std::logic_error("Spatial index has no buckets");
+        }
+
+        return buckets.toIndex(toBucketCoordinates(position));
+    }
+
+    void UnitSpatialIndex::removeFromBucket(const Entry& entry)
+    {
+        auto& bucket = buckets.getVector()[entry.bucketIndex];
+
+        // swap-remove, fixing up the slot of the unit we moved
+        auto lastUnitId = bucket.back();
+        bucket[entry.slot] = lastUnitId;
+        bucket.pop_back();
+        if (entry.slot < getSize(bucket))
+        {
+            entries.at(lastUnitId).slot = entry.slot;
+        }
+    }
+
+    UnitSpatialIndex::Entry UnitSpatialIndex::addToBucket(UnitId unitId, int bucketIndex)
+    {
+        auto& bucket = buckets.getVector()[bucketIndex];
+        bucket.push_back(unitId);
+        return Entry{bucketIndex, static_cast<int>(bucket.size()) - 1};
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <rwe/grid/Grid.h>
+#include <rwe/grid/Point.h>
+#include <rwe/sim/UnitId.h>
+#include <unordered_map>
+#include <vector>
+
+namespace rwe
+{
+    class SnapshotReader;
+    class SnapshotWriter;
+
+    /**
+     * A uniform bucket grid over the heightmap that records
+     * which units are (roughly) where, so that proximity queries
+     * only need to look at the units in nearby buckets
+     * rather than every unit in the game.
+     *
+     * Positions are given in heightmap cell coordinates.
+     * Positions outside the map are clamped to the edge buckets.
+     */
+    class UnitSpatialIndex
+    {
+    public:
+        /** The width and height of each bucket, in heightmap cells. */
+        static constexpr int BucketSize = 8;
+
+    private:
+        struct Entry
+        {
+            int bucketIndex;
+            int slot;
+        };
+
+        Grid<std::vector<UnitId>> buckets;
+        std::unordered_map<UnitId, Entry> entries;
+
+    public:
+        UnitSpatialIndex() = default;
+
+        UnitSpatialIndex(int widthInCells, int heightInCells);
+
+        void insert(UnitId unitId, const Point& position);
+
+        /**
+         * Updates the position of a unit that is already in the index.
+         */
+        void move(UnitId unitId, const Point& position);
+
+        void remove(UnitId unitId);
+
+        /**
+         * Removes every unit.
+         * Only the buckets that hold units are visited.
+         */
+        void clear();
+
+        bool contains(UnitId unitId) const;
+
+        int size() const;
+
+        /**
+         * Writes the contents of every bucket.
+         * The order of units within a bucket is kept,
+         * since it decides the order in which queries visit them.
+         */
+        void saveSnapshot(SnapshotWriter& w) const;
+
+        void restoreSnapshot(SnapshotReader& r);
+
+        /**
+         * Calls f for every unit whose bucket overlaps
+         * the rectangle between min and max (inclusive).
+         * The callback may see units that lie slightly outside the rectangle,
+         * callers are expected to do their own exact checks.
+         * Units are visited in an unspecified (but deterministic) order.
+         */
+        template <typename Func>
+        void forEachInRegion(const Point& min, const Point& max, Func f) const
+        {
+            if (buckets.getWidth() == 0 || buckets.getHeight() == 0)
+            {
+                return;
+            }
+
+            auto minBucket = toBucketCoordinates(min);
+            auto maxBucket = toBucketCoordinates(max);
+
+            for (int y = minBucket.y; y <= maxBucket.y; ++y)
+            {
+                for (int x = minBucket.x; x <= maxBucket.x; ++x)
+                {
+                    for (const auto& unitId : buckets.get(x, y))
+                    {
+                        f(unitId);
+                    }
+                }
+            }
+        }
+
+    private:
+        GridCoordinates toBucketCoordinates(const Point& position) const;
+
+        int toBucketIndex(const Point& position) const;
+
+        void removeFromBucket(const Entry& entry);
+
+        Entry addToBucket(UnitId unitId, int bucketIndex);
+    };
+}
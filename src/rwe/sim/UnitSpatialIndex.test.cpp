@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/sim/UnitSpatialIndex.h>
+#include <vector>
+
+namespace rwe
+{
+    std::vector<UnitId> queryRegion(const UnitSpatialIndex& index, const Point& min, const Point& max)
+    {
+        std::vector<UnitId> result;
+        index.forEachInRegion(min, max, [&](UnitId id) { result.push_back(id); });
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    TEST_CASE("UnitSpatialIndex")
+    {
+        UnitSpatialIndex index(64, 32);
+
+        SECTION("finds units in the queried region")
+        {
+            index.insert(UnitId(1), Point(2, 2));
+            index.insert(UnitId(2), Point(40, 20));
+            index.insert(UnitId(3), Point(3, 5));
+
+            REQUIRE(index.size() == 3);
+            REQUIRE(queryRegion(index, Point(0, 0), Point(7, 7)) == std::vector<UnitId>{UnitId(1), UnitId(3)});
+            REQUIRE(queryRegion(index, Point(32, 16), Point(47, 23)) == std::vector<UnitId>{UnitId(2)});
+            REQUIRE(queryRegion(index, Point(0, 0), Point(63, 31)) == std::vector<UnitId>{UnitId(1), UnitId(2), UnitId(3)});
+        }
+
+        SECTION("does not find units in distant buckets")
+        {
+            index.insert(UnitId(1), Point(2, 2));
+            REQUIRE(queryRegion(index, Point(16, 16), Point(30, 30)).empty());
+        }
+
+        SECTION("moved units are found at their new position")
+        {
+            index.insert(UnitId(1), Point(2, 2));
+            index.insert(UnitId(2), Point(3, 3));
+            index.move(UnitId(1), Point(50, 25));
+
+            REQUIRE(queryRegion(index, Point(0, 0), Point(7, 7)) == std::vector<UnitId>{UnitId(2)});
+            REQUIRE(queryRegion(index, Point(48, 24), Point(55, 31)) == std::vector<UnitId>{UnitId(1)});
+        }
+
+        SECTION("removed units are not found")
+        {
+            index.insert(UnitId(1), Point(2, 2));
+            index.insert(UnitId(2), Point(3, 3));
+            index.insert(UnitId(3), Point(4, 4));
+            index.remove(UnitId(1));
+
+            REQUIRE(index.size() == 2);
+            REQUIRE(!index.contains(UnitId(1)));
+            REQUIRE(queryRegion(index, Point(0, 0), Point(7, 7)) == std::vector<UnitId>{UnitId(2), UnitId(3)});
+
+            // the remaining entries must still be individually removable
+            index.remove(UnitId(3));
+            index.remove(UnitId(2));
+            REQUIRE(index.size() == 0);
+            REQUIRE(queryRegion(index, Point(0, 0), Point(63, 31)).empty());
+        }
+
+        SECTION("clear removes every unit")
+        {
+            index.insert(UnitId(1), Point(2, 2));
+            index.insert(UnitId(2), Point(40, 20));
+            index.clear();
+
+            REQUIRE(index.size() == 0);
+            REQUIRE(!index.contains(UnitId(1)));
+            REQUIRE(queryRegion(index, Point(0, 0), Point(63, 31)).empty());
+
+            // units can be added again afterwards
+            index.insert(UnitId(1), Point(3, 3));
+            REQUIRE(queryRegion(index, Point(0, 0), Point(7, 7)) == std::vector<UnitId>{UnitId(1)});
+        }
+
+        SECTION("positions outside the map are clamped to the edge")
+        {
+            index.insert(UnitId(1), Point(-5, -5));
+            index.insert(UnitId(2), Point(100, 100));
+
+            REQUIRE(queryRegion(index, Point(-10, -10), Point(0, 0)) == std::vector<UnitId>{UnitId(1)});
+            REQUIRE(queryRegion(index, Point(63, 31), Point(63, 31)) == std::vector<UnitId>{UnitId(2)});
+        }
+
+        SECTION("rejects duplicate and unknown units")
+        {
+            index.insert(UnitId(1), Point(2, 2));
+            REQUIRE_THROWS(index.insert(UnitId(1), Point(2, 2)));
+            REQUIRE_THROWS(index.move(UnitId(2), Point(2, 2)));
+            REQUIRE_THROWS(index.remove(UnitId(2)));
+        }
+    }
+}
@@ -91,18 +91,8 @@ namespace rwe
         return SimVector(sin(rotation), 0_ss, cos(rotation));
     }
 
-    std::unordered_map<std::string, int> createPieceIndex(const std::vector<UnitMesh>& pieces)
-    {
-        std::unordered_map<std::string, int> m;
-        for (Index i = 0; i < getSize(pieces); ++i)
-        {
-            m.insert_or_assign(toUpper(pieces[i].name), i);
-        }
-        return m;
-    }
-
-    UnitState::UnitState(const std::vector<UnitMesh>& pieces, std::unique_ptr<CobEnvironment>&& cobEnvironment)
-        : pieces(pieces), pieceNameToIndices(createPieceIndex(this->pieces)), cobEnvironment(std::move(cobEnvironment))
+    UnitState::UnitState(const UnitModelDefinition* modelDefinition, std::unique_ptr<CobEnvironment>&& cobEnvironment, const std::vector<std::optional<int>>* cobPieceIndices)
+        : pieces(modelDefinition->pieces.size()), modelDefinition(modelDefinition), cobEnvironment(std::move(cobEnvironment)), cobPieceIndices(cobPieceIndices)
     {
     }
 
@@ -174,122 +164,132 @@ namespace rwe
 
     void UnitState::moveObject(const std::string& pieceName, SimAxis axis, SimScalar targetPosition, SimScalar speed)
     {
-        auto piece = findPiece(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name: " + pieceName);
-        }
+        moveObject(getPieceIndex(pieceName), axis, targetPosition, speed);
+    }
+
+    void UnitState::moveObject(int pieceIndex, SimAxis axis, SimScalar targetPosition, SimScalar speed)
+    {
+        markPieceAnimating(pieceIndex);
+        auto& piece = pieces[pieceIndex];
 
         UnitMesh::MoveOperation op(targetPosition, speed);
 
         switch (axis)
         {
             case SimAxis::X:
-                piece->get().xMoveOperation = op;
+                piece.xMoveOperation = op;
                 break;
             case SimAxis::Y:
-                piece->get().yMoveOperation = op;
+                piece.yMoveOperation = op;
                 break;
             case SimAxis::Z:
-                piece->get().zMoveOperation = op;
+                piece.zMoveOperation = op;
                 break;
         }
     }
 
     void UnitState::moveObjectNow(const std::string& pieceName, SimAxis axis, SimScalar targetPosition)
     {
-        auto piece = findPiece(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name: " + pieceName);
-        }
+        moveObjectNow(getPieceIndex(pieceName), axis, targetPosition);
+    }
+
+    void UnitState::moveObjectNow(int pieceIndex, SimAxis axis, SimScalar targetPosition)
+    {
+        markPieceAnimating(pieceIndex);
+        auto& piece = pieces[pieceIndex];
 
         switch (axis)
         {
             case SimAxis::X:
-                piece->get().offset.x = targetPosition;
-                piece->get().xMoveOperation = std::nullopt;
+                piece.offset.x = targetPosition;
+                piece.xMoveOperation = std::nullopt;
                 break;
             case SimAxis::Y:
-                piece->get().offset.y = targetPosition;
-                piece->get().yMoveOperation = std::nullopt;
+                piece.offset.y = targetPosition;
+                piece.yMoveOperation = std::nullopt;
                 break;
             case SimAxis::Z:
-                piece->get().offset.z = targetPosition;
-                piece->get().zMoveOperation = std::nullopt;
+                piece.offset.z = targetPosition;
+                piece.zMoveOperation = std::nullopt;
                 break;
         }
     }
 
     void UnitState::turnObject(const std::string& pieceName, SimAxis axis, SimAngle targetAngle, SimScalar speed)
     {
-        auto piece = findPiece(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name: " + pieceName);
-        }
+        turnObject(getPieceIndex(pieceName), axis, targetAngle, speed);
+    }
+
+    void UnitState::turnObject(int pieceIndex, SimAxis axis, SimAngle targetAngle, SimScalar speed)
+    {
+        markPieceAnimating(pieceIndex);
+        auto& piece = pieces[pieceIndex];
 
         UnitMesh::TurnOperation op(targetAngle, speed);
 
         switch (axis)
         {
             case SimAxis::X:
-                piece->get().xTurnOperation = op;
+                piece.xTurnOperation = op;
                 break;
             case SimAxis::Y:
-                piece->get().yTurnOperation = op;
+                piece.yTurnOperation = op;
                 break;
             case SimAxis::Z:
-                piece->get().zTurnOperation = op;
+                piece.zTurnOperation = op;
                 break;
         }
     }
 
     void UnitState::turnObjectNow(const std::string& pieceName, SimAxis axis, SimAngle targetAngle)
     {
-        auto piece = findPiece(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name: " + pieceName);
-        }
+        turnObjectNow(getPieceIndex(pieceName), axis, targetAngle);
+    }
+
+    void UnitState::turnObjectNow(int pieceIndex, SimAxis axis, SimAngle targetAngle)
+    {
+        markPieceAnimating(pieceIndex);
+        auto& piece = pieces[pieceIndex];
 
         switch (axis)
         {
             case SimAxis::X:
-                piece->get().rotationX = targetAngle;
-                piece->get().xTurnOperation = std::nullopt;
+                piece.rotationX = targetAngle;
+                piece.xTurnOperation = std::nullopt;
                 break;
             case SimAxis::Y:
-                piece->get().rotationY = targetAngle;
-                piece->get().yTurnOperation = std::nullopt;
+                piece.rotationY = targetAngle;
+                piece.yTurnOperation = std::nullopt;
                 break;
             case SimAxis::Z:
-                piece->get().rotationZ = targetAngle;
-                piece->get().zTurnOperation = std::nullopt;
+                piece.rotationZ = targetAngle;
+                piece.zTurnOperation = std::nullopt;
                 break;
         }
     }
 
     void UnitState::spinObject(const std::string& pieceName, SimAxis axis, SimScalar speed, SimScalar acceleration)
     {
-        auto piece = findPiece(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name: " + pieceName);
-        }
+        spinObject(getPieceIndex(pieceName), axis, speed, acceleration);
+    }
+
+    void UnitState::spinObject(int pieceIndex, SimAxis axis, SimScalar speed, SimScalar acceleration)
+    {
+        markPieceAnimating(pieceIndex);
+        auto& piece = pieces[pieceIndex];
 
         UnitMesh::SpinOperation op(acceleration == 0_ss ? speed : 0_ss, speed, acceleration);
 
         switch (axis)
         {
             case SimAxis::X:
-                piece->get().xTurnOperation = op;
+                piece.xTurnOperation = op;
                 break;
             case SimAxis::Y:
-                piece->get().yTurnOperation = op;
+                piece.yTurnOperation = op;
                 break;
             case SimAxis::Z:
-                piece->get().zTurnOperation = op;
+                piece.zTurnOperation = op;
                 break;
         }
     }
@@ -317,43 +317,44 @@ namespace rwe
 
     void UnitState::stopSpinObject(const std::string& pieceName, SimAxis axis, SimScalar deceleration)
     {
+        stopSpinObject(getPieceIndex(pieceName), axis, deceleration);
+    }
 
-        auto piece = findPiece(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name: " + pieceName);
-        }
+    void UnitState::stopSpinObject(int pieceIndex, SimAxis axis, SimScalar deceleration)
+    {
+        auto& piece = pieces[pieceIndex];
 
         switch (axis)
         {
             case SimAxis::X:
-                setStopSpinOp(piece->get().xTurnOperation, deceleration);
+                setStopSpinOp(piece.xTurnOperation, deceleration);
                 break;
             case SimAxis::Y:
-                setStopSpinOp(piece->get().yTurnOperation, deceleration);
+                setStopSpinOp(piece.yTurnOperation, deceleration);
                 break;
             case SimAxis::Z:
-                setStopSpinOp(piece->get().zTurnOperation, deceleration);
+                setStopSpinOp(piece.zTurnOperation, deceleration);
                 break;
         }
     }
 
     bool UnitState::isMoveInProgress(const std::string& pieceName, SimAxis axis) const
     {
-        auto piece = findPiece(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name " + pieceName);
-        }
+        return isMoveInProgress(getPieceIndex(pieceName), axis);
+    }
+
+    bool UnitState::isMoveInProgress(int pieceIndex, SimAxis axis) const
+    {
+        const auto& piece = pieces[pieceIndex];
 
         switch (axis)
         {
             case SimAxis::X:
-                return !!(piece->get().xMoveOperation);
+                return !!(piece.xMoveOperation);
             case SimAxis::Y:
-                return !!(piece->get().yMoveOperation);
+                return !!(piece.yMoveOperation);
             case SimAxis::Z:
-                return !!(piece->get().zMoveOperation);
+                return !!(piece.zMoveOperation);
         }
 
         throw std::logic_error("Invalid axis");
@@ -361,25 +362,55 @@ namespace rwe
 
     bool UnitState::isTurnInProgress(const std::string& pieceName, SimAxis axis) const
     {
-        auto piece = findPiece(pieceName);
-        if (!piece)
-        {
-            throw std::runtime_error("Invalid piece name " + pieceName);
-        }
+        return isTurnInProgress(getPieceIndex(pieceName), axis);
+    }
+
+    bool UnitState::isTurnInProgress(int pieceIndex, SimAxis axis) const
+    {
+        const auto& piece = pieces[pieceIndex];
 
         switch (axis)
         {
             case SimAxis::X:
-                return !!(piece->get().xTurnOperation);
+                return !!(piece.xTurnOperation);
             case SimAxis::Y:
-                return !!(piece->get().yTurnOperation);
+                return !!(piece.yTurnOperation);
             case SimAxis::Z:
-                return !!(piece->get().zTurnOperation);
+                return !!(piece.zTurnOperation);
         }
 
         throw std::logic_error("Invalid axis");
     }
 
+    void UnitState::updatePieces(SimScalar dt)
+    {
+        auto out = animatingPieces.begin();
+        for (auto pieceIndex : animatingPieces)
+        {
+            auto& piece = pieces[pieceIndex];
+            piece.update(dt);
+            if (piece.isAnimating())
+            {
+                *out++ = pieceIndex;
+            }
+            else
+            {
+                piece.inAnimatingList = false;
+            }
+        }
+        animatingPieces.erase(out, animatingPieces.end());
+    }
+
+    void UnitState::markPieceAnimating(int pieceIndex)
+    {
+        auto& piece = pieces[pieceIndex];
+        if (!piece.inAnimatingList)
+        {
+            piece.inAnimatingList = true;
+            animatingPieces.push_back(pieceIndex);
+        }
+    }
+
     bool UnitState::isOwnedBy(PlayerId playerId) const
     {
         return owner == playerId;
@@ -653,10 +684,37 @@ namespace rwe
         return std::nullopt;
     }
 
+    int UnitState::getPieceIndex(const std::string& pieceName) const
+    {
+        auto pieceIndexIt = modelDefinition->pieceIndicesByName.find(toUpper(pieceName));
+        if (pieceIndexIt == modelDefinition->pieceIndicesByName.end())
+        {
+            throw std::runtime_error("Invalid piece name: " + pieceName);
+        }
+
+        return pieceIndexIt->second;
+    }
+
+    std::optional<int> UnitState::findCobPiece(unsigned int cobPieceIndex) const
+    {
+        return cobPieceIndices->at(cobPieceIndex);
+    }
+
+    int UnitState::getCobPiece(unsigned int cobPieceIndex) const
+    {
+        auto pieceIndex = findCobPiece(cobPieceIndex);
+        if (!pieceIndex)
+        {
+            throw std::runtime_error("Invalid piece name: " + cobEnvironment->_script->pieces.at(cobPieceIndex));
+        }
+
+        return *pieceIndex;
+    }
+
     std::optional<std::reference_wrapper<const UnitMesh>> UnitState::findPiece(const std::string& pieceName) const
     {
-        auto pieceIndexIt = pieceNameToIndices.find(toUpper(pieceName));
-        if (pieceIndexIt == pieceNameToIndices.end())
+        auto pieceIndexIt = modelDefinition->pieceIndicesByName.find(toUpper(pieceName));
+        if (pieceIndexIt == modelDefinition->pieceIndicesByName.end())
         {
             return std::nullopt;
         }
@@ -666,8 +724,8 @@ namespace rwe
 
     std::optional<std::reference_wrapper<UnitMesh>> UnitState::findPiece(const std::string& pieceName)
     {
-        auto pieceIndexIt = pieceNameToIndices.find(toUpper(pieceName));
-        if (pieceIndexIt == pieceNameToIndices.end())
+        auto pieceIndexIt = modelDefinition->pieceIndicesByName.find(toUpper(pieceName));
+        if (pieceIndexIt == modelDefinition->pieceIndicesByName.end())
         {
             return std::nullopt;
         }
@@ -16,8 +16,10 @@
 #include <rwe/sim/SimScalar.h>
 #include <rwe/sim/SimVector.h>
 #include <rwe/sim/UnitDefinition.h>
+#include <rwe/sim/UnitDefinitionId.h>
 #include <rwe/sim/UnitFireOrders.h>
 #include <rwe/sim/UnitMesh.h>
+#include <rwe/sim/UnitModelDefinition.h>
 #include <rwe/sim/UnitOrder.h>
 #include <rwe/sim/UnitWeapon.h>
 #include <variant>
@@ -35,6 +37,15 @@ namespace rwe
 
     struct NavigationGoalLandingLocation
     {
+        bool operator==(const NavigationGoalLandingLocation&) const
+        {
+            return true;
+        }
+
+        bool operator!=(const NavigationGoalLandingLocation&) const
+        {
+            return false;
+        }
     };
 
     using NavigationGoal = std::variant<UnitId, SimVector, DiscreteRect, NavigationGoalLandingLocation>;
@@ -63,7 +74,7 @@ namespace rwe
     using UnitCreationStatus = std::variant<UnitCreationStatusPending, UnitCreationStatusFailed, UnitCreationStatusDone>;
     struct UnitBehaviorStateCreatingUnit
     {
-        std::string unitType;
+        UnitDefinitionId unitType;
         PlayerId owner;
         SimVector position;
         UnitCreationStatus status{UnitCreationStatusPending()};
@@ -215,12 +226,28 @@ namespace rwe
         using LifeState = std::variant<LifeStateAlive, LifeStateDead>;
 
     public:
-        std::string unitType;
+        UnitDefinitionId unitType;
         std::vector<UnitMesh> pieces;
-        std::unordered_map<std::string, int> pieceNameToIndices;
+        /**
+         * The model the unit's pieces belong to.
+         * Piece names and the piece hierarchy live here rather than in pieces,
+         * and are shared by all units with the same model.
+         */
+        const UnitModelDefinition* modelDefinition;
+        /**
+         * Indices of the pieces that may be animating.
+         * Every piece for which isAnimating() is true is in here,
+         * so updatePieces can skip the rest.
+         */
+        std::vector<int> animatingPieces;
         SimVector position;
         SimVector previousPosition;
         std::unique_ptr<CobEnvironment> cobEnvironment;
+        /**
+         * Maps each piece in the unit's COB script to its index in pieces.
+         * Shared by all units of the same type.
+         */
+        const std::vector<std::optional<int>>* cobPieceIndices;
         PlayerId owner;
 
         /**
@@ -281,7 +308,7 @@ namespace rwe
 
         static SimVector toDirection(SimAngle rotation);
 
-        UnitState(const std::vector<UnitMesh>& pieces, std::unique_ptr<CobEnvironment>&& cobEnvironment);
+        UnitState(const UnitModelDefinition* modelDefinition, std::unique_ptr<CobEnvironment>&& cobEnvironment, const std::vector<std::optional<int>>* cobPieceIndices);
 
         bool isBeingBuilt(const UnitDefinition& unitDefinition) const;
 
@@ -302,20 +329,39 @@ namespace rwe
 
         void moveObject(const std::string& pieceName, SimAxis axis, SimScalar targetPosition, SimScalar speed);
 
+        void moveObject(int pieceIndex, SimAxis axis, SimScalar targetPosition, SimScalar speed);
+
         void moveObjectNow(const std::string& pieceName, SimAxis axis, SimScalar targetPosition);
 
+        void moveObjectNow(int pieceIndex, SimAxis axis, SimScalar targetPosition);
+
         void turnObject(const std::string& pieceName, SimAxis axis, SimAngle targetAngle, SimScalar speed);
 
+        void turnObject(int pieceIndex, SimAxis axis, SimAngle targetAngle, SimScalar speed);
+
         void turnObjectNow(const std::string& pieceName, SimAxis axis, SimAngle targetAngle);
 
+        void turnObjectNow(int pieceIndex, SimAxis axis, SimAngle targetAngle);
+
         void spinObject(const std::string& pieceName, SimAxis axis, SimScalar speed, SimScalar acceleration);
 
+        void spinObject(int pieceIndex, SimAxis axis, SimScalar speed, SimScalar acceleration);
+
         void stopSpinObject(const std::string& pieceName, SimAxis axis, SimScalar deceleration);
 
+        void stopSpinObject(int pieceIndex, SimAxis axis, SimScalar deceleration);
+
         bool isMoveInProgress(const std::string& pieceName, SimAxis axis) const;
 
+        bool isMoveInProgress(int pieceIndex, SimAxis axis) const;
+
         bool isTurnInProgress(const std::string& pieceName, SimAxis axis) const;
 
+        bool isTurnInProgress(int pieceIndex, SimAxis axis) const;
+
+        /** Advances the animation of every piece that is moving, turning or spinning. */
+        void updatePieces(SimScalar dt);
+
         bool isOwnedBy(PlayerId playerId) const;
 
         bool isAlive() const;
@@ -364,8 +410,21 @@ namespace rwe
 
         std::optional<std::pair<UnitId, SimVector>> getActiveNanolatheTarget() const;
 
+        /** Returns the index of the named piece in pieces, or throws if there is no such piece. */
+        int getPieceIndex(const std::string& pieceName) const;
+
+        /** Returns the index in pieces of the given COB script piece, if the unit has it. */
+        std::optional<int> findCobPiece(unsigned int cobPieceIndex) const;
+
+        /** Returns the index in pieces of the given COB script piece, or throws if the unit does not have it. */
+        int getCobPiece(unsigned int cobPieceIndex) const;
+
         std::optional<std::reference_wrapper<const UnitMesh>> findPiece(const std::string& pieceName) const;
 
         std::optional<std::reference_wrapper<UnitMesh>> findPiece(const std::string& pieceName);
+
+    private:
+        /** Must be called before any change to the piece's offset, rotation or operations. */
+        void markPieceAnimating(int pieceIndex);
     };
 }
@@ -0,0 +1,84 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/sim/UnitState.h>
+
+namespace rwe
+{
+    bool unitMeshesEqual(const UnitMesh& a, const UnitMesh& b)
+    {
+        return a.offset == b.offset
+            && a.previousOffset == b.previousOffset
+            && a.rotationX == b.rotationX
+            && a.rotationY == b.rotationY
+            && a.rotationZ == b.rotationZ
+            && a.previousRotationX == b.previousRotationX
+            && a.previousRotationY == b.previousRotationY
+            && a.previousRotationZ == b.previousRotationZ
+            && a.isAnimating() == b.isAnimating();
+    }
+
+    TEST_CASE("UnitState::updatePieces")
+    {
+        std::vector<UnitPieceDefinition> pieceDefinitions{
+            UnitPieceDefinition{"base", SimVector(0_ss, 0_ss, 0_ss), std::nullopt},
+            UnitPieceDefinition{"turret", SimVector(0_ss, 0_ss, 0_ss), std::string("base")},
+            UnitPieceDefinition{"barrel", SimVector(0_ss, 0_ss, 0_ss), std::string("turret")}};
+        auto modelDefinition = createUnitModelDefinition(10_ss, std::move(pieceDefinitions));
+        std::vector<std::optional<int>> cobPieceIndices;
+
+        SECTION("matches updating every piece")
+        {
+            UnitState unit(&modelDefinition, nullptr, &cobPieceIndices);
+            auto reference = unit.pieces;
+            auto dt = 1_ss / 30_ss;
+
+            auto step = [&]() {
+                unit.updatePieces(dt);
+                for (auto& piece : reference)
+                {
+                    piece.update(dt);
+                }
+                for (std::size_t i = 0; i < reference.size(); ++i)
+                {
+                    REQUIRE(unitMeshesEqual(unit.pieces[i], reference[i]));
+                }
+            };
+
+            unit.moveObject(1, SimAxis::X, 5_ss, 30_ss);
+            reference[1].xMoveOperation = UnitMesh::MoveOperation(5_ss, 30_ss);
+            for (int i = 0; i < 10; ++i)
+            {
+                step();
+            }
+
+            unit.turnObjectNow(2, SimAxis::Y, SimAngle(1000));
+            reference[2].rotationY = SimAngle(1000);
+            step();
+            step();
+
+            unit.spinObject(0, SimAxis::Z, 10_ss, 1_ss);
+            reference[0].zTurnOperation = UnitMesh::SpinOperation(0_ss, 10_ss, 1_ss);
+            for (int i = 0; i < 5; ++i)
+            {
+                step();
+            }
+        }
+
+        SECTION("drops pieces once they come to rest")
+        {
+            UnitState unit(&modelDefinition, nullptr, &cobPieceIndices);
+            REQUIRE(unit.animatingPieces.empty());
+
+            unit.moveObject(1, SimAxis::Y, 1_ss, 30_ss);
+            unit.moveObject(1, SimAxis::Z, 1_ss, 30_ss);
+            REQUIRE(unit.animatingPieces == std::vector<int>{1});
+
+            // reaches the target, then settles on the next update
+            unit.updatePieces(1_ss);
+            REQUIRE(unit.animatingPieces == std::vector<int>{1});
+            unit.updatePieces(1_ss);
+            REQUIRE(unit.animatingPieces.empty());
+            REQUIRE(unit.pieces[1].offset.y == 1_ss);
+            REQUIRE(unit.pieces[1].offset.z == 1_ss);
+        }
+    }
+}
@@ -5,6 +5,7 @@
 #include <rwe/sim/ProjectilePhysicsType.h>
 #include <rwe/sim/UnitId.h>
 #include <rwe/sim/WeaponDefinition.h>
+#include <rwe/sim/WeaponDefinitionId.h>
 #include <variant>
 
 namespace rwe
@@ -59,7 +60,7 @@ namespace rwe
 
     struct UnitWeapon
     {
-        std::string weaponType;
+        WeaponDefinitionId weaponType;
 
         /** The game time at which the weapon next becomes ready to fire. */
         GameTime readyTime{0};
@@ -1,5 +1,38 @@
 #include "WeaponDefinition.h"
+#include <stdexcept>
 
 namespace rwe
 {
+    std::optional<unsigned int> WeaponDefinition::tryGetDamage(const std::string& unitType) const
+    {
+        auto it = damage.find(unitType);
+        if (it != damage.end())
+        {
+            return it->second;
+        }
+
+        it = damage.find("DEFAULT");
+        if (it != damage.end())
+        {
+            return it->second;
+        }
+
+        return std::nullopt;
+    }
+
+    unsigned int WeaponDefinition::getDamage(UnitDefinitionId unitType) const
+    {
+        if (unitType.value >= damageByUnitType.size())
+        {
+            throw std::logic_error("Damage table for weapon " + weaponType + " has not been resolved for unit type " + std::to_string(unitType.value));
+        }
+
+        const auto& entry = damageByUnitType[unitType.value];
+        if (!entry)
+        {
+            throw std::runtime_error("Failed to find damage entry for weapon " + weaponType);
+        }
+
+        return *entry;
+    }
 }
@@ -5,12 +5,18 @@
 #include <rwe/sim/ProjectilePhysicsType.h>
 #include <rwe/sim/SimAngle.h>
 #include <rwe/sim/SimScalar.h>
+#include <rwe/sim/UnitDefinitionId.h>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace rwe
 {
     struct WeaponDefinition
     {
+        /** The upper-case name the weapon type is known by. */
+        std::string weaponType;
+
         ProjectilePhysicsType physicsType;
 
         SimScalar maxRange;
@@ -38,6 +44,12 @@ namespace rwe
 
         std::unordered_map<std::string, unsigned int> damage;
 
+        /**
+         * The damage table resolved against the loaded unit types, indexed by UnitDefinitionId.
+         * Empty entries are unit types the table has no damage for.
+         */
+        std::vector<std::optional<unsigned int>> damageByUnitType;
+
         SimScalar damageRadius;
 
         /** Number of ticks projectiles fired from this weapon live for */
@@ -48,5 +60,17 @@ namespace rwe
 
         /** If true, projectile does not explode when hitting the ground but instead continues travelling. */
         bool groundBounce;
+
+        /**
+         * Looks up the damage the weapon deals to the given unit type in the damage table,
+         * falling back to the weapon's default damage.
+         */
+        std::optional<unsigned int> tryGetDamage(const std::string& unitType) const;
+
+        /**
+         * Returns the damage the weapon deals to the given unit type from the resolved table,
+         * or throws if the table has no damage for it.
+         */
+        unsigned int getDamage(UnitDefinitionId unitType) const;
     };
 }
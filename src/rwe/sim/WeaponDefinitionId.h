@@ -0,0 +1,9 @@
+#pragma once
+
+#include <rwe/util/OpaqueId.h>
+
+namespace rwe
+{
+    struct WeaponDefinitionIdTag;
+    using WeaponDefinitionId = OpaqueId<unsigned int, WeaponDefinitionIdTag>;
+}
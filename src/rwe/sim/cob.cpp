@@ -138,7 +138,7 @@ namespace rwe
 
     void handlePieceCommand(GameSimulation& simulation, const CobEnvironment& env, UnitId unitId, const CobEnvironment::PieceCommandStatus& result)
     {
-        const auto& objectName = getObjectName(env, result.piece);
+        const auto& unit = simulation.getUnitState(unitId);
         match(
             result.command,
             [&](const CobEnvironment::PieceCommandStatus::Move& m) {
@@ -146,11 +146,11 @@ namespace rwe
                 auto position = m.axis == CobAxis::X ? -m.position : m.position;
                 if (m.speed)
                 {
-                    simulation.moveObject(unitId, objectName, toSimAxis(m.axis), cobPositionToSimScalar(position), toSimScalar(*m.speed));
+                    simulation.moveObject(unitId, unit.getCobPiece(result.piece), toSimAxis(m.axis), cobPositionToSimScalar(position), toSimScalar(*m.speed));
                 }
                 else
                 {
-                    simulation.moveObjectNow(unitId, objectName, toSimAxis(m.axis), cobPositionToSimScalar(position));
+                    simulation.moveObjectNow(unitId, unit.getCobPiece(result.piece), toSimAxis(m.axis), cobPositionToSimScalar(position));
                 }
             },
             [&](const CobEnvironment::PieceCommandStatus::Turn& t) {
@@ -158,42 +158,54 @@ namespace rwe
                 auto angle = t.axis == CobAxis::Z ? -t.angle : t.angle;
                 if (t.speed)
                 {
-                    simulation.turnObject(unitId, objectName, toSimAxis(t.axis), toWorldAngle(angle), toSimScalar(*t.speed));
+                    simulation.turnObject(unitId, unit.getCobPiece(result.piece), toSimAxis(t.axis), toWorldAngle(angle), toSimScalar(*t.speed));
                 }
                 else
                 {
-                    simulation.turnObjectNow(unitId, objectName, toSimAxis(t.axis), toWorldAngle(angle));
+                    simulation.turnObjectNow(unitId, unit.getCobPiece(result.piece), toSimAxis(t.axis), toWorldAngle(angle));
                 }
             },
             [&](const CobEnvironment::PieceCommandStatus::Spin& s) {
-                simulation.spinObject(unitId, objectName, toSimAxis(s.axis), toSimScalar(s.targetSpeed), toSimScalar(s.acceleration));
+                simulation.spinObject(unitId, unit.getCobPiece(result.piece), toSimAxis(s.axis), toSimScalar(s.targetSpeed), toSimScalar(s.acceleration));
             },
             [&](const CobEnvironment::PieceCommandStatus::StopSpin& s) {
-                simulation.stopSpinObject(unitId, objectName, toSimAxis(s.axis), toSimScalar(s.deceleration));
+                simulation.stopSpinObject(unitId, unit.getCobPiece(result.piece), toSimAxis(s.axis), toSimScalar(s.deceleration));
             },
             [&](const CobEnvironment::PieceCommandStatus::Show&) {
-                simulation.showObject(unitId, objectName);
+                if (auto pieceIndex = unit.findCobPiece(result.piece))
+                {
+                    simulation.showObject(unitId, *pieceIndex);
+                }
             },
             [&](const CobEnvironment::PieceCommandStatus::Hide&) {
-                simulation.hideObject(unitId, objectName);
+                if (auto pieceIndex = unit.findCobPiece(result.piece))
+                {
+                    simulation.hideObject(unitId, *pieceIndex);
+                }
             },
             [&](const CobEnvironment::PieceCommandStatus::EnableShading&) {
-                simulation.enableShading(unitId, objectName);
+                if (auto pieceIndex = unit.findCobPiece(result.piece))
+                {
+                    simulation.enableShading(unitId, *pieceIndex);
+                }
             },
             [&](const CobEnvironment::PieceCommandStatus::DisableShading&) {
-                simulation.disableShading(unitId, objectName);
+                if (auto pieceIndex = unit.findCobPiece(result.piece))
+                {
+                    simulation.disableShading(unitId, *pieceIndex);
+                }
             },
             [&](const CobEnvironment::PieceCommandStatus::EmitSfx& s) {
                 switch (s.sfxType)
                 {
                     case CobSfxType::WhiteSmoke:
-                        simulation.events.push_back(EmitParticleFromPieceEvent{EmitParticleFromPieceEvent::SfxType::LightSmoke, unitId, objectName});
+                        simulation.events.push_back(EmitParticleFromPieceEvent{EmitParticleFromPieceEvent::SfxType::LightSmoke, unitId, getObjectName(env, result.piece)});
                         break;
                     case CobSfxType::BlackSmoke:
-                        simulation.events.push_back(EmitParticleFromPieceEvent{EmitParticleFromPieceEvent::SfxType::BlackSmoke, unitId, objectName});
+                        simulation.events.push_back(EmitParticleFromPieceEvent{EmitParticleFromPieceEvent::SfxType::BlackSmoke, unitId, getObjectName(env, result.piece)});
                         break;
                     case CobSfxType::Wake1:
-                        simulation.events.push_back(EmitParticleFromPieceEvent{EmitParticleFromPieceEvent::SfxType::Wake1, unitId, objectName});
+                        simulation.events.push_back(EmitParticleFromPieceEvent{EmitParticleFromPieceEvent::SfxType::Wake1, unitId, getObjectName(env, result.piece)});
                         break;
                     case CobSfxType::Vtol:
                     case CobSfxType::Thrust:
@@ -206,7 +218,7 @@ namespace rwe
             });
     }
 
-    int handleQuery(GameSimulation& sim, const CobEnvironment& env, UnitId unitId, const CobEnvironment::QueryStatus& result)
+    int handleQuery(GameSimulation& sim, UnitId unitId, const CobEnvironment::QueryStatus& result)
     {
         return match(
             result.query,
@@ -228,7 +240,7 @@ namespace rwe
             },
             [&](const CobEnvironment::QueryStatus::Health&) {
                 const auto& unit = sim.getUnitState(unitId);
-                const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
+                const auto& unitDefinition = sim.unitDefinitions.get(unit.unitType);
                 return static_cast<int>((unit.hitPoints * 100) / unitDefinition.maxHitPoints);
             },
             [&](const CobEnvironment::QueryStatus::InBuildStance&) {
@@ -239,15 +251,13 @@ namespace rwe
                 return 0;
             },
             [&](const CobEnvironment::QueryStatus::PieceXZ& q) {
-                auto pieceId = q.piece;
-                const auto& pieceName = getObjectName(env, pieceId);
-                auto pos = sim.getUnitPiecePosition(unitId, pieceName);
+                auto pieceIndex = sim.getUnitState(unitId).getCobPiece(q.piece);
+                auto pos = sim.getUnitPiecePosition(unitId, pieceIndex);
                 return packCoords(pos.x, pos.z);
             },
             [&](const CobEnvironment::QueryStatus::PieceY& q) {
-                auto pieceId = q.piece;
-                const auto& pieceName = getObjectName(env, pieceId);
-                auto pos = sim.getUnitPiecePosition(unitId, pieceName);
+                auto pieceIndex = sim.getUnitState(unitId).getCobPiece(q.piece);
+                auto pos = sim.getUnitPiecePosition(unitId, pieceIndex);
                 return simScalarToCobPosition(pos.y).value;
             },
             [&](const CobEnvironment::QueryStatus::UnitXZ& q) {
@@ -280,8 +290,7 @@ namespace rwe
                     // FIXME: not sure if correct return value when unit does not exist
                     return 0;
                 }
-                const auto& unitDefinition = sim.unitDefinitions.at(targetUnitOption->get().unitType);
-                const auto& modelDefinition = sim.unitModelDefinitions.at(unitDefinition.objectName);
+                const auto& modelDefinition = *targetUnitOption->get().modelDefinition;
                 return simScalarToCobPosition(modelDefinition.height).value;
             },
             [&](const CobEnvironment::QueryStatus::XZAtan& q) {
@@ -305,7 +314,7 @@ namespace rwe
             },
             [&](const CobEnvironment::QueryStatus::BuildPercentLeft&) {
                 const auto& unit = sim.getUnitState(unitId);
-                const auto& unitDefinition = sim.unitDefinitions.at(unit.unitType);
+                const auto& unitDefinition = sim.unitDefinitions.get(unit.unitType);
                 return static_cast<int>(unit.getBuildPercentLeft(unitDefinition));
             },
             [&](const CobEnvironment::QueryStatus::YardOpen&) {
@@ -348,7 +357,7 @@ namespace rwe
                     // FIXME: unsure if correct return value when unit does not exist
                     return 0;
                 }
-                const auto& unitDefinition = sim.unitDefinitions.at(targetUnitOption->get().unitType);
+                const auto& unitDefinition = sim.unitDefinitions.get(targetUnitOption->get().unitType);
                 return static_cast<int>(targetUnitOption->get().getBuildPercentLeft(unitDefinition));
             },
             [&](const CobEnvironment::QueryStatus::UnitAllied& q) {
@@ -426,13 +435,11 @@ namespace rwe
 
             auto isUnblocked = match(
                 status.condition,
-                [&env, &simulation, unitId](const CobEnvironment::BlockedStatus::Move& condition) {
-                    const auto& pieceName = env._script->pieces.at(condition.object);
-                    return !simulation.isPieceMoving(unitId, pieceName, toSimAxis(condition.axis));
+                [&unit, &simulation, unitId](const CobEnvironment::BlockedStatus::Move& condition) {
+                    return !simulation.isPieceMoving(unitId, unit.getCobPiece(condition.object), toSimAxis(condition.axis));
                 },
-                [&env, &simulation, unitId](const CobEnvironment::BlockedStatus::Turn& condition) {
-                    const auto& pieceName = env._script->pieces.at(condition.object);
-                    return !simulation.isPieceTurning(unitId, pieceName, toSimAxis(condition.axis));
+                [&unit, &simulation, unitId](const CobEnvironment::BlockedStatus::Turn& condition) {
+                    return !simulation.isPieceTurning(unitId, unit.getCobPiece(condition.object), toSimAxis(condition.axis));
                 });
 
             if (isUnblocked)
@@ -474,7 +481,7 @@ namespace rwe
                     handlePieceCommand(simulation, env, unitId, s);
                 },
                 [&](const CobEnvironment::QueryStatus& s) {
-                    auto result = handleQuery(simulation, env, unitId, s);
+                    auto result = handleQuery(simulation, unitId, s);
                     env.pushResult(result);
                 },
                 [&](const CobEnvironment::SetQueryStatus& s) {
@@ -4,30 +4,32 @@
 namespace rwe
 {
     Matrix4x<SimScalar> getPieceTransform(const std::string& pieceName, const UnitModelDefinition& modelDefinition, const std::vector<UnitMesh>& pieces)
+    {
+        auto pieceIndexIt = modelDefinition.pieceIndicesByName.find(toUpper(pieceName));
+        if (pieceIndexIt == modelDefinition.pieceIndicesByName.end())
+        {
+            throw std::runtime_error("missing piece definition: " + pieceName);
+        }
+
+        return getPieceTransform(pieceIndexIt->second, modelDefinition, pieces);
+    }
+
+    Matrix4x<SimScalar> getPieceTransform(int pieceIndex, const UnitModelDefinition& modelDefinition, const std::vector<UnitMesh>& pieces)
     {
         assert(modelDefinition.pieces.size() == pieces.size());
 
-        std::optional<std::string> parentPiece = pieceName;
+        std::optional<int> currentIndex = pieceIndex;
         auto matrix = Matrix4x<SimScalar>::identity();
 
         do
         {
-            auto pieceIndexIt = modelDefinition.pieceIndicesByName.find(toUpper(*parentPiece));
-            if (pieceIndexIt == modelDefinition.pieceIndicesByName.end())
-            {
-                throw std::runtime_error("missing piece definition: " + *parentPiece);
-            }
+            const auto& pieceDef = modelDefinition.pieces.at(*currentIndex);
+            const auto& pieceState = pieces[*currentIndex];
 
-            const auto& pieceDef = modelDefinition.pieces.at(pieceIndexIt->second);
-
-            parentPiece = pieceDef.parent;
-
-            auto pieceStateIt = pieces.begin() + pieceIndexIt->second;
-
-            auto position = pieceDef.origin + pieceStateIt->offset;
-            auto rotationX = pieceStateIt->rotationX;
-            auto rotationY = pieceStateIt->rotationY;
-            auto rotationZ = pieceStateIt->rotationZ;
+            auto position = pieceDef.origin + pieceState.offset;
+            auto rotationX = pieceState.rotationX;
+            auto rotationY = pieceState.rotationY;
+            auto rotationZ = pieceState.rotationZ;
             matrix = Matrix4x<SimScalar>::translation(position)
                 * Matrix4x<SimScalar>::rotationZXY(
                     sin(rotationX),
@@ -37,7 +39,13 @@ namespace rwe
                     sin(rotationZ),
                     cos(rotationZ))
                 * matrix;
-        } while (parentPiece);
+
+            currentIndex = modelDefinition.pieceParentIndices[*currentIndex];
+            if (!currentIndex && pieceDef.parent)
+            {
+                throw std::runtime_error("missing piece definition: " + *pieceDef.parent);
+            }
+        } while (currentIndex);
 
         return matrix;
     }
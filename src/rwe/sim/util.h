@@ -8,4 +8,10 @@
 namespace rwe
 {
     Matrix4x<SimScalar> getPieceTransform(const std::string& pieceName, const UnitModelDefinition& modelDefinition, const std::vector<UnitMesh>& pieces);
+
+    /**
+     * Returns the transform of the piece at the given index in the model,
+     * relative to the unit, without looking up any piece names.
+     */
+    Matrix4x<SimScalar> getPieceTransform(int pieceIndex, const UnitModelDefinition& modelDefinition, const std::vector<UnitMesh>& pieces);
 }
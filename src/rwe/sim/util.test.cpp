@@ -16,7 +16,7 @@ namespace rwe
         {
             std::vector<UnitPieceDefinition> pieceDefs{UnitPieceDefinition{"foo", SimVector(0_ss, 0_ss, 0_ss)}};
             auto modelDef = createUnitModelDefinition(0_ss, std::move(pieceDefs));
-            std::vector<UnitMesh> pieces{UnitMesh{"foo"}};
+            std::vector<UnitMesh> pieces{UnitMesh()};
             REQUIRE(getPieceTransform("foo", modelDef, pieces) == Matrix4x<SimScalar>::identity());
         }
 
@@ -24,7 +24,7 @@ namespace rwe
         {
             std::vector<UnitPieceDefinition> pieceDefs{UnitPieceDefinition{"foo", SimVector(1_ss, 2_ss, 3_ss)}};
             auto modelDef = createUnitModelDefinition(0_ss, std::move(pieceDefs));
-            std::vector<UnitMesh> pieces{UnitMesh{"foo"}};
+            std::vector<UnitMesh> pieces{UnitMesh()};
             auto expected = Matrix4x<SimScalar>::translation(SimVector(1_ss, 2_ss, 3_ss));
             REQUIRE(getPieceTransform("foo", modelDef, pieces) == expected);
         }
@@ -33,7 +33,7 @@ namespace rwe
         {
             std::vector<UnitPieceDefinition> pieceDefs{UnitPieceDefinition{"foo", SimVector(1_ss, 2_ss, 3_ss)}};
             auto modelDef = createUnitModelDefinition(0_ss, std::move(pieceDefs));
-            std::vector<UnitMesh> pieces{UnitMesh{"foo"}};
+            std::vector<UnitMesh> pieces{UnitMesh()};
             pieces[0].offset = SimVector(10_ss, 20_ss, 30_ss);
             auto expected = Matrix4x<SimScalar>::translation(SimVector(11_ss, 22_ss, 33_ss));
             REQUIRE(getPieceTransform("foo", modelDef, pieces) == expected);
@@ -46,7 +46,7 @@ namespace rwe
                 UnitPieceDefinition{"bar", SimVector(2_ss, 3_ss, 4_ss), "foo"},
             };
             auto modelDef = createUnitModelDefinition(0_ss, std::move(pieceDefs));
-            std::vector<UnitMesh> pieces{UnitMesh{"foo"}, UnitMesh{"bar"}};
+            std::vector<UnitMesh> pieces{UnitMesh(), UnitMesh()};
             pieces[0].offset = SimVector(10_ss, 20_ss, 30_ss);
             pieces[1].offset = SimVector(100_ss, 200_ss, 300_ss);
 
@@ -64,7 +64,7 @@ namespace rwe
                 UnitPieceDefinition{"bar", SimVector(10_ss, 20_ss, 30_ss), "foo"},
             };
             auto modelDef = createUnitModelDefinition(0_ss, std::move(pieceDefs));
-            std::vector<UnitMesh> pieces{UnitMesh{"foo"}, UnitMesh{"bar"}};
+            std::vector<UnitMesh> pieces{UnitMesh(), UnitMesh()};
             pieces[0].rotationY = QuarterTurn;
 
             auto fooExpectedPosition = SimVector(1_ss, 2_ss, 3_ss);
@@ -78,5 +78,42 @@ namespace rwe
             REQUIRE(barActualPosition.y.value == Catch::Approx(barExpectedPosition.y.value));
             REQUIRE(barActualPosition.z.value == Catch::Approx(barExpectedPosition.z.value));
         }
+
+        SECTION("gives the same result by index as by name")
+        {
+            std::vector<UnitPieceDefinition> pieceDefs{
+                UnitPieceDefinition{"foo", SimVector(1_ss, 2_ss, 3_ss)},
+                UnitPieceDefinition{"bar", SimVector(10_ss, 20_ss, 30_ss), "FOO"},
+                UnitPieceDefinition{"baz", SimVector(5_ss, 5_ss, 5_ss), "bar"},
+            };
+            auto modelDef = createUnitModelDefinition(0_ss, std::move(pieceDefs));
+            std::vector<UnitMesh> pieces{UnitMesh(), UnitMesh(), UnitMesh()};
+            pieces[0].rotationY = QuarterTurn;
+            pieces[1].offset = SimVector(1_ss, 0_ss, 0_ss);
+
+            REQUIRE(getPieceTransform(0, modelDef, pieces) == getPieceTransform("foo", modelDef, pieces));
+            REQUIRE(getPieceTransform(1, modelDef, pieces) == getPieceTransform("bar", modelDef, pieces));
+            REQUIRE(getPieceTransform(2, modelDef, pieces) == getPieceTransform("baz", modelDef, pieces));
+        }
+
+        SECTION("throws when a parent piece is missing")
+        {
+            std::vector<UnitPieceDefinition> pieceDefs{UnitPieceDefinition{"foo", SimVector(0_ss, 0_ss, 0_ss), "nope"}};
+            auto modelDef = createUnitModelDefinition(0_ss, std::move(pieceDefs));
+            std::vector<UnitMesh> pieces{UnitMesh()};
+            REQUIRE_THROWS_AS(getPieceTransform(0, modelDef, pieces), std::runtime_error);
+        }
+    }
+
+    TEST_CASE("createCobPieceIndexMap")
+    {
+        std::vector<UnitPieceDefinition> pieceDefs{
+            UnitPieceDefinition{"Base", SimVector(0_ss, 0_ss, 0_ss)},
+            UnitPieceDefinition{"Turret", SimVector(0_ss, 0_ss, 0_ss), "Base"},
+        };
+        auto modelDef = createUnitModelDefinition(0_ss, std::move(pieceDefs));
+
+        auto map = createCobPieceIndexMap({"turret", "flare", "BASE"}, modelDef);
+        REQUIRE(map == std::vector<std::optional<int>>{1, std::nullopt, 0});
     }
 }
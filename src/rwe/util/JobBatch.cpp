@@ -0,0 +1,21 @@
+#include "JobBatch.h"
+
+namespace rwe
+{
+    void JobBatch::add(std::function<void()> job)
+    {
+        jobs.push_back(std::move(job));
+    }
+
+    std::size_t JobBatch::size() const
+    {
+        return jobs.size();
+    }
+
+    void JobBatch::run(ThreadPool& threadPool)
+    {
+        auto batchJobs = std::move(jobs);
+        jobs.clear();
+        threadPool.parallelFor(batchJobs.size(), [&](std::size_t i, unsigned int) { batchJobs[i](); });
+    }
+}
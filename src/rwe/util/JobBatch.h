@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <rwe/util/ThreadPool.h>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * A set of independent jobs to run together on a thread pool.
+     *
+     * Work with dependencies is run as a sequence of batches,
+     * each using only what the batches before it produced.
+     * For a result that does not depend on the number of threads,
+     * each job should write only to its own output slot
+     * and the slots should be combined in order once the batch has run.
+     */
+    class JobBatch
+    {
+    private:
+        std::vector<std::function<void()>> jobs;
+
+    public:
+        void add(std::function<void()> job);
+
+        std::size_t size() const;
+
+        /**
+         * Runs every job and waits for them all to finish, then empties the batch.
+         * If a job throws, the first exception is rethrown.
+         */
+        void run(ThreadPool& threadPool);
+    };
+}
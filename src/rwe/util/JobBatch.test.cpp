@@ -0,0 +1,41 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/util/JobBatch.h>
+#include <stdexcept>
+#include <vector>
+
+namespace rwe
+{
+    TEST_CASE("JobBatch")
+    {
+        SECTION("runs every job once and empties the batch")
+        {
+            ThreadPool pool(4);
+            std::vector<int> results(100);
+
+            JobBatch batch;
+            for (std::size_t i = 0; i < results.size(); ++i)
+            {
+                batch.add([&results, i]() { results[i] += static_cast<int>(i); });
+            }
+            REQUIRE(batch.size() == 100);
+
+            batch.run(pool);
+            REQUIRE(batch.size() == 0);
+            batch.run(pool);
+
+            for (std::size_t i = 0; i < results.size(); ++i)
+            {
+                REQUIRE(results[i] == static_cast<int>(i));
+            }
+        }
+
+        SECTION("rethrows an exception from a job")
+        {
+            ThreadPool pool(2);
+            JobBatch batch;
+            batch.add([]() {});
+            batch.add([]() { throw std::runtime_error("failed"); });
+            REQUIRE_THROWS_AS(batch.run(pool), std::runtime_error);
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#include "MappedFile.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace rwe
+{
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string& path)
+    {
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE)
+        {
+            fileHandle = nullptr;
+            throw std::runtime_error("Could not open file: " + path);
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(fileHandle, &size))
+        {
+            CloseHandle(fileHandle);
+            throw std::runtime_error("Could not get size of file: " + path);
+        }
+
+        _size = static_cast<std::size_t>(size.QuadPart);
+        if (_size == 0)
+        {
+            // empty files cannot be mapped
+            return;
+        }
+
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle == nullptr)
+        {
+            CloseHandle(fileHandle);
+            throw std::runtime_error("Could not map file: " + path);
+        }
+
+        _data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if (_data == nullptr)
+        {
+            CloseHandle(mappingHandle);
+            CloseHandle(fileHandle);
+            throw std::runtime_error("Could not map file: " + path);
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (_data != nullptr)
+        {
+            UnmapViewOfFile(_data);
+        }
+        if (mappingHandle != nullptr)
+        {
+            CloseHandle(mappingHandle);
+        }
+        CloseHandle(fileHandle);
+    }
+#else
+    MappedFile::MappedFile(const std::string& path)
+    {
+        auto fd = open(path.c_str(), O_RDONLY);
+        if (fd == -1)
+        {
+            throw std::runtime_error("Could not open file: " + path);
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) == -1)
+        {
+            close(fd);
+            throw std::runtime_error("Could not get size of file: " + path);
+        }
+
+        _size = static_cast<std::size_t>(st.st_size);
+        if (_size == 0)
+        {
+            // empty files cannot be mapped
+            close(fd);
+            return;
+        }
+
+        auto p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        // the mapping keeps the file open
+        close(fd);
+
+        if (p == MAP_FAILED)
+        {
+            throw std::runtime_error("Could not map file: " + path);
+        }
+
+        _data = static_cast<const char*>(p);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (_data != nullptr)
+        {
+            munmap(const_cast<char*>(_data), _size);
+        }
+    }
+#endif
+
+    const char* MappedFile::data() const
+    {
+        return _data;
+    }
+
+    std::size_t MappedFile::size() const
+    {
+        return _size;
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace rwe
+{
+    /**
+     * A read-only view of a whole file, mapped into memory.
+     * The contents can be read from any number of threads at once.
+     */
+    class MappedFile
+    {
+    private:
+        const char* _data{nullptr};
+        std::size_t _size{0};
+
+#ifdef _WIN32
+        void* fileHandle{nullptr};
+        void* mappingHandle{nullptr};
+#endif
+
+    public:
+        /** Throws std::runtime_error if the file cannot be opened or mapped. */
+        explicit MappedFile(const std::string& path);
+
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /** The contents of the file. Null if the file is empty. */
+        const char* data() const;
+
+        std::size_t size() const;
+    };
+}
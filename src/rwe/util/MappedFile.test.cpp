@@ -0,0 +1,43 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <rwe/util/MappedFile.h>
+#include <string>
+
+namespace rwe
+{
+    TEST_CASE("MappedFile")
+    {
+        auto path = std::filesystem::temp_directory_path() / "rwe_mappedfile_test.bin";
+
+        SECTION("maps the contents of a file")
+        {
+            {
+                std::ofstream out(path, std::ios::binary);
+                out << "Hello, world!";
+            }
+
+            MappedFile file(path.string());
+            REQUIRE(file.size() == 13);
+            REQUIRE(std::string(file.data(), file.size()) == "Hello, world!");
+        }
+
+        SECTION("maps an empty file")
+        {
+            {
+                std::ofstream out(path, std::ios::binary);
+            }
+
+            MappedFile file(path.string());
+            REQUIRE(file.size() == 0);
+        }
+
+        SECTION("throws if the file does not exist")
+        {
+            std::filesystem::remove(path);
+            REQUIRE_THROWS_AS(MappedFile(path.string()), std::runtime_error);
+        }
+
+        std::filesystem::remove(path);
+    }
+}
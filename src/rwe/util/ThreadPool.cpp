@@ -0,0 +1,130 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace rwe
+{
+    unsigned int ThreadPool::getDefaultThreadCount()
+    {
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    ThreadPool::ThreadPool(unsigned int threadCount)
+    {
+        for (unsigned int i = 1; i < threadCount; ++i)
+        {
+            threads.emplace_back(&ThreadPool::workerLoop, this, i);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        workAvailable.notify_all();
+
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+
+    unsigned int ThreadPool::getThreadCount() const
+    {
+        return static_cast<unsigned int>(threads.size()) + 1;
+    }
+
+    void ThreadPool::parallelFor(std::size_t count, const Task& task)
+    {
+        if (threads.empty() || count <= 1)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                task(i, 0);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            currentTask = &task;
+            taskCount = count;
+            nextIndex = 0;
+            firstException = nullptr;
+            busyWorkers = static_cast<unsigned int>(threads.size());
+            ++generation;
+        }
+        workAvailable.notify_all();
+
+        runItems(0);
+
+        std::exception_ptr exception;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workFinished.wait(lock, [&]() { return busyWorkers == 0; });
+            currentTask = nullptr;
+            exception = firstException;
+            firstException = nullptr;
+        }
+
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    void ThreadPool::workerLoop(unsigned int workerIndex)
+    {
+        unsigned int seenGeneration = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                workAvailable.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+                if (stopping)
+                {
+                    return;
+                }
+                seenGeneration = generation;
+            }
+
+            runItems(workerIndex);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                --busyWorkers;
+                if (busyWorkers == 0)
+                {
+                    workFinished.notify_one();
+                }
+            }
+        }
+    }
+
+    void ThreadPool::runItems(unsigned int workerIndex)
+    {
+        while (true)
+        {
+            auto i = nextIndex.fetch_add(1);
+            if (i >= taskCount)
+            {
+                return;
+            }
+
+            try
+            {
+                (*currentTask)(i, workerIndex);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!firstException)
+                {
+                    firstException = std::current_exception();
+                }
+                nextIndex = taskCount;
+            }
+        }
+    }
+}
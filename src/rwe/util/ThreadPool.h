@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rwe
+{
+    /**
+     * A fixed set of worker threads for running data-parallel loops.
+     *
+     * The pool decides only where work runs, never what the work is.
+     * Callers that need deterministic results should make each item's output
+     * depend only on its index, and combine the outputs in index order.
+     */
+    class ThreadPool
+    {
+    public:
+        using Task = std::function<void(std::size_t index, unsigned int workerIndex)>;
+
+    private:
+        std::vector<std::thread> threads;
+
+        std::mutex mutex;
+        std::condition_variable workAvailable;
+        std::condition_variable workFinished;
+
+        const Task* currentTask{nullptr};
+        std::size_t taskCount{0};
+        std::atomic<std::size_t> nextIndex{0};
+        unsigned int generation{0};
+        unsigned int busyWorkers{0};
+        bool stopping{false};
+        std::exception_ptr firstException;
+
+    public:
+        /** Returns the number of hardware threads, or 1 if that is unknown. */
+        static unsigned int getDefaultThreadCount();
+
+        /**
+         * Creates a pool whose loops run on the calling thread
+         * plus threadCount - 1 worker threads.
+         */
+        explicit ThreadPool(unsigned int threadCount);
+
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /** The number of threads that run loop items, including the calling thread. */
+        unsigned int getThreadCount() const;
+
+        /**
+         * Calls task(i, workerIndex) for every i in [0, count)
+         * and waits for all the calls to finish.
+         *
+         * workerIndex is less than getThreadCount() and no two calls
+         * running at the same time share one, so it can be used
+         * to index per-thread scratch space.
+         *
+         * If a call throws, no further items are started
+         * and the exception is rethrown once the running calls have finished.
+         *
+         * Must not be called from inside a task, or from two threads at once.
+         */
+        void parallelFor(std::size_t count, const Task& task);
+
+    private:
+        void workerLoop(unsigned int workerIndex);
+
+        void runItems(unsigned int workerIndex);
+    };
+}
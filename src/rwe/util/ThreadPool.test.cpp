@@ -0,0 +1,79 @@
+#include <catch2/catch_test_macros.hpp>
+#include <rwe/util/ThreadPool.h>
+#include <stdexcept>
+
+namespace rwe
+{
+    TEST_CASE("ThreadPool")
+    {
+        SECTION("runs every item exactly once")
+        {
+            ThreadPool pool(4);
+            REQUIRE(pool.getThreadCount() == 4);
+
+            std::vector<std::atomic<int>> counts(1000);
+            for (int round = 0; round < 10; ++round)
+            {
+                pool.parallelFor(counts.size(), [&](std::size_t i, unsigned int) { counts[i] += 1; });
+            }
+
+            for (const auto& c : counts)
+            {
+                REQUIRE(c == 10);
+            }
+        }
+
+        SECTION("gives each running item its own worker index")
+        {
+            ThreadPool pool(3);
+            std::vector<std::atomic<int>> running(pool.getThreadCount());
+            std::atomic<bool> clash{false};
+
+            pool.parallelFor(500, [&](std::size_t, unsigned int workerIndex) {
+                if (workerIndex >= running.size())
+                {
+                    clash = true;
+                    return;
+                }
+                if (running[workerIndex].fetch_add(1) != 0)
+                {
+                    clash = true;
+                }
+                std::this_thread::yield();
+                running[workerIndex] -= 1;
+            });
+
+            REQUIRE(!clash);
+        }
+
+        SECTION("runs inline with a single thread")
+        {
+            ThreadPool pool(1);
+            std::vector<std::size_t> order;
+            pool.parallelFor(5, [&](std::size_t i, unsigned int workerIndex) {
+                REQUIRE(workerIndex == 0);
+                order.push_back(i);
+            });
+
+            REQUIRE(order == std::vector<std::size_t>{0, 1, 2, 3, 4});
+        }
+
+        SECTION("rethrows exceptions from items")
+        {
+            ThreadPool pool(4);
+            REQUIRE_THROWS_AS(
+                pool.parallelFor(100, [](std::size_t i, unsigned int) {
+                    if (i == 37)
+                    {
+                        throw std::runtime_error("bad item");
+                    }
+                }),
+                std::runtime_error);
+
+            // the pool is still usable afterwards
+            std::atomic<int> total{0};
+            pool.parallelFor(10, [&](std::size_t, unsigned int) { total += 1; });
+            REQUIRE(total == 10);
+        }
+    }
+}
@@ -24,5 +24,18 @@ namespace rwe
     {
     public:
         virtual const std::string& getPath() const = 0;
+
+        /**
+         * Lists every file in the filesystem by its path from the root, with '/' separators.
+         * A file's position in the list identifies it to readIndexedFile
+         * until the next call to indexFiles.
+         */
+        virtual std::vector<std::string> indexFiles() = 0;
+
+        /**
+         * Reads the file at the given position in the list last returned by indexFiles.
+         * Returns empty if the file can no longer be read.
+         */
+        virtual std::optional<std::vector<char>> readIndexedFile(std::size_t index) const = 0;
     };
 }
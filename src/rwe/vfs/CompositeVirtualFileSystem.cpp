@@ -1,4 +1,6 @@
 #include "CompositeVirtualFileSystem.h"
+#include <algorithm>
+#include <cctype>
 #include <filesystem>
 #include <map>
 #include <rwe/util/rwe_string.h>
@@ -10,8 +12,43 @@ namespace fs = std::filesystem;
 
 namespace rwe
 {
+    std::string normalizeVfsPath(const std::string& path)
+    {
+        auto begin = path.find_first_not_of('/');
+        if (begin == std::string::npos)
+        {
+            return std::string();
+        }
+        auto end = path.find_last_not_of('/') + 1;
+        return toUpper(path.substr(begin, end - begin));
+    }
+
+    bool endsWithIgnoreCase(const std::string& str, const std::string& end)
+    {
+        if (end.size() > str.size())
+        {
+            return false;
+        }
+
+        return std::equal(end.begin(), end.end(), str.end() - end.size(), [](unsigned char a, unsigned char b) {
+            return std::toupper(a) == std::toupper(b);
+        });
+    }
+
     std::optional<std::vector<char>> CompositeVirtualFileSystem::readFile(const std::string& filename) const
     {
+        if (index)
+        {
+            auto it = index->filesByPath.find(normalizeVfsPath(filename));
+            if (it == index->filesByPath.end())
+            {
+                return std::nullopt;
+            }
+
+            const auto& file = index->files[it->second];
+            return filesystems[file.filesystemIndex]->readIndexedFile(file.fileIndex);
+        }
+
         for (const auto& fs : filesystems)
         {
             auto file = fs->readFile(filename);
@@ -47,6 +84,11 @@ namespace rwe
     std::vector<std::string>
     CompositeVirtualFileSystem::getFileNames(const std::string& directory, const std::string& extension)
     {
+        if (index)
+        {
+            return getIndexedFileNames(directory, extension, false);
+        }
+
         std::set<std::string> entries;
 
         for (const auto& fs : filesystems)
@@ -80,6 +122,11 @@ namespace rwe
     std::vector<std::string>
     CompositeVirtualFileSystem::getFileNamesRecursive(const std::string& directory, const std::string& extension)
     {
+        if (index)
+        {
+            return getIndexedFileNames(directory, extension, true);
+        }
+
         std::set<std::string> entries;
 
         for (const auto& fs : filesystems)
@@ -125,9 +172,71 @@ namespace rwe
 
     void CompositeVirtualFileSystem::clear()
     {
+        index = std::nullopt;
         filesystems.clear();
     }
 
+    void CompositeVirtualFileSystem::buildIndex()
+    {
+        Index newIndex;
+
+        for (std::size_t filesystemIndex = 0; filesystemIndex < filesystems.size(); ++filesystemIndex)
+        {
+            auto paths = filesystems[filesystemIndex]->indexFiles();
+            for (std::size_t fileIndex = 0; fileIndex < paths.size(); ++fileIndex)
+            {
+                auto key = normalizeVfsPath(paths[fileIndex]);
+                auto [it, inserted] = newIndex.filesByPath.try_emplace(key, newIndex.files.size());
+                if (!inserted)
+                {
+                    // shadowed by an earlier filesystem
+                    continue;
+                }
+
+                // add the file to each directory above it
+                newIndex.filesByDirectory[std::string()].push_back(newIndex.files.size());
+                for (auto separator = key.find('/'); separator != std::string::npos; separator = key.find('/', separator + 1))
+                {
+                    newIndex.filesByDirectory[key.substr(0, separator)].push_back(newIndex.files.size());
+                }
+
+                newIndex.files.push_back(IndexedFile{std::move(paths[fileIndex]), filesystemIndex, fileIndex});
+            }
+        }
+
+        index = std::move(newIndex);
+    }
+
+    std::vector<std::string> CompositeVirtualFileSystem::getIndexedFileNames(const std::string& directory, const std::string& extension, bool recursive) const
+    {
+        auto key = normalizeVfsPath(directory);
+        auto it = index->filesByDirectory.find(key);
+        if (it == index->filesByDirectory.end())
+        {
+            return std::vector<std::string>();
+        }
+
+        auto prefixLength = key.empty() ? 0 : key.size() + 1;
+
+        std::vector<std::string> v;
+        for (auto fileIndex : it->second)
+        {
+            const auto& path = index->files[fileIndex].path;
+            auto relativePath = path.substr(prefixLength);
+            if (!recursive && relativePath.find('/') != std::string::npos)
+            {
+                continue;
+            }
+            if (endsWithIgnoreCase(relativePath, extension))
+            {
+                v.push_back(std::move(relativePath));
+            }
+        }
+
+        std::sort(v.begin(), v.end());
+        return v;
+    }
+
     void addHpisWithExtension(CompositeVirtualFileSystem& vfs, const fs::path& searchPath, const std::string& extension)
     {
         fs::directory_iterator it(searchPath);
@@ -161,6 +270,7 @@ namespace rwe
     {
         CompositeVirtualFileSystem vfs;
         addToVfs(vfs, searchPath);
+        vfs.buildIndex();
         return vfs;
     }
 }
@@ -2,15 +2,50 @@
 
 #include <filesystem>
 #include <memory>
+#include <optional>
 #include <rwe/vfs/AbstractVirtualFileSystem.h>
+#include <unordered_map>
 
 namespace rwe
 {
+    /**
+     * Normalises a path for lookup in the VFS index:
+     * upper case, with no leading or trailing separators.
+     */
+    std::string normalizeVfsPath(const std::string& path);
+
     class CompositeVirtualFileSystem final : public AbstractVirtualFileSystem
     {
     private:
+        struct IndexedFile
+        {
+            /** The path as the owning filesystem spells it. */
+            std::string path;
+            std::size_t filesystemIndex;
+            std::size_t fileIndex;
+        };
+
+        struct Index
+        {
+            /** Only the highest priority file at each path. */
+            std::vector<IndexedFile> files;
+
+            /** Keyed by normalised path. */
+            std::unordered_map<std::string, std::size_t> filesByPath;
+
+            /** Every file beneath each directory, keyed by normalised path. */
+            std::unordered_map<std::string, std::vector<std::size_t>> filesByDirectory;
+        };
+
         std::vector<std::unique_ptr<LeafVirtualFileSystem>> filesystems;
 
+        /**
+         * Built by buildIndex, discarded whenever the filesystems change.
+         * While it is present readFile, getFileNames and getFileNamesRecursive
+         * use it instead of asking each filesystem in turn.
+         */
+        std::optional<Index> index;
+
     public:
         std::optional<std::vector<char>> readFile(const std::string& filename) const override;
 
@@ -30,14 +65,27 @@ namespace rwe
 
         void clear();
 
+        /**
+         * Indexes the files of every filesystem, so that looking up a path
+         * no longer searches each filesystem and directory in turn.
+         * Where several filesystems contain a path, the first added wins, as it does in readFile.
+         * The index is a snapshot: files created afterwards are not found until it is rebuilt.
+         */
+        void buildIndex();
+
         template <typename T, typename... Args>
         void emplaceFileSystem(Args&&... args)
         {
+            index = std::nullopt;
             filesystems.emplace_back(std::make_unique<T>(std::forward<Args>(args)...));
         }
-    };
 
+    private:
+        std::vector<std::string> getIndexedFileNames(const std::string& directory, const std::string& extension, bool recursive) const;
+    };
 
     void addToVfs(CompositeVirtualFileSystem& vfs, const std::filesystem::path& searchPath);
+
+    /** Creates an indexed VFS from the search path. */
     CompositeVirtualFileSystem constructVfs(const std::filesystem::path& searchPath);
 }
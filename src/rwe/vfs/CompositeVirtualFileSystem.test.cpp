@@ -0,0 +1,107 @@
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <rwe/io/hpi/hpi_write.h>
+#include <rwe/vfs/CompositeVirtualFileSystem.h>
+#include <rwe/vfs/DirectoryFileSystem.h>
+#include <rwe/vfs/HpiFileSystem.h>
+#include <string>
+#include <vector>
+
+namespace rwe
+{
+    void writeVfsTestFile(const std::filesystem::path& path, const std::string& contents)
+    {
+        std::filesystem::create_directories(path.parent_path());
+        std::ofstream out(path, std::ios::binary);
+        out << contents;
+    }
+
+    std::optional<std::string> readVfsTestFile(const CompositeVirtualFileSystem& vfs, const std::string& path)
+    {
+        auto bytes = vfs.readFile(path);
+        if (!bytes)
+        {
+            return std::nullopt;
+        }
+        return std::string(bytes->begin(), bytes->end());
+    }
+
+    TEST_CASE("CompositeVirtualFileSystem")
+    {
+        auto root = std::filesystem::temp_directory_path() / "rwe_vfs_test";
+        std::filesystem::remove_all(root);
+
+        auto directory = root / "data";
+        writeVfsTestFile(directory / "units" / "ARMCOM.fbi", "directory armcom");
+        writeVfsTestFile(directory / "palettes" / "palette.pal", "palette");
+
+        auto hpiPath = root / "archive.hpi";
+        {
+            auto bytes = writeHpiArchive(
+                {
+                    {"units/armcom.fbi", "archive armcom", false},
+                    {"units/corcom.fbi", "archive corcom", true},
+                    {"units/readme.txt", "not a unit", false},
+                    {"features/trees/tree1.tdf", "tree", false},
+                    {"features/rocks.tdf", "rocks", false},
+                },
+                0x7d);
+            std::ofstream out(hpiPath, std::ios::binary);
+            out.write(bytes.data(), bytes.size());
+        }
+
+        CompositeVirtualFileSystem vfs;
+        vfs.emplaceFileSystem<DirectoryFileSystem>(directory);
+        vfs.emplaceFileSystem<HpiFileSystem>(hpiPath.string());
+
+        auto unindexedUnits = vfs.getFileNames("units", ".fbi");
+        auto unindexedFeatures = vfs.getFileNamesRecursive("features", ".tdf");
+
+        vfs.buildIndex();
+
+        SECTION("reads files case-insensitively from the first filesystem that has them")
+        {
+            REQUIRE(readVfsTestFile(vfs, "units/armcom.fbi") == "directory armcom");
+            REQUIRE(readVfsTestFile(vfs, "UNITS/CORCOM.FBI") == "archive corcom");
+            REQUIRE(readVfsTestFile(vfs, "Palettes/Palette.pal") == "palette");
+            REQUIRE(readVfsTestFile(vfs, "/features/trees/tree1.tdf") == "tree");
+            REQUIRE(!readVfsTestFile(vfs, "units/missing.fbi"));
+            REQUIRE(!readVfsTestFile(vfs, "units"));
+        }
+
+        SECTION("lists the files in a directory")
+        {
+            REQUIRE(vfs.getFileNames("units", ".fbi") == std::vector<std::string>{"ARMCOM.fbi", "corcom.fbi"});
+            REQUIRE(vfs.getFileNames("UNITS/", ".FBI") == std::vector<std::string>{"ARMCOM.fbi", "corcom.fbi"});
+            REQUIRE(vfs.getFileNames("features", ".tdf") == std::vector<std::string>{"rocks.tdf"});
+            REQUIRE(vfs.getFileNames("missing", ".tdf").empty());
+        }
+
+        SECTION("lists the files beneath a directory")
+        {
+            REQUIRE(vfs.getFileNamesRecursive("features", ".tdf") == std::vector<std::string>{"rocks.tdf", "trees/tree1.tdf"});
+            REQUIRE(vfs.getFileNamesRecursive("features", ".tdf") == unindexedFeatures);
+        }
+
+        SECTION("lists shadowed files once")
+        {
+            // without the index, the same file spelled differently appears twice
+            REQUIRE(unindexedUnits == std::vector<std::string>{"ARMCOM.fbi", "armcom.fbi", "corcom.fbi"});
+        }
+
+        SECTION("drops the index when a filesystem is added")
+        {
+            auto otherDirectory = root / "other";
+            writeVfsTestFile(otherDirectory / "units" / "new.fbi", "new");
+            vfs.emplaceFileSystem<DirectoryFileSystem>(otherDirectory);
+
+            REQUIRE(readVfsTestFile(vfs, "units/new.fbi") == "new");
+            vfs.buildIndex();
+            REQUIRE(readVfsTestFile(vfs, "units/new.fbi") == "new");
+            REQUIRE(readVfsTestFile(vfs, "units/armcom.fbi") == "directory armcom");
+        }
+
+        std::filesystem::remove_all(root);
+    }
+}
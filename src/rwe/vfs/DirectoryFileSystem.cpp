@@ -63,17 +63,8 @@ namespace rwe
         return pathString;
     }
 
-    std::optional<std::vector<char>> DirectoryFileSystem::readFile(const std::string& filename) const
+    std::optional<std::vector<char>> readFileAtPath(const std::filesystem::path& fullPath)
     {
-        fs::path fullPath(path);
-        auto correctlyCasedPath = findPathCaseInsensitive(path, filename);
-        if (!correctlyCasedPath)
-        {
-            return std::nullopt;
-        }
-
-        fullPath /= *correctlyCasedPath;
-
         std::ifstream input(fullPath.string(), std::ios::binary);
         if (!input.is_open())
         {
@@ -90,6 +81,46 @@ namespace rwe
         return output;
     }
 
+    std::vector<std::string> DirectoryFileSystem::indexFiles()
+    {
+        indexedFiles.clear();
+        std::vector<std::string> paths;
+
+        std::error_code ec;
+        fs::recursive_directory_iterator it(path, fs::directory_options::skip_permission_denied, ec);
+        fs::recursive_directory_iterator end;
+        for (; !ec && it != end; it.increment(ec))
+        {
+            std::error_code fileEc;
+            if (it->is_regular_file(fileEc))
+            {
+                paths.push_back(it->path().lexically_relative(path).generic_string());
+                indexedFiles.push_back(it->path());
+            }
+        }
+
+        return paths;
+    }
+
+    std::optional<std::vector<char>> DirectoryFileSystem::readIndexedFile(std::size_t index) const
+    {
+        return readFileAtPath(indexedFiles.at(index));
+    }
+
+    std::optional<std::vector<char>> DirectoryFileSystem::readFile(const std::string& filename) const
+    {
+        fs::path fullPath(path);
+        auto correctlyCasedPath = findPathCaseInsensitive(path, filename);
+        if (!correctlyCasedPath)
+        {
+            return std::nullopt;
+        }
+
+        fullPath /= *correctlyCasedPath;
+
+        return readFileAtPath(fullPath);
+    }
+
     std::vector<std::string> DirectoryFileSystem::getFileNames(const std::string& directory, const std::string& extension)
     {
         fs::path fullPath;
@@ -11,6 +11,7 @@ namespace rwe
     private:
         std::filesystem::path path;
         std::string pathString;
+        std::vector<std::filesystem::path> indexedFiles;
 
     public:
         explicit DirectoryFileSystem(const std::string& path);
@@ -19,6 +20,10 @@ namespace rwe
     public:
         const std::string& getPath() const override;
 
+        std::vector<std::string> indexFiles() override;
+
+        std::optional<std::vector<char>> readIndexedFile(std::size_t index) const override;
+
         std::optional<std::vector<char>> readFile(const std::string& filename) const override;
 
         std::vector<std::string> getFileNames(const std::string& directory, const std::string& filter) override;
@@ -1,13 +1,48 @@
 #include "HpiFileSystem.h"
+#include <mutex>
+#include <rwe/util/ThreadPool.h>
 #include <rwe/util/rwe_string.h>
 
 namespace rwe
 {
+    /** Files at least this big have their chunks decompressed in parallel. */
+    constexpr std::size_t HpiParallelExtractMinSize = 4 * 65536;
+
+    /**
+     * Decompresses the chunks of large files. Shared by every HpiFileSystem.
+     * Only one file can be extracted on it at a time,
+     * so readers that find it busy extract on their own thread instead.
+     */
+    struct HpiExtractThreadPool
+    {
+        std::mutex mutex;
+        ThreadPool threadPool{ThreadPool::getDefaultThreadCount()};
+    };
+
+    HpiExtractThreadPool& getHpiExtractThreadPool()
+    {
+        static HpiExtractThreadPool pool;
+        return pool;
+    }
+
     const std::string& HpiFileSystem::getPath() const
     {
         return name;
     }
 
+    std::vector<std::string> HpiFileSystem::indexFiles()
+    {
+        indexedFiles.clear();
+        std::vector<std::string> paths;
+        indexFilesInternal(hpi.root(), "", paths);
+        return paths;
+    }
+
+    std::optional<std::vector<char>> HpiFileSystem::readIndexedFile(std::size_t index) const
+    {
+        return extractFile(*indexedFiles.at(index));
+    }
+
     std::optional<std::vector<char>> HpiFileSystem::readFile(const std::string& filename) const
     {
         auto file = hpi.findFile(filename);
@@ -16,23 +51,52 @@ namespace rwe
             return std::nullopt;
         }
 
-        std::vector<char> buffer(file->get().size);
-        hpi.extract(*file, buffer.data());
+        return extractFile(*file);
+    }
+
+    std::vector<char> HpiFileSystem::extractFile(const HpiArchive::File& file) const
+    {
+        std::vector<char> buffer(file.size);
 
+        if (buffer.size() >= HpiParallelExtractMinSize)
+        {
+            auto& pool = getHpiExtractThreadPool();
+            std::unique_lock<std::mutex> lock(pool.mutex, std::try_to_lock);
+            if (lock.owns_lock())
+            {
+                hpi.extract(file, buffer.data(), pool.threadPool);
+                return buffer;
+            }
+        }
+
+        hpi.extract(file, buffer.data());
         return buffer;
     }
 
-    HpiFileSystem::HpiFileSystem(const std::string& file)
-        : name(file),
-          stream(file, std::ios::binary),
-          hpi(&stream)
+    void HpiFileSystem::indexFilesInternal(const HpiArchive::Directory& directory, const std::string& prefix, std::vector<std::string>& paths)
     {
-        if (!stream.is_open())
+        for (const auto& e : directory.entries)
         {
-            throw std::runtime_error("Could not open file");
+            auto path = prefix + e.name;
+            if (auto file = std::get_if<HpiArchive::File>(&e.data); file != nullptr)
+            {
+                paths.push_back(std::move(path));
+                indexedFiles.push_back(file);
+            }
+            else
+            {
+                indexFilesInternal(std::get<HpiArchive::Directory>(e.data), path + "/", paths);
+            }
         }
     }
 
+    HpiFileSystem::HpiFileSystem(const std::string& file)
+        : name(file),
+          file(file),
+          hpi(this->file.data(), this->file.size())
+    {
+    }
+
     std::vector<std::string> HpiFileSystem::getFileNames(const std::string& directory, const std::string& extension)
     {
         auto dir = hpi.findDirectory(directory);
@@ -1,11 +1,15 @@
 #pragma once
 
-#include <fstream>
 #include <rwe/io/hpi/HpiArchive.h>
+#include <rwe/util/MappedFile.h>
 #include <rwe/vfs/AbstractVirtualFileSystem.h>
 
 namespace rwe
 {
+    /**
+     * Serves files from an HPI archive, mapped into memory.
+     * readFile may be called from several threads at once.
+     */
     class HpiFileSystem final : public LeafVirtualFileSystem
     {
     private:
@@ -26,8 +30,9 @@ namespace rwe
 
     private:
         std::string name;
-        std::ifstream stream;
+        MappedFile file;
         HpiArchive hpi;
+        std::vector<const HpiArchive::File*> indexedFiles;
 
     public:
         explicit HpiFileSystem(const std::string& file);
@@ -35,6 +40,10 @@ namespace rwe
     public:
         const std::string& getPath() const override;
 
+        std::vector<std::string> indexFiles() override;
+
+        std::optional<std::vector<char>> readIndexedFile(std::size_t index) const override;
+
         std::optional<std::vector<char>> readFile(const std::string& filename) const override;
 
         std::vector<std::string> getFileNames(const std::string& directory, const std::string& extension) override;
@@ -45,6 +54,8 @@ namespace rwe
         std::vector<std::string> getDirectoryNames(const std::string& directory) override;
 
     private:
+        std::vector<char> extractFile(const HpiArchive::File& file) const;
+        void indexFilesInternal(const HpiArchive::Directory& directory, const std::string& prefix, std::vector<std::string>& paths);
         std::vector<std::string> getFileNamesInternal(const HpiArchive::Directory& directory, const std::string& extension);
         std::vector<std::string> getFileNamesRecursiveInternal(const HpiArchive::Directory& directory, const std::string& extension);
         std::vector<std::string> getDirectoryNamesInternal(const HpiArchive::Directory& directory);
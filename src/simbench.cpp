@@ -0,0 +1,456 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <rwe/LoadingScene_util.h>
+#include <rwe/game/Replay.h>
+#include <rwe/io/_3do/_3do.h>
+#include <rwe/io/fbi/io.h>
+#include <rwe/io/featuretdf/io.h>
+#include <rwe/io/moveinfotdf/io.h>
+#include <rwe/io/ota/ota.h>
+#include <rwe/io/tdf/tdf.h>
+#include <rwe/io/tnt/TntArchive.h>
+#include <rwe/io/weapontdf/WeaponTdf.h>
+#include <rwe/mesh_util.h>
+#include <rwe/sim/GameSimulation.h>
+#include <rwe/util/OpaqueArgs.h>
+#include <rwe/util/SpanStream.h>
+#include <rwe/util/rwe_string.h>
+#include <rwe/vertex_height.h>
+#include <rwe/vfs/CompositeVirtualFileSystem.h>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace rwe
+{
+    using BenchClock = std::chrono::steady_clock;
+
+    struct BenchMap
+    {
+        MapTerrain terrain;
+        std::vector<std::pair<Point, std::string>> features;
+    };
+
+    BenchMap loadMap(AbstractVirtualFileSystem& vfs, const std::string& mapName, const OtaSchema& schema)
+    {
+        auto tntBytes = vfs.readFileOrThrow("maps/" + mapName + ".tnt");
+        SpanStream tntStream(tntBytes.data(), tntBytes.size());
+        TntArchive tnt(&tntStream);
+
+        Grid<TntTileAttributes> mapAttributes(tnt.getHeader().width, tnt.getHeader().height);
+        tnt.readMapAttributes(mapAttributes.getData());
+
+        auto featureNames = getFeatureNames(tnt);
+        std::vector<std::pair<Point, std::string>> features;
+
+        mapAttributes.forEachIndexed([&](auto c, const auto& e) {
+            switch (e.feature)
+            {
+                case TntTileAttributes::FeatureNone:
+                case TntTileAttributes::FeatureUnknown:
+                case TntTileAttributes::FeatureVoid:
+                    break;
+                default:
+                    features.emplace_back(Point(c.x, c.y), featureNames.at(e.feature));
+            }
+        });
+
+        for (const auto& f : schema.features)
+        {
+            features.emplace_back(Point(f.xPos, f.zPos), f.featureName);
+        }
+
+        MapTerrain terrain(getHeightGrid(mapAttributes), SimScalar(tnt.getHeader().seaLevel));
+        return BenchMap{std::move(terrain), std::move(features)};
+    }
+
+    UnitModelDefinition loadModelDefinition(AbstractVirtualFileSystem& vfs, const std::string& objectName)
+    {
+        auto bytes = vfs.readFileOrThrow("objects3d/" + objectName + ".3do");
+        SpanStream s(bytes.data(), bytes.size());
+        auto objects = parse3doObjects(s, s.tellg());
+        if (objects.size() != 1)
+        {
+            throw std::runtime_error("Expected exactly one root object in model: " + objectName);
+        }
+
+        return createUnitModelDefinition(
+            simScalarFromFixed(findHighestVertex(objects.front()).y),
+            unitMeshFrom3do(objects.front()));
+    }
+
+    /**
+     * Loads the same simulation data that LoadingScene does,
+     * minus anything that only exists for rendering or audio.
+     */
+    void loadDefinitions(AbstractVirtualFileSystem& vfs, GameSimulation& simulation, const std::vector<std::pair<Point, std::string>>& mapFeatures)
+    {
+        for (auto& c : parseMoveInfoTdf(readTdf(vfs, "gamedata/MOVEINFO.TDF")))
+        {
+            simulation.movementClassDatabase.registerMovementClass(parseMovementClassDefinition(c.second));
+        }
+
+        for (const auto& fileName : vfs.getFileNames("weapons", ".tdf"))
+        {
+            for (auto& pair : parseWeaponTdf(readTdf(vfs, "weapons/" + fileName)))
+            {
+                addWeaponDefinition(simulation.weaponDefinitions, simulation.weaponNameIndex, parseWeaponDefinition(pair.first, pair.second));
+            }
+        }
+
+        std::unordered_set<std::string> requiredFeatures;
+        for (const auto& f : mapFeatures)
+        {
+            requiredFeatures.insert(toUpper(f.second));
+        }
+
+        for (const auto& fbiName : vfs.getFileNames("units", ".fbi"))
+        {
+            auto fbi = parseUnitFbi(readTdf(vfs, "units/" + fbiName));
+            addUnitDefinition(simulation.unitDefinitions, simulation.unitNameIndex, parseUnitDefinition(fbi, simulation.movementClassDatabase));
+
+            auto objectName = toUpper(fbi.objectName);
+            if (simulation.unitModelDefinitions.find(objectName) == simulation.unitModelDefinitions.end())
+            {
+                simulation.unitModelDefinitions.insert({objectName, loadModelDefinition(vfs, fbi.objectName)});
+            }
+
+            if (!fbi.corpse.empty())
+            {
+                requiredFeatures.insert(toUpper(fbi.corpse));
+            }
+        }
+
+        simulation.resolveWeaponDamage();
+
+        std::unordered_map<std::string, FeatureTdf> featureTdfs;
+        for (const auto& name : vfs.getFileNamesRecursive("features", ".tdf"))
+        {
+            auto tdfRoot = readTdf(vfs, "features/" + name);
+            for (const auto& e : tdfRoot.blocks)
+            {
+                featureTdfs.insert({toUpper(e.first), parseFeatureTdf(*e.second)});
+            }
+        }
+
+        for (const auto& initialFeatureName : requiredFeatures)
+        {
+            if (simulation.featureNameIndex.find(initialFeatureName) != simulation.featureNameIndex.end())
+            {
+                continue;
+            }
+
+            auto nextId = simulation.featureDefinitions.getNextId();
+            std::unordered_map<std::string, FeatureDefinitionId> openSet{{initialFeatureName, nextId}};
+            nextId = FeatureDefinitionId(nextId.value + 1);
+            for (std::deque<std::string> featuresToLoad{{initialFeatureName}}; !featuresToLoad.empty(); featuresToLoad.pop_front())
+            {
+                const auto& featureName = featuresToLoad.front();
+                auto f = parseFeatureDefinition(featureTdfs.at(toUpper(featureName)), featureName, nextId, simulation.featureNameIndex, featuresToLoad, openSet);
+                auto id = simulation.featureDefinitions.insert(f);
+                simulation.featureNameIndex.insert({toUpper(featureName), id});
+            }
+        }
+
+        ThreadPool threadPool(ThreadPool::getDefaultThreadCount());
+        simulation.unitScriptDefinitions = loadCobScripts(vfs, threadPool);
+        simulation.movementClassCollisionService = createMovementClassCollisionService(simulation.terrain, simulation.movementClassDatabase);
+    }
+
+    SimVector getStartPosition(const GameSimulation& simulation, const OtaSchema& schema, int playerIndex)
+    {
+        auto startPosKey = "StartPos" + std::to_string(playerIndex + 1);
+        auto it = std::find_if(schema.specials.begin(), schema.specials.end(), [&](const OtaSpecial& s) { return s.specialWhat == startPosKey; });
+        if (it == schema.specials.end())
+        {
+            throw std::runtime_error("Missing key from schema: " + startPosKey);
+        }
+
+        auto pos = simulation.terrain.topLeftCoordinateToWorld(SimVector(SimScalar(it->xPos), 0_ss, SimScalar(it->zPos)));
+        pos.y = simulation.terrain.getHeightAt(pos.x, pos.z);
+        return pos;
+    }
+
+    /**
+     * Spawns a square block of completed units centred on the given position
+     * and orders each of them to move to the destination.
+     * Returns the number of units that could actually be placed.
+     */
+    int spawnArmy(GameSimulation& simulation, PlayerId owner, const std::string& unitType, int count, const SimVector& center, const SimVector& destination)
+    {
+        const auto spacing = 48_ss;
+        auto side = static_cast<int>(std::ceil(std::sqrt(static_cast<float>(count))));
+        auto offset = SimScalar(side - 1) * spacing / 2_ss;
+
+        int spawned = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            auto x = center.x - offset + SimScalar(i % side) * spacing;
+            auto z = center.z - offset + SimScalar(i / side) * spacing;
+            SimVector position(x, simulation.terrain.getHeightAt(x, z), z);
+
+            auto unitId = simulation.trySpawnUnit(unitType, owner, position, std::nullopt);
+            if (!unitId)
+            {
+                continue;
+            }
+
+            auto& unit = simulation.getUnitState(*unitId);
+            unit.finishBuilding(simulation.unitDefinitions.get(unit.unitType));
+            unit.addOrder(MoveOrder(destination));
+            ++spawned;
+        }
+
+        return spawned;
+    }
+
+    void printTiming(const std::string& name, double ms, double totalMs, unsigned int ticks)
+    {
+        std::cout << "  " << std::left << std::setw(22) << name << std::right
+                  << std::setw(12) << ms << " ms"
+                  << std::setw(10) << (ms / ticks) << " ms/tick"
+                  << std::setw(8) << (totalMs > 0.0 ? 100.0 * ms / totalMs : 0.0) << " %" << std::endl;
+    }
+
+    void addSearchPath(CompositeVirtualFileSystem& vfs, const std::vector<fs::path>& searchPath)
+    {
+        for (const auto& path : searchPath)
+        {
+            addToVfs(vfs, path.string());
+        }
+        vfs.buildIndex();
+    }
+
+    /** Creates the simulation for a game on the map, with its features but no players. */
+    GameSimulation loadSimulation(AbstractVirtualFileSystem& vfs, const std::string& mapName, const OtaRecord& ota, const OtaSchema& schema)
+    {
+        auto map = loadMap(vfs, mapName, schema);
+
+        GameSimulation simulation(std::move(map.terrain), static_cast<unsigned char>(schema.surfaceMetal), std::max(0, ota.minWindSpeed), std::min(ota.maxWindSpeed, MaxUtilizableWindSpeed));
+        loadDefinitions(vfs, simulation, map.features);
+
+        for (const auto& [pos, featureName] : map.features)
+        {
+            auto featureId = simulation.tryGetFeatureDefinitionId(featureName).value();
+            simulation.addFeature(featureId, pos.x, pos.y);
+        }
+
+        return simulation;
+    }
+
+    int runBenchmark(const std::vector<fs::path>& searchPath, const std::string& mapName, unsigned int schemaIndex, const std::vector<std::string>& unitTypes, unsigned int unitsPerPlayer, unsigned int ticks, unsigned int seed, unsigned int threadCount)
+    {
+        CompositeVirtualFileSystem vfs;
+        addSearchPath(vfs, searchPath);
+
+        auto loadStart = BenchClock::now();
+
+        auto ota = parseOta(readTdf(vfs, "maps/" + mapName + ".ota"));
+        const auto& schema = ota.schemas.at(schemaIndex);
+
+        auto simulation = loadSimulation(vfs, mapName, ota, schema);
+
+        simulation.rng.seed(seed);
+        simulation.unitUpdateThreadCount = threadCount;
+
+        std::vector<PlayerId> players;
+        std::vector<SimVector> startPositions;
+        for (Index i = 0; i < getSize(unitTypes); ++i)
+        {
+            GamePlayerInfo gpi{std::nullopt, GamePlayerType::Computer, PlayerColorIndex(i), GamePlayerStatus::Alive, "ARM", Metal(1000), Energy(1000), Metal(1000), Energy(1000), Metal(1000), Energy(1000)};
+            players.push_back(simulation.addPlayer(gpi));
+            startPositions.push_back(getStartPosition(simulation, schema, i));
+        }
+
+        for (Index i = 0; i < getSize(players); ++i)
+        {
+            // march each army towards the next player's start position so that they meet
+            const auto& destination = startPositions[(i + 1) % startPositions.size()];
+            auto spawned = spawnArmy(simulation, players[i], unitTypes[i], unitsPerPlayer, startPositions[i], destination);
+            std::cout << "Player " << (i + 1) << ": spawned " << spawned << "/" << unitsPerPlayer << " " << unitTypes[i] << std::endl;
+        }
+
+        auto loadTime = BenchClock::now() - loadStart;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Loaded in " << std::chrono::duration<double, std::milli>(loadTime).count() << " ms" << std::endl;
+
+        // The profiler only keeps recent history, so accumulate as we go.
+        std::array<double, TickPhaseCount> phaseTotals{};
+        auto runStart = BenchClock::now();
+        for (unsigned int i = 0; i < ticks; ++i)
+        {
+            simulation.tick();
+
+            if constexpr (TickProfiler::Enabled)
+            {
+                for (int p = 0; p < TickPhaseCount; ++p)
+                {
+                    phaseTotals[p] += simulation.tickProfiler.getRecentPhaseMs(static_cast<TickPhase>(p), 0);
+                }
+            }
+
+            // nobody consumes events in a headless run
+            simulation.events.clear();
+        }
+        auto runMs = std::chrono::duration<double, std::milli>(BenchClock::now() - runStart).count();
+
+        std::cout << "Ran " << ticks << " ticks in " << runMs << " ms (" << (ticks * 1000.0 / runMs) << " ticks/s)" << std::endl;
+        if constexpr (TickProfiler::Enabled)
+        {
+            for (int p = 0; p < TickPhaseCount; ++p)
+            {
+                printTiming(getTickPhaseName(static_cast<TickPhase>(p)), phaseTotals[p], runMs, ticks);
+            }
+
+            std::cout << "Unit types:" << std::endl;
+            simulation.tickProfiler.writeUnitTypeCsv(std::cout, [&](UnitDefinitionId id) { return simulation.unitDefinitions.get(id).unitType; });
+
+            std::cout << "Counters:" << std::endl;
+            for (int c = 0; c < TickCounterCount; ++c)
+            {
+                auto counter = static_cast<TickCounter>(c);
+                std::cout << "  " << std::left << std::setw(22) << getTickCounterName(counter) << std::right
+                          << std::setw(12) << simulation.tickProfiler.getCounterTotal(counter) << std::endl;
+            }
+        }
+        else
+        {
+            std::cout << "Per-phase timings unavailable, reconfigure with -DRWE_TICK_PROFILER=ON" << std::endl;
+        }
+
+        std::cout << "Units alive: " << std::distance(simulation.units.begin(), simulation.units.end()) << std::endl;
+        std::cout << "Final hash: " << std::hex << std::setw(8) << std::setfill('0') << simulation.computeHash().value << std::endl;
+
+        return 0;
+    }
+
+    /**
+     * Re-simulates a recorded game as fast as possible,
+     * checking the recorded hashes along the way.
+     */
+    int runReplay(const std::vector<fs::path>& searchPath, const fs::path& replayPath)
+    {
+        CompositeVirtualFileSystem vfs;
+        addSearchPath(vfs, searchPath);
+
+        auto loadStart = BenchClock::now();
+
+        auto replayStream = std::make_unique<std::ifstream>(replayPath, std::ios::binary);
+        if (!*replayStream)
+        {
+            throw std::runtime_error("Failed to open replay: " + replayPath.string());
+        }
+        ReplayReader reader(std::move(replayStream));
+        const auto& header = reader.getHeader();
+
+        auto ota = parseOta(readTdf(vfs, "maps/" + header.mapName + ".ota"));
+        const auto& schema = ota.schemas.at(header.schemaIndex);
+
+        auto simulation = loadSimulation(vfs, header.mapName, ota, schema);
+        reader.restoreInitialState(simulation);
+
+        auto loadTime = BenchClock::now() - loadStart;
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Loaded replay on " << header.mapName << " in " << std::chrono::duration<double, std::milli>(loadTime).count() << " ms" << std::endl;
+
+        auto runStart = BenchClock::now();
+        auto result = playReplay(reader, simulation);
+        auto runMs = std::chrono::duration<double, std::milli>(BenchClock::now() - runStart).count();
+
+        std::cout << "Ran " << result.ticks << " ticks in " << runMs << " ms (" << (result.ticks * 1000.0 / runMs) << " ticks/s)" << std::endl;
+        std::cout << "Hash checkpoints verified: " << result.checkpointsVerified << std::endl;
+
+        if (result.mismatch)
+        {
+            std::cout << "Hash mismatch at game time " << std::dec << result.mismatch->gameTime.value
+                      << ": expected " << std::hex << std::setw(8) << std::setfill('0') << result.mismatch->expected.value
+                      << ", got " << std::setw(8) << result.mismatch->actual.value << std::endl;
+            return 1;
+        }
+
+        std::cout << "Final hash: " << std::hex << std::setw(8) << std::setfill('0') << simulation.computeHash().value << std::endl;
+
+        return 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        rwe::OpaqueArgs args;
+        args.parse(argc, argv);
+
+        if (args.isHelpRequested() || (!args.contains("map") && !args.contains("replay")))
+        {
+            std::cout << "Usage: rwe_simbench --map <name> [options]\n"
+                      << "       rwe_simbench --replay <path> [--data-path <path>...]\n"
+                      << "  --help                Show this message\n"
+                      << "  --data-path <path>    Game data search path (repeatable)\n"
+                      << "  --replay <path>       Play back a recorded game and verify its hashes\n"
+                      << "  --map <name>          Map to run the simulation on\n"
+                      << "  --schema <index>      Map schema index (default: 0)\n"
+                      << "  --unit <type>         Unit type for each army (repeatable, default: ARMPW and CORAK)\n"
+                      << "  --units <count>       Units per army (default: 50)\n"
+                      << "  --ticks <count>       Number of ticks to run (default: 3000)\n"
+                      << "  --seed <value>        RNG seed (default: 0)\n"
+                      << "  --threads <count>     Threads for planning unit updates (default: one per core)\n"
+                      << std::endl;
+            return args.isHelpRequested() ? 0 : 1;
+        }
+
+        std::vector<fs::path> searchPath;
+        for (const auto& p : args.getMulti("data-path"))
+        {
+            searchPath.emplace_back(p);
+        }
+        if (searchPath.empty())
+        {
+            searchPath.emplace_back(".");
+        }
+
+        if (args.contains("replay"))
+        {
+            return rwe::runReplay(searchPath, args.getString("replay"));
+        }
+
+        auto unitTypes = args.getMulti("unit");
+        if (unitTypes.empty())
+        {
+            unitTypes = {"ARMPW", "CORAK"};
+        }
+        if (unitTypes.size() > 10)
+        {
+            throw std::runtime_error("too many armies");
+        }
+        for (auto& t : unitTypes)
+        {
+            t = rwe::toUpper(t);
+        }
+
+        return rwe::runBenchmark(
+            searchPath,
+            args.getString("map"),
+            args.getUint("schema", 0),
+            unitTypes,
+            args.getUint("units", 50),
+            args.getUint("ticks", 3000),
+            args.getUint("seed", 0),
+            args.getUint("threads", 0));
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
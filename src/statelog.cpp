@@ -0,0 +1,104 @@
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <rwe/game/StateLog.h>
+#include <rwe/util/OpaqueArgs.h>
+#include <string>
+
+namespace rwe
+{
+    StateLogReader openStateLog(const std::string& path)
+    {
+        auto stream = std::make_unique<std::ifstream>(path, std::ios::binary);
+        if (!*stream)
+        {
+            throw std::runtime_error("Failed to open state log: " + path);
+        }
+        return StateLogReader(std::move(stream));
+    }
+
+    /** Writes the state after each tick as one line of JSON. */
+    int convertStateLog(const std::string& path)
+    {
+        auto reader = openStateLog(path);
+        while (reader.readFrame())
+        {
+            std::cout << stateLogFrameToJson(reader.getFrame()) << '\n';
+        }
+        std::cout.flush();
+        return 0;
+    }
+
+    /**
+     * Writes the differences between the two logs after each tick
+     * as one line of JSON, skipping ticks where they match.
+     * Returns 1 if the logs differ.
+     */
+    int diffStateLogs(const std::string& pathA, const std::string& pathB, bool stopAtFirst)
+    {
+        auto readerA = openStateLog(pathA);
+        auto readerB = openStateLog(pathB);
+
+        auto differs = false;
+        while (true)
+        {
+            auto hasA = readerA.readFrame();
+            auto hasB = readerB.readFrame();
+            if (!hasA || !hasB)
+            {
+                if (hasA != hasB)
+                {
+                    std::cerr << (hasA ? pathB : pathA) << " ends first" << std::endl;
+                    differs = true;
+                }
+                break;
+            }
+
+            auto diff = diffStateLogFrames(readerA.getFrame(), readerB.getFrame());
+            if (!diff.is_null())
+            {
+                std::cout << diff << '\n';
+                differs = true;
+                if (stopAtFirst)
+                {
+                    break;
+                }
+            }
+        }
+
+        std::cout.flush();
+        return differs ? 1 : 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        rwe::OpaqueArgs args;
+        args.parse(argc, argv);
+
+        if (args.isHelpRequested() || !args.contains("log"))
+        {
+            std::cout << "Usage: rwe_statelog --log <path> [--diff <path> [--first]]\n"
+                      << "  --help                Show this message\n"
+                      << "  --log <path>          State log written by rwe --state-log\n"
+                      << "  --diff <path>         Print the differences from another state log, tick by tick\n"
+                      << "  --first               Stop at the first tick that differs\n"
+                      << std::endl;
+            return args.isHelpRequested() ? 0 : 1;
+        }
+
+        if (args.contains("diff"))
+        {
+            return rwe::diffStateLogs(args.getString("log"), args.getString("diff"), args.getBool("first"));
+        }
+
+        return rwe::convertStateLog(args.getString("log"));
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}